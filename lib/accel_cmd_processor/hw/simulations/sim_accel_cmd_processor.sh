@@ -0,0 +1,74 @@
+#!/bin/bash
+
+# GHDL counterpart of sim_accel_cmd_processor.do, see lib/common/sim/ghdl.sh
+#
+# usage: sim_accel_cmd_processor.sh [-b <packets>] [-c <max cycles>] [-w] [-e]
+#
+# The data write units copy instr.mem and data.mem of the firmware into the
+# memories of the unit. A packet is done with the reply to the packet
+# processor (snd lane 0), -b sends the next command after each reply.
+
+cd $(dirname $(readlink -f $0))
+
+hsarepo=../../../..
+src=$hsarepo/lib
+mips32dir=$src/ext/mips32
+acpdir=$src/accel_cmd_processor/hw
+commondir=$src/common
+core_software=$src/accel_cmd_processor/sw/core0/vsim
+
+# 2 ms like the .do file
+ghdl_default_cycles=100000
+source $commondir/sim/ghdl.sh
+ghdl_options "$@"
+
+# the simulation.env file, otherwise the environment of the shell
+if [ -f $core_software/simulation.env ]; then
+	source $core_software/simulation.env
+fi
+INSTR_MEM_BLOCKS=${MIPS_NUM_TEXT_MEM_BLOCKS:-1}
+DATA_MEM_BLOCKS=${MIPS_NUM_DATA_MEM_BLOCKS:-1}
+
+ghdl_analyze \
+	$mips32dir/alu_pkg.vhd \
+	$mips32dir/asip_alu/asip_instruction_components_pkg.vhd \
+	$mips32dir/asip_alu/asip_alu.vhd \
+	$mips32dir/asip_alu/asip_decode.vhd \
+	$mips32dir/stage_pc.vhd \
+	$mips32dir/instruction_fetch.vhd \
+	$mips32dir/stage_if_id.vhd \
+	$mips32dir/branching_unit.vhd \
+	$mips32dir/decoder_unit.vhd \
+	$mips32dir/hazard_detection_unit.vhd \
+	$mips32dir/forwarding_unit.vhd \
+	$mips32dir/instruction_decode.vhd \
+	$mips32dir/stage_id_ex.vhd \
+	$mips32dir/execute.vhd \
+	$mips32dir/stage_ex_mem.vhd \
+	$mips32dir/memory_access.vhd \
+	$mips32dir/stage_mem_wb.vhd \
+	$mips32dir/write_back.vhd \
+	$mips32dir/coprocessor0.vhd \
+	$mips32dir/cpu_top.vhd \
+	$commondir/axi_lite/axi_lite_master.vhd \
+	$acpdir/memory_controller/external_memory_interface_acp.vhd \
+	$commondir/mem_router/bram_tdp.vhd \
+	$commondir/mem_router/dualclock_bram.vhd \
+	$commondir/mem_router/axi_dualclock_bram.vhd \
+	$commondir/mem_router/instruction_cache.vhd \
+	$commondir/mem_router/mem_router.vhd \
+	$acpdir/memory_controller/memory_controller_acp.vhd \
+	$commondir/interrupts/interrupt_demux.vhd \
+	$acpdir/accel_cmd_processor_top.vhd \
+	$commondir/axi_lite/axi_lite_slave.vhd \
+	$commondir/sim/generic_memory.vhd \
+	$commondir/sim/mti_file_pkg.vhd \
+	$commondir/sim/data_write_unit.vhd \
+	$commondir/sim/bench_statistics.vhd \
+	$acpdir/tb_accel_cmd_processor_top.vhd
+
+ghdl_run tb_accel_cmd_processor_top \
+	G_MEM_NUM_4K_DATA_MEMS=$DATA_MEM_BLOCKS \
+	G_MEM_NUM_4K_INSTR_MEMS=$INSTR_MEM_BLOCKS \
+	G_IMEM_INIT_FILE=$core_software/instr.mem \
+	G_DMEM_INIT_FILE=$core_software/data.mem
@@ -57,7 +57,14 @@ use IEEE.math_real.all;
 entity tb_accel_cmd_processor_top IS
 generic(
         G_MEM_NUM_4K_DATA_MEMS          : integer := 4;
-        G_MEM_NUM_4K_INSTR_MEMS         : integer := 4
+        G_MEM_NUM_4K_INSTR_MEMS         : integer := 4;
+	-- text and data segments for simulators without "mem load", see sim_accel_cmd_processor.sh
+	G_IMEM_INIT_FILE		: string  := "";
+	G_DMEM_INIT_FILE		: string  := "";
+	-- benchmark mode: commands sent one after the other, stop after this many
+	-- replies to the packet processor or cycles, 0 runs on
+	G_BENCH_PACKETS			: integer := 0;
+	G_BENCH_MAX_CYCLES		: integer := 0
 );
 end tb_accel_cmd_processor_top;
 
@@ -129,6 +136,13 @@ signal data_reset			: std_logic;
 signal finish_instr_write		: std_logic;
 signal finish_data_write		: std_logic;
 
+-- benchmark counters
+signal s_bench_beat			: std_logic;
+signal s_bench_irqs			: std_logic_vector(CONF_NUM_HW_INTERRUPTS+CONF_NUM_SND_INTERRUPTS-1 downto 0);
+signal s_bench_done			: std_logic;
+-- without a packet or cycle limit the clocks run on like in the .do file
+constant BENCH_LIMITED			: boolean := G_BENCH_PACKETS > 0 or G_BENCH_MAX_CYCLES > 0;
+
 component accel_cmd_processor_top is
     generic(
 	G_START_ADDRESS			: std_logic_vector(31 downto 0)	:= x"00000000";
@@ -245,7 +259,8 @@ component data_write_unit is
 		C_AXI_ADDR_WIDTH			: integer		:= 64;
 		C_AXI_DATA_WIDTH			: integer		:= 64;	
 		C_NUM_4K_BRAM_BLOCKS			: integer		:= 4;
-		C_BRAM_LINE_WIDTH			: integer		:= 32
+		C_BRAM_LINE_WIDTH			: integer		:= 32;
+		C_INIT_FILE				: string		:= ""
     );
     port(
         clk                     : in  std_logic;
@@ -312,6 +327,17 @@ component generic_memory is
     );
 end component;
 
+procedure oneway_handshake(signal i_snd_irq: in std_logic; signal o_snd_irq_ack: out std_logic) is
+begin
+  o_snd_irq_ack <= '0';
+  if(i_snd_irq = '1') then
+    wait for 20 ns;
+    o_snd_irq_ack <= '1';
+    wait until i_snd_irq = '0';
+    o_snd_irq_ack <= '0';
+  end if;
+end procedure;
+
 begin
 
 uut: accel_cmd_processor_top
@@ -428,7 +454,8 @@ inst_write_instr: data_write_unit
 		C_AXI_ADDR_WIDTH	=> CONF_CMD_AXI_ADDR_WIDTH,
 		C_AXI_DATA_WIDTH	=> CONF_CMD_AXI_DATA_WIDTH,
 		C_NUM_4K_BRAM_BLOCKS	=> G_MEM_NUM_4K_INSTR_MEMS,
-		C_BRAM_LINE_WIDTH	=> 32
+		C_BRAM_LINE_WIDTH	=> 32,
+		C_INIT_FILE		=> G_IMEM_INIT_FILE
     )
     port map(
         clk       	=> clock,
@@ -464,7 +491,8 @@ inst_write_data: data_write_unit
 		C_AXI_ADDR_WIDTH	=> CONF_CMD_AXI_ADDR_WIDTH,
 		C_AXI_DATA_WIDTH	=> CONF_CMD_AXI_DATA_WIDTH,
 		C_NUM_4K_BRAM_BLOCKS	=> G_MEM_NUM_4K_DATA_MEMS,
-		C_BRAM_LINE_WIDTH	=> 32
+		C_BRAM_LINE_WIDTH	=> 32,
+		C_INIT_FILE		=> G_DMEM_INIT_FILE
     )
     port map(
         clk       	=> clock,
@@ -529,7 +557,13 @@ inst_config: generic_memory
 	S_AXI_RREADY	=> s_data_axi_rready
 );
 
+-- packet processor, accelerator and the unused lane take the interrupts at once
+acknowledge_snd: for i in 0 to CONF_NUM_SND_INTERRUPTS-1 generate
+  oneway_handshake(s_snd_irq(i), s_snd_irq_ack(i));
+end generate;
+
 stimuli: process
+  variable commands : integer := 0;
 begin
   reset 	<= '0';
   cmd_reset 	<= '0';
@@ -537,7 +571,6 @@ begin
   halt 		<= '1';
   -- for the moment no interrupts arrive
   s_rcv_irq		<= (others => '0');	
-  s_snd_irq_ack 	<= (others => '0');
   wait for 25 ns;
   reset <= '1';
   cmd_reset <= '1';
@@ -552,20 +585,54 @@ begin
   end if;
   halt <= '0';
 
-  -- write testcase
+  -- write testcase, in benchmark mode the next one follows the reply to the packet processor
   wait for 100 ns;
-  s_rcv_irq <= "10";
-  wait until s_rcv_irq_ack = "10";
-  s_rcv_irq <= "00";
+  loop
+    s_rcv_irq <= "10";
+    wait until s_rcv_irq_ack = "10";
+    s_rcv_irq <= "00";
+    commands := commands + 1;
+    exit when commands >= G_BENCH_PACKETS;
+    if(s_snd_irq(0) /= '1') then
+      wait until s_snd_irq(0) = '1';
+    end if;
+    wait until s_snd_irq(0) = '0';
+  end loop;
   wait;
 end process;
 
+-- a packet is done with the reply to the packet processor (snd lane 0)
+s_bench_beat <= (s_data_axi_rvalid and s_data_axi_rready) or (s_data_axi_wvalid and s_data_axi_wready);
+s_bench_irqs <= s_rcv_irq & s_snd_irq;
+
+inst_bench: entity work.bench_statistics
+    generic map(
+		C_NAME			=> "accel_cmd_processor",
+		C_NUM_IRQS		=> CONF_NUM_HW_INTERRUPTS+CONF_NUM_SND_INTERRUPTS,
+		C_IRQ_NAMES		=> "rcv1,rcv0,snd2,snd1,snd0",
+		C_PACKETS		=> G_BENCH_PACKETS,
+		C_MAX_CYCLES		=> G_BENCH_MAX_CYCLES
+    )
+    port map(
+	clk		=> clock,
+	rstn		=> reset,
+	completion	=> s_snd_irq(0),
+	bus_beat	=> s_bench_beat,
+	irq		=> s_bench_irqs,
+	done		=> s_bench_done
+);
+
+-- in benchmark mode the clocks stop once the benchmark is done, which ends
+-- the simulation
 clock_P: process
 begin
 clock <= '0';
 wait for 10 ns;
 clock <= '1';
 wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
 end process;
 
 cmd_clock_P: process
@@ -574,6 +641,9 @@ cmd_clock <= '0';
 wait for 10 ns;
 cmd_clock <= '1';
 wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
 end process;
 
 data_clock_P: process
@@ -582,6 +652,9 @@ data_clock <= '0';
 wait for 10 ns;
 data_clock <= '1';
 wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
 end process;
 
 end behav;
@@ -0,0 +1,324 @@
+-- Copyright (C) 2017 Philipp Holzinger
+-- Copyright (C) 2017 Martin Stumpf
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+-- Direct mapped instruction cache for a text region that lives behind the
+-- memory controller (e.g. DRAM). Lines are filled word by word through the
+-- memory controller port that is shared with the data side of the pipeline.
+--
+-- The tags are kept in registers so that a miss is known in the same cycle
+-- the fetch address is presented. This is required because the pipeline
+-- captures the instruction one cycle after the address without a handshake.
+--
+-- With PREFETCH enabled, a miss on line L also fetches line L+1 and the first
+-- hit on a prefetched line fetches its successor (tagged next-line prefetch).
+-- Prefetches only use the memory controller port while the pipeline does not
+-- need it and are abandoned between two words if it does.
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+
+use IEEE.math_real.all;
+use ieee.numeric_std.all;
+
+entity instruction_cache is
+Generic(
+    ADDR_SIZE       : integer           := 32;
+    REGION_ADDR     : std_logic_vector  := x"00000000";
+    REGION_SIZE     : integer           := 16#10000#;  -- bytes, power of two
+    LINES           : integer           := 64;         -- power of two, at least 2
+    LINE_SIZE       : integer           := 32;         -- bytes, at least two memory words
+    MEM_WIDTH       : integer           := 64;
+    INST_WIDTH      : integer           := 32;
+    PREFETCH        : boolean           := true
+);
+Port (
+    clk             : in    std_logic;
+    resetn          : in    std_logic;
+
+    -- instruction fetch
+    inst_addr       : in    std_logic_vector(ADDR_SIZE - 1 downto 0);
+    inst_in_region  : out   std_logic;
+    inst_dout       : out   std_logic_vector(INST_WIDTH - 1 downto 0);
+    inst_miss       : out   std_logic;
+    inst_bus_exc    : out   std_logic;
+
+    -- arbitration of the memory controller port with the data side
+    data_request    : in    std_logic;
+    data_busy       : in    std_logic;
+    data_grant      : out   std_logic;
+
+    -- line fills through the memory controller
+    mem_addr        : out   std_logic_vector(ADDR_SIZE - 1 downto 0);
+    mem_re          : out   std_logic;
+    mem_din         : in    std_logic_vector(MEM_WIDTH - 1 downto 0);
+    mem_read_busy   : in    std_logic;
+    mem_bus_exc     : in    std_logic
+);
+end instruction_cache;
+
+architecture Behavioral of instruction_cache is
+
+constant WORD_BYTES      : integer := MEM_WIDTH / 8;
+constant WORDS_PER_LINE  : integer := LINE_SIZE / WORD_BYTES;
+constant INSTS_PER_WORD  : integer := MEM_WIDTH / INST_WIDTH;
+constant WORD_BITS       : integer := integer(ceil(log2(real(WORD_BYTES))));
+constant INST_BITS       : integer := integer(ceil(log2(real(INST_WIDTH / 8))));
+constant OFFSET_BITS     : integer := integer(ceil(log2(real(LINE_SIZE))));
+constant INDEX_BITS      : integer := integer(ceil(log2(real(LINES))));
+constant REGION_BITS     : integer := integer(ceil(log2(real(REGION_SIZE))));
+constant TAG_LOW         : integer := OFFSET_BITS + INDEX_BITS;
+
+function tag_width return integer is
+begin
+    if REGION_BITS > TAG_LOW then
+        return REGION_BITS - TAG_LOW;
+    end if;
+    return 1;
+end tag_width;
+
+constant TAG_BITS        : integer := tag_width;
+
+subtype offset_t is unsigned(ADDR_SIZE - 1 downto 0);
+subtype tag_t is std_logic_vector(TAG_BITS - 1 downto 0);
+
+type tag_array_t is array(0 to LINES - 1) of tag_t;
+type data_array_t is array(0 to LINES * WORDS_PER_LINE - 1) of std_logic_vector(MEM_WIDTH - 1 downto 0);
+
+function line_of(offset : offset_t) return offset_t is
+    variable res : offset_t := offset;
+begin
+    res(OFFSET_BITS - 1 downto 0) := (others => '0');
+    return res;
+end line_of;
+
+function index_of(offset : offset_t) return integer is
+begin
+    return to_integer(offset(TAG_LOW - 1 downto OFFSET_BITS));
+end index_of;
+
+function tag_of(offset : offset_t) return tag_t is
+    variable res : tag_t := (others => '0');
+begin
+    if REGION_BITS > TAG_LOW then
+        res := std_logic_vector(offset(REGION_BITS - 1 downto TAG_LOW));
+    end if;
+    return res;
+end tag_of;
+
+type fill_state_t is (IDLE, REQ, WRITE);
+signal state            : fill_state_t;
+
+signal tags             : tag_array_t;
+signal valid            : std_logic_vector(LINES - 1 downto 0);
+signal prefetched       : std_logic_vector(LINES - 1 downto 0);
+signal data_ram         : data_array_t;
+signal data_dout        : std_logic_vector(MEM_WIDTH - 1 downto 0);
+
+-- fetch side
+signal fetch_offset     : offset_t;
+signal fetch_line       : offset_t;
+signal fetch_index      : integer range 0 to LINES - 1;
+signal fetch_word       : integer range 0 to WORDS_PER_LINE - 1;
+signal fetch_in_region  : std_logic;
+signal fetch_hit        : std_logic;
+signal fetch_error      : std_logic;
+signal fetch_miss       : std_logic;
+signal inst_sel         : integer range 0 to INSTS_PER_WORD - 1;
+signal error_delayed    : std_logic;
+
+-- line fill
+signal fill_line        : offset_t;
+signal fill_index       : integer range 0 to LINES - 1;
+signal fill_word        : integer range 0 to WORDS_PER_LINE - 1;
+signal fill_prefetch    : std_logic;
+signal fill_abort       : std_logic;
+signal start_demand     : std_logic;
+signal start_prefetch   : std_logic;
+
+-- pending prefetch
+signal pf_pending       : std_logic;
+signal pf_line          : offset_t;
+signal pf_index         : integer range 0 to LINES - 1;
+signal pf_useful        : std_logic;
+
+-- the last demand fill failed with a bus error
+signal err_valid        : std_logic;
+signal err_line         : offset_t;
+
+-- the data side owns the memory controller until its access is done
+signal data_owned       : std_logic;
+signal data_grant_int   : std_logic;
+
+begin
+
+    assert LINES >= 2 report "instruction_cache: LINES must be at least 2" severity failure;
+    assert WORDS_PER_LINE >= 2 report "instruction_cache: LINE_SIZE must hold at least two memory words" severity failure;
+
+    fetch_offset    <= unsigned(inst_addr) - unsigned(REGION_ADDR);
+    fetch_line      <= line_of(fetch_offset);
+    fetch_index     <= index_of(fetch_offset);
+    fetch_word      <= to_integer(fetch_offset(OFFSET_BITS - 1 downto WORD_BITS));
+    fetch_in_region <= '1' when unsigned(inst_addr) >= unsigned(REGION_ADDR) and fetch_offset < to_unsigned(REGION_SIZE, ADDR_SIZE) else '0';
+
+    fetch_hit   <= '1' when fetch_in_region = '1' and valid(fetch_index) = '1' and tags(fetch_index) = tag_of(fetch_offset) else '0';
+    fetch_error <= '1' when fetch_in_region = '1' and err_valid = '1' and fetch_line = err_line else '0';
+    fetch_miss  <= fetch_in_region and not fetch_hit and not fetch_error;
+
+    inst_in_region <= fetch_in_region;
+    inst_miss      <= fetch_miss;
+    inst_bus_exc   <= fetch_error;
+    inst_dout      <= (others => '0') when error_delayed = '1' else
+                      data_dout((inst_sel + 1) * INST_WIDTH - 1 downto inst_sel * INST_WIDTH);
+
+    -- memory controller port
+    mem_addr <= std_logic_vector(unsigned(REGION_ADDR) + fill_line + to_unsigned(fill_word * WORD_BYTES, ADDR_SIZE));
+    mem_re   <= '1' when state = REQ else '0';
+
+    data_grant_int <= '1' when data_owned = '1' or (state = IDLE and fetch_miss = '0') else '0';
+    data_grant     <= data_grant_int;
+
+    -- a prefetch gives way to the data side and to misses on other lines
+    fill_abort <= '1' when fill_prefetch = '1' and (data_request = '1' or fetch_miss = '1') and
+                           not (fetch_miss = '1' and fetch_line = fill_line) else '0';
+
+    -- skip lines outside the region, lines already present and lines that
+    -- would evict the one currently executed
+    pf_index  <= index_of(pf_line);
+    pf_useful <= '1' when pf_line < to_unsigned(REGION_SIZE, ADDR_SIZE) and
+                          not (valid(pf_index) = '1' and tags(pf_index) = tag_of(pf_line)) and
+                          not (fetch_hit = '1' and fetch_index = pf_index) else '0';
+
+    start_demand   <= '1' when state = IDLE and fetch_miss = '1' and data_owned = '0' else '0';
+    start_prefetch <= '1' when state = IDLE and fetch_miss = '0' and data_owned = '0' and data_request = '0' and
+                               pf_pending = '1' and pf_useful = '1' else '0';
+
+    -- tag and data arrays
+    tag_ram: process(clk)
+    begin
+        if(rising_edge(clk)) then
+            if(start_demand = '1') then
+                tags(fetch_index) <= tag_of(fetch_offset);
+            elsif(start_prefetch = '1') then
+                tags(pf_index) <= tag_of(pf_line);
+            end if;
+        end if;
+    end process;
+
+    data_ram_p: process(clk)
+    begin
+        if(rising_edge(clk)) then
+            if(state = WRITE) then
+                data_ram(fill_index * WORDS_PER_LINE + fill_word) <= mem_din;
+            end if;
+            data_dout <= data_ram(fetch_index * WORDS_PER_LINE + fetch_word);
+        end if;
+    end process;
+
+    delay: process(clk)
+    begin
+        if(rising_edge(clk)) then
+            if(resetn='0') then
+                inst_sel      <= 0;
+                error_delayed <= '0';
+            else
+                inst_sel      <= to_integer(fetch_offset(WORD_BITS - 1 downto INST_BITS));
+                error_delayed <= fetch_error;
+            end if;
+        end if;
+    end process;
+
+    fill: process(clk)
+    begin
+        if(rising_edge(clk)) then
+            if(resetn='0') then
+                state         <= IDLE;
+                valid         <= (others => '0');
+                prefetched    <= (others => '0');
+                fill_line     <= (others => '0');
+                fill_index    <= 0;
+                fill_word     <= 0;
+                fill_prefetch <= '0';
+                pf_pending    <= '0';
+                pf_line       <= (others => '0');
+                err_valid     <= '0';
+                err_line      <= (others => '0');
+                data_owned    <= '0';
+            else
+                -- the data side keeps the port until its access is not busy anymore
+                data_owned <= data_grant_int and data_request and data_busy;
+
+                case state is
+                    when IDLE =>
+                        if(start_demand = '1') then
+                            valid(fetch_index) <= '0';
+                            fill_line     <= fetch_line;
+                            fill_index    <= fetch_index;
+                            fill_word     <= 0;
+                            fill_prefetch <= '0';
+                            err_valid     <= '0';
+                            state         <= REQ;
+                            if(PREFETCH) then
+                                pf_pending <= '1';
+                                pf_line    <= fetch_line + LINE_SIZE;
+                            end if;
+                        elsif(start_prefetch = '1') then
+                            valid(pf_index) <= '0';
+                            fill_line     <= pf_line;
+                            fill_index    <= pf_index;
+                            fill_word     <= 0;
+                            fill_prefetch <= '1';
+                            pf_pending    <= '0';
+                            state         <= REQ;
+                        elsif(pf_pending = '1' and pf_useful = '0') then
+                            pf_pending <= '0';
+                        end if;
+                    when REQ =>
+                        if(mem_bus_exc = '1') then
+                            -- the line stays invalid, a demand fill reports the error to the fetch
+                            if(fill_prefetch = '0') then
+                                err_valid <= '1';
+                                err_line  <= fill_line;
+                            end if;
+                            state <= IDLE;
+                        elsif(mem_read_busy = '0') then
+                            state <= WRITE;
+                        end if;
+                    when WRITE =>
+                        if(fill_word = WORDS_PER_LINE - 1) then
+                            valid(fill_index)      <= '1';
+                            prefetched(fill_index) <= fill_prefetch;
+                            state                  <= IDLE;
+                        elsif(fill_abort = '1') then
+                            state <= IDLE;
+                        else
+                            fill_word <= fill_word + 1;
+                            state     <= REQ;
+                        end if;
+                    when others =>
+                        state <= IDLE;
+                end case;
+
+                -- first use of a prefetched line keeps the stream going
+                if(PREFETCH and fetch_hit = '1' and prefetched(fetch_index) = '1') then
+                    prefetched(fetch_index) <= '0';
+                    pf_pending <= '1';
+                    pf_line    <= fetch_line + LINE_SIZE;
+                end if;
+            end if;
+        end if;
+    end process;
+
+end Behavioral;
@@ -30,7 +30,14 @@ Generic(
     DMEM_ADDR       : std_logic_vector 	:= x"00001000";
     DMEM_SIZE       : integer 		:= 16#1000#;
     DMEM_WIDTH      : integer 		:= 32;
-    DMEM_INIT_FILE  : string 		:= ""
+    DMEM_INIT_FILE  : string 		:= "";
+    -- optional instruction cache for a text region behind the memory controller
+    ICACHE_ENABLE   : boolean		:= false;
+    ICACHE_ADDR     : std_logic_vector 	:= x"00010000";
+    ICACHE_SIZE     : integer 		:= 16#10000#;
+    ICACHE_LINES    : integer 		:= 64;
+    ICACHE_LINE_SIZE: integer 		:= 32;
+    ICACHE_PREFETCH : boolean		:= true
 );
 Port (
     clk             : in    std_logic;
@@ -67,7 +74,16 @@ Port (
     memctrl_write_busy                  : in    std_logic;
     memctrl_address_error_exc_load      : in    std_logic;
     memctrl_address_error_exc_store     : in    std_logic;
-    memctrl_data_bus_exc                : in    std_logic
+    memctrl_data_bus_exc                : in    std_logic;
+    
+    -- optional side port of the data memory, granted while the MIPS is
+    -- stalled on the memory controller and does not use the data memory
+    dmem_ext_en                         : in    std_logic := '0';
+    dmem_ext_we                         : in    std_logic := '0';
+    dmem_ext_addr                       : in    std_logic_vector(ADDR_SIZE - 1 downto 0) := (others => '0');
+    dmem_ext_din                        : in    std_logic_vector(DMEM_WIDTH - 1 downto 0) := (others => '0');
+    dmem_ext_dout                       : out   std_logic_vector(DMEM_WIDTH - 1 downto 0);
+    dmem_ext_grant                      : out   std_logic
 );
 end mem_router;
 
@@ -100,30 +116,65 @@ signal iaddr_local_long :  std_logic_vector(ADDR_SIZE - 1 downto 0);
 signal daddr_local_long :  std_logic_vector(ADDR_SIZE - 1 downto 0);
 
 signal bram_en : std_logic;
+signal bram_wr : std_logic;
+signal bram_addr : std_logic_vector(DMEM_LOCAL_NUM_ADDR_BITS - 1 downto 0);
+signal bram_din : std_logic_vector(DMEM_WIDTH - 1 downto 0);
+signal imem_dout : std_logic_vector(IMEM_WIDTH - 1 downto 0);
+
+-- instruction cache
+signal icache_in_region         : std_logic;
+signal icache_in_region_delayed : std_logic;
+signal icache_dout              : std_logic_vector(IMEM_WIDTH - 1 downto 0);
+signal icache_miss              : std_logic;
+signal icache_bus_exc           : std_logic;
+signal icache_mem_addr          : std_logic_vector(ADDR_SIZE - 1 downto 0);
+signal icache_mem_re            : std_logic;
+signal icache_mem_bus_exc       : std_logic;
+signal data_request             : std_logic;
+signal data_mem_busy            : std_logic;
+signal data_grant               : std_logic;
+
+-- the memory controller access of the current instruction already finished
+-- while the pipeline was stalled by an instruction cache miss
+signal data_done                : std_logic;
+signal data_done_delayed        : std_logic;
+signal read_done_delayed        : std_logic;
+signal data_read_busy           : std_logic;
+signal data_write_busy          : std_logic;
+
+-- busy state of the next cycle and capture of a memory controller load
+signal next_busy                : std_logic;
+signal memctrl_result_valid     : std_logic;
+
+-- data memory side port
+signal dext_local_long          : std_logic_vector(ADDR_SIZE - 1 downto 0);
+signal dmem_ext_access          : std_logic;
+signal dmem_ext_grant_int       : std_logic;
 
 begin
-	bram_en <= read_from_local or write_to_local;
+	-- the side port only gets cycles in which the MIPS is stalled, so the
+	-- data memory output of a preceding local load is already saved
+	dmem_ext_grant_int <= prev_busy and not (read_from_local or write_to_local);
+	dmem_ext_access    <= dmem_ext_en and dmem_ext_grant_int;
+	dmem_ext_grant     <= dmem_ext_grant_int;
+	dmem_ext_dout      <= data_from_dmem;
+
+	bram_en   <= read_from_local or write_to_local or dmem_ext_access;
+	bram_wr   <= write_to_local or (dmem_ext_access and dmem_ext_we);
+	bram_addr <= dext_local_long(DMEM_LOCAL_NUM_ADDR_BITS - 1 downto 0) when dmem_ext_access = '1' else daddr_local;
+	bram_din  <= dmem_ext_din when dmem_ext_access = '1' else mips_data_din;
 
     iaddr_local_long <= std_logic_vector(unsigned(mips_inst_addr) - unsigned(IMEM_ADDR));
     daddr_local_long <= std_logic_vector(unsigned(mips_data_addr) - unsigned(DMEM_ADDR));
+    dext_local_long  <= std_logic_vector(unsigned(dmem_ext_addr) - unsigned(DMEM_ADDR));
     iaddr_local <= iaddr_local_long(IMEM_LOCAL_NUM_ADDR_BITS - 1 downto 0);
     daddr_local <= daddr_local_long(DMEM_LOCAL_NUM_ADDR_BITS - 1 downto 0);
         
     -- exceptions
-    mips_address_error_exc_load  <= memctrl_address_error_exc_load;
-    mips_address_error_exc_fetch <= '1' when unsigned(mips_inst_addr)<unsigned(IMEM_ADDR) and mips_inst_re = '1' else
-				    '1' when unsigned(iaddr_local_long)>=to_unsigned(IMEM_SIZE,iaddr_local_long'length) and mips_inst_re = '1' 
-					else '0';
- 
     mips_address_error_exc_store <= memctrl_address_error_exc_store;
-    mips_instruction_bus_exc     <= '0';
-    mips_data_bus_exc            <= memctrl_data_bus_exc;
  
     -- memctrl signals
-    memctrl_addr <= mips_data_addr;
     memctrl_dout <= mips_data_din;
-    memctrl_re   <= read_from_memctrl;
-    memctrl_we   <= write_to_memctrl; 
     
     -- compute whether or not current addr is local or in memctrl
     data_addr_is_local <= '1' when unsigned(mips_data_addr) >= unsigned(DMEM_ADDR) and unsigned(mips_data_addr) < (unsigned(DMEM_ADDR) + to_unsigned(DMEM_SIZE, DMEM_ADDR'length)) else '0';
@@ -133,17 +184,6 @@ begin
     write_to_memctrl <= '1' when data_addr_is_local = '0' and mips_data_we = '1' else '0';
     read_from_local <= '1' when data_addr_is_local = '1' and mips_data_re = '1' else '0';
     read_from_memctrl <= '1' when data_addr_is_local = '0' and mips_data_re = '1' else '0';
-    
-    -- switch dout depending on current state
-    mips_data_dout <= saved_result       when                                     prev_busy = '1' else
-                      data_from_dmem_reg when read_from_local_delayed = '1'   and prev_busy = '0' else
-                      memctrl_din        when read_from_memctrl_delayed = '1' and prev_busy = '0' else (others => '0');
-    
-    -- busy flags
-    mips_inst_read_busy  <= prev_halt;
-    mips_data_write_busy <= memctrl_write_busy  when write_to_memctrl = '1'  else '0';
-    mips_data_read_busy  <= memctrl_read_busy   when read_from_memctrl = '1' else
-                            local_read_busy     when read_from_local = '1'   else '0';
 		
     local_read_busy <= read_from_local and (not local_read_busy_delayed);
 
@@ -160,7 +200,7 @@ begin
 			read_from_local_delayed   <= read_from_local;
 			read_from_memctrl_delayed <= read_from_memctrl;
 			prev_halt                 <= halt;
-			prev_busy                 <= memctrl_read_busy or memctrl_write_busy or local_read_busy;
+			prev_busy                 <= next_busy;
 			local_read_busy_delayed   <= local_read_busy;
 		end if;
 	end if;
@@ -184,7 +224,7 @@ begin
 			saved_result <= (others => '0');
 		elsif(prev_busy = '0' and read_from_local_delayed='1') then
 			saved_result <= data_from_dmem_reg;
-		elsif(prev_busy = '0' and read_from_memctrl_delayed='1') then
+		elsif(memctrl_result_valid = '1') then
 			saved_result <= memctrl_din;
 		else
 			saved_result <= saved_result;
@@ -206,8 +246,128 @@ begin
         wr    => '0',
         addr  => iaddr_local,
         din   => (others => '0'),
-        dout  => mips_inst_dout
+        dout  => imem_dout
     );
+
+    -- without the instruction cache the datapath is the plain one of the
+    -- local memories and the memory controller
+    no_icache_gen: if not ICACHE_ENABLE generate
+        -- exceptions
+        mips_address_error_exc_load  <= memctrl_address_error_exc_load;
+        mips_address_error_exc_fetch <= '1' when unsigned(mips_inst_addr)<unsigned(IMEM_ADDR) and mips_inst_re = '1' else
+				        '1' when unsigned(iaddr_local_long)>=to_unsigned(IMEM_SIZE,iaddr_local_long'length) and mips_inst_re = '1' 
+					    else '0';
+        mips_instruction_bus_exc     <= '0';
+        mips_data_bus_exc            <= memctrl_data_bus_exc;
+
+        -- memctrl signals
+        memctrl_addr <= mips_data_addr;
+        memctrl_re   <= read_from_memctrl;
+        memctrl_we   <= write_to_memctrl; 
+
+        -- switch dout depending on current state
+        mips_data_dout <= saved_result       when                                     prev_busy = '1' else
+                          data_from_dmem_reg when read_from_local_delayed = '1'   and prev_busy = '0' else
+                          memctrl_din        when read_from_memctrl_delayed = '1' and prev_busy = '0' else (others => '0');
+        mips_inst_dout <= imem_dout;
+
+        -- busy flags
+        mips_inst_read_busy  <= prev_halt;
+        mips_data_write_busy <= memctrl_write_busy  when write_to_memctrl = '1'  else '0';
+        mips_data_read_busy  <= memctrl_read_busy   when read_from_memctrl = '1' else
+                                local_read_busy     when read_from_local = '1'   else '0';
+
+        next_busy            <= memctrl_read_busy or memctrl_write_busy or local_read_busy;
+        memctrl_result_valid <= '1' when prev_busy = '0' and read_from_memctrl_delayed = '1' else '0';
+    end generate;
+
+    -- with the instruction cache, line fills share the memory controller with
+    -- the data accesses and a data access may finish during an instruction
+    -- cache miss
+    icache_gen: if ICACHE_ENABLE generate
+        icache_inst : entity work.instruction_cache
+        generic map (
+            ADDR_SIZE   => ADDR_SIZE,
+            REGION_ADDR => ICACHE_ADDR,
+            REGION_SIZE => ICACHE_SIZE,
+            LINES       => ICACHE_LINES,
+            LINE_SIZE   => ICACHE_LINE_SIZE,
+            MEM_WIDTH   => DMEM_WIDTH,
+            INST_WIDTH  => IMEM_WIDTH,
+            PREFETCH    => ICACHE_PREFETCH
+        )
+        port map (
+            clk             => clk,
+            resetn          => resetn,
+            inst_addr       => mips_inst_addr,
+            inst_in_region  => icache_in_region,
+            inst_dout       => icache_dout,
+            inst_miss       => icache_miss,
+            inst_bus_exc    => icache_bus_exc,
+            data_request    => data_request,
+            data_busy       => data_mem_busy,
+            data_grant      => data_grant,
+            mem_addr        => icache_mem_addr,
+            mem_re          => icache_mem_re,
+            mem_din         => memctrl_din,
+            mem_read_busy   => memctrl_read_busy,
+            mem_bus_exc     => icache_mem_bus_exc
+        );
+
+        -- exceptions, the ones of line fills are reported by the cache
+        mips_address_error_exc_load  <= memctrl_address_error_exc_load and not icache_mem_re;
+        mips_address_error_exc_fetch <= '0' when icache_in_region = '1' else
+                                        '1' when unsigned(mips_inst_addr)<unsigned(IMEM_ADDR) and mips_inst_re = '1' else
+				        '1' when unsigned(iaddr_local_long)>=to_unsigned(IMEM_SIZE,iaddr_local_long'length) and mips_inst_re = '1' 
+					    else '0';
+        mips_instruction_bus_exc     <= icache_bus_exc;
+        mips_data_bus_exc            <= memctrl_data_bus_exc and not icache_mem_re;
+        icache_mem_bus_exc           <= memctrl_data_bus_exc or memctrl_address_error_exc_load;
+
+        -- memctrl signals, line fills of the instruction cache take precedence
+        memctrl_addr <= icache_mem_addr when icache_mem_re = '1' else mips_data_addr;
+        memctrl_re   <= '1' when icache_mem_re = '1' else read_from_memctrl and data_grant and not data_done;
+        memctrl_we   <= write_to_memctrl and data_grant and not data_done and not icache_mem_re;
+
+        data_request  <= (read_from_memctrl or write_to_memctrl) and not data_done;
+        data_mem_busy <= memctrl_read_busy or memctrl_write_busy;
+
+        -- switch dout depending on current state
+        mips_data_dout <= saved_result       when prev_busy = '1' or data_done_delayed = '1'   else
+                          data_from_dmem_reg when read_from_local_delayed = '1'   and prev_busy = '0' else
+                          memctrl_din        when read_from_memctrl_delayed = '1' and prev_busy = '0' else (others => '0');
+        mips_inst_dout <= icache_dout when icache_in_region_delayed = '1' else imem_dout;
+
+        -- busy flags
+        mips_inst_read_busy  <= prev_halt or icache_miss;
+        mips_data_write_busy <= data_write_busy;
+        mips_data_read_busy  <= data_read_busy;
+        data_write_busy      <= '0'                 when data_done = '1'         else
+                                not data_grant or memctrl_write_busy when write_to_memctrl = '1' else '0';
+        data_read_busy       <= '0'                 when data_done = '1'         else
+                                not data_grant or memctrl_read_busy  when read_from_memctrl = '1' else
+                                local_read_busy     when read_from_local = '1'   else '0';
+
+        next_busy            <= data_read_busy or data_write_busy or icache_miss;
+        memctrl_result_valid <= read_done_delayed;
+
+        icache_delay: process(clk)
+        begin
+	    if(rising_edge(clk)) then
+		    if(resetn='0') then
+			    icache_in_region_delayed  <= '0';
+			    data_done                 <= '0';
+			    data_done_delayed         <= '0';
+			    read_done_delayed         <= '0';
+		    else
+			    icache_in_region_delayed  <= icache_in_region;
+			    data_done                 <= icache_miss and (data_done or (data_request and data_grant and not data_mem_busy));
+			    data_done_delayed         <= data_done;
+			    read_done_delayed         <= read_from_memctrl and data_grant and not data_done and not memctrl_read_busy;
+		    end if;
+	    end if;
+        end process;
+    end generate;
     
     dmem_bram_inst : entity work.singleclock_bram
     generic map (
@@ -219,9 +379,9 @@ begin
     port map (
         clk   => clk,
         en    => bram_en,
-        wr    => write_to_local,
-        addr  => daddr_local,
-        din   => mips_data_din,
+        wr    => bram_wr,
+        addr  => bram_addr,
+        din   => bram_din,
         dout  => data_from_dmem
     );
 
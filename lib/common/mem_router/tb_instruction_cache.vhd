@@ -0,0 +1,170 @@
+-- Copyright (C) 2017 Philipp Holzinger
+-- Copyright (C) 2017 Martin Stumpf
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+library ieee;
+use IEEE.std_logic_1164.all;
+use IEEE.numeric_std.all;
+
+entity tb_instruction_cache IS
+end tb_instruction_cache;
+
+architecture behav of tb_instruction_cache is
+
+constant REGION_ADDR: std_logic_vector(31 downto 0) := x"00010000";
+constant MEM_LATENCY: integer := 6;
+-- the loop body spans several lines and is executed a few times
+constant LOOP_BYTES: integer := 512;
+constant LOOP_COUNT: integer := 3;
+
+signal clock: std_logic;
+signal reset: std_logic;
+
+signal inst_addr: std_logic_vector(31 downto 0);
+signal inst_in_region: std_logic;
+signal inst_dout: std_logic_vector(31 downto 0);
+signal inst_miss: std_logic;
+signal inst_bus_exc: std_logic;
+signal data_grant: std_logic;
+
+signal mem_addr: std_logic_vector(31 downto 0);
+signal mem_re: std_logic;
+signal mem_din: std_logic_vector(63 downto 0);
+signal mem_read_busy: std_logic;
+signal mem_done: std_logic;
+signal mem_count: integer;
+
+-- fetch model
+signal prev_addr: std_logic_vector(31 downto 0);
+signal prev_valid: std_logic;
+signal iteration: integer;
+signal stall_cycles: integer;
+signal finished: boolean;
+
+begin
+
+uut: entity work.instruction_cache
+generic map(
+	ADDR_SIZE => 32,
+	REGION_ADDR => REGION_ADDR,
+	REGION_SIZE => 16#10000#,
+	LINES => 32,
+	LINE_SIZE => 32,
+	MEM_WIDTH => 64,
+	INST_WIDTH => 32,
+	PREFETCH => true
+)
+port map(
+	clk => clock,
+	resetn => reset,
+	inst_addr => inst_addr,
+	inst_in_region => inst_in_region,
+	inst_dout => inst_dout,
+	inst_miss => inst_miss,
+	inst_bus_exc => inst_bus_exc,
+	data_request => '0',
+	data_busy => '0',
+	data_grant => data_grant,
+	mem_addr => mem_addr,
+	mem_re => mem_re,
+	mem_din => mem_din,
+	mem_read_busy => mem_read_busy,
+	mem_bus_exc => '0'
+);
+
+-- memory controller model, every instruction word holds its own address
+mem_read_busy <= mem_re and not mem_done;
+
+memory: process(clock)
+variable addr: unsigned(31 downto 0);
+begin
+if(rising_edge(clock)) then
+if(reset='0') then
+	mem_done <= '0';
+	mem_count <= 0;
+	mem_din <= (others => '0');
+else
+	mem_done <= '0';
+	if(mem_done='1') then
+		addr := unsigned(mem_addr);
+		mem_din <= std_logic_vector(addr + 4) & std_logic_vector(addr);
+		mem_count <= 0;
+	elsif(mem_re='1') then
+		if(mem_count = MEM_LATENCY) then
+			mem_done <= '1';
+		else
+			mem_count <= mem_count + 1;
+		end if;
+	end if;
+end if;
+end if;
+end process;
+
+-- sequential fetch that stalls on a miss like the pipeline does
+fetch: process(clock)
+begin
+if(rising_edge(clock)) then
+if(reset='0') then
+	inst_addr <= REGION_ADDR;
+	prev_addr <= (others => '0');
+	prev_valid <= '0';
+	iteration <= 0;
+	stall_cycles <= 0;
+	finished <= false;
+elsif(not finished) then
+	if(prev_valid='1') then
+		assert inst_dout = prev_addr report "wrong instruction fetched" severity error;
+	end if;
+	assert inst_in_region = '1' report "fetch address not in region" severity error;
+	prev_addr <= inst_addr;
+	prev_valid <= not inst_miss;
+	if(inst_miss='1') then
+		stall_cycles <= stall_cycles + 1;
+		assert iteration = 0 report "miss after the loop was cached" severity error;
+	elsif(unsigned(inst_addr) = unsigned(REGION_ADDR) + LOOP_BYTES - 4) then
+		inst_addr <= REGION_ADDR;
+		report "iteration " & integer'image(iteration) & " stalled for " & integer'image(stall_cycles) & " cycles";
+		stall_cycles <= 0;
+		iteration <= iteration + 1;
+		if(iteration = LOOP_COUNT - 1) then
+			finished <= true;
+		end if;
+	else
+		inst_addr <= std_logic_vector(unsigned(inst_addr) + 4);
+	end if;
+end if;
+end if;
+end process;
+
+stimuli: process
+begin
+  reset <= '0';
+  wait for 45 ns;
+  reset <= '1';
+  wait until finished;
+  assert data_grant = '1' report "data side not granted while idle" severity error;
+  report "instruction cache test finished";
+  wait;
+end process;
+
+clock_P: process
+begin
+clock <= '0';
+wait for 10 ns;
+clock <= '1';
+wait for 10 ns;
+end process;
+
+end behav;
@@ -0,0 +1,247 @@
+-- Copyright (C) 2017 Philipp Holzinger
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+library ieee;
+use ieee.std_logic_1164.all;
+
+-- Two AXI4 masters sharing one slave in simulation, e.g. burst_memory.
+--
+-- The slave is handed to one master for a whole transaction: from its first
+-- AWVALID or ARVALID until the write response or the last read beat has been
+-- taken. The other master waits with its ready signals low. When both ask at
+-- the same time the one that did not have the slave last wins.
+
+entity axi_arbiter is
+    generic(
+		C_AXI_ADDR_WIDTH			: integer		:= 64;
+		C_AXI_DATA_WIDTH			: integer		:= 64
+    );
+    port(
+	ACLK		: in std_logic;
+	ARESETN		: in std_logic;
+
+	-- master 0
+	S0_AXI_AWID	: in std_logic_vector(0 downto 0);
+	S0_AXI_AWADDR	: in std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
+	S0_AXI_AWLEN	: in std_logic_vector(7 downto 0);
+	S0_AXI_AWSIZE	: in std_logic_vector(2 downto 0);
+	S0_AXI_AWBURST	: in std_logic_vector(1 downto 0);
+	S0_AXI_AWLOCK	: in std_logic;
+	S0_AXI_AWCACHE	: in std_logic_vector(3 downto 0);
+	S0_AXI_AWPROT	: in std_logic_vector(2 downto 0);
+	S0_AXI_AWQOS	: in std_logic_vector(3 downto 0);
+	S0_AXI_AWVALID	: in std_logic;
+	S0_AXI_AWREADY	: out std_logic;
+	S0_AXI_WDATA	: in std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
+	S0_AXI_WSTRB	: in std_logic_vector((C_AXI_DATA_WIDTH/8)-1 downto 0);
+	S0_AXI_WLAST	: in std_logic;
+	S0_AXI_WVALID	: in std_logic;
+	S0_AXI_WREADY	: out std_logic;
+	S0_AXI_BID	: out std_logic_vector(0 downto 0);
+	S0_AXI_BRESP	: out std_logic_vector(1 downto 0);
+	S0_AXI_BVALID	: out std_logic;
+	S0_AXI_BREADY	: in std_logic;
+	S0_AXI_ARID	: in std_logic_vector(0 downto 0);
+	S0_AXI_ARADDR	: in std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
+	S0_AXI_ARLEN	: in std_logic_vector(7 downto 0);
+	S0_AXI_ARSIZE	: in std_logic_vector(2 downto 0);
+	S0_AXI_ARBURST	: in std_logic_vector(1 downto 0);
+	S0_AXI_ARLOCK	: in std_logic;
+	S0_AXI_ARCACHE	: in std_logic_vector(3 downto 0);
+	S0_AXI_ARPROT	: in std_logic_vector(2 downto 0);
+	S0_AXI_ARQOS	: in std_logic_vector(3 downto 0);
+	S0_AXI_ARVALID	: in std_logic;
+	S0_AXI_ARREADY	: out std_logic;
+	S0_AXI_RID	: out std_logic_vector(0 downto 0);
+	S0_AXI_RDATA	: out std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
+	S0_AXI_RRESP	: out std_logic_vector(1 downto 0);
+	S0_AXI_RLAST	: out std_logic;
+	S0_AXI_RVALID	: out std_logic;
+	S0_AXI_RREADY	: in std_logic;
+
+	-- master 1
+	S1_AXI_AWID	: in std_logic_vector(0 downto 0);
+	S1_AXI_AWADDR	: in std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
+	S1_AXI_AWLEN	: in std_logic_vector(7 downto 0);
+	S1_AXI_AWSIZE	: in std_logic_vector(2 downto 0);
+	S1_AXI_AWBURST	: in std_logic_vector(1 downto 0);
+	S1_AXI_AWLOCK	: in std_logic;
+	S1_AXI_AWCACHE	: in std_logic_vector(3 downto 0);
+	S1_AXI_AWPROT	: in std_logic_vector(2 downto 0);
+	S1_AXI_AWQOS	: in std_logic_vector(3 downto 0);
+	S1_AXI_AWVALID	: in std_logic;
+	S1_AXI_AWREADY	: out std_logic;
+	S1_AXI_WDATA	: in std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
+	S1_AXI_WSTRB	: in std_logic_vector((C_AXI_DATA_WIDTH/8)-1 downto 0);
+	S1_AXI_WLAST	: in std_logic;
+	S1_AXI_WVALID	: in std_logic;
+	S1_AXI_WREADY	: out std_logic;
+	S1_AXI_BID	: out std_logic_vector(0 downto 0);
+	S1_AXI_BRESP	: out std_logic_vector(1 downto 0);
+	S1_AXI_BVALID	: out std_logic;
+	S1_AXI_BREADY	: in std_logic;
+	S1_AXI_ARID	: in std_logic_vector(0 downto 0);
+	S1_AXI_ARADDR	: in std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
+	S1_AXI_ARLEN	: in std_logic_vector(7 downto 0);
+	S1_AXI_ARSIZE	: in std_logic_vector(2 downto 0);
+	S1_AXI_ARBURST	: in std_logic_vector(1 downto 0);
+	S1_AXI_ARLOCK	: in std_logic;
+	S1_AXI_ARCACHE	: in std_logic_vector(3 downto 0);
+	S1_AXI_ARPROT	: in std_logic_vector(2 downto 0);
+	S1_AXI_ARQOS	: in std_logic_vector(3 downto 0);
+	S1_AXI_ARVALID	: in std_logic;
+	S1_AXI_ARREADY	: out std_logic;
+	S1_AXI_RID	: out std_logic_vector(0 downto 0);
+	S1_AXI_RDATA	: out std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
+	S1_AXI_RRESP	: out std_logic_vector(1 downto 0);
+	S1_AXI_RLAST	: out std_logic;
+	S1_AXI_RVALID	: out std_logic;
+	S1_AXI_RREADY	: in std_logic;
+
+	-- shared slave
+	M_AXI_AWID	: out std_logic_vector(0 downto 0);
+	M_AXI_AWADDR	: out std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
+	M_AXI_AWLEN	: out std_logic_vector(7 downto 0);
+	M_AXI_AWSIZE	: out std_logic_vector(2 downto 0);
+	M_AXI_AWBURST	: out std_logic_vector(1 downto 0);
+	M_AXI_AWLOCK	: out std_logic;
+	M_AXI_AWCACHE	: out std_logic_vector(3 downto 0);
+	M_AXI_AWPROT	: out std_logic_vector(2 downto 0);
+	M_AXI_AWQOS	: out std_logic_vector(3 downto 0);
+	M_AXI_AWVALID	: out std_logic;
+	M_AXI_AWREADY	: in std_logic;
+	M_AXI_WDATA	: out std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
+	M_AXI_WSTRB	: out std_logic_vector((C_AXI_DATA_WIDTH/8)-1 downto 0);
+	M_AXI_WLAST	: out std_logic;
+	M_AXI_WVALID	: out std_logic;
+	M_AXI_WREADY	: in std_logic;
+	M_AXI_BID	: in std_logic_vector(0 downto 0);
+	M_AXI_BRESP	: in std_logic_vector(1 downto 0);
+	M_AXI_BVALID	: in std_logic;
+	M_AXI_BREADY	: out std_logic;
+	M_AXI_ARID	: out std_logic_vector(0 downto 0);
+	M_AXI_ARADDR	: out std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
+	M_AXI_ARLEN	: out std_logic_vector(7 downto 0);
+	M_AXI_ARSIZE	: out std_logic_vector(2 downto 0);
+	M_AXI_ARBURST	: out std_logic_vector(1 downto 0);
+	M_AXI_ARLOCK	: out std_logic;
+	M_AXI_ARCACHE	: out std_logic_vector(3 downto 0);
+	M_AXI_ARPROT	: out std_logic_vector(2 downto 0);
+	M_AXI_ARQOS	: out std_logic_vector(3 downto 0);
+	M_AXI_ARVALID	: out std_logic;
+	M_AXI_ARREADY	: in std_logic;
+	M_AXI_RID	: in std_logic_vector(0 downto 0);
+	M_AXI_RDATA	: in std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
+	M_AXI_RRESP	: in std_logic_vector(1 downto 0);
+	M_AXI_RLAST	: in std_logic;
+	M_AXI_RVALID	: in std_logic;
+	M_AXI_RREADY	: out std_logic
+    );
+end entity;
+
+architecture behav of axi_arbiter is
+
+    type owner_type is (NONE, OWNER0, OWNER1);
+    signal owner	: owner_type;
+    signal last_owner	: owner_type;
+
+    signal request0	: std_logic;
+    signal request1	: std_logic;
+    signal finished	: std_logic;
+
+begin
+
+    request0 <= S0_AXI_AWVALID or S0_AXI_ARVALID;
+    request1 <= S1_AXI_AWVALID or S1_AXI_ARVALID;
+    finished <= (M_AXI_BVALID and M_AXI_BREADY) or (M_AXI_RVALID and M_AXI_RREADY and M_AXI_RLAST);
+
+    arbitration: process(ACLK)
+    begin
+        if rising_edge(ACLK) then
+            if ARESETN = '0' then
+                owner <= NONE;
+                last_owner <= OWNER1;
+            else
+                case owner is
+                    when NONE =>
+                        if request0 = '1' and (request1 = '0' or last_owner = OWNER1) then
+                            owner <= OWNER0;
+                        elsif request1 = '1' then
+                            owner <= OWNER1;
+                        end if;
+                    when others =>
+                        if finished = '1' then
+                            last_owner <= owner;
+                            owner <= NONE;
+                        end if;
+                end case;
+            end if;
+        end if;
+    end process;
+
+    -- requests of the owner
+    M_AXI_AWID	  <= S1_AXI_AWID    when owner = OWNER1 else S0_AXI_AWID;
+    M_AXI_AWADDR  <= S1_AXI_AWADDR  when owner = OWNER1 else S0_AXI_AWADDR;
+    M_AXI_AWLEN	  <= S1_AXI_AWLEN   when owner = OWNER1 else S0_AXI_AWLEN;
+    M_AXI_AWSIZE  <= S1_AXI_AWSIZE  when owner = OWNER1 else S0_AXI_AWSIZE;
+    M_AXI_AWBURST <= S1_AXI_AWBURST when owner = OWNER1 else S0_AXI_AWBURST;
+    M_AXI_AWLOCK  <= S1_AXI_AWLOCK  when owner = OWNER1 else S0_AXI_AWLOCK;
+    M_AXI_AWCACHE <= S1_AXI_AWCACHE when owner = OWNER1 else S0_AXI_AWCACHE;
+    M_AXI_AWPROT  <= S1_AXI_AWPROT  when owner = OWNER1 else S0_AXI_AWPROT;
+    M_AXI_AWQOS	  <= S1_AXI_AWQOS   when owner = OWNER1 else S0_AXI_AWQOS;
+    M_AXI_AWVALID <= S0_AXI_AWVALID when owner = OWNER0 else S1_AXI_AWVALID when owner = OWNER1 else '0';
+    M_AXI_WDATA	  <= S1_AXI_WDATA   when owner = OWNER1 else S0_AXI_WDATA;
+    M_AXI_WSTRB	  <= S1_AXI_WSTRB   when owner = OWNER1 else S0_AXI_WSTRB;
+    M_AXI_WLAST	  <= S1_AXI_WLAST   when owner = OWNER1 else S0_AXI_WLAST;
+    M_AXI_WVALID  <= S0_AXI_WVALID  when owner = OWNER0 else S1_AXI_WVALID when owner = OWNER1 else '0';
+    M_AXI_BREADY  <= S0_AXI_BREADY  when owner = OWNER0 else S1_AXI_BREADY when owner = OWNER1 else '0';
+    M_AXI_ARID	  <= S1_AXI_ARID    when owner = OWNER1 else S0_AXI_ARID;
+    M_AXI_ARADDR  <= S1_AXI_ARADDR  when owner = OWNER1 else S0_AXI_ARADDR;
+    M_AXI_ARLEN	  <= S1_AXI_ARLEN   when owner = OWNER1 else S0_AXI_ARLEN;
+    M_AXI_ARSIZE  <= S1_AXI_ARSIZE  when owner = OWNER1 else S0_AXI_ARSIZE;
+    M_AXI_ARBURST <= S1_AXI_ARBURST when owner = OWNER1 else S0_AXI_ARBURST;
+    M_AXI_ARLOCK  <= S1_AXI_ARLOCK  when owner = OWNER1 else S0_AXI_ARLOCK;
+    M_AXI_ARCACHE <= S1_AXI_ARCACHE when owner = OWNER1 else S0_AXI_ARCACHE;
+    M_AXI_ARPROT  <= S1_AXI_ARPROT  when owner = OWNER1 else S0_AXI_ARPROT;
+    M_AXI_ARQOS	  <= S1_AXI_ARQOS   when owner = OWNER1 else S0_AXI_ARQOS;
+    M_AXI_ARVALID <= S0_AXI_ARVALID when owner = OWNER0 else S1_AXI_ARVALID when owner = OWNER1 else '0';
+    M_AXI_RREADY  <= S0_AXI_RREADY  when owner = OWNER0 else S1_AXI_RREADY when owner = OWNER1 else '0';
+
+    -- answers of the slave, only the owner sees ready and valid
+    S0_AXI_AWREADY <= M_AXI_AWREADY when owner = OWNER0 else '0';
+    S0_AXI_WREADY  <= M_AXI_WREADY  when owner = OWNER0 else '0';
+    S0_AXI_BVALID  <= M_AXI_BVALID  when owner = OWNER0 else '0';
+    S0_AXI_ARREADY <= M_AXI_ARREADY when owner = OWNER0 else '0';
+    S0_AXI_RVALID  <= M_AXI_RVALID  when owner = OWNER0 else '0';
+    S0_AXI_BID     <= M_AXI_BID;
+    S0_AXI_BRESP   <= M_AXI_BRESP;
+    S0_AXI_RID     <= M_AXI_RID;
+    S0_AXI_RDATA   <= M_AXI_RDATA;
+    S0_AXI_RRESP   <= M_AXI_RRESP;
+    S0_AXI_RLAST   <= M_AXI_RLAST;
+
+    S1_AXI_AWREADY <= M_AXI_AWREADY when owner = OWNER1 else '0';
+    S1_AXI_WREADY  <= M_AXI_WREADY  when owner = OWNER1 else '0';
+    S1_AXI_BVALID  <= M_AXI_BVALID  when owner = OWNER1 else '0';
+    S1_AXI_ARREADY <= M_AXI_ARREADY when owner = OWNER1 else '0';
+    S1_AXI_RVALID  <= M_AXI_RVALID  when owner = OWNER1 else '0';
+    S1_AXI_BID     <= M_AXI_BID;
+    S1_AXI_BRESP   <= M_AXI_BRESP;
+    S1_AXI_RID     <= M_AXI_RID;
+    S1_AXI_RDATA   <= M_AXI_RDATA;
+    S1_AXI_RRESP   <= M_AXI_RRESP;
+    S1_AXI_RLAST   <= M_AXI_RLAST;
+
+end architecture;
@@ -0,0 +1,150 @@
+-- Copyright (C) 2017 Philipp Holzinger
+-- 
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+-- 
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+-- 
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+library std;
+use std.textio.all;
+
+-- Throughput counters of a top-level testbench. From the end of the reset
+-- it counts the clock cycles, the completed packets (rising edges of
+-- completion), the cycles with a beat on the data bus of the unit and the
+-- rising edges of every interrupt lane. After C_PACKETS packets, or after
+-- C_MAX_CYCLES cycles, a single line
+-- 
+--   BENCHMARK <C_NAME>: <p> packets in <c> cycles, <c/p> cycles/packet,
+--   DMA bus <u>% (<b> beats), interrupts <name>=<n> ...
+-- 
+-- is reported, marked INCOMPLETE if fewer than C_PACKETS packets completed,
+-- and done is set so the testbench can stop its clocks. 0 disables a limit.
+entity bench_statistics is
+    generic(
+		C_NAME			: string	:= "testbench";
+		C_NUM_IRQS		: integer	:= 1;
+		-- comma separated lane names, the leftmost one is irq(C_NUM_IRQS-1)
+		C_IRQ_NAMES		: string	:= "irq";
+		C_PACKETS		: integer	:= 0;
+		C_MAX_CYCLES		: integer	:= 0
+    );
+    port(
+        clk             : in  std_logic;
+        rstn            : in  std_logic;
+	completion	: in  std_logic;
+	bus_beat	: in  std_logic;
+	irq		: in  std_logic_vector(C_NUM_IRQS-1 downto 0);
+	done		: out std_logic := '0'
+    );
+end entity;
+
+architecture behav of bench_statistics is
+
+    type count_array is array (C_NUM_IRQS-1 downto 0) of natural;
+
+    signal r_completion	: std_logic;
+    signal r_irq	: std_logic_vector(C_NUM_IRQS-1 downto 0);
+
+    -- <index>-th comma separated field of <names> from the left
+    function field(names : string; index : natural) return string is
+        variable first : integer := names'low;
+        variable n     : natural := 0;
+    begin
+        for i in names'range loop
+            if names(i) = ',' then
+                if n = index then
+                    return names(first to i-1);
+                end if;
+                n := n + 1;
+                first := i + 1;
+            end if;
+        end loop;
+        if n = index then
+            return names(first to names'high);
+        end if;
+        return "irq" & integer'image(index);
+    end function;
+
+    -- <value> rounded to <digits> decimal places
+    function fixed(value : real; digits : positive) return string is
+        variable scaled : integer := integer(value * real(10**digits));
+        variable frac   : string(1 to digits);
+    begin
+        for i in digits downto 1 loop
+            frac(i) := character'val(character'pos('0') + scaled mod 10);
+            scaled := scaled / 10;
+        end loop;
+        return integer'image(scaled) & "." & frac;
+    end function;
+
+begin
+
+    count: process(clk)
+        variable cycles   : natural := 0;
+        variable packets  : natural := 0;
+        variable beats    : natural := 0;
+        variable irqs     : count_array := (others => 0);
+        variable finished : boolean := false;
+        variable l        : line;
+    begin
+        if rising_edge(clk) then
+            if rstn = '0' then
+                cycles := 0;
+                packets := 0;
+                beats := 0;
+                irqs := (others => 0);
+                r_completion <= '0';
+                r_irq <= (others => '0');
+            elsif not finished then
+                cycles := cycles + 1;
+                r_completion <= completion;
+                r_irq <= irq;
+                if completion = '1' and r_completion = '0' then
+                    packets := packets + 1;
+                end if;
+                if bus_beat = '1' then
+                    beats := beats + 1;
+                end if;
+                for i in irq'range loop
+                    if irq(i) = '1' and r_irq(i) = '0' then
+                        irqs(i) := irqs(i) + 1;
+                    end if;
+                end loop;
+
+                if (C_PACKETS > 0 and packets >= C_PACKETS) or (C_MAX_CYCLES > 0 and cycles >= C_MAX_CYCLES) then
+                    finished := true;
+                    done <= '1';
+                    write(l, "BENCHMARK " & C_NAME & ": " & integer'image(packets) & " packets in "
+                             & integer'image(cycles) & " cycles, ");
+                    if packets > 0 then
+                        write(l, fixed(real(cycles)/real(packets), 2) & " cycles/packet, ");
+                    else
+                        write(l, string'("- cycles/packet, "));
+                    end if;
+                    write(l, "DMA bus " & fixed(100.0*real(beats)/real(cycles), 1) & "% ("
+                             & integer'image(beats) & " beats), interrupts");
+                    for i in irq'range loop
+                        write(l, " " & field(C_IRQ_NAMES, C_NUM_IRQS-1-i) & "=" & integer'image(irqs(i)));
+                    end loop;
+                    if C_PACKETS > 0 and packets < C_PACKETS then
+                        write(l, string'(", INCOMPLETE"));
+                    end if;
+                    report l.all severity note;
+                    deallocate(l);
+                end if;
+            end if;
+        end if;
+    end process;
+
+end architecture;
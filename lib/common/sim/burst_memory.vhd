@@ -17,13 +17,22 @@ library ieee;
 use ieee.std_logic_1164.all;
 use ieee.numeric_std.all;
 use ieee.math_real.all;
+library std;
+use std.textio.all;
+use work.mti_file_pkg.all;
 
 entity burst_memory is
     generic(
 		C_LOW_ADDR				: std_logic_vector	:= x"0001000000000000";
 		C_AXI_ADDR_WIDTH			: integer		:= 64;
 		C_AXI_DATA_WIDTH			: integer		:= 64;	
-		C_NUM_1K_BRAM_BLOCKS			: integer		:= 4
+		C_NUM_1K_BRAM_BLOCKS			: integer		:= 4;
+		-- MTI files loaded at elaboration, for simulators without "mem load";
+		-- the overlay replaces the lines it holds, missing files are skipped
+		C_INIT_FILE				: string		:= "";
+		C_OVERLAY_FILE				: string		:= "";
+		-- MTI file the non-zero lines are saved to on a rising edge of DUMP
+		C_DUMP_FILE				: string		:= ""
     );
     port(
         clk             : in  std_logic;
@@ -69,7 +78,16 @@ entity burst_memory is
 	S_AXI_RRESP	: out std_logic_vector(1 downto 0);
 	S_AXI_RLAST	: out std_logic;
 	S_AXI_RVALID	: out std_logic;
-	S_AXI_RREADY	: in std_logic
+	S_AXI_RREADY	: in std_logic;
+
+	-- testbench access next to the AXI slave, BD_DOUT holds the line at BD_ADDR one S_AXI_ACLK cycle after BD_EN
+	BD_EN		: in std_logic := '0';
+	BD_WE		: in std_logic := '0';
+	BD_ADDR		: in std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0) := (others => '0');
+	BD_DIN		: in std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0) := (others => '0');
+	BD_DOUT		: out std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
+
+	DUMP		: in std_logic := '0'
     );
 end entity;
 
@@ -81,7 +99,39 @@ architecture behav of burst_memory is
     
     -- Shared memory
     type mem_type is array ( 0 to NUM_LINES-1 ) of std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
-    shared variable bram: mem_type;
+
+    procedure load_mti(ram : inout mem_type; name : in string) is
+        file f          : text;
+        variable status : file_open_status;
+        variable l      : line;
+        variable index  : integer;
+        variable word   : std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
+        variable good   : boolean;
+    begin
+        if name = "" then
+            return;
+        end if;
+        file_open(status, f, name, read_mode);
+        if status /= open_ok then
+            report "burst_memory: " & name & " not found, not loaded" severity note;
+            return;
+        end if;
+        while not endfile(f) loop
+            readline(f, l);
+            mti_read_address(l, index);
+            if index >= 0 then
+                loop
+                    mti_read_word(l, word, good);
+                    exit when not good or index >= NUM_LINES;
+                    ram(index) := word;
+                    index := index + 1;
+                end loop;
+            end if;
+        end loop;
+        file_close(f);
+    end procedure;
+
+    shared variable bram: mem_type := (others => (others => '0'));
     
     -- internal read/write state
     type unit_state is (IDLE,READ_BRAM,WRITE_BRAM);
@@ -93,6 +143,7 @@ architecture behav of burst_memory is
     
     signal rebased_address      : std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
     signal decoded_addr		: std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
+    signal bd_rebased_address	: std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
 
     -- AXI4FULL signals
     signal axi_arlen_cntr	: std_logic_vector(7 downto 0);
@@ -170,6 +221,60 @@ begin
             end if;
         end if;
     end process;
+
+    -- the files are read into the memory in place before the first clock
+    -- edge, only the lines they hold are touched
+    init_memory: process
+    begin
+        load_mti(bram, C_INIT_FILE);
+        load_mti(bram, C_OVERLAY_FILE);
+        wait;
+    end process;
+
+    bd_rebased_address <= std_logic_vector(unsigned(BD_ADDR)-unsigned(C_LOW_ADDR));
+
+    backdoor: process(S_AXI_ACLK)
+        variable index : integer;
+    begin
+        if rising_edge(S_AXI_ACLK) then
+            if BD_EN = '1' then
+                index := to_integer(unsigned(bd_rebased_address(integer(ceil(log2(real(NUM_LINES))))-1+ADDRESS_SHIFT downto ADDRESS_SHIFT)));
+                if BD_WE = '1' then
+                    bram(index) := BD_DIN;
+                end if;
+                BD_DOUT <= bram(index);
+            end if;
+        end if;
+    end process;
+
+    -- same layout as "mem save -format mti -dataradix hex -wordsperline 2"
+    dump_memory: process(DUMP)
+        file f          : text;
+        variable status : file_open_status;
+        variable l      : line;
+        constant ZERO   : std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0) := (others => '0');
+    begin
+        if rising_edge(DUMP) and C_DUMP_FILE /= "" then
+            file_open(status, f, C_DUMP_FILE, write_mode);
+            if status /= open_ok then
+                report "burst_memory: cannot write " & C_DUMP_FILE severity error;
+            else
+                write(l, string'("// memory data file (do not edit the following line - required for mem load use)"));
+                writeline(f, l);
+                write(l, "// instance=" & bram'path_name);
+                writeline(f, l);
+                write(l, string'("// format=mti addressradix=d dataradix=h version=1.0 wordsperline=2"));
+                writeline(f, l);
+                for i in 0 to NUM_LINES/2-1 loop
+                    if bram(2*i) /= ZERO or bram(2*i+1) /= ZERO then
+                        write(l, integer'image(2*i) & ": " & to_hex(bram(2*i)) & " " & to_hex(bram(2*i+1)));
+                        writeline(f, l);
+                    end if;
+                end loop;
+                file_close(f);
+            end if;
+        end if;
+    end process;
     
 end architecture;
 
@@ -18,6 +18,9 @@ library ieee;
 use ieee.std_logic_1164.all;
 use ieee.numeric_std.all;
 use ieee.math_real.all;
+library std;
+use std.textio.all;
+use work.mti_file_pkg.all;
 
 -- C_AXI_ADDR_WIDTH must always be a multiple of C_BRAM_LINE_WIDTH!!!
 entity data_write_unit is
@@ -26,7 +29,10 @@ entity data_write_unit is
 		C_AXI_ADDR_WIDTH			: integer		:= 64;
 		C_AXI_DATA_WIDTH			: integer		:= 64;	
 		C_NUM_4K_BRAM_BLOCKS			: integer		:= 4;
-		C_BRAM_LINE_WIDTH			: integer		:= 32
+		C_BRAM_LINE_WIDTH			: integer		:= 32;
+		-- MTI file with C_BRAM_LINE_WIDTH bit words loaded at elaboration,
+		-- for simulators without "mem load"
+		C_INIT_FILE				: string		:= ""
     );
     port(
         clk                     : in  std_logic;
@@ -101,7 +107,8 @@ end component axi_lite_master;
     
     -- Shared memory
     type mem_type is array ( 0 to NUM_LINES-1 ) of std_logic_vector(C_BRAM_LINE_WIDTH-1 downto 0);
-    shared variable bram: mem_type;
+
+    shared variable bram: mem_type := (others => (others => '0'));
 
     signal current_address 	: std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
     signal current_bram_index 	: std_logic_vector(integer(ceil(log2(real(NUM_LINES))))-1 downto 0);
@@ -171,6 +178,38 @@ axi_lite_master_inst : axi_lite_master
 		M_AXI_RREADY	=> M_AXI_RREADY
 	);
 
+-- C_INIT_FILE is read into the memory in place before the first clock edge
+init_memory: process
+    file f          : text;
+    variable status : file_open_status;
+    variable l      : line;
+    variable index  : integer;
+    variable word   : std_logic_vector(C_BRAM_LINE_WIDTH-1 downto 0);
+    variable good   : boolean;
+begin
+    if C_INIT_FILE /= "" then
+        file_open(status, f, C_INIT_FILE, read_mode);
+        if status /= open_ok then
+            report "data_write_unit: " & C_INIT_FILE & " not found, not loaded" severity warning;
+        else
+            while not endfile(f) loop
+                readline(f, l);
+                mti_read_address(l, index);
+                if index >= 0 then
+                    loop
+                        mti_read_word(l, word, good);
+                        exit when not good or index >= NUM_LINES;
+                        bram(index) := word;
+                        index := index + 1;
+                    end loop;
+                end if;
+            end loop;
+            file_close(f);
+        end if;
+    end if;
+    wait;
+end process;
+
 prepare_data: process(clk)
 begin
         if(rising_edge(clk)) then
@@ -109,7 +109,7 @@ end component axi_lite_slave;
     
     -- Shared memory
     type mem_type is array ( 0 to NUM_LINES-1 ) of std_logic_vector(C_BRAM_LINE_WIDTH-1 downto 0);
-    shared variable bram: mem_type;
+    shared variable bram: mem_type := (others => (others => '0'));
     
     -- internal read/write state
     type unit_state is (IDLE,READ_BRAM,WRITE_BRAM);
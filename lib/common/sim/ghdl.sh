@@ -0,0 +1,98 @@
+#!/bin/bash
+
+# GHDL flow of the top-level testbenches, sourced by the sim_<unit>.sh scripts
+# next to the ModelSim .do files. They analyse the sources of the .do file in
+# the same order into ghdl_work/ and run the testbench with the generics the
+# .do file passes to vsim. The memories load their files themselves since
+# there is no "mem load".
+#
+# options of the sim_<unit>.sh scripts:
+#   -b <packets>   benchmark mode, stop once <packets> packets are done
+#   -c <cycles>    stop after <cycles> clock cycles, by default the time the
+#                  .do file runs
+#   -w             write the waveform to <testbench>.ghw
+#   -e             only analyse and elaborate the testbench
+#
+# At the end bench_statistics reports one line like
+#   BENCHMARK packet_processor: 4 packets in 51234 cycles, 12808.50 cycles/packet,
+#   DMA bus 3.2% (1650 beats), interrupts aql=1 dma=4 ...
+# which is also in ghdl_transcript. The run fails if the line is missing or
+# fewer than <packets> packets were done.
+#
+# environment:
+#   GHDL=ghdl        the simulator
+#   GHDL_FLAGS       additional analysis and elaboration options
+
+GHDL=${GHDL:-ghdl}
+GHDL_WORKDIR=ghdl_work
+GHDL_STD_FLAGS="--std=93c --ieee=synopsys -fexplicit --workdir=$GHDL_WORKDIR"
+
+bench_packets=0
+max_cycles=$ghdl_default_cycles
+wave=0
+elaborate_only=0
+
+ghdl_options(){
+	local option
+	OPTIND=1
+	while getopts "b:c:we" option; do
+		case $option in
+			b) bench_packets=$OPTARG ;;
+			c) max_cycles=$OPTARG ;;
+			w) wave=1 ;;
+			e) elaborate_only=1 ;;
+			*) echo "usage: $(basename $0) [-b <packets>] [-c <max cycles>] [-w] [-e]"; exit 1 ;;
+		esac
+	done
+	if ! command -v $GHDL > /dev/null; then
+		echo "ERROR: $GHDL is not in the PATH"
+		exit 1
+	fi
+}
+
+# analyses the given sources in order
+ghdl_analyze(){
+	mkdir -p $GHDL_WORKDIR
+	local source
+	for source in "$@"; do
+		if ! $GHDL -a $GHDL_STD_FLAGS $GHDL_FLAGS $source; then
+			echo "ERROR: analysis of $source failed"
+			exit 1
+		fi
+	done
+}
+
+# elaborates and runs testbench <top> with the generics <name>=<value> that follow
+ghdl_run(){
+	local top=$1
+	shift
+	local options=(-gG_BENCH_PACKETS=$bench_packets -gG_BENCH_MAX_CYCLES=$max_cycles --ieee-asserts=disable-at-0)
+	local generic
+	for generic in "$@"; do
+		options+=("-g$generic")
+	done
+	if [ $wave -eq 1 ]; then
+		options+=("--wave=$top.ghw")
+	fi
+
+	if ! $GHDL -e $GHDL_STD_FLAGS $GHDL_FLAGS $top; then
+		echo "ERROR: elaboration of $top failed"
+		exit 1
+	fi
+	if [ $elaborate_only -eq 1 ]; then
+		return
+	fi
+	$GHDL -r $GHDL_STD_FLAGS $top "${options[@]}" 2>&1 | tee ghdl_transcript
+	if [ ${PIPESTATUS[0]} -ne 0 ]; then
+		echo "ERROR: simulation of $top failed"
+		exit 1
+	fi
+	if ! grep -q "BENCHMARK " ghdl_transcript; then
+		echo "ERROR: $top ended without a benchmark report, set -c"
+		exit 1
+	fi
+	if grep -q "BENCHMARK .*INCOMPLETE" ghdl_transcript; then
+		echo "ERROR: $top did not finish $bench_packets packets in $max_cycles cycles"
+		exit 1
+	fi
+}
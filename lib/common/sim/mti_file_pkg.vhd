@@ -0,0 +1,110 @@
+-- Copyright (C) 2017 Philipp Holzinger
+-- 
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+-- 
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+-- 
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+library std;
+use std.textio.all;
+
+-- Memory files in the MTI format of "mem load" and "mem save" (see
+-- tools/common/mti), for simulators without these commands. Only decimal
+-- addresses and hexadecimal data are supported, like the files of elf2mem.sh
+-- and aql2mem.
+package mti_file_pkg is
+
+    -- address of the first word of <l>, which is left behind the colon;
+    -- -1 for headers, comments and empty lines
+    procedure mti_read_address(l : inout line; index : out integer);
+
+    -- next word of <l>, good is false at the end of the line
+    procedure mti_read_word(l : inout line; word : out std_logic_vector; good : out boolean);
+
+    -- lower case hexadecimal digits of <v>, x for undefined nibbles
+    function to_hex(v : std_logic_vector) return string;
+
+end package;
+
+package body mti_file_pkg is
+
+    function hex_value(c : character) return integer is
+    begin
+        case c is
+            when '0' to '9' => return character'pos(c) - character'pos('0');
+            when 'a' to 'f' => return character'pos(c) - character'pos('a') + 10;
+            when 'A' to 'F' => return character'pos(c) - character'pos('A') + 10;
+            when others     => return -1;
+        end case;
+    end function;
+
+    procedure mti_read_address(l : inout line; index : out integer) is
+        variable c      : character;
+        variable good   : boolean;
+        variable value  : integer := 0;
+        variable digits : integer := 0;
+    begin
+        index := -1;
+        loop
+            read(l, c, good);
+            exit when not good or c /= ' ';
+        end loop;
+        while good and c >= '0' and c <= '9' loop
+            value := value*10 + character'pos(c) - character'pos('0');
+            digits := digits + 1;
+            read(l, c, good);
+        end loop;
+        if good and c = ':' and digits > 0 then
+            index := value;
+        end if;
+    end procedure;
+
+    procedure mti_read_word(l : inout line; word : out std_logic_vector; good : out boolean) is
+        variable c      : character;
+        variable ok     : boolean;
+        variable value  : unsigned(word'length-1 downto 0) := (others => '0');
+        variable digits : integer := 0;
+    begin
+        loop
+            read(l, c, ok);
+            exit when not ok or c /= ' ';
+        end loop;
+        while ok and hex_value(c) >= 0 loop
+            value := shift_left(value, 4) + to_unsigned(hex_value(c), value'length);
+            digits := digits + 1;
+            read(l, c, ok);
+        end loop;
+        word := std_logic_vector(value);
+        good := digits > 0;
+    end procedure;
+
+    function to_hex(v : std_logic_vector) return string is
+        constant DIGITS : string(1 to 16) := "0123456789abcdef";
+        variable padded : std_logic_vector(4*((v'length+3)/4)-1 downto 0) := (others => '0');
+        variable nibble : std_logic_vector(3 downto 0);
+        variable s      : string(1 to padded'length/4);
+    begin
+        padded(v'length-1 downto 0) := v;
+        for i in s'range loop
+            nibble := padded(padded'length-4*(i-1)-1 downto padded'length-4*i);
+            if is_x(nibble) then
+                s(i) := 'x';
+            else
+                s(i) := DIGITS(to_integer(unsigned(nibble))+1);
+            end if;
+        end loop;
+        return s;
+    end function;
+
+end package body;
@@ -0,0 +1,250 @@
+-- Copyright (C) 2017 Philipp Holzinger
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+library ieee;
+use IEEE.std_logic_1164.all;
+use IEEE.numeric_std.all;
+
+-- backdoor of burst_memory as used by the AQL producer of tb_packet_processor_top,
+-- next to single beat accesses through the AXI slave
+entity tb_burst_memory IS
+end tb_burst_memory;
+
+architecture behav of tb_burst_memory is
+
+constant LOW_ADDR: std_logic_vector(63 downto 0) := x"0001000000000000";
+
+signal clock: std_logic;
+signal reset: std_logic;
+
+signal awaddr: std_logic_vector(63 downto 0);
+signal awvalid: std_logic;
+signal awready: std_logic;
+signal wdata: std_logic_vector(63 downto 0);
+signal wlast: std_logic;
+signal wvalid: std_logic;
+signal wready: std_logic;
+signal bvalid: std_logic;
+signal bready: std_logic;
+signal araddr: std_logic_vector(63 downto 0);
+signal arvalid: std_logic;
+signal arready: std_logic;
+signal rdata: std_logic_vector(63 downto 0);
+signal rlast: std_logic;
+signal rvalid: std_logic;
+signal rready: std_logic;
+
+signal bd_en: std_logic;
+signal bd_we: std_logic;
+signal bd_addr: std_logic_vector(63 downto 0);
+signal bd_din: std_logic_vector(63 downto 0);
+signal bd_dout: std_logic_vector(63 downto 0);
+
+function word(index: integer) return std_logic_vector is
+begin
+	return std_logic_vector(unsigned(LOW_ADDR) + to_unsigned(8*index, 64));
+end function;
+
+begin
+
+uut: entity work.burst_memory
+generic map(
+	C_LOW_ADDR => LOW_ADDR,
+	C_AXI_ADDR_WIDTH => 64,
+	C_AXI_DATA_WIDTH => 64,
+	C_NUM_1K_BRAM_BLOCKS => 1
+)
+port map(
+	clk => clock,
+	rstn => reset,
+	S_AXI_ACLK => clock,
+	S_AXI_ARESETN => reset,
+	S_AXI_AWID => "0",
+	S_AXI_AWADDR => awaddr,
+	S_AXI_AWLEN => x"00",
+	S_AXI_AWSIZE => "011",
+	S_AXI_AWBURST => "01",
+	S_AXI_AWLOCK => '0',
+	S_AXI_AWCACHE => "0000",
+	S_AXI_AWPROT => "000",
+	S_AXI_AWQOS => "0000",
+	S_AXI_AWREGION => "0000",
+	S_AXI_AWVALID => awvalid,
+	S_AXI_AWREADY => awready,
+	S_AXI_WDATA => wdata,
+	S_AXI_WSTRB => x"FF",
+	S_AXI_WLAST => wlast,
+	S_AXI_WVALID => wvalid,
+	S_AXI_WREADY => wready,
+	S_AXI_BID => open,
+	S_AXI_BRESP => open,
+	S_AXI_BVALID => bvalid,
+	S_AXI_BREADY => bready,
+	S_AXI_ARID => "0",
+	S_AXI_ARADDR => araddr,
+	S_AXI_ARLEN => x"00",
+	S_AXI_ARSIZE => "011",
+	S_AXI_ARBURST => "01",
+	S_AXI_ARLOCK => '0',
+	S_AXI_ARCACHE => "0000",
+	S_AXI_ARPROT => "000",
+	S_AXI_ARQOS => "0000",
+	S_AXI_ARREGION => "0000",
+	S_AXI_ARVALID => arvalid,
+	S_AXI_ARREADY => arready,
+	S_AXI_RID => open,
+	S_AXI_RDATA => rdata,
+	S_AXI_RRESP => open,
+	S_AXI_RLAST => rlast,
+	S_AXI_RVALID => rvalid,
+	S_AXI_RREADY => rready,
+	BD_EN => bd_en,
+	BD_WE => bd_we,
+	BD_ADDR => bd_addr,
+	BD_DIN => bd_din,
+	BD_DOUT => bd_dout
+);
+
+stimuli: process
+  variable value: std_logic_vector(63 downto 0);
+
+  -- single beat write, WDATA is taken with the write response
+  procedure axi_write(addr: std_logic_vector(63 downto 0); data: std_logic_vector(63 downto 0)) is
+  begin
+    awaddr <= addr;
+    wdata <= data;
+    wlast <= '1';
+    awvalid <= '1';
+    wvalid <= '1';
+    bready <= '1';
+    loop
+      wait until rising_edge(clock);
+      exit when bvalid = '1';
+    end loop;
+    awvalid <= '0';
+    wvalid <= '0';
+    wlast <= '0';
+    bready <= '0';
+  end procedure;
+
+  -- single beat read
+  procedure axi_read(addr: std_logic_vector(63 downto 0); data: out std_logic_vector(63 downto 0)) is
+  begin
+    araddr <= addr;
+    arvalid <= '1';
+    rready <= '1';
+    wait until rising_edge(clock);
+    arvalid <= '0';
+    loop
+      wait until falling_edge(clock);
+      exit when rvalid = '1';
+    end loop;
+    assert rlast = '1' report "single beat read without RLAST" severity error;
+    data := rdata;
+    wait until rising_edge(clock);
+    rready <= '0';
+  end procedure;
+
+  -- backdoor write, one cycle like the 'M' command of the stimulus replay
+  procedure bd_write(addr: std_logic_vector(63 downto 0); data: std_logic_vector(63 downto 0)) is
+  begin
+    bd_addr <= addr;
+    bd_din <= data;
+    bd_we <= '1';
+    bd_en <= '1';
+    wait until rising_edge(clock);
+    bd_we <= '0';
+    bd_en <= '0';
+  end procedure;
+
+  -- backdoor read, BD_DOUT is valid after the next edge
+  procedure bd_read(addr: std_logic_vector(63 downto 0); data: out std_logic_vector(63 downto 0)) is
+  begin
+    bd_addr <= addr;
+    bd_en <= '1';
+    wait until rising_edge(clock);
+    bd_en <= '0';
+    wait until falling_edge(clock);
+    data := bd_dout;
+  end procedure;
+begin
+  reset <= '0';
+  awaddr <= (others => '0');
+  awvalid <= '0';
+  wdata <= (others => '0');
+  wlast <= '0';
+  wvalid <= '0';
+  bready <= '0';
+  araddr <= (others => '0');
+  arvalid <= '0';
+  rready <= '0';
+  bd_en <= '0';
+  bd_we <= '0';
+  bd_addr <= (others => '0');
+  bd_din <= (others => '0');
+  wait for 45 ns;
+  reset <= '1';
+  wait until rising_edge(clock);
+
+  -- a backdoor write reads back the new value at once, a read of another
+  -- word still sees it until the next edge, so the stimulus replay must
+  -- not compare before that
+  bd_write(word(8), x"0000000000000080");
+  bd_addr <= word(9);
+  bd_en <= '1';
+  wait until falling_edge(clock);
+  assert bd_dout = x"0000000000000080" report "backdoor write did not read back" severity error;
+  wait until rising_edge(clock);
+  bd_en <= '0';
+  wait until falling_edge(clock);
+  assert bd_dout = x"0000000000000000" report "backdoor read of an empty word" severity error;
+
+  -- the output holds while the backdoor is disabled
+  bd_addr <= word(8);
+  wait until rising_edge(clock);
+  wait until falling_edge(clock);
+  assert bd_dout = x"0000000000000000" report "backdoor output changed while disabled" severity error;
+
+  -- backdoor data is visible to the AXI slave
+  axi_read(word(8), value);
+  assert value = x"0000000000000080" report "AXI read of backdoor data" severity error;
+
+  -- AXI writes are visible to the backdoor, like READ_INDEX updates of the packet processor
+  axi_write(word(16), x"0123456789ABCDEF");
+  wait until rising_edge(clock);
+  bd_read(word(16), value);
+  assert value = x"0123456789ABCDEF" report "backdoor read of AXI data" severity error;
+  axi_read(word(16), value);
+  assert value = x"0123456789ABCDEF" report "AXI read of AXI data" severity error;
+
+  -- backdoor overwrite of a word written through AXI
+  wait until rising_edge(clock);
+  bd_write(word(16), x"FEDCBA9876543210");
+  axi_read(word(16), value);
+  assert value = x"FEDCBA9876543210" report "AXI read after backdoor overwrite" severity error;
+
+  report "tb_burst_memory finished" severity note;
+  wait;
+end process;
+
+clock_P: process
+begin
+clock <= '0';
+wait for 10 ns;
+clock <= '1';
+wait for 10 ns;
+end process;
+
+end behav;
@@ -0,0 +1,200 @@
+// Copyright (C) 2017 Philipp Holzinger
+// Copyright (C) 2017 Martin Stumpf
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "mem_copy.h"
+
+// the routines access every buffer as doublewords
+typedef uint64_t __attribute__((__may_alias__)) dword_t;
+
+// The pipeline stalls one cycle if a loaded value is used by the next
+// instruction. The unrolled loops therefore issue all loads of a block
+// before the first store, so every store finds its value already loaded.
+
+void mem_copy64(uint64_t *dst, const uint64_t *src, uint64_t count){
+	dword_t *d = (dword_t*)dst;
+	const dword_t *s = (const dword_t*)src;
+
+	while(count >= 4){
+		const uint64_t w0 = s[0];
+		const uint64_t w1 = s[1];
+		const uint64_t w2 = s[2];
+		const uint64_t w3 = s[3];
+		d[0] = w0;
+		d[1] = w1;
+		d[2] = w2;
+		d[3] = w3;
+		s += 4;
+		d += 4;
+		count -= 4;
+	}
+	while(count != 0){
+		*d++ = *s++;
+		--count;
+	}
+}
+
+void mem_fill64(uint64_t *dst, uint64_t pattern, uint64_t count){
+	dword_t *d = (dword_t*)dst;
+
+	while(count >= 4){
+		d[0] = pattern;
+		d[1] = pattern;
+		d[2] = pattern;
+		d[3] = pattern;
+		d += 4;
+		count -= 4;
+	}
+	while(count != 0){
+		*d++ = pattern;
+		--count;
+	}
+}
+
+// copy <count> doublewords to an aligned destination from a source that is
+// <offset> (1..7) bytes past the aligned doubleword <s>
+static void copy64_shifted(dword_t *d, const dword_t *s, unsigned int offset, uint64_t count){
+	const unsigned int shift_lo = offset * 8;
+	const unsigned int shift_hi = 64 - shift_lo;
+	uint64_t prev = s[0];
+
+	while(count >= 4){
+		const uint64_t w1 = s[1];
+		const uint64_t w2 = s[2];
+		const uint64_t w3 = s[3];
+		const uint64_t w4 = s[4];
+		d[0] = (prev >> shift_lo) | (w1 << shift_hi);
+		d[1] = (w1   >> shift_lo) | (w2 << shift_hi);
+		d[2] = (w2   >> shift_lo) | (w3 << shift_hi);
+		d[3] = (w3   >> shift_lo) | (w4 << shift_hi);
+		prev = w4;
+		s += 4;
+		d += 4;
+		count -= 4;
+	}
+	while(count != 0){
+		const uint64_t next = s[1];
+		*d++ = (prev >> shift_lo) | (next << shift_hi);
+		prev = next;
+		++s;
+		--count;
+	}
+}
+
+// returns <count> (1..8) bytes starting at <addr> in the low bytes, the
+// second doubleword is only read if the bytes actually reach into it
+static inline uint64_t load_bytes(uintptr_t addr, unsigned int count){
+	const dword_t *s = (const dword_t*)(addr & ~(uintptr_t)0x7);
+	const unsigned int offset = addr & 0x7;
+	uint64_t value = s[0] >> (offset * 8);
+	if(offset != 0 && offset + count > 8){
+		value |= s[1] << ((8 - offset) * 8);
+	}
+	return value;
+}
+
+// writes the low <count> bytes of <value> to <addr>, which must not cross a
+// doubleword boundary
+static inline void store_bytes(uintptr_t addr, unsigned int count, uint64_t value){
+	dword_t *d = (dword_t*)(addr & ~(uintptr_t)0x7);
+	const unsigned int shift = (addr & 0x7) * 8;
+	const uint64_t mask = ((count == 8) ? ~(uint64_t)0 : (((uint64_t)1 << (count * 8)) - 1)) << shift;
+	*d = (*d & ~mask) | ((value << shift) & mask);
+}
+
+void *mem_copy(void *dst, const void *src, uint64_t length){
+	uintptr_t d = (uintptr_t)dst;
+	uintptr_t s = (uintptr_t)src;
+
+	// align the destination
+	uint64_t head = (8 - (d & 0x7)) & 0x7;
+	if(head > length){
+		head = length;
+	}
+	if(head != 0){
+		store_bytes(d, head, load_bytes(s, head));
+		d += head;
+		s += head;
+		length -= head;
+	}
+
+	const uint64_t count = length >> 3;
+	if(count != 0){
+		if((s & 0x7) == 0){
+			mem_copy64((uint64_t*)d, (const uint64_t*)s, count);
+		}else{
+			copy64_shifted((dword_t*)d, (const dword_t*)(s & ~(uintptr_t)0x7), s & 0x7, count);
+		}
+		d += count << 3;
+		s += count << 3;
+		length &= 0x7;
+	}
+
+	if(length != 0){
+		store_bytes(d, length, load_bytes(s, length));
+	}
+	return dst;
+}
+
+void *mem_fill(void *dst, uint8_t value, uint64_t length){
+	uintptr_t d = (uintptr_t)dst;
+
+	// replicate the byte without a multiplication, there is no multiplier
+	uint64_t pattern = value;
+	pattern |= pattern << 8;
+	pattern |= pattern << 16;
+	pattern |= pattern << 32;
+
+	uint64_t head = (8 - (d & 0x7)) & 0x7;
+	if(head > length){
+		head = length;
+	}
+	if(head != 0){
+		store_bytes(d, head, pattern);
+		d += head;
+		length -= head;
+	}
+
+	const uint64_t count = length >> 3;
+	if(count != 0){
+		mem_fill64((uint64_t*)d, pattern, count);
+		d += count << 3;
+		length &= 0x7;
+	}
+
+	if(length != 0){
+		store_bytes(d, length, pattern);
+	}
+	return dst;
+}
+
+void mem_expand_int8(volatile int32_t *dst, const int8_t *src, uint64_t count){
+	uintptr_t s = (uintptr_t)src;
+
+	while(count != 0){
+		// consume up to the end of the current source doubleword
+		unsigned int n = 8 - (s & 0x7);
+		if(n > count){
+			n = count;
+		}
+		uint64_t bytes = load_bytes(s, n);
+		s += n;
+		count -= n;
+		for(; n != 0; --n){
+			*dst++ = (int32_t)(int8_t)(bytes & 0xFF);
+			bytes >>= 8;
+		}
+	}
+}
@@ -0,0 +1,46 @@
+// Copyright (C) 2017 Philipp Holzinger
+// Copyright (C) 2017 Martin Stumpf
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MEM_COPY_H_
+#define MEM_COPY_H_
+
+#include "stdint.h"
+
+// Copy and fill routines for the MIPS64 firmwares.
+//
+// The cores have no byte or halfword memory accesses, these are emulated in
+// the reserved instruction exception handler. All routines below therefore
+// only use aligned doubleword loads and stores. A partial doubleword at the
+// head or tail is written with a read-modify-write of the whole doubleword,
+// so they must not be used on registers with side effects.
+
+// copy <count> doublewords, both pointers have to be doubleword aligned
+void mem_copy64(uint64_t *dst, const uint64_t *src, uint64_t count);
+
+// fill <count> doublewords with <pattern>, dst has to be doubleword aligned
+void mem_fill64(uint64_t *dst, uint64_t pattern, uint64_t count);
+
+// copy <length> bytes with arbitrary alignment of source and destination
+void *mem_copy(void *dst, const void *src, uint64_t length);
+
+// fill <length> bytes with <value> with arbitrary alignment of dst
+void *mem_fill(void *dst, uint8_t value, uint64_t length);
+
+// sign extend <count> bytes to words, e.g. filter masks for the accelerators;
+// the destination is written with word stores only, so it may be a register file
+void mem_expand_int8(volatile int32_t *dst, const int8_t *src, uint64_t count);
+
+#endif
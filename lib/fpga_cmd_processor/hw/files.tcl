@@ -21,6 +21,7 @@ add_files "fpga_cmd_processor_top.vhd"
 
 add_files "memory_controller/memory_controller_fcp.vhd"
 add_files "memory_controller/external_memory_interface_fcp.vhd"
+add_files "memory_controller/copy_engine_fcp.vhd"
 
 add_files "${mips64_dir}/branching_unit_64.vhd"
 add_files "${mips64_dir}/asip_alu/asip_alu_64.vhd"
@@ -45,6 +46,7 @@ add_files "${mips64_dir}/instruction_decode_64.vhd"
 
 add_files "${common_dir}/axi_lite/axi_lite_master.vhd"
 add_files "${common_dir}/interrupts/interrupt_demux.vhd"
+add_files "${common_dir}/mem_router/instruction_cache.vhd"
 add_files "${common_dir}/mem_router/mem_router.vhd"
 add_files "${common_dir}/mem_router/singleclock_bram.vhd"
 add_files "${common_dir}/mem_router/bram_sp.vhd"
@@ -53,6 +53,10 @@ entity fpga_cmd_processor_top is
 	C_DATA_AXI_DATA_WIDTH		: integer		:= 64;
 	C_CPU_HALT_NUM_ADDR		: std_logic_vector	:= x"0002000000000000";
 	C_IRQ_SND_NUM_ADDR		: std_logic_vector	:= x"0002000000000008";
+	C_COPY_SRC_ADDR			: std_logic_vector	:= x"0002000000000010";
+	C_COPY_DST_ADDR			: std_logic_vector	:= x"0002000000000018";
+	C_COPY_LEN_ADDR			: std_logic_vector	:= x"0002000000000020";
+	C_COPY_CTRL_ADDR		: std_logic_vector	:= x"0002000000000028";
     	C_IMEM_LOW_ADDR       		: std_logic_vector	:= x"0003000000000000";
         C_IMEM_INIT_FILE    		: string 		:= "";
     	C_DMEM_LOW_ADDR       		: std_logic_vector 	:= x"0003000002000000";
@@ -226,6 +230,10 @@ component memory_controller_fcp is
 		C_DATA_AXI_DATA_WIDTH			: integer		:= 64;
 		C_CPU_HALT_NUM_ADDR			: std_logic_vector	:= x"0002000000000000";
 		C_IRQ_SND_NUM_ADDR			: std_logic_vector	:= x"0002000000000008";
+		C_COPY_SRC_ADDR				: std_logic_vector	:= x"0002000000000010";
+		C_COPY_DST_ADDR				: std_logic_vector	:= x"0002000000000018";
+		C_COPY_LEN_ADDR				: std_logic_vector	:= x"0002000000000020";
+		C_COPY_CTRL_ADDR			: std_logic_vector	:= x"0002000000000028";
     		C_IMEM_LOW_ADDR       			: std_logic_vector	:= x"0003000000000000";
     		C_IMEM_BRAM_SIZE       			: integer 		:= 16348;
 		C_IMEM_INIT_FILE    			: string 		:= "";
@@ -497,6 +505,10 @@ inst_memory_controller: memory_controller_fcp
 	C_DATA_AXI_DATA_WIDTH	=> C_DATA_AXI_DATA_WIDTH,
 	C_CPU_HALT_NUM_ADDR	=> C_CPU_HALT_NUM_ADDR,
 	C_IRQ_SND_NUM_ADDR	=> C_IRQ_SND_NUM_ADDR,
+	C_COPY_SRC_ADDR		=> C_COPY_SRC_ADDR,
+	C_COPY_DST_ADDR		=> C_COPY_DST_ADDR,
+	C_COPY_LEN_ADDR		=> C_COPY_LEN_ADDR,
+	C_COPY_CTRL_ADDR	=> C_COPY_CTRL_ADDR,
     	C_IMEM_LOW_ADDR         => C_IMEM_LOW_ADDR, 
     	C_IMEM_BRAM_SIZE      	=> G_MEM_NUM_4K_INSTR_MEMS*4096,
         C_IMEM_INIT_FILE        => C_IMEM_INIT_FILE,
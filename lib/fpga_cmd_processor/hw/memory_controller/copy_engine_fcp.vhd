@@ -0,0 +1,294 @@
+-- Copyright (C) 2017 Philipp Holzinger
+-- Copyright (C) 2017 Martin Stumpf
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+-- Doubleword copy engine of the fpga command processor. It sits between
+-- mem_router and the external memory interface and copies between the local
+-- data memory and the AXI buses in any combination.
+--
+-- Registers (64 bit):
+--   C_COPY_SRC_ADDR	source address, advances while copying
+--   C_COPY_DST_ADDR	destination address, advances while copying
+--   C_COPY_LEN_ADDR	length in bytes, only whole doublewords are copied
+--			and the remainder (< 8) is left in the register
+--   C_COPY_CTRL_ADDR	write: start the copy
+--			read:  stalls until the engine is idle, then returns
+--			       bit 0 = last copy was aborted by a bus error
+--
+-- While a copy runs, every CPU access to the memory controller is stalled.
+-- The local data memory is accessed through the side port of mem_router,
+-- which is only granted while the CPU is stalled on the memory controller,
+-- so reading the control register is what lets local copies make progress.
+entity copy_engine_fcp is
+    generic(
+		C_CPU_DATA_WIDTH			: integer		:= 64;
+		C_CPU_ADDR_WIDTH			: integer		:= 64;
+    		C_DMEM_LOW_ADDR       			: std_logic_vector 	:= x"0003000002000000";
+    		C_DMEM_BRAM_SIZE       			: integer 		:= 16348;
+		C_COPY_SRC_ADDR				: std_logic_vector	:= x"0002000000000010";
+		C_COPY_DST_ADDR				: std_logic_vector	:= x"0002000000000018";
+		C_COPY_LEN_ADDR				: std_logic_vector	:= x"0002000000000020";
+		C_COPY_CTRL_ADDR			: std_logic_vector	:= x"0002000000000028"
+    );
+    port(
+        clk                     : in    std_logic;
+        rstn                    : in    std_logic;
+
+	-- from mem_router
+        cpu_addr                : in    std_logic_vector(C_CPU_ADDR_WIDTH-1 downto 0);
+        cpu_din                 : in    std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+        cpu_we                  : in    std_logic;
+        cpu_re                  : in    std_logic;
+        cpu_dout                : out   std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	cpu_read_busy           : out   std_logic;
+        cpu_write_busy          : out   std_logic;
+        cpu_address_error_exc_load  : out std_logic;
+        cpu_address_error_exc_store : out std_logic;
+        cpu_data_bus_exc            : out std_logic;
+
+	-- to external memory interface
+        mem_addr                : out   std_logic_vector(C_CPU_ADDR_WIDTH-1 downto 0);
+        mem_dout                : out   std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+        mem_we                  : out   std_logic;
+        mem_re                  : out   std_logic;
+        mem_din                 : in    std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	mem_read_busy           : in    std_logic;
+        mem_write_busy          : in    std_logic;
+        mem_address_error_exc_load  : in std_logic;
+        mem_address_error_exc_store : in std_logic;
+        mem_data_bus_exc            : in std_logic;
+
+	-- side port of the local data memory
+	dmem_en			: out   std_logic;
+	dmem_we			: out   std_logic;
+	dmem_addr		: out   std_logic_vector(C_CPU_ADDR_WIDTH-1 downto 0);
+	dmem_dout		: out   std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	dmem_din		: in    std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	dmem_grant		: in    std_logic
+    );
+end entity;
+
+architecture behav of copy_engine_fcp is
+
+-- requested register
+    type reg_location is (FORWARD,COPY_SRC,COPY_DST,COPY_LEN,COPY_CTRL);
+    signal access_location : reg_location;
+    signal access_location_delayed : reg_location;
+
+-- copy state
+    type copy_state is (IDLE,READ,READ_DATA,WRITE);
+    signal state : copy_state;
+
+    signal r_src	: unsigned(C_CPU_ADDR_WIDTH-1 downto 0);
+    signal r_dst	: unsigned(C_CPU_ADDR_WIDTH-1 downto 0);
+    signal r_len	: unsigned(C_CPU_DATA_WIDTH-1 downto 0);
+    signal r_buffer	: std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+    signal r_error	: std_logic;
+    signal r_reg_dout	: std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+
+    signal s_src_local	: std_logic;
+    signal s_dst_local	: std_logic;
+    signal s_mem_exc	: std_logic;
+
+begin
+
+s_src_local <= '1' when r_src >= unsigned(C_DMEM_LOW_ADDR) and r_src < (unsigned(C_DMEM_LOW_ADDR) + to_unsigned(C_DMEM_BRAM_SIZE, C_CPU_ADDR_WIDTH)) else '0';
+s_dst_local <= '1' when r_dst >= unsigned(C_DMEM_LOW_ADDR) and r_dst < (unsigned(C_DMEM_LOW_ADDR) + to_unsigned(C_DMEM_BRAM_SIZE, C_CPU_ADDR_WIDTH)) else '0';
+s_mem_exc   <= mem_data_bus_exc or mem_address_error_exc_load or mem_address_error_exc_store;
+
+address_check: process(cpu_addr)
+begin
+	if(cpu_addr = C_COPY_SRC_ADDR) then
+		access_location <= COPY_SRC;
+	elsif(cpu_addr = C_COPY_DST_ADDR) then
+		access_location <= COPY_DST;
+	elsif(cpu_addr = C_COPY_LEN_ADDR) then
+		access_location <= COPY_LEN;
+	elsif(cpu_addr = C_COPY_CTRL_ADDR) then
+		access_location <= COPY_CTRL;
+	else
+		access_location <= FORWARD;
+	end if;
+end process;
+
+distribute_data: process(state,access_location,cpu_addr,cpu_din,cpu_re,cpu_we,mem_read_busy,mem_write_busy,
+			 mem_address_error_exc_load,mem_address_error_exc_store,mem_data_bus_exc,
+			 r_src,r_dst,r_buffer,s_src_local,s_dst_local)
+begin
+	-- prevent latches
+	mem_addr	<= cpu_addr;
+	mem_dout	<= cpu_din;
+	mem_re		<= '0';
+	mem_we		<= '0';
+	dmem_en		<= '0';
+	dmem_we		<= '0';
+	dmem_addr	<= std_logic_vector(r_src);
+	dmem_dout	<= r_buffer;
+	cpu_read_busy	<= '0';
+	cpu_write_busy	<= '0';
+	cpu_address_error_exc_load  <= '0';
+	cpu_address_error_exc_store <= '0';
+	cpu_data_bus_exc            <= '0';
+
+	case state is
+		when IDLE =>
+			-- everything but the engine registers goes to the external memory interface
+			if(access_location = FORWARD) then
+				mem_re		<= cpu_re;
+				mem_we		<= cpu_we;
+				cpu_read_busy	<= mem_read_busy;
+				cpu_write_busy	<= mem_write_busy;
+				cpu_address_error_exc_load  <= mem_address_error_exc_load;
+				cpu_address_error_exc_store <= mem_address_error_exc_store;
+				cpu_data_bus_exc            <= mem_data_bus_exc;
+			end if;
+		when READ =>
+			if(s_src_local = '1') then
+				dmem_en		<= '1';
+				dmem_addr	<= std_logic_vector(r_src);
+			else
+				mem_addr	<= std_logic_vector(r_src);
+				mem_re		<= '1';
+			end if;
+		when READ_DATA =>
+			-- keep the address, the interface selects its output with it
+			mem_addr <= std_logic_vector(r_src);
+		when WRITE =>
+			if(s_dst_local = '1') then
+				dmem_en		<= '1';
+				dmem_we		<= '1';
+				dmem_addr	<= std_logic_vector(r_dst);
+				dmem_dout	<= r_buffer;
+			else
+				mem_addr	<= std_logic_vector(r_dst);
+				mem_dout	<= r_buffer;
+				mem_we		<= '1';
+			end if;
+		when others =>
+	end case;
+
+	-- the CPU waits until the copy has finished
+	if(state /= IDLE) then
+		cpu_read_busy	<= cpu_re;
+		cpu_write_busy	<= cpu_we;
+	end if;
+end process;
+
+collect_data: process(access_location_delayed,mem_din,r_reg_dout)
+begin
+	if(access_location_delayed = FORWARD) then
+		cpu_dout <= mem_din;
+	else
+		cpu_dout <= r_reg_dout;
+	end if;
+end process;
+
+manage_copy: process(clk)
+begin
+	if(rising_edge(clk)) then
+		if(rstn='0') then
+			state		<= IDLE;
+			r_src		<= (others => '0');
+			r_dst		<= (others => '0');
+			r_len		<= (others => '0');
+			r_buffer	<= (others => '0');
+			r_error		<= '0';
+		else
+			case state is
+				when IDLE =>
+					if(cpu_we = '1') then
+						case access_location is
+							when COPY_SRC =>
+								r_src <= resize(unsigned(cpu_din),r_src'length);
+							when COPY_DST =>
+								r_dst <= resize(unsigned(cpu_din),r_dst'length);
+							when COPY_LEN =>
+								r_len <= unsigned(cpu_din);
+							when COPY_CTRL =>
+								r_error <= '0';
+								if(r_len >= 8) then
+									state <= READ;
+								end if;
+							when others =>
+						end case;
+					end if;
+				when READ =>
+					if(s_src_local = '1') then
+						if(dmem_grant = '1') then
+							state <= READ_DATA;
+						end if;
+					elsif(s_mem_exc = '1') then
+						r_error <= '1';
+						state <= IDLE;
+					elsif(mem_read_busy = '0') then
+						state <= READ_DATA;
+					end if;
+				when READ_DATA =>
+					if(s_src_local = '1') then
+						r_buffer <= dmem_din;
+					else
+						r_buffer <= mem_din;
+					end if;
+					state <= WRITE;
+				when WRITE =>
+					if(s_dst_local = '0' and s_mem_exc = '1') then
+						r_error <= '1';
+						state <= IDLE;
+					elsif((s_dst_local = '1' and dmem_grant = '1') or (s_dst_local = '0' and mem_write_busy = '0')) then
+						r_src <= r_src + 8;
+						r_dst <= r_dst + 8;
+						r_len <= r_len - 8;
+						if(r_len < 16) then
+							state <= IDLE;
+						else
+							state <= READ;
+						end if;
+					end if;
+				when others =>
+					state <= IDLE;
+			end case;
+		end if;
+	end if;
+end process;
+
+register_output: process(clk)
+begin
+	if(rising_edge(clk)) then
+		if(rstn='0') then
+			r_reg_dout <= (others => '0');
+			access_location_delayed <= FORWARD;
+		else
+			access_location_delayed <= access_location;
+			case access_location is
+				when COPY_SRC =>
+					r_reg_dout <= std_logic_vector(resize(r_src,r_reg_dout'length));
+				when COPY_DST =>
+					r_reg_dout <= std_logic_vector(resize(r_dst,r_reg_dout'length));
+				when COPY_LEN =>
+					r_reg_dout <= std_logic_vector(r_len);
+				when COPY_CTRL =>
+					r_reg_dout <= (0 => r_error, others => '0');
+				when others =>
+					r_reg_dout <= (others => '0');
+			end case;
+		end if;
+	end if;
+end process;
+
+end architecture;
@@ -33,6 +33,10 @@ entity memory_controller_fcp is
 		C_DATA_AXI_DATA_WIDTH			: integer		:= 64;
 		C_CPU_HALT_NUM_ADDR			: std_logic_vector	:= x"0002000000000000";
 		C_IRQ_SND_NUM_ADDR			: std_logic_vector	:= x"0002000000000008";
+		C_COPY_SRC_ADDR				: std_logic_vector	:= x"0002000000000010";
+		C_COPY_DST_ADDR				: std_logic_vector	:= x"0002000000000018";
+		C_COPY_LEN_ADDR				: std_logic_vector	:= x"0002000000000020";
+		C_COPY_CTRL_ADDR			: std_logic_vector	:= x"0002000000000028";
     		C_IMEM_LOW_ADDR       			: std_logic_vector	:= x"0003000000000000";
     		C_IMEM_BRAM_SIZE       			: integer 		:= 16348;
 		C_IMEM_INIT_FILE  			: string 		:= "";
@@ -217,6 +221,52 @@ component external_memory_interface_fcp is
     );
 end component external_memory_interface_fcp;
 
+component copy_engine_fcp is
+    generic(
+		C_CPU_DATA_WIDTH			: integer		:= 64;
+		C_CPU_ADDR_WIDTH			: integer		:= 64;
+    		C_DMEM_LOW_ADDR       			: std_logic_vector 	:= x"0003000002000000";
+    		C_DMEM_BRAM_SIZE       			: integer 		:= 16348;
+		C_COPY_SRC_ADDR				: std_logic_vector	:= x"0002000000000010";
+		C_COPY_DST_ADDR				: std_logic_vector	:= x"0002000000000018";
+		C_COPY_LEN_ADDR				: std_logic_vector	:= x"0002000000000020";
+		C_COPY_CTRL_ADDR			: std_logic_vector	:= x"0002000000000028"
+    );
+    port(
+        clk                     : in    std_logic;
+        rstn                    : in    std_logic;
+	-- from mem_router
+        cpu_addr                : in    std_logic_vector(C_CPU_ADDR_WIDTH-1 downto 0);
+        cpu_din                 : in    std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+        cpu_we                  : in    std_logic;
+        cpu_re                  : in    std_logic;
+        cpu_dout                : out   std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	cpu_read_busy           : out   std_logic;
+        cpu_write_busy          : out   std_logic;
+        cpu_address_error_exc_load  : out std_logic;
+        cpu_address_error_exc_store : out std_logic;
+        cpu_data_bus_exc            : out std_logic;
+	-- to external memory interface
+        mem_addr                : out   std_logic_vector(C_CPU_ADDR_WIDTH-1 downto 0);
+        mem_dout                : out   std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+        mem_we                  : out   std_logic;
+        mem_re                  : out   std_logic;
+        mem_din                 : in    std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	mem_read_busy           : in    std_logic;
+        mem_write_busy          : in    std_logic;
+        mem_address_error_exc_load  : in std_logic;
+        mem_address_error_exc_store : in std_logic;
+        mem_data_bus_exc            : in std_logic;
+	-- side port of the local data memory
+	dmem_en			: out   std_logic;
+	dmem_we			: out   std_logic;
+	dmem_addr		: out   std_logic_vector(C_CPU_ADDR_WIDTH-1 downto 0);
+	dmem_dout		: out   std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	dmem_din		: in    std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	dmem_grant		: in    std_logic
+    );
+end component copy_engine_fcp;
+
 component mem_router is
 Generic(
     ADDR_SIZE       : integer := 32;
@@ -264,7 +314,14 @@ Port (
     memctrl_write_busy                  : in    std_logic;
     memctrl_address_error_exc_load      : in    std_logic;
     memctrl_address_error_exc_store     : in    std_logic;
-    memctrl_data_bus_exc                : in    std_logic
+    memctrl_data_bus_exc                : in    std_logic;
+    -- side port of the data memory
+    dmem_ext_en                         : in    std_logic := '0';
+    dmem_ext_we                         : in    std_logic := '0';
+    dmem_ext_addr                       : in    std_logic_vector(ADDR_SIZE - 1 downto 0) := (others => '0');
+    dmem_ext_din                        : in    std_logic_vector(DMEM_WIDTH - 1 downto 0) := (others => '0');
+    dmem_ext_dout                       : out   std_logic_vector(DMEM_WIDTH - 1 downto 0);
+    dmem_ext_grant                      : out   std_logic
 );
 end component mem_router;
 
@@ -279,6 +336,24 @@ end component mem_router;
 	signal s_forward_address_error_exc_store     : std_logic;
 	signal s_forward_data_bus_exc                : std_logic;
 
+	signal s_extmem_addr                         : std_logic_vector(C_CPU_ADDR_WIDTH-1 downto 0);
+	signal s_extmem_din                          : std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	signal s_extmem_dout                         : std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	signal s_extmem_re                           : std_logic;
+	signal s_extmem_we                           : std_logic;
+	signal s_extmem_read_busy                    : std_logic;
+	signal s_extmem_write_busy                   : std_logic;
+	signal s_extmem_address_error_exc_load       : std_logic;
+	signal s_extmem_address_error_exc_store      : std_logic;
+	signal s_extmem_data_bus_exc                 : std_logic;
+
+	signal s_dmem_ext_en                         : std_logic;
+	signal s_dmem_ext_we                         : std_logic;
+	signal s_dmem_ext_addr                       : std_logic_vector(C_CPU_ADDR_WIDTH-1 downto 0);
+	signal s_dmem_ext_din                        : std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	signal s_dmem_ext_dout                       : std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	signal s_dmem_ext_grant                      : std_logic;
+
 begin
 
 external_memory_interface_inst: external_memory_interface_fcp
@@ -301,18 +376,18 @@ external_memory_interface_inst: external_memory_interface_fcp
         rstn                    => rstn,
         halt                    => halt,
 
-        data_addr               => s_forward_addr,
-        data_din                => s_forward_din,
-        data_we                 => s_forward_we,
-        data_re                 => s_forward_re,
-        data_dout               => s_forward_dout, 
-	data_read_busy          => s_forward_read_busy,
-        data_write_busy         => s_forward_write_busy,
+        data_addr               => s_extmem_addr,
+        data_din                => s_extmem_din,
+        data_we                 => s_extmem_we,
+        data_re                 => s_extmem_re,
+        data_dout               => s_extmem_dout, 
+	data_read_busy          => s_extmem_read_busy,
+        data_write_busy         => s_extmem_write_busy,
         
 	-- exceptions
-        address_error_exc_load  => s_forward_address_error_exc_load,
-        address_error_exc_store => s_forward_address_error_exc_store,
-        data_bus_exc            => s_forward_data_bus_exc,
+        address_error_exc_load  => s_extmem_address_error_exc_load,
+        address_error_exc_store => s_extmem_address_error_exc_store,
+        data_bus_exc            => s_extmem_data_bus_exc,
     	
 	-- to interrupt controller
 	SND_INT_NUM			=> SND_INT_NUM,
@@ -371,6 +446,51 @@ external_memory_interface_inst: external_memory_interface_fcp
 	data_axi_rready	=> data_axi_rready
     );
 
+copy_engine_inst: copy_engine_fcp
+    generic map(
+		C_CPU_DATA_WIDTH	=> C_CPU_DATA_WIDTH,
+		C_CPU_ADDR_WIDTH	=> C_CPU_ADDR_WIDTH,
+		C_DMEM_LOW_ADDR		=> C_DMEM_LOW_ADDR,
+		C_DMEM_BRAM_SIZE	=> C_DMEM_BRAM_SIZE,
+		C_COPY_SRC_ADDR		=> C_COPY_SRC_ADDR,
+		C_COPY_DST_ADDR		=> C_COPY_DST_ADDR,
+		C_COPY_LEN_ADDR		=> C_COPY_LEN_ADDR,
+		C_COPY_CTRL_ADDR	=> C_COPY_CTRL_ADDR
+    )
+    port map(
+        clk                     => clk,
+        rstn                    => rstn,
+	-- from mem_router
+        cpu_addr                => s_forward_addr,
+        cpu_din                 => s_forward_din,
+        cpu_we                  => s_forward_we,
+        cpu_re                  => s_forward_re,
+        cpu_dout                => s_forward_dout,
+	cpu_read_busy           => s_forward_read_busy,
+        cpu_write_busy          => s_forward_write_busy,
+        cpu_address_error_exc_load  => s_forward_address_error_exc_load,
+        cpu_address_error_exc_store => s_forward_address_error_exc_store,
+        cpu_data_bus_exc            => s_forward_data_bus_exc,
+	-- to external memory interface
+        mem_addr                => s_extmem_addr,
+        mem_dout                => s_extmem_din,
+        mem_we                  => s_extmem_we,
+        mem_re                  => s_extmem_re,
+        mem_din                 => s_extmem_dout,
+	mem_read_busy           => s_extmem_read_busy,
+        mem_write_busy          => s_extmem_write_busy,
+        mem_address_error_exc_load  => s_extmem_address_error_exc_load,
+        mem_address_error_exc_store => s_extmem_address_error_exc_store,
+        mem_data_bus_exc            => s_extmem_data_bus_exc,
+	-- side port of the local data memory
+	dmem_en			=> s_dmem_ext_en,
+	dmem_we			=> s_dmem_ext_we,
+	dmem_addr		=> s_dmem_ext_addr,
+	dmem_dout		=> s_dmem_ext_din,
+	dmem_din		=> s_dmem_ext_dout,
+	dmem_grant		=> s_dmem_ext_grant
+    );
+
 mem_router_inst: mem_router
 generic map(
     ADDR_SIZE       	=> C_CPU_ADDR_WIDTH,
@@ -418,7 +538,14 @@ port map(
     memctrl_write_busy                  => s_forward_write_busy,
     memctrl_address_error_exc_load      => s_forward_address_error_exc_load,
     memctrl_address_error_exc_store     => s_forward_address_error_exc_store,
-    memctrl_data_bus_exc                => s_forward_data_bus_exc
+    memctrl_data_bus_exc                => s_forward_data_bus_exc,
+    -- side port of the data memory
+    dmem_ext_en                         => s_dmem_ext_en,
+    dmem_ext_we                         => s_dmem_ext_we,
+    dmem_ext_addr                       => s_dmem_ext_addr,
+    dmem_ext_din                        => s_dmem_ext_din,
+    dmem_ext_dout                       => s_dmem_ext_dout,
+    dmem_ext_grant                      => s_dmem_ext_grant
 );
 
 end architecture;
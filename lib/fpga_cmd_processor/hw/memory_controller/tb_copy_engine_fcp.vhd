@@ -0,0 +1,320 @@
+-- Copyright (C) 2017 Philipp Holzinger
+-- Copyright (C) 2017 Martin Stumpf
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+library ieee;
+use IEEE.std_logic_1164.all;
+use IEEE.numeric_std.all;
+
+-- copy_engine_fcp behind mem_router, the testbench takes the place of the
+-- MIPS data port and of the external memory interface
+entity tb_copy_engine_fcp IS
+end tb_copy_engine_fcp;
+
+architecture behav of tb_copy_engine_fcp is
+
+constant DMEM_ADDR: std_logic_vector(63 downto 0) := x"0003000002000000";
+constant EXT_ADDR: std_logic_vector(63 downto 0) := x"0001000000000000";
+constant COPY_SRC_ADDR: std_logic_vector(63 downto 0) := x"0002000000000010";
+constant COPY_DST_ADDR: std_logic_vector(63 downto 0) := x"0002000000000018";
+constant COPY_LEN_ADDR: std_logic_vector(63 downto 0) := x"0002000000000020";
+constant COPY_CTRL_ADDR: std_logic_vector(63 downto 0) := x"0002000000000028";
+constant EXT_LATENCY: integer := 4;
+constant EXT_WORDS: integer := 64;
+
+signal clock: std_logic;
+signal reset: std_logic;
+
+-- MIPS data port
+signal data_addr: std_logic_vector(63 downto 0);
+signal data_re: std_logic;
+signal data_we: std_logic;
+signal data_din: std_logic_vector(63 downto 0);
+signal data_dout: std_logic_vector(63 downto 0);
+signal data_read_busy: std_logic;
+signal data_write_busy: std_logic;
+
+-- mem_router to copy engine
+signal memctrl_addr: std_logic_vector(63 downto 0);
+signal memctrl_din: std_logic_vector(63 downto 0);
+signal memctrl_dout: std_logic_vector(63 downto 0);
+signal memctrl_re: std_logic;
+signal memctrl_we: std_logic;
+signal memctrl_read_busy: std_logic;
+signal memctrl_write_busy: std_logic;
+signal memctrl_exc_load: std_logic;
+signal memctrl_exc_store: std_logic;
+signal memctrl_bus_exc: std_logic;
+
+-- data memory side port
+signal dmem_en: std_logic;
+signal dmem_we: std_logic;
+signal dmem_addr: std_logic_vector(63 downto 0);
+signal dmem_din: std_logic_vector(63 downto 0);
+signal dmem_dout: std_logic_vector(63 downto 0);
+signal dmem_grant: std_logic;
+
+-- copy engine to external memory model
+signal mem_addr: std_logic_vector(63 downto 0);
+signal mem_dout: std_logic_vector(63 downto 0);
+signal mem_we: std_logic;
+signal mem_re: std_logic;
+signal mem_din: std_logic_vector(63 downto 0);
+signal mem_read_busy: std_logic;
+signal mem_write_busy: std_logic;
+
+-- external memory model
+type ext_array is array (0 to EXT_WORDS-1) of std_logic_vector(63 downto 0);
+signal ext_mem: ext_array;
+signal ext_count: integer;
+signal ext_done: std_logic;
+signal ext_writes: integer;
+
+function pattern(i: integer) return std_logic_vector is
+begin
+	return std_logic_vector(to_unsigned(16#1111# * (i+1), 32)) & std_logic_vector(to_unsigned(i, 32));
+end function;
+
+begin
+
+router: entity work.mem_router
+generic map(
+	ADDR_SIZE => 64,
+	IMEM_ADDR => x"0003000000000000",
+	IMEM_SIZE => 16#1000#,
+	IMEM_WIDTH => 32,
+	DMEM_ADDR => DMEM_ADDR,
+	DMEM_SIZE => 16#1000#,
+	DMEM_WIDTH => 64
+)
+port map(
+	clk => clock,
+	resetn => reset,
+	halt => '0',
+	mips_inst_addr => x"0003000000000000",
+	mips_inst_re => '0',
+	mips_inst_dout => open,
+	mips_data_addr => data_addr,
+	mips_data_re => data_re,
+	mips_data_we => data_we,
+	mips_data_din => data_din,
+	mips_data_dout => data_dout,
+	mips_inst_read_busy => open,
+	mips_data_read_busy => data_read_busy,
+	mips_data_write_busy => data_write_busy,
+	mips_address_error_exc_load => open,
+	mips_address_error_exc_fetch => open,
+	mips_address_error_exc_store => open,
+	mips_instruction_bus_exc => open,
+	mips_data_bus_exc => open,
+	memctrl_addr => memctrl_addr,
+	memctrl_din => memctrl_din,
+	memctrl_dout => memctrl_dout,
+	memctrl_re => memctrl_re,
+	memctrl_we => memctrl_we,
+	memctrl_read_busy => memctrl_read_busy,
+	memctrl_write_busy => memctrl_write_busy,
+	memctrl_address_error_exc_load => memctrl_exc_load,
+	memctrl_address_error_exc_store => memctrl_exc_store,
+	memctrl_data_bus_exc => memctrl_bus_exc,
+	dmem_ext_en => dmem_en,
+	dmem_ext_we => dmem_we,
+	dmem_ext_addr => dmem_addr,
+	dmem_ext_din => dmem_dout,
+	dmem_ext_dout => dmem_din,
+	dmem_ext_grant => dmem_grant
+);
+
+uut: entity work.copy_engine_fcp
+generic map(
+	C_CPU_DATA_WIDTH => 64,
+	C_CPU_ADDR_WIDTH => 64,
+	C_DMEM_LOW_ADDR => DMEM_ADDR,
+	C_DMEM_BRAM_SIZE => 16#1000#,
+	C_COPY_SRC_ADDR => COPY_SRC_ADDR,
+	C_COPY_DST_ADDR => COPY_DST_ADDR,
+	C_COPY_LEN_ADDR => COPY_LEN_ADDR,
+	C_COPY_CTRL_ADDR => COPY_CTRL_ADDR
+)
+port map(
+	clk => clock,
+	rstn => reset,
+	cpu_addr => memctrl_addr,
+	cpu_din => memctrl_dout,
+	cpu_we => memctrl_we,
+	cpu_re => memctrl_re,
+	cpu_dout => memctrl_din,
+	cpu_read_busy => memctrl_read_busy,
+	cpu_write_busy => memctrl_write_busy,
+	cpu_address_error_exc_load => memctrl_exc_load,
+	cpu_address_error_exc_store => memctrl_exc_store,
+	cpu_data_bus_exc => memctrl_bus_exc,
+	mem_addr => mem_addr,
+	mem_dout => mem_dout,
+	mem_we => mem_we,
+	mem_re => mem_re,
+	mem_din => mem_din,
+	mem_read_busy => mem_read_busy,
+	mem_write_busy => mem_write_busy,
+	mem_address_error_exc_load => '0',
+	mem_address_error_exc_store => '0',
+	mem_data_bus_exc => '0',
+	dmem_en => dmem_en,
+	dmem_we => dmem_we,
+	dmem_addr => dmem_addr,
+	dmem_dout => dmem_dout,
+	dmem_din => dmem_din,
+	dmem_grant => dmem_grant
+);
+
+-- external memory with the handshake of external_memory_interface_fcp:
+-- busy while a request is pending, read data valid from the cycle after
+mem_read_busy <= mem_re and not ext_done;
+mem_write_busy <= mem_we and not ext_done;
+
+ext_memory: process(clock)
+variable index: integer;
+begin
+if(rising_edge(clock)) then
+if(reset='0') then
+	ext_mem <= (others => (others => '0'));
+	ext_count <= 0;
+	ext_done <= '0';
+	ext_writes <= 0;
+	mem_din <= (others => '0');
+elsif((mem_re='1' or mem_we='1') and ext_done='0') then
+	if(ext_count = EXT_LATENCY) then
+		index := to_integer(unsigned(mem_addr(15 downto 3))) mod EXT_WORDS;
+		ext_count <= 0;
+		ext_done <= '1';
+		if(mem_we='1') then
+			ext_mem(index) <= mem_dout;
+			ext_writes <= ext_writes + 1;
+		else
+			mem_din <= ext_mem(index);
+		end if;
+	else
+		ext_count <= ext_count + 1;
+	end if;
+else
+	ext_count <= 0;
+	ext_done <= '0';
+end if;
+end if;
+end process;
+
+stimuli: process
+  variable value: std_logic_vector(63 downto 0);
+  variable stalls: integer;
+
+  -- one store of the MIPS, held while the router reports busy and
+  -- released right at the edge that completes it like a pipeline register
+  procedure cpu_write(addr: std_logic_vector(63 downto 0); data: std_logic_vector(63 downto 0)) is
+  begin
+    wait until falling_edge(clock);
+    data_addr <= addr;
+    data_din <= data;
+    data_we <= '1';
+    loop
+      wait until rising_edge(clock);
+      exit when data_write_busy = '0';
+    end loop;
+    data_we <= '0';
+  end procedure;
+
+  -- one load of the MIPS, the data follows in the cycle after the last busy one
+  procedure cpu_read(addr: std_logic_vector(63 downto 0); data: out std_logic_vector(63 downto 0); cycles: out integer) is
+    variable n: integer := 0;
+  begin
+    wait until falling_edge(clock);
+    data_addr <= addr;
+    data_re <= '1';
+    loop
+      wait until rising_edge(clock);
+      exit when data_read_busy = '0';
+      n := n + 1;
+    end loop;
+    data_re <= '0';
+    wait until falling_edge(clock);
+    data := data_dout;
+    cycles := n;
+  end procedure;
+
+  function offset(base: std_logic_vector(63 downto 0); bytes: integer) return std_logic_vector is
+  begin
+    return std_logic_vector(unsigned(base) + to_unsigned(bytes, 64));
+  end function;
+begin
+  reset <= '0';
+  data_addr <= (others => '0');
+  data_din <= (others => '0');
+  data_re <= '0';
+  data_we <= '0';
+  wait for 45 ns;
+  reset <= '1';
+
+  -- source data in the local data memory
+  for i in 0 to 3 loop
+    cpu_write(offset(DMEM_ADDR, 16#100#+8*i), pattern(i));
+  end loop;
+
+  -- local data memory to AXI, 4 doublewords and a remainder of 3 bytes
+  cpu_write(COPY_SRC_ADDR, offset(DMEM_ADDR, 16#100#));
+  cpu_write(COPY_DST_ADDR, offset(EXT_ADDR, 16#40#));
+  cpu_write(COPY_LEN_ADDR, std_logic_vector(to_unsigned(4*8+3, 64)));
+  cpu_write(COPY_CTRL_ADDR, (others => '0'));
+  cpu_read(COPY_CTRL_ADDR, value, stalls);
+  assert value(0) = '0' report "dmem to AXI copy reported a bus error" severity error;
+  assert stalls > 0 report "reading the control register should stall while copying" severity error;
+  assert ext_writes = 4 report "dmem to AXI copy should write 4 doublewords" severity error;
+  for i in 0 to 3 loop
+    assert ext_mem(8+i) = pattern(i) report "doubleword " & integer'image(i) & " not copied to AXI" severity error;
+  end loop;
+  assert ext_mem(12) = x"0000000000000000" report "copy wrote past its length" severity error;
+  cpu_read(COPY_LEN_ADDR, value, stalls);
+  assert unsigned(value) = 3 report "remainder should be left in the length register" severity error;
+  cpu_read(COPY_SRC_ADDR, value, stalls);
+  assert value = offset(DMEM_ADDR, 16#120#) report "source address should advance by the copied bytes" severity error;
+
+  -- and back from AXI to another place in the local data memory
+  cpu_write(COPY_SRC_ADDR, offset(EXT_ADDR, 16#40#));
+  cpu_write(COPY_DST_ADDR, offset(DMEM_ADDR, 16#200#));
+  cpu_write(COPY_LEN_ADDR, std_logic_vector(to_unsigned(4*8, 64)));
+  cpu_write(COPY_CTRL_ADDR, (others => '0'));
+  cpu_read(COPY_CTRL_ADDR, value, stalls);
+  assert value(0) = '0' report "AXI to dmem copy reported a bus error" severity error;
+  for i in 0 to 3 loop
+    cpu_read(offset(DMEM_ADDR, 16#200#+8*i), value, stalls);
+    assert value = pattern(i) report "doubleword " & integer'image(i) & " not copied to dmem" severity error;
+  end loop;
+
+  -- everything else still reaches the external memory
+  cpu_write(offset(EXT_ADDR, 16#8#), x"0123456789ABCDEF");
+  cpu_read(offset(EXT_ADDR, 16#8#), value, stalls);
+  assert value = x"0123456789ABCDEF" report "access not forwarded to the external memory" severity error;
+
+  report "tb_copy_engine_fcp finished" severity note;
+  wait;
+end process;
+
+clock_P: process
+begin
+clock <= '0';
+wait for 10 ns;
+clock <= '1';
+wait for 10 ns;
+end process;
+
+end behav;
@@ -0,0 +1,76 @@
+#!/bin/bash
+
+# GHDL counterpart of sim_fpga_cmd_processor.do, see lib/common/sim/ghdl.sh
+#
+# usage: sim_fpga_cmd_processor.sh [-b <packets>] [-c <max cycles>] [-w] [-e]
+#
+# A packet is done when the AQL doorbell of the packet processor rings. The
+# firmware memories load instr.hex and data.hex of sw/core/vsim, see
+# CONF_IMEM_INIT_FILE of the testbench.
+
+cd $(dirname $(readlink -f $0))
+
+hsarepo=../../../..
+src=$hsarepo/lib
+mips64dir=$src/ext/mips64
+fcpdir=$src/fpga_cmd_processor/hw
+commondir=$src/common
+core_software=$src/fpga_cmd_processor/sw/core/vsim
+
+# the simulation.env file, otherwise the environment of the shell
+if [ -f $core_software/simulation.env ]; then
+	source $core_software/simulation.env
+fi
+INSTR_MEM_BLOCKS=${MIPS_NUM_TEXT_MEM_BLOCKS:-1}
+DATA_MEM_BLOCKS=${MIPS_NUM_DATA_MEM_BLOCKS:-1}
+ACCELERATOR_CORES=${MIPS_NUM_ACCELERATOR_CORES:-1}
+
+# 2 ms like the .do file, 20 ms for the memory copy benchmark
+if [ "$MIPS_MEM_COPY_BENCHMARK" == "1" ]; then
+	ghdl_default_cycles=1000000
+else
+	ghdl_default_cycles=100000
+fi
+source $commondir/sim/ghdl.sh
+ghdl_options "$@"
+
+ghdl_analyze \
+	$mips64dir/alu_pkg_64.vhd \
+	$mips64dir/asip_alu/asip_instruction_components_pkg_64.vhd \
+	$mips64dir/asip_alu/asip_alu_64.vhd \
+	$mips64dir/asip_alu/asip_decode_64.vhd \
+	$mips64dir/stage_pc_64.vhd \
+	$mips64dir/instruction_fetch_64.vhd \
+	$mips64dir/stage_if_id_64.vhd \
+	$mips64dir/branching_unit_64.vhd \
+	$mips64dir/decoder_unit_64.vhd \
+	$mips64dir/hazard_detection_unit_64.vhd \
+	$mips64dir/forwarding_unit_64.vhd \
+	$mips64dir/instruction_decode_64.vhd \
+	$mips64dir/stage_id_ex_64.vhd \
+	$mips64dir/execute_64.vhd \
+	$mips64dir/stage_ex_mem_64.vhd \
+	$mips64dir/memory_access_64.vhd \
+	$mips64dir/stage_mem_wb_64.vhd \
+	$mips64dir/write_back_64.vhd \
+	$mips64dir/coprocessor0_64.vhd \
+	$mips64dir/cpu_top_64.vhd \
+	$commondir/axi_lite/axi_lite_master.vhd \
+	$fcpdir/memory_controller/external_memory_interface_fcp.vhd \
+	$fcpdir/memory_controller/copy_engine_fcp.vhd \
+	$commondir/mem_router/bram_sp.vhd \
+	$commondir/mem_router/singleclock_bram.vhd \
+	$commondir/mem_router/instruction_cache.vhd \
+	$commondir/mem_router/mem_router.vhd \
+	$fcpdir/memory_controller/memory_controller_fcp.vhd \
+	$commondir/interrupts/interrupt_demux.vhd \
+	$fcpdir/fpga_cmd_processor_top.vhd \
+	$commondir/axi_lite/axi_lite_slave.vhd \
+	$commondir/sim/generic_memory.vhd \
+	$commondir/sim/bench_statistics.vhd \
+	$fcpdir/tb_fpga_cmd_processor_top.vhd
+
+ghdl_run tb_fpga_cmd_processor_top \
+	G_MEM_NUM_4K_DATA_MEMS=$DATA_MEM_BLOCKS \
+	G_MEM_NUM_4K_INSTR_MEMS=$INSTR_MEM_BLOCKS \
+	G_NUM_ACCELERATOR_CORES=$ACCELERATOR_CORES
@@ -44,6 +44,7 @@ package config is
 	constant CONF_DATA_AXI_DATA_WIDTH	: integer		:= 64;
 	constant CONF_CPU_HALT_NUM_ADDR		: std_logic_vector	:= x"0002000000000000";
 	constant CONF_IRQ_SND_NUM_ADDR		: std_logic_vector	:= x"0002000000000008";
+	constant CONF_BENCH_MARKER_ADDR		: std_logic_vector	:= x"00020000000000F8";
     	constant CONF_IMEM_LOW_ADDR       	: std_logic_vector	:= x"0003000000000000";
     	constant CONF_DMEM_LOW_ADDR       	: std_logic_vector 	:= x"0003000002000000";
     	constant CONF_IMEM_INIT_FILE    	: string 		:= "../../sw/core/vsim/instr.hex";
@@ -54,6 +55,7 @@ use work.config.all;
 
 library ieee;
 use IEEE.std_logic_1164.all;
+use IEEE.numeric_std.all;
 use IEEE.math_real.all;
 
 
@@ -61,7 +63,10 @@ entity tb_fpga_cmd_processor_top IS
 generic(
         G_MEM_NUM_4K_DATA_MEMS          : integer := 4;
         G_MEM_NUM_4K_INSTR_MEMS         : integer := 4;
-	G_NUM_ACCELERATOR_CORES		: integer := 1
+	G_NUM_ACCELERATOR_CORES		: integer := 1;
+	-- benchmark mode: stop after this many AQL doorbells or cycles, 0 runs on
+	G_BENCH_PACKETS			: integer := 0;
+	G_BENCH_MAX_CYCLES		: integer := 0
 );
 end tb_fpga_cmd_processor_top;
 
@@ -132,6 +137,18 @@ signal cmd_reset			: std_logic;
 signal data_clock			: std_logic;
 signal data_reset			: std_logic;
 
+-- benchmark measurements
+signal bench_cycle			: natural;
+signal bench_start			: natural;
+signal bench_overhead			: natural;
+
+-- benchmark counters
+signal s_bench_beat			: std_logic;
+signal s_bench_irqs			: std_logic_vector(4 downto 0);
+signal s_bench_done			: std_logic;
+-- without a packet or cycle limit the clocks run on like in the .do file
+constant BENCH_LIMITED			: boolean := G_BENCH_PACKETS > 0 or G_BENCH_MAX_CYCLES > 0;
+
 component generic_memory is
     generic(
 		C_LOW_ADDR				: std_logic_vector	:= x"0001000000000000";
@@ -389,6 +406,68 @@ oneway_handshake(s_snd_cpl_irq, s_snd_cpl_irq_ack);
 handshake_controller(s_snd_add_irq, s_snd_add_irq_ack, s_rcv_add_irq, s_rcv_add_irq_ack, 1 us);
 handshake_controller(s_snd_rem_irq, s_snd_rem_irq_ack, s_rcv_rem_irq, s_rcv_rem_irq_ack, 1 us);
 
+-- cycles between the two marker writes of a firmware benchmark
+benchmark_monitor: process(clock)
+	variable id	: std_logic_vector(63 downto 0);
+	variable cycles	: integer;
+	variable size	: natural;
+	variable rate	: natural;
+begin
+	if(rising_edge(clock)) then
+		if(reset='0') then
+			bench_cycle	<= 0;
+			bench_start	<= 0;
+			bench_overhead	<= 0;
+		else
+			bench_cycle <= bench_cycle + 1;
+			if(s_cmd_axi_wvalid='1' and s_cmd_axi_wready='1' and s_cmd_axi_awaddr=CONF_BENCH_MARKER_ADDR) then
+				id := s_cmd_axi_wdata;
+				if(id(63)='0') then
+					bench_start <= bench_cycle;
+				elsif(id(39 downto 32)=x"FF") then
+					bench_overhead <= bench_cycle - bench_start;
+				else
+					cycles := bench_cycle - bench_start - bench_overhead;
+					if(cycles < 1) then
+						cycles := 1;
+					end if;
+					size := to_integer(unsigned(id(31 downto 16)));
+					rate := (size * 1000) / cycles;
+					report "benchmark routine " & integer'image(to_integer(unsigned(id(39 downto 32)))) &
+					       " direction " & integer'image(to_integer(unsigned(id(47 downto 40)))) &
+					       " size " & integer'image(size) &
+					       " src+" & integer'image(to_integer(unsigned(id(15 downto 8)))) &
+					       " dst+" & integer'image(to_integer(unsigned(id(7 downto 0)))) &
+					       ": " & integer'image(cycles) & " cycles, " &
+					       integer'image(rate / 1000) & "." & integer'image((rate mod 1000) / 100) &
+					       integer'image((rate mod 100) / 10) & integer'image(rate mod 10) & " bytes/cycle";
+				end if;
+			end if;
+		end if;
+	end if;
+end process;
+
+-- a packet is done when the packet processor is rung, the interrupts are the ones sent
+s_bench_beat <= (s_data_axi_rvalid and s_data_axi_rready) or (s_data_axi_wvalid and s_data_axi_wready);
+s_bench_irqs <= s_snd_aql_irq & s_snd_dma_irq & s_snd_cpl_irq & s_snd_add_irq & s_snd_rem_irq;
+
+inst_bench: entity work.bench_statistics
+    generic map(
+		C_NAME			=> "fpga_cmd_processor",
+		C_NUM_IRQS		=> 5,
+		C_IRQ_NAMES		=> "aql,dma,cpl,add,rem",
+		C_PACKETS		=> G_BENCH_PACKETS,
+		C_MAX_CYCLES		=> G_BENCH_MAX_CYCLES
+    )
+    port map(
+	clk		=> clock,
+	rstn		=> reset,
+	completion	=> s_snd_aql_irq,
+	bus_beat	=> s_bench_beat,
+	irq		=> s_bench_irqs,
+	done		=> s_bench_done
+);
+
 stimuli: process
 begin
   reset 	<= '0';
@@ -409,12 +488,17 @@ begin
   wait;
 end process;
 
+-- in benchmark mode the clocks stop once the benchmark is done, which ends
+-- the simulation
 clock_P: process
 begin
 clock <= '0';
 wait for 10 ns;
 clock <= '1';
 wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
 end process;
 
 cmd_clock_P: process
@@ -423,6 +507,9 @@ cmd_clock <= '0';
 wait for 10 ns;
 cmd_clock <= '1';
 wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
 end process;
 
 data_clock_P: process
@@ -431,6 +518,9 @@ data_clock <= '0';
 wait for 10 ns;
 data_clock <= '1';
 wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
 end process;
 
 end behav;
@@ -8,3 +8,7 @@ export MIPS_HEAP_SIZE=512
 
 export MIPS_TEXT_SIZE=$(expr 4096 \* $MIPS_NUM_TEXT_MEM_BLOCKS)
 export MIPS_DATA_SIZE=$(expr 4096 \* $MIPS_NUM_DATA_MEM_BLOCKS)
+
+# build a firmware that runs the copy routine benchmark instead of the
+# regular command processor (results are reported by the testbench)
+export FCP_MEM_COPY_BENCHMARK=0
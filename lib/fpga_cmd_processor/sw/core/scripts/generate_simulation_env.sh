@@ -5,5 +5,6 @@ source conf.sh
 echo "\
 export MIPS_NUM_TEXT_MEM_BLOCKS=$MIPS_NUM_TEXT_MEM_BLOCKS
 export MIPS_NUM_DATA_MEM_BLOCKS=$MIPS_NUM_DATA_MEM_BLOCKS
-export MIPS_NUM_ACCELERATOR_CORES=$NUM_ACCELERATOR_CORES\
+export MIPS_NUM_ACCELERATOR_CORES=$NUM_ACCELERATOR_CORES
+export MIPS_MEM_COPY_BENCHMARK=$FCP_MEM_COPY_BENCHMARK\
 " > $1/simulation.env
@@ -0,0 +1,70 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef AQL_QUEUE_H_
+#define AQL_QUEUE_H_
+
+#include "fpga_cmd_processor.h"
+
+// Submission of AQL packets to the queue of the packet processor.
+//
+// A producer reserves slots by advancing WRITE_INDEX, waits until the ring
+// has space for them, writes the packet bodies and publishes each packet by
+// storing its header and setup word last. The packet processor stops at a
+// slot whose header is still INVALID, so packets can be published out of
+// order by several producers. The doorbell is rung once per batch.
+//
+// The cores have no LL/SC, so the reservation is made atomic against the
+// interrupt handlers of this core by clearing the IE bit around the update
+// of WRITE_INDEX and restoring the previous status register afterwards.
+// The host side version for several threads is tools/common/aql.
+
+// slot of the packet with <index>
+static inline hsa_kernel_dispatch_packet_t *aql_slot(uint64_t index){
+	const uint64_t slot = index & (MAX_QUEUE_LENGTH-1);
+	return (hsa_kernel_dispatch_packet_t*)((char*)BASE_AQL_PKT_ADDR + PACKETSIZE*slot);
+}
+
+// reserves <count> consecutive slots and waits until the packet processor
+// has released them, returns the index of the first
+static inline uint64_t aql_reserve(uint64_t count){
+	const unsigned int status_reg = save_and_disable_interrupts();
+	const uint64_t index = *WRITE_INDEX;
+	*WRITE_INDEX = index + count;
+	restore_interrupts(status_reg);
+	while(index + count - *READ_INDEX > MAX_QUEUE_LENGTH){}
+	return index;
+}
+
+// the PASID of the process the packet with <index> belongs to
+static inline void aql_set_pasid(uint64_t index, uint32_t pasid){
+	BASE_PASID_BUF_ADDR[index & (MAX_QUEUE_LENGTH-1)] = pasid;
+}
+
+// hands the packet with <index> to the packet processor, all other fields
+// of the slot have to be written before
+static inline void aql_publish(uint64_t index, uint16_t header, uint16_t setup){
+	// keep the compiler from moving the body stores behind the header
+	__asm__ volatile("" ::: "memory");
+	*((volatile uint32_t*)aql_slot(index)) = ((uint32_t)setup << 16) | header;
+}
+
+// wakes up the packet processor for all packets published so far
+static inline void aql_ring_doorbell(){
+	__asm__ volatile("" ::: "memory");
+	send_aql_interrupt();
+}
+
+#endif
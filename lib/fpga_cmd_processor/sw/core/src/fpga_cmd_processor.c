@@ -15,22 +15,29 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "fpga_cmd_processor.h"
+#include "aql_queue.h"
 #include "testimage.h"
 #include "code_segments.h"
+#include "mem_copy_benchmark.h"
 
 int main(){
+#if MEM_COPY_BENCHMARK
+	run_mem_copy_benchmark(BENCH_MARKER_ADDR, (uint8_t*)BASE_FREE_MEM);
+	return 0;
+#endif
+
 	// invalidate all packet slots
 	invalidate_aql_packets();
 
 	// initialize cores
 	write_core_code();
 
-	// single producer queue
-	uint64_t packet_index = (*WRITE_INDEX)++;
+	// reserve a slot, other producers may fill the queue concurrently
+	uint64_t packet_index = aql_reserve(1);
 	volatile uint16_t *src_image = (volatile uint16_t*)test_image;
 	volatile uint16_t *dst_image = malloc(width*height*sizeof(uint16_t));
 		
-	hsa_kernel_dispatch_packet_t *packet = (hsa_kernel_dispatch_packet_t*)((char*)BASE_AQL_PKT_ADDR+PACKETSIZE*packet_index);
+	hsa_kernel_dispatch_packet_t *packet = aql_slot(packet_index);
 
 	volatile uint64_t signal_value = 1;
 	uint64_t handle = (uint64_t)(&signal_value);
@@ -50,12 +57,11 @@ int main(){
 	packet->grid_size_y = height;
 	packet->completion_signal = signal;
 		
-	BASE_PASID_BUF_ADDR[packet_index] = 7;
+	aql_set_pasid(packet_index, 7);
 	
 	// atomically assign packet to packet processor
-	uint32_t hs = (setup(2) << 16) | header(HSA_PACKET_TYPE_KERNEL_DISPATCH,0,HSA_FENCE_SCOPE_SYSTEM,HSA_FENCE_SCOPE_SYSTEM);
-	*((volatile uint32_t*)packet) = hs;
-	send_aql_interrupt();
+	aql_publish(packet_index, header(HSA_PACKET_TYPE_KERNEL_DISPATCH,0,HSA_FENCE_SCOPE_SYSTEM,HSA_FENCE_SCOPE_SYSTEM), setup(2));
+	aql_ring_doorbell();
 
 	// wait for completion
 	while(signal_value == 1){}
@@ -71,26 +77,78 @@ void invalidate_aql_packets(){
 	}
 }
 
+// copies <count> doublewords from the local data memory to the code space,
+// bulk copies are left to the copy engine and finished by the CPU from its
+// registers if a bus error aborted them
+static void copy_code(uint64_t *dst, const uint64_t *src, uint64_t count){
+	if(count*8 >= COPY_ENGINE_MIN_LENGTH){
+		start_copy_engine(src, dst, count*8);
+		if(!wait_for_copy_engine()){
+			return;
+		}
+		src   = (const uint64_t*)(*COPY_SRC_ADDR);
+		dst   = (uint64_t*)(*COPY_DST_ADDR);
+		count = *COPY_LEN_ADDR / 8;
+	}
+	mem_copy64(dst, src, count);
+}
+
+// copies the extents of a segment to <base>, the words between them are
+// expected to be zero already as after configuration of the FPGA
+static void write_code_segment(uint64_t *base, const code_extent_t *extents, uint64_t count, uint64_t length){
+#if CODE_SEGMENT_CLEAR_GAPS
+	mem_fill64(base, 0, length);
+#endif
+	for(uint64_t e=0; e<count; ++e){
+		copy_code(base + extents[e].offset, extents[e].words, extents[e].length);
+	}
+}
+
+static inline bool has_code(unsigned int core){
+	return core < CODE_VECTOR_LENGTH && code_vector[core].imem_length != 0;
+}
+
 void write_core_code(){
-	char *segment_base = (char*)BASE_CODE_SPACE_ADDR;
+	// the cores with code get a slot of an instruction and a data segment in the code space, in order
+	unsigned int slot[AVAILABLE_CORES+1];
+	bool loaded[AVAILABLE_CORES+1];
+	unsigned int slots = 0;
 	for(unsigned int i=0; i<AVAILABLE_CORES+1; ++i){
-		/*uint64_t *current_address = (uint64_t*)segment_base;
-		if(code_vector[i].instructions != NULL){
-			// write instruction segment
-			for(unsigned int line=0; line<code_vector[i].imem_length; ++line){
-				current_address[line] = (code_vector[i].instructions)[line];
-			}
-			segment_base += CODE_SEGMENT_ADDR_SPACE_LEN;
-			current_address = (uint64_t*)segment_base;
+		slot[i] = slots;
+		loaded[i] = false;
+		if(has_code(i)){
+			++slots;
+		}
+	}
 
-			// write code segment
-			for(unsigned int line=0; line<code_vector[i].dmem_length; ++line){
-				current_address[line] = (code_vector[i].data)[line];
+	for(unsigned int i=0; i<AVAILABLE_CORES+1; ++i){
+		if(has_code(i) && !loaded[i]){
+			char *segment_base = (char*)BASE_CODE_SPACE_ADDR + 2*slot[i]*CODE_SEGMENT_ADDR_SPACE_LEN;
+#if CODE_MULTICAST
+			// the image goes to all cores sharing it at once
+			uint64_t mask = 0;
+			for(unsigned int j=i; j<AVAILABLE_CORES+1; ++j){
+				if(has_code(j) && !loaded[j] && slot[j] < CODE_MULTICAST_TARGETS
+				   && code_vector[j].instructions == code_vector[i].instructions && code_vector[j].data == code_vector[i].data
+				   && code_vector[j].imem_length == code_vector[i].imem_length && code_vector[j].dmem_length == code_vector[i].dmem_length){
+					mask |= (uint64_t)1 << slot[j];
+					loaded[j] = true;
+				}
 			}
-			segment_base += CODE_SEGMENT_ADDR_SPACE_LEN;
-		}*/
+			if(mask != 0){
+				segment_base = (char*)BASE_CODE_MULTICAST_ADDR + (mask << CODE_MULTICAST_MASK_SHIFT);
+			}
+#endif
+			loaded[i] = true;
+
+			// write instruction segment
+			write_code_segment((uint64_t*)segment_base, code_vector[i].instructions, code_vector[i].imem_extents, code_vector[i].imem_length);
+
+			// write data segment
+			write_code_segment((uint64_t*)(segment_base + CODE_SEGMENT_ADDR_SPACE_LEN), code_vector[i].data, code_vector[i].dmem_extents, code_vector[i].dmem_length);
+		}
 	
-		// notify processor
+		// notify processor as soon as its code is in place
 		if(i!=0){
 			change_accelerator_state(i);
 		}
@@ -99,9 +157,7 @@ void write_core_code(){
 }
 
 void interrupt_transfer(){
-	const uint64_t length   = *DMA_PAYLOAD_SIZE_ADDR;
-	const uint64_t length64 = length >> 3;
-	const uint64_t length8  = length - (length64 << 3);
+	uint64_t length = *DMA_PAYLOAD_SIZE_ADDR;
 	uint8_t *src = (uint8_t*)(*DMA_DEVICE_ADDR);
 	uint8_t *dst = (uint8_t*)(*DMA_HOST_ADDR);
 	
@@ -110,19 +166,23 @@ void interrupt_transfer(){
 		dst = (uint8_t*)(*DMA_DEVICE_ADDR);
 	}
 
-	// write as much as possible in doubleword steps	
-	for(unsigned int i=0; i<length64; ++i){
-		*((uint64_t*)dst) = *((uint64_t*)src);
-		src += 8;
-		dst += 8;
-	}
-	
-	// write rest in byte steps	
-	for(unsigned int i=0; i<length8; ++i){
-		*dst = *src;
-		++src;
-		++dst;
+	// let the copy engine move the doublewords of bulk transfers, it
+	// leaves the registers pointing to whatever is left for the CPU
+	if(length >= COPY_ENGINE_MIN_LENGTH && (((uint64_t)src | (uint64_t)dst) & 0x7) == 0){
+		start_copy_engine(src, dst, length);
+		if(wait_for_copy_engine()){
+			// the rest would only fault again, the packet processor fails the packet
+			*DMA_STATUS_ADDR = DMA_STATUS_ERROR;
+			send_dma_interrupt();
+			return;
+		}
+		src    = (uint8_t*)(*COPY_SRC_ADDR);
+		dst    = (uint8_t*)(*COPY_DST_ADDR);
+		length = *COPY_LEN_ADDR;
 	}
+
+	mem_copy(dst, src, length);
+	*DMA_STATUS_ADDR = DMA_STATUS_OK;
 	send_dma_interrupt();
 }
 
@@ -24,6 +24,7 @@
 #include "hsa_packets.h"
 #include "hsa_fpga.h"
 #include "address_conf.h"
+#include "mem_copy.h"
 
 #ifndef MAX_QUEUE_LENGTH
 #define MAX_QUEUE_LENGTH 128
@@ -33,6 +34,29 @@
 #define AVAILABLE_CORES 1
 #endif
 
+// smaller transfers are copied by the CPU alone
+#ifndef COPY_ENGINE_MIN_LENGTH
+#define COPY_ENGINE_MIN_LENGTH 64
+#endif
+
+// zero the code and data memories of the cores before their segments are
+// written, needed if the firmware is loaded again without reconfiguration
+#ifndef CODE_SEGMENT_CLEAR_GAPS
+#define CODE_SEGMENT_CLEAR_GAPS 0
+#endif
+
+// write identical images of several cores only once through the multicast
+// window, needs an axi_lite_multicast in front of the code space
+#ifndef CODE_MULTICAST
+#define CODE_MULTICAST 0
+#endif
+
+// code space slots reachable through the multicast window, the 7 bits
+// between the mask shift and the end of the 4 GiB window
+#ifndef CODE_MULTICAST_TARGETS
+#define CODE_MULTICAST_TARGETS 7
+#endif
+
 // main functions
 void write_core_code();
 void invalidate_aql_packets();
@@ -70,6 +94,19 @@ static inline void send_remove_core_interrupt(){
 	*SND_INT = 0;
 }
 
+static inline void start_copy_engine(const void *src, void *dst, uint64_t length){
+	*COPY_SRC_ADDR  = (uint64_t)src;
+	*COPY_DST_ADDR  = (uint64_t)dst;
+	*COPY_LEN_ADDR  = length;
+	*COPY_CTRL_ADDR = 1;
+}
+
+// stalls on the memory controller until the copy engine is idle again,
+// returns true if the last copy was aborted by a bus error
+static inline bool wait_for_copy_engine(){
+	return (*COPY_CTRL_ADDR & 0x1) != 0;
+}
+
 static inline void change_packet_processor_state(){
 	*CPU_HALT = 0;
 }
@@ -96,4 +133,30 @@ static inline void disable_interrupts(){
 		 );
 }
 
+// clears only the IE bit of the status register and returns its previous
+// value, the interrupt mask set up by startup.s is kept
+static inline unsigned int save_and_disable_interrupts(){
+	unsigned int status_reg;
+	__asm__ volatile("mfc0 %0,$12\n\t"   // asm code
+		 : "=r"(status_reg)      // outputs optional
+		 :                       // inputs optional
+		 :                       // clobbered registers optional
+		 );
+	__asm__ volatile("mtc0 %0,$12\n\t"   // asm code
+		 :                       // outputs optional
+		 : "r"(status_reg & ~0x1u) // inputs optional
+		 : "memory"              // clobbered registers optional
+		 );
+	return status_reg;
+}
+
+// writes back a status register value returned by save_and_disable_interrupts
+static inline void restore_interrupts(unsigned int status_reg){
+	__asm__ volatile("mtc0 %0,$12\n\t"   // asm code
+		 :                       // outputs optional
+		 : "r"(status_reg)       // inputs optional
+		 : "memory"              // clobbered registers optional
+		 );
+}
+
 #endif
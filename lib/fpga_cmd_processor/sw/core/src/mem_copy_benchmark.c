@@ -0,0 +1,101 @@
+// Copyright (C) 2017 Philipp Holzinger
+// Copyright (C) 2017 Martin Stumpf
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <stdlib.h>
+
+#include "mem_copy_benchmark.h"
+#include "mem_copy.h"
+
+#if MEM_COPY_BENCHMARK
+
+#define BENCH_MAX_SIZE	1024
+
+// routines
+#define BENCH_CALIBRATE	0xFF
+#define BENCH_MEM_COPY	0
+#define BENCH_MEM_FILL	1
+#define BENCH_NAIVE	2
+
+// directions
+#define BENCH_LOCAL_TO_LOCAL	0
+#define BENCH_LOCAL_TO_DEVICE	1
+#define BENCH_DEVICE_TO_LOCAL	2
+
+static uint64_t local_src[BENCH_MAX_SIZE/8 + 1];
+static uint64_t local_dst[BENCH_MAX_SIZE/8 + 1];
+
+static const uint64_t bench_sizes[]    = {8, 64, 256, 1024};
+static const uint8_t bench_offsets[][2] = {{0,0}, {0,3}, {5,0}, {3,3}};
+
+static inline uint64_t bench_id(uint8_t routine, uint8_t direction, uint64_t size, uint8_t src_offset, uint8_t dst_offset){
+	return ((uint64_t)direction << 40) | ((uint64_t)routine << 32) | (size << 16) | ((uint64_t)src_offset << 8) | dst_offset;
+}
+
+// the copy loop interrupt_transfer() used before
+static void naive_copy(uint8_t *dst, const uint8_t *src, uint64_t length){
+	const uint64_t length64 = length >> 3;
+	const uint64_t length8  = length - (length64 << 3);
+	for(unsigned int i=0; i<length64; ++i){
+		*((uint64_t*)dst) = *((uint64_t*)src);
+		src += 8;
+		dst += 8;
+	}
+	for(unsigned int i=0; i<length8; ++i){
+		*dst = *src;
+		++src;
+		++dst;
+	}
+}
+
+static void measure(volatile uint64_t *marker, uint8_t routine, uint8_t direction, uint8_t *dst, const uint8_t *src, uint64_t size, uint8_t src_offset, uint8_t dst_offset){
+	const uint64_t id = bench_id(routine, direction, size, src_offset, dst_offset);
+	*marker = id;
+	switch(routine){
+		case BENCH_MEM_COPY: mem_copy(dst + dst_offset, src + src_offset, size); break;
+		case BENCH_MEM_FILL: mem_fill(dst + dst_offset, 0xA5, size); break;
+		case BENCH_NAIVE:    naive_copy(dst + dst_offset, src + src_offset, size); break;
+		default: break;
+	}
+	*marker = id | ((uint64_t)1 << 63);
+}
+
+void run_mem_copy_benchmark(volatile uint64_t *marker, uint8_t *device_buffer){
+	uint8_t *directions[3][2] = {
+		[BENCH_LOCAL_TO_LOCAL]  = {(uint8_t*)local_dst, (uint8_t*)local_src},
+		[BENCH_LOCAL_TO_DEVICE] = {device_buffer,       (uint8_t*)local_src},
+		[BENCH_DEVICE_TO_LOCAL] = {(uint8_t*)local_dst, device_buffer}
+	};
+
+	// cost of the two marker writes themselves
+	measure(marker, BENCH_CALIBRATE, BENCH_LOCAL_TO_LOCAL, NULL, NULL, 0, 0, 0);
+
+	for(unsigned int dir=0; dir<3; ++dir){
+		uint8_t *dst = directions[dir][0];
+		const uint8_t *src = directions[dir][1];
+		for(unsigned int s=0; s<sizeof(bench_sizes)/sizeof(bench_sizes[0]); ++s){
+			const uint64_t size = bench_sizes[s];
+			// the old loop only works for doubleword aligned buffers
+			measure(marker, BENCH_NAIVE, dir, dst, src, size, 0, 0);
+			for(unsigned int a=0; a<sizeof(bench_offsets)/sizeof(bench_offsets[0]); ++a){
+				measure(marker, BENCH_MEM_COPY, dir, dst, src, size, bench_offsets[a][0], bench_offsets[a][1]);
+			}
+			measure(marker, BENCH_MEM_FILL, dir, dst, src, size, 0, 3);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,36 @@
+// Copyright (C) 2017 Philipp Holzinger
+// Copyright (C) 2017 Martin Stumpf
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef MEM_COPY_BENCHMARK_H_
+#define MEM_COPY_BENCHMARK_H_
+
+#include "stdint.h"
+
+#ifndef MEM_COPY_BENCHMARK
+#define MEM_COPY_BENCHMARK 0
+#endif
+
+// Runs the copy routines for several sizes and alignments between the local
+// data memory and <device_buffer> (at least 2 KiB). Every measurement is
+// framed by two writes to <marker>; the testbench counts the cycles between
+// them and reports bytes/cycle.
+//
+// marker layout: [7:0] dst offset, [15:8] src offset, [31:16] size,
+//                [39:32] routine, [47:40] direction, [63] end of measurement
+void run_mem_copy_benchmark(volatile uint64_t *marker, uint8_t *device_buffer);
+
+#endif
@@ -29,6 +29,7 @@
 #define DEF_BASE_DEVICE_MEMORY          0x0001000000000000
 #define DEF_BASE_CONFIG_SPACE           0x0002000000000000
 #define DEF_BASE_CODE_SPACE             0x0004000000000000
+#define DEF_BASE_CODE_MULTICAST         (DEF_BASE_CODE_SPACE + 0x100000000)
 #define DEF_BASE_AQL_PKT_ADDR 		(DEF_BASE_DEVICE_MEMORY + 0x0000000)
 #define DEF_BASE_PASID_BUF_ADDR 	(DEF_BASE_DEVICE_MEMORY + (MAX_QUEUE_LENGTH*PACKETSIZE))
 #define DEF_READ_INDEX 			(DEF_BASE_DEVICE_MEMORY + (MAX_QUEUE_LENGTH*PACKETSIZE)+(MAX_QUEUE_LENGTH*4))
@@ -36,13 +37,19 @@
 #define DEF_BASE_FREE_MEM 		(DEF_BASE_DEVICE_MEMORY + (MAX_QUEUE_LENGTH*PACKETSIZE)+(MAX_QUEUE_LENGTH*4)+16)
 #define DEF_CPU_HALT 			(DEF_BASE_CONFIG_SPACE + 0x00000)
 #define DEF_SND_INT 			(DEF_BASE_CONFIG_SPACE + 0x00008)
+#define DEF_COPY_SRC_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00010)
+#define DEF_COPY_DST_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00018)
+#define DEF_COPY_LEN_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00020)
+#define DEF_COPY_CTRL_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00028)
 #define DEF_DMA_HOST_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00050)
 #define DEF_DMA_DEVICE_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00058)
 #define DEF_DMA_PAYLOAD_SIZE_ADDR 	(DEF_BASE_CONFIG_SPACE + 0x00060)
 #define DEF_DMA_LDST_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00068)
 #define DEF_DMA_PASID_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x0006C)
+#define DEF_DMA_STATUS_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00070)
 #define DEF_CMPL_SIG_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00080)
 #define DEF_CMPL_SIG_PASID_ADDR 	(DEF_BASE_CONFIG_SPACE + 0x00088)
+#define DEF_BENCH_MARKER_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x000F8)
 
 //------------------
 
@@ -63,19 +70,37 @@ volatile uint64_t * const BASE_FREE_MEM             = (volatile uint64_t * const
 volatile uint64_t * const CPU_HALT           = (volatile uint64_t * const)DEF_CPU_HALT;
 volatile uint64_t * const SND_INT            = (volatile uint64_t * const)DEF_SND_INT;
 
+// copy engine addresses (local to the command processor)
+volatile uint64_t * const COPY_SRC_ADDR      = (volatile uint64_t * const)DEF_COPY_SRC_ADDR;
+volatile uint64_t * const COPY_DST_ADDR      = (volatile uint64_t * const)DEF_COPY_DST_ADDR;
+volatile uint64_t * const COPY_LEN_ADDR      = (volatile uint64_t * const)DEF_COPY_LEN_ADDR;
+volatile uint64_t * const COPY_CTRL_ADDR     = (volatile uint64_t * const)DEF_COPY_CTRL_ADDR;
+
 // DMA register addresses
 volatile uint64_t * const DMA_HOST_ADDR         = (volatile uint64_t * const)DEF_DMA_HOST_ADDR;
 volatile uint64_t * const DMA_DEVICE_ADDR       = (volatile uint64_t * const)DEF_DMA_DEVICE_ADDR;
 volatile uint64_t * const DMA_PAYLOAD_SIZE_ADDR = (volatile uint64_t * const)DEF_DMA_PAYLOAD_SIZE_ADDR;
 volatile uint32_t * const DMA_LDST_ADDR         = (volatile uint32_t * const)DEF_DMA_LDST_ADDR;
 volatile uint32_t * const DMA_PASID_ADDR        = (volatile uint32_t * const)DEF_DMA_PASID_ADDR;
+// result of the last transfer, written before the DMA interrupt is sent back
+volatile uint32_t * const DMA_STATUS_ADDR       = (volatile uint32_t * const)DEF_DMA_STATUS_ADDR;
+#define DMA_STATUS_OK    0x0
+#define DMA_STATUS_ERROR 0x1
 
 // completion signal addresse
 volatile uint64_t * const CMPL_SIG_ADDR       = (volatile uint64_t * const)DEF_CMPL_SIG_ADDR;
 volatile uint32_t * const CMPL_SIG_PASID_ADDR = (volatile uint32_t * const)DEF_CMPL_SIG_PASID_ADDR;
 
+// written by the benchmarks, observed by the testbench
+volatile uint64_t * const BENCH_MARKER_ADDR = (volatile uint64_t * const)DEF_BENCH_MARKER_ADDR;
+
 // config addresses
 volatile char * const BASE_CODE_SPACE_ADDR = (volatile char * const)DEF_BASE_CODE_SPACE;
 const uint64_t CODE_SEGMENT_ADDR_SPACE_LEN   = (const uint64_t) 0x01000000;
 
+// multicast window of the code space (lib/util/axi_lite_multicast), a write
+// goes to the code space slots of all cores in the mask at bit 25 and above
+volatile char * const BASE_CODE_MULTICAST_ADDR = (volatile char * const)DEF_BASE_CODE_MULTICAST;
+const uint64_t CODE_MULTICAST_MASK_SHIFT       = (const uint64_t) 25;
+
 #endif
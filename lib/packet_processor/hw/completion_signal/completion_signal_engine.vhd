@@ -0,0 +1,265 @@
+-- Copyright (C) 2017 Philipp Holzinger
+-- Copyright (C) 2017 Martin Stumpf
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+-- Decrements an HSA completion signal value in host memory without
+-- involving the command processor.
+--
+-- The decrement is done as an exclusive read/write pair. If the slave does
+-- not support exclusive accesses (OKAY instead of EXOKAY on the read) a plain
+-- read-modify-write is performed, which is safe as long as this engine is
+-- the only device side writer of the signal. A failed exclusive write is
+-- retried from the read.
+--
+-- SIG_STATUS: bit 0 busy, bit 1 done, bit 2 error (SLVERR/DECERR)
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.all;
+use IEEE.numeric_std.all;
+
+entity COMPLETION_SIGNAL_ENGINE is
+generic(
+	C_M_AXI_ADDR_WIDTH: integer := 64;
+	C_M_AXI_DATA_WIDTH: integer := 64
+);
+port(
+	-- cpu side
+	SIG_ADDR: in std_logic_vector(C_M_AXI_ADDR_WIDTH-1 downto 0);
+	SIG_START: in std_logic;
+	SIG_STATUS: out std_logic_vector(2 downto 0);
+	RE: in std_logic;
+	CLK: in std_logic;
+	-- host memory side
+	M_AXI_ACLK: in std_logic;
+	M_AXI_ARESETN: in std_logic;
+	M_AXI_AWID: out std_logic_vector(0 downto 0);
+	M_AXI_AWADDR: out std_logic_vector(C_M_AXI_ADDR_WIDTH-1 downto 0);
+	M_AXI_AWLEN: out std_logic_vector(7 downto 0);
+	M_AXI_AWSIZE: out std_logic_vector(2 downto 0);
+	M_AXI_AWBURST: out std_logic_vector(1 downto 0);
+	M_AXI_AWLOCK: out std_logic;
+	M_AXI_AWCACHE: out std_logic_vector(3 downto 0);
+	M_AXI_AWPROT: out std_logic_vector(2 downto 0);
+	M_AXI_AWQOS: out std_logic_vector(3 downto 0);
+	M_AXI_AWVALID: out std_logic;
+	M_AXI_AWREADY: in std_logic;
+	M_AXI_WDATA: out std_logic_vector(C_M_AXI_DATA_WIDTH-1 downto 0);
+	M_AXI_WSTRB: out std_logic_vector(C_M_AXI_DATA_WIDTH/8-1 downto 0);
+	M_AXI_WLAST: out std_logic;
+	M_AXI_WVALID: out std_logic;
+	M_AXI_WREADY: in std_logic;
+	M_AXI_BID: in std_logic_vector(0 downto 0);
+	M_AXI_BRESP: in std_logic_vector(1 downto 0);
+	M_AXI_BVALID: in std_logic;
+	M_AXI_BREADY: out std_logic;
+	M_AXI_ARID: out std_logic_vector(0 downto 0);
+	M_AXI_ARADDR: out std_logic_vector(C_M_AXI_ADDR_WIDTH-1 downto 0);
+	M_AXI_ARLEN: out std_logic_vector(7 downto 0);
+	M_AXI_ARSIZE: out std_logic_vector(2 downto 0);
+	M_AXI_ARBURST: out std_logic_vector(1 downto 0);
+	M_AXI_ARLOCK: out std_logic;
+	M_AXI_ARCACHE: out std_logic_vector(3 downto 0);
+	M_AXI_ARPROT: out std_logic_vector(2 downto 0);
+	M_AXI_ARQOS: out std_logic_vector(3 downto 0);
+	M_AXI_ARVALID: out std_logic;
+	M_AXI_ARREADY: in std_logic;
+	M_AXI_RID: in std_logic_vector(0 downto 0);
+	M_AXI_RDATA: in std_logic_vector(C_M_AXI_DATA_WIDTH-1 downto 0);
+	M_AXI_RRESP: in std_logic_vector(1 downto 0);
+	M_AXI_RLAST: in std_logic;
+	M_AXI_RVALID: in std_logic;
+	M_AXI_RREADY: out std_logic
+);
+end COMPLETION_SIGNAL_ENGINE;
+
+architecture CSE_RTL of COMPLETION_SIGNAL_ENGINE is
+
+-- cpu clock domain
+signal REG_ADDR: std_logic_vector(C_M_AXI_ADDR_WIDTH-1 downto 0);
+signal REG_REQ: std_logic;
+signal REG_DONE: std_logic;
+signal REG_ERROR: std_logic;
+signal ACK_SYNC: std_logic_vector(1 downto 0);
+
+-- axi clock domain
+type axi_state is (IDLE, READ_ADDR, READ_DATA, WRITE_ADDR_DATA, WRITE_RESP, FINISH);
+signal STATE: axi_state;
+signal REQ_SYNC: std_logic_vector(1 downto 0);
+signal ACK: std_logic;
+signal AXI_ERROR: std_logic;
+signal EXCLUSIVE: std_logic;
+signal VALUE: std_logic_vector(C_M_AXI_DATA_WIDTH-1 downto 0);
+signal AW_DONE: std_logic;
+signal W_DONE: std_logic;
+
+-- AxSIZE for one full data beat
+function BEAT_SIZE(BYTES: integer) return std_logic_vector is
+	variable RES: integer := 0;
+	variable VAL: integer := BYTES;
+begin
+	while VAL > 1 loop
+		VAL := VAL / 2;
+		RES := RES + 1;
+	end loop;
+	return std_logic_vector(to_unsigned(RES, 3));
+end BEAT_SIZE;
+
+constant C_AXSIZE: std_logic_vector(2 downto 0) := BEAT_SIZE(C_M_AXI_DATA_WIDTH/8);
+
+begin
+
+-- busy as long as the four phase handshake with the axi domain is not finished
+SIG_STATUS(0) <= REG_REQ OR ACK_SYNC(1);
+SIG_STATUS(1) <= REG_DONE;
+SIG_STATUS(2) <= REG_ERROR;
+
+cpu_side: process(CLK)
+begin
+if(rising_edge(CLK)) then
+if(RE='0') then
+	REG_ADDR <= (others => '0');
+	REG_REQ <= '0';
+	REG_DONE <= '0';
+	REG_ERROR <= '0';
+	ACK_SYNC <= (others => '0');
+else
+	ACK_SYNC <= ACK_SYNC(0) & ACK;
+	if(SIG_START='1' and REG_REQ='0' and ACK_SYNC(1)='0') then
+		REG_ADDR <= SIG_ADDR;
+		REG_REQ <= '1';
+		REG_DONE <= '0';
+		REG_ERROR <= '0';
+	elsif(REG_REQ='1' and ACK_SYNC(1)='1') then
+		-- AXI_ERROR is stable while ACK is set
+		REG_REQ <= '0';
+		REG_DONE <= '1';
+		REG_ERROR <= AXI_ERROR;
+	end if;
+end if;
+end if;
+end process;
+
+-- single beat transfers of one signal value
+M_AXI_AWID <= (others => '0');
+M_AXI_AWADDR <= REG_ADDR;
+M_AXI_AWLEN <= (others => '0');
+M_AXI_AWSIZE <= C_AXSIZE;
+M_AXI_AWBURST <= "01";
+M_AXI_AWLOCK <= EXCLUSIVE;
+M_AXI_AWCACHE <= "0010";
+M_AXI_AWPROT <= "000";
+M_AXI_AWQOS <= (others => '0');
+M_AXI_WDATA <= std_logic_vector(unsigned(VALUE)-1);
+M_AXI_WSTRB <= (others => '1');
+M_AXI_WLAST <= '1';
+M_AXI_ARID <= (others => '0');
+M_AXI_ARADDR <= REG_ADDR;
+M_AXI_ARLEN <= (others => '0');
+M_AXI_ARSIZE <= C_AXSIZE;
+M_AXI_ARBURST <= "01";
+M_AXI_ARLOCK <= '1';
+M_AXI_ARCACHE <= "0010";
+M_AXI_ARPROT <= "000";
+M_AXI_ARQOS <= (others => '0');
+
+M_AXI_ARVALID <= '1' when STATE = READ_ADDR else '0';
+M_AXI_RREADY <= '1' when STATE = READ_DATA else '0';
+M_AXI_AWVALID <= '1' when STATE = WRITE_ADDR_DATA and AW_DONE = '0' else '0';
+M_AXI_WVALID <= '1' when STATE = WRITE_ADDR_DATA and W_DONE = '0' else '0';
+M_AXI_BREADY <= '1' when STATE = WRITE_RESP else '0';
+
+axi_side: process(M_AXI_ACLK)
+begin
+if(rising_edge(M_AXI_ACLK)) then
+if(M_AXI_ARESETN='0') then
+	STATE <= IDLE;
+	REQ_SYNC <= (others => '0');
+	ACK <= '0';
+	AXI_ERROR <= '0';
+	EXCLUSIVE <= '0';
+	VALUE <= (others => '0');
+	AW_DONE <= '0';
+	W_DONE <= '0';
+else
+	REQ_SYNC <= REQ_SYNC(0) & REG_REQ;
+	case STATE is
+		when IDLE =>
+			if(REQ_SYNC(1)='1' and ACK='0') then
+				AXI_ERROR <= '0';
+				STATE <= READ_ADDR;
+			end if;
+		when READ_ADDR =>
+			if(M_AXI_ARREADY='1') then
+				STATE <= READ_DATA;
+			end if;
+		when READ_DATA =>
+			if(M_AXI_RVALID='1') then
+				VALUE <= M_AXI_RDATA;
+				AW_DONE <= '0';
+				W_DONE <= '0';
+				case M_AXI_RRESP is
+					-- EXOKAY, the write must be exclusive as well
+					when "01" =>
+						EXCLUSIVE <= '1';
+						STATE <= WRITE_ADDR_DATA;
+					-- OKAY, no exclusive access support
+					when "00" =>
+						EXCLUSIVE <= '0';
+						STATE <= WRITE_ADDR_DATA;
+					when others =>
+						AXI_ERROR <= '1';
+						STATE <= FINISH;
+				end case;
+			end if;
+		when WRITE_ADDR_DATA =>
+			if(M_AXI_AWREADY='1') then
+				AW_DONE <= '1';
+			end if;
+			if(M_AXI_WREADY='1') then
+				W_DONE <= '1';
+			end if;
+			if((AW_DONE='1' or M_AXI_AWREADY='1') and (W_DONE='1' or M_AXI_WREADY='1')) then
+				STATE <= WRITE_RESP;
+			end if;
+		when WRITE_RESP =>
+			if(M_AXI_BVALID='1') then
+				case M_AXI_BRESP is
+					when "01" =>
+						STATE <= FINISH;
+					when "00" =>
+						-- the exclusive write failed, somebody else changed the signal in between
+						if(EXCLUSIVE='1') then
+							STATE <= READ_ADDR;
+						else
+							STATE <= FINISH;
+						end if;
+					when others =>
+						AXI_ERROR <= '1';
+						STATE <= FINISH;
+				end case;
+			end if;
+		when FINISH =>
+			ACK <= '1';
+			if(ACK='1' and REQ_SYNC(1)='0') then
+				ACK <= '0';
+				STATE <= IDLE;
+			end if;
+		when others => STATE <= IDLE;
+	end case;
+end if;
+end if;
+end process;
+
+end CSE_RTL;
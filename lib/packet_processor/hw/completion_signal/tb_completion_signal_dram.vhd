@@ -0,0 +1,481 @@
+-- Copyright (C) 2017 Philipp Holzinger
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+library ieee;
+use IEEE.std_logic_1164.all;
+use IEEE.numeric_std.all;
+
+-- completion signal in device memory as placed by the packet tools arena, the
+-- engine and a barrier polling like BARRIER_AND of the packet processor share
+-- the DRAM model through axi_arbiter like in tb_packet_processor_top
+entity tb_completion_signal_dram IS
+end tb_completion_signal_dram;
+
+architecture behav of tb_completion_signal_dram is
+
+constant DRAM_LOW_ADDR: std_logic_vector(63 downto 0) := x"0001000000000000";
+-- first signal of the arena of images.wl
+constant SIG_HANDLE: std_logic_vector(63 downto 0) := x"0001000000200000";
+
+signal clock: std_logic;
+signal reset: std_logic;
+
+signal sig_addr: std_logic_vector(63 downto 0);
+signal sig_start: std_logic;
+signal sig_status: std_logic_vector(2 downto 0);
+
+-- barrier master
+signal araddr: std_logic_vector(63 downto 0);
+signal arvalid: std_logic;
+signal arready: std_logic;
+signal rdata: std_logic_vector(63 downto 0);
+signal rvalid: std_logic;
+signal rready: std_logic;
+signal barrier_done: std_logic;
+signal polls: integer;
+
+-- signal engine master
+signal e_awid: std_logic_vector(0 downto 0);
+signal e_awaddr: std_logic_vector(63 downto 0);
+signal e_awlen: std_logic_vector(7 downto 0);
+signal e_awsize: std_logic_vector(2 downto 0);
+signal e_awburst: std_logic_vector(1 downto 0);
+signal e_awlock: std_logic;
+signal e_awcache: std_logic_vector(3 downto 0);
+signal e_awprot: std_logic_vector(2 downto 0);
+signal e_awqos: std_logic_vector(3 downto 0);
+signal e_awvalid: std_logic;
+signal e_awready: std_logic;
+signal e_wdata: std_logic_vector(63 downto 0);
+signal e_wstrb: std_logic_vector(7 downto 0);
+signal e_wlast: std_logic;
+signal e_wvalid: std_logic;
+signal e_wready: std_logic;
+signal e_bid: std_logic_vector(0 downto 0);
+signal e_bresp: std_logic_vector(1 downto 0);
+signal e_bvalid: std_logic;
+signal e_bready: std_logic;
+signal e_arid: std_logic_vector(0 downto 0);
+signal e_araddr: std_logic_vector(63 downto 0);
+signal e_arlen: std_logic_vector(7 downto 0);
+signal e_arsize: std_logic_vector(2 downto 0);
+signal e_arburst: std_logic_vector(1 downto 0);
+signal e_arlock: std_logic;
+signal e_arcache: std_logic_vector(3 downto 0);
+signal e_arprot: std_logic_vector(2 downto 0);
+signal e_arqos: std_logic_vector(3 downto 0);
+signal e_arvalid: std_logic;
+signal e_arready: std_logic;
+signal e_rid: std_logic_vector(0 downto 0);
+signal e_rdata: std_logic_vector(63 downto 0);
+signal e_rresp: std_logic_vector(1 downto 0);
+signal e_rlast: std_logic;
+signal e_rvalid: std_logic;
+signal e_rready: std_logic;
+
+-- arbiter to DRAM
+signal m_awid: std_logic_vector(0 downto 0);
+signal m_awaddr: std_logic_vector(63 downto 0);
+signal m_awlen: std_logic_vector(7 downto 0);
+signal m_awsize: std_logic_vector(2 downto 0);
+signal m_awburst: std_logic_vector(1 downto 0);
+signal m_awlock: std_logic;
+signal m_awcache: std_logic_vector(3 downto 0);
+signal m_awprot: std_logic_vector(2 downto 0);
+signal m_awqos: std_logic_vector(3 downto 0);
+signal m_awvalid: std_logic;
+signal m_awready: std_logic;
+signal m_wdata: std_logic_vector(63 downto 0);
+signal m_wstrb: std_logic_vector(7 downto 0);
+signal m_wlast: std_logic;
+signal m_wvalid: std_logic;
+signal m_wready: std_logic;
+signal m_bid: std_logic_vector(0 downto 0);
+signal m_bresp: std_logic_vector(1 downto 0);
+signal m_bvalid: std_logic;
+signal m_bready: std_logic;
+signal m_arid: std_logic_vector(0 downto 0);
+signal m_araddr: std_logic_vector(63 downto 0);
+signal m_arlen: std_logic_vector(7 downto 0);
+signal m_arsize: std_logic_vector(2 downto 0);
+signal m_arburst: std_logic_vector(1 downto 0);
+signal m_arlock: std_logic;
+signal m_arcache: std_logic_vector(3 downto 0);
+signal m_arprot: std_logic_vector(2 downto 0);
+signal m_arqos: std_logic_vector(3 downto 0);
+signal m_arvalid: std_logic;
+signal m_arready: std_logic;
+signal m_rid: std_logic_vector(0 downto 0);
+signal m_rdata: std_logic_vector(63 downto 0);
+signal m_rresp: std_logic_vector(1 downto 0);
+signal m_rlast: std_logic;
+signal m_rvalid: std_logic;
+signal m_rready: std_logic;
+
+signal bd_en: std_logic;
+signal bd_we: std_logic;
+signal bd_addr: std_logic_vector(63 downto 0);
+signal bd_din: std_logic_vector(63 downto 0);
+signal bd_dout: std_logic_vector(63 downto 0);
+
+begin
+
+engine: entity work.COMPLETION_SIGNAL_ENGINE
+port map(
+	SIG_ADDR => sig_addr,
+	SIG_START => sig_start,
+	SIG_STATUS => sig_status,
+	RE => reset,
+	CLK => clock,
+	M_AXI_ACLK => clock,
+	M_AXI_ARESETN => reset,
+	M_AXI_AWID => e_awid,
+	M_AXI_AWADDR => e_awaddr,
+	M_AXI_AWLEN => e_awlen,
+	M_AXI_AWSIZE => e_awsize,
+	M_AXI_AWBURST => e_awburst,
+	M_AXI_AWLOCK => e_awlock,
+	M_AXI_AWCACHE => e_awcache,
+	M_AXI_AWPROT => e_awprot,
+	M_AXI_AWQOS => e_awqos,
+	M_AXI_AWVALID => e_awvalid,
+	M_AXI_AWREADY => e_awready,
+	M_AXI_WDATA => e_wdata,
+	M_AXI_WSTRB => e_wstrb,
+	M_AXI_WLAST => e_wlast,
+	M_AXI_WVALID => e_wvalid,
+	M_AXI_WREADY => e_wready,
+	M_AXI_BID => e_bid,
+	M_AXI_BRESP => e_bresp,
+	M_AXI_BVALID => e_bvalid,
+	M_AXI_BREADY => e_bready,
+	M_AXI_ARID => e_arid,
+	M_AXI_ARADDR => e_araddr,
+	M_AXI_ARLEN => e_arlen,
+	M_AXI_ARSIZE => e_arsize,
+	M_AXI_ARBURST => e_arburst,
+	M_AXI_ARLOCK => e_arlock,
+	M_AXI_ARCACHE => e_arcache,
+	M_AXI_ARPROT => e_arprot,
+	M_AXI_ARQOS => e_arqos,
+	M_AXI_ARVALID => e_arvalid,
+	M_AXI_ARREADY => e_arready,
+	M_AXI_RID => e_rid,
+	M_AXI_RDATA => e_rdata,
+	M_AXI_RRESP => e_rresp,
+	M_AXI_RLAST => e_rlast,
+	M_AXI_RVALID => e_rvalid,
+	M_AXI_RREADY => e_rready
+);
+
+arbiter: entity work.axi_arbiter
+generic map(
+	C_AXI_ADDR_WIDTH => 64,
+	C_AXI_DATA_WIDTH => 64
+)
+port map(
+	ACLK => clock,
+	ARESETN => reset,
+	-- the barrier only reads
+	S0_AXI_AWID => "0",
+	S0_AXI_AWADDR => (others => '0'),
+	S0_AXI_AWLEN => x"00",
+	S0_AXI_AWSIZE => "011",
+	S0_AXI_AWBURST => "01",
+	S0_AXI_AWLOCK => '0',
+	S0_AXI_AWCACHE => "0000",
+	S0_AXI_AWPROT => "000",
+	S0_AXI_AWQOS => "0000",
+	S0_AXI_AWVALID => '0',
+	S0_AXI_AWREADY => open,
+	S0_AXI_WDATA => (others => '0'),
+	S0_AXI_WSTRB => x"FF",
+	S0_AXI_WLAST => '0',
+	S0_AXI_WVALID => '0',
+	S0_AXI_WREADY => open,
+	S0_AXI_BID => open,
+	S0_AXI_BRESP => open,
+	S0_AXI_BVALID => open,
+	S0_AXI_BREADY => '0',
+	S0_AXI_ARID => "0",
+	S0_AXI_ARADDR => araddr,
+	S0_AXI_ARLEN => x"00",
+	S0_AXI_ARSIZE => "011",
+	S0_AXI_ARBURST => "01",
+	S0_AXI_ARLOCK => '0',
+	S0_AXI_ARCACHE => "0000",
+	S0_AXI_ARPROT => "000",
+	S0_AXI_ARQOS => "0000",
+	S0_AXI_ARVALID => arvalid,
+	S0_AXI_ARREADY => arready,
+	S0_AXI_RID => open,
+	S0_AXI_RDATA => rdata,
+	S0_AXI_RRESP => open,
+	S0_AXI_RLAST => open,
+	S0_AXI_RVALID => rvalid,
+	S0_AXI_RREADY => rready,
+	S1_AXI_AWID => e_awid,
+	S1_AXI_AWADDR => e_awaddr,
+	S1_AXI_AWLEN => e_awlen,
+	S1_AXI_AWSIZE => e_awsize,
+	S1_AXI_AWBURST => e_awburst,
+	S1_AXI_AWLOCK => e_awlock,
+	S1_AXI_AWCACHE => e_awcache,
+	S1_AXI_AWPROT => e_awprot,
+	S1_AXI_AWQOS => e_awqos,
+	S1_AXI_AWVALID => e_awvalid,
+	S1_AXI_AWREADY => e_awready,
+	S1_AXI_WDATA => e_wdata,
+	S1_AXI_WSTRB => e_wstrb,
+	S1_AXI_WLAST => e_wlast,
+	S1_AXI_WVALID => e_wvalid,
+	S1_AXI_WREADY => e_wready,
+	S1_AXI_BID => e_bid,
+	S1_AXI_BRESP => e_bresp,
+	S1_AXI_BVALID => e_bvalid,
+	S1_AXI_BREADY => e_bready,
+	S1_AXI_ARID => e_arid,
+	S1_AXI_ARADDR => e_araddr,
+	S1_AXI_ARLEN => e_arlen,
+	S1_AXI_ARSIZE => e_arsize,
+	S1_AXI_ARBURST => e_arburst,
+	S1_AXI_ARLOCK => e_arlock,
+	S1_AXI_ARCACHE => e_arcache,
+	S1_AXI_ARPROT => e_arprot,
+	S1_AXI_ARQOS => e_arqos,
+	S1_AXI_ARVALID => e_arvalid,
+	S1_AXI_ARREADY => e_arready,
+	S1_AXI_RID => e_rid,
+	S1_AXI_RDATA => e_rdata,
+	S1_AXI_RRESP => e_rresp,
+	S1_AXI_RLAST => e_rlast,
+	S1_AXI_RVALID => e_rvalid,
+	S1_AXI_RREADY => e_rready,
+	M_AXI_AWID => m_awid,
+	M_AXI_AWADDR => m_awaddr,
+	M_AXI_AWLEN => m_awlen,
+	M_AXI_AWSIZE => m_awsize,
+	M_AXI_AWBURST => m_awburst,
+	M_AXI_AWLOCK => m_awlock,
+	M_AXI_AWCACHE => m_awcache,
+	M_AXI_AWPROT => m_awprot,
+	M_AXI_AWQOS => m_awqos,
+	M_AXI_AWVALID => m_awvalid,
+	M_AXI_AWREADY => m_awready,
+	M_AXI_WDATA => m_wdata,
+	M_AXI_WSTRB => m_wstrb,
+	M_AXI_WLAST => m_wlast,
+	M_AXI_WVALID => m_wvalid,
+	M_AXI_WREADY => m_wready,
+	M_AXI_BID => m_bid,
+	M_AXI_BRESP => m_bresp,
+	M_AXI_BVALID => m_bvalid,
+	M_AXI_BREADY => m_bready,
+	M_AXI_ARID => m_arid,
+	M_AXI_ARADDR => m_araddr,
+	M_AXI_ARLEN => m_arlen,
+	M_AXI_ARSIZE => m_arsize,
+	M_AXI_ARBURST => m_arburst,
+	M_AXI_ARLOCK => m_arlock,
+	M_AXI_ARCACHE => m_arcache,
+	M_AXI_ARPROT => m_arprot,
+	M_AXI_ARQOS => m_arqos,
+	M_AXI_ARVALID => m_arvalid,
+	M_AXI_ARREADY => m_arready,
+	M_AXI_RID => m_rid,
+	M_AXI_RDATA => m_rdata,
+	M_AXI_RRESP => m_rresp,
+	M_AXI_RLAST => m_rlast,
+	M_AXI_RVALID => m_rvalid,
+	M_AXI_RREADY => m_rready
+);
+
+dram: entity work.burst_memory
+generic map(
+	C_LOW_ADDR => DRAM_LOW_ADDR,
+	C_AXI_ADDR_WIDTH => 64,
+	C_AXI_DATA_WIDTH => 64,
+	C_NUM_1K_BRAM_BLOCKS => 4096
+)
+port map(
+	clk => clock,
+	rstn => reset,
+	S_AXI_ACLK => clock,
+	S_AXI_ARESETN => reset,
+	S_AXI_AWID => m_awid,
+	S_AXI_AWADDR => m_awaddr,
+	S_AXI_AWLEN => m_awlen,
+	S_AXI_AWSIZE => m_awsize,
+	S_AXI_AWBURST => m_awburst,
+	S_AXI_AWLOCK => m_awlock,
+	S_AXI_AWCACHE => m_awcache,
+	S_AXI_AWPROT => m_awprot,
+	S_AXI_AWQOS => m_awqos,
+	S_AXI_AWREGION => "0000",
+	S_AXI_AWVALID => m_awvalid,
+	S_AXI_AWREADY => m_awready,
+	S_AXI_WDATA => m_wdata,
+	S_AXI_WSTRB => m_wstrb,
+	S_AXI_WLAST => m_wlast,
+	S_AXI_WVALID => m_wvalid,
+	S_AXI_WREADY => m_wready,
+	S_AXI_BID => m_bid,
+	S_AXI_BRESP => m_bresp,
+	S_AXI_BVALID => m_bvalid,
+	S_AXI_BREADY => m_bready,
+	S_AXI_ARID => m_arid,
+	S_AXI_ARADDR => m_araddr,
+	S_AXI_ARLEN => m_arlen,
+	S_AXI_ARSIZE => m_arsize,
+	S_AXI_ARBURST => m_arburst,
+	S_AXI_ARLOCK => m_arlock,
+	S_AXI_ARCACHE => m_arcache,
+	S_AXI_ARPROT => m_arprot,
+	S_AXI_ARQOS => m_arqos,
+	S_AXI_ARREGION => "0000",
+	S_AXI_ARVALID => m_arvalid,
+	S_AXI_ARREADY => m_arready,
+	S_AXI_RID => m_rid,
+	S_AXI_RDATA => m_rdata,
+	S_AXI_RRESP => m_rresp,
+	S_AXI_RLAST => m_rlast,
+	S_AXI_RVALID => m_rvalid,
+	S_AXI_RREADY => m_rready,
+	BD_EN => bd_en,
+	BD_WE => bd_we,
+	BD_ADDR => bd_addr,
+	BD_DIN => bd_din,
+	BD_DOUT => bd_dout
+);
+
+-- reads the signal until it is zero like the BARRIER_AND loop of the firmware
+barrier: process
+  variable value: std_logic_vector(63 downto 0);
+begin
+  araddr <= SIG_HANDLE;
+  arvalid <= '0';
+  rready <= '0';
+  barrier_done <= '0';
+  polls <= 0;
+  wait until reset = '1';
+  loop
+    wait until falling_edge(clock);
+    arvalid <= '1';
+    rready <= '1';
+    loop
+      wait until rising_edge(clock);
+      exit when arready = '1';
+    end loop;
+    arvalid <= '0';
+    loop
+      wait until falling_edge(clock);
+      exit when rvalid = '1';
+    end loop;
+    value := rdata;
+    wait until rising_edge(clock);
+    rready <= '0';
+    polls <= polls + 1;
+    exit when value = x"0000000000000000";
+  end loop;
+  barrier_done <= '1';
+  wait;
+end process;
+
+stimuli: process
+  variable value: std_logic_vector(63 downto 0);
+
+  -- backdoor write, one cycle like the 'M' command of the stimulus replay
+  procedure bd_write(addr: std_logic_vector(63 downto 0); data: std_logic_vector(63 downto 0)) is
+  begin
+    bd_addr <= addr;
+    bd_din <= data;
+    bd_we <= '1';
+    bd_en <= '1';
+    wait until rising_edge(clock);
+    bd_we <= '0';
+    bd_en <= '0';
+  end procedure;
+
+  -- backdoor read, BD_DOUT is valid after the next edge
+  procedure bd_read(addr: std_logic_vector(63 downto 0); data: out std_logic_vector(63 downto 0)) is
+  begin
+    bd_addr <= addr;
+    bd_en <= '1';
+    wait until rising_edge(clock);
+    bd_en <= '0';
+    wait until falling_edge(clock);
+    data := bd_dout;
+  end procedure;
+
+  procedure decrement is
+  begin
+    sig_start <= '1';
+    wait for 20 ns;
+    sig_start <= '0';
+    wait until sig_status(0)='0';
+    assert sig_status(2)='0' report "decrement in DRAM reported an error" severity error;
+  end procedure;
+begin
+  reset <= '0';
+  sig_addr <= SIG_HANDLE;
+  sig_start <= '0';
+  bd_en <= '0';
+  bd_we <= '0';
+  bd_addr <= (others => '0');
+  bd_din <= (others => '0');
+  wait for 45 ns;
+  wait until rising_edge(clock);
+
+  -- the barrier depends on a signal with two outstanding packets, offset 0
+  -- of the DRAM holds the start of the queue
+  bd_write(SIG_HANDLE, x"0000000000000002");
+  bd_write(DRAM_LOW_ADDR, x"00000000C0FFEE00");
+  reset <= '1';
+
+  -- the first decrement does not release the barrier
+  wait for 200 ns;
+  decrement;
+  bd_read(SIG_HANDLE, value);
+  assert value = x"0000000000000001" report "first decrement did not reach the DRAM" severity error;
+  wait for 400 ns;
+  assert barrier_done = '0' report "barrier released with a pending packet" severity error;
+
+  -- the second one does
+  decrement;
+  if barrier_done = '0' then
+    wait until barrier_done = '1' for 2 us;
+  end if;
+  assert barrier_done = '1' report "barrier never saw the decremented signal" severity error;
+  assert polls > 1 report "barrier did not poll before the decrement" severity error;
+
+  -- the signal did not wrap onto the start of the DRAM
+  bd_read(DRAM_LOW_ADDR, value);
+  assert value = x"00000000C0FFEE00" report "decrement wrapped to DRAM offset 0" severity error;
+  bd_read(SIG_HANDLE, value);
+  assert value = x"0000000000000000" report "signal not zero after two decrements" severity error;
+
+  report "tb_completion_signal_dram finished" severity note;
+  wait;
+end process;
+
+clock_P: process
+begin
+clock <= '0';
+wait for 10 ns;
+clock <= '1';
+wait for 10 ns;
+end process;
+
+end behav;
@@ -0,0 +1,312 @@
+-- Copyright (C) 2017 Philipp Holzinger
+-- Copyright (C) 2017 Martin Stumpf
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+library ieee;
+use IEEE.std_logic_1164.all;
+use IEEE.numeric_std.all;
+
+entity tb_completion_signal_engine IS
+end tb_completion_signal_engine;
+
+architecture behav of tb_completion_signal_engine is
+
+-- the slave answers with DECERR for this address
+constant BAD_ADDR: std_logic_vector(63 downto 0) := x"00000000DEAD0000";
+constant SIG_HANDLE: std_logic_vector(63 downto 0) := x"0000000000001000";
+
+signal sig_addr: std_logic_vector(63 downto 0);
+signal sig_start: std_logic;
+signal sig_status: std_logic_vector(2 downto 0);
+signal reset: std_logic;
+signal clock: std_logic;
+signal axi_clock: std_logic;
+
+signal awaddr: std_logic_vector(63 downto 0);
+signal awlock: std_logic;
+signal awvalid: std_logic;
+signal awready: std_logic;
+signal wdata: std_logic_vector(63 downto 0);
+signal wvalid: std_logic;
+signal wready: std_logic;
+signal bresp: std_logic_vector(1 downto 0);
+signal bvalid: std_logic;
+signal bready: std_logic;
+signal araddr: std_logic_vector(63 downto 0);
+signal arlock: std_logic;
+signal arvalid: std_logic;
+signal arready: std_logic;
+signal rdata: std_logic_vector(63 downto 0);
+signal rresp: std_logic_vector(1 downto 0);
+signal rvalid: std_logic;
+signal rready: std_logic;
+
+-- host memory model
+signal signal_value: std_logic_vector(63 downto 0);
+signal fail_next_exclusive: std_logic;
+-- without exclusive access support reads answer OKAY and the engine falls back to a plain read-modify-write
+signal exclusive_support: std_logic;
+signal reads: integer;
+signal last_write_lock: std_logic;
+
+component COMPLETION_SIGNAL_ENGINE
+generic(
+	C_M_AXI_ADDR_WIDTH: integer := 64;
+	C_M_AXI_DATA_WIDTH: integer := 64
+);
+port(
+	SIG_ADDR: in std_logic_vector(C_M_AXI_ADDR_WIDTH-1 downto 0);
+	SIG_START: in std_logic;
+	SIG_STATUS: out std_logic_vector(2 downto 0);
+	RE: in std_logic;
+	CLK: in std_logic;
+	M_AXI_ACLK: in std_logic;
+	M_AXI_ARESETN: in std_logic;
+	M_AXI_AWID: out std_logic_vector(0 downto 0);
+	M_AXI_AWADDR: out std_logic_vector(C_M_AXI_ADDR_WIDTH-1 downto 0);
+	M_AXI_AWLEN: out std_logic_vector(7 downto 0);
+	M_AXI_AWSIZE: out std_logic_vector(2 downto 0);
+	M_AXI_AWBURST: out std_logic_vector(1 downto 0);
+	M_AXI_AWLOCK: out std_logic;
+	M_AXI_AWCACHE: out std_logic_vector(3 downto 0);
+	M_AXI_AWPROT: out std_logic_vector(2 downto 0);
+	M_AXI_AWQOS: out std_logic_vector(3 downto 0);
+	M_AXI_AWVALID: out std_logic;
+	M_AXI_AWREADY: in std_logic;
+	M_AXI_WDATA: out std_logic_vector(C_M_AXI_DATA_WIDTH-1 downto 0);
+	M_AXI_WSTRB: out std_logic_vector(C_M_AXI_DATA_WIDTH/8-1 downto 0);
+	M_AXI_WLAST: out std_logic;
+	M_AXI_WVALID: out std_logic;
+	M_AXI_WREADY: in std_logic;
+	M_AXI_BID: in std_logic_vector(0 downto 0);
+	M_AXI_BRESP: in std_logic_vector(1 downto 0);
+	M_AXI_BVALID: in std_logic;
+	M_AXI_BREADY: out std_logic;
+	M_AXI_ARID: out std_logic_vector(0 downto 0);
+	M_AXI_ARADDR: out std_logic_vector(C_M_AXI_ADDR_WIDTH-1 downto 0);
+	M_AXI_ARLEN: out std_logic_vector(7 downto 0);
+	M_AXI_ARSIZE: out std_logic_vector(2 downto 0);
+	M_AXI_ARBURST: out std_logic_vector(1 downto 0);
+	M_AXI_ARLOCK: out std_logic;
+	M_AXI_ARCACHE: out std_logic_vector(3 downto 0);
+	M_AXI_ARPROT: out std_logic_vector(2 downto 0);
+	M_AXI_ARQOS: out std_logic_vector(3 downto 0);
+	M_AXI_ARVALID: out std_logic;
+	M_AXI_ARREADY: in std_logic;
+	M_AXI_RID: in std_logic_vector(0 downto 0);
+	M_AXI_RDATA: in std_logic_vector(C_M_AXI_DATA_WIDTH-1 downto 0);
+	M_AXI_RRESP: in std_logic_vector(1 downto 0);
+	M_AXI_RLAST: in std_logic;
+	M_AXI_RVALID: in std_logic;
+	M_AXI_RREADY: out std_logic
+);
+end component;
+
+begin
+
+uut: COMPLETION_SIGNAL_ENGINE
+port map(
+	SIG_ADDR => sig_addr,
+	SIG_START => sig_start,
+	SIG_STATUS => sig_status,
+	RE => reset,
+	CLK => clock,
+	M_AXI_ACLK => axi_clock,
+	M_AXI_ARESETN => reset,
+	M_AXI_AWID => open,
+	M_AXI_AWADDR => awaddr,
+	M_AXI_AWLEN => open,
+	M_AXI_AWSIZE => open,
+	M_AXI_AWBURST => open,
+	M_AXI_AWLOCK => awlock,
+	M_AXI_AWCACHE => open,
+	M_AXI_AWPROT => open,
+	M_AXI_AWQOS => open,
+	M_AXI_AWVALID => awvalid,
+	M_AXI_AWREADY => awready,
+	M_AXI_WDATA => wdata,
+	M_AXI_WSTRB => open,
+	M_AXI_WLAST => open,
+	M_AXI_WVALID => wvalid,
+	M_AXI_WREADY => wready,
+	M_AXI_BID => "0",
+	M_AXI_BRESP => bresp,
+	M_AXI_BVALID => bvalid,
+	M_AXI_BREADY => bready,
+	M_AXI_ARID => open,
+	M_AXI_ARADDR => araddr,
+	M_AXI_ARLEN => open,
+	M_AXI_ARSIZE => open,
+	M_AXI_ARBURST => open,
+	M_AXI_ARLOCK => arlock,
+	M_AXI_ARCACHE => open,
+	M_AXI_ARPROT => open,
+	M_AXI_ARQOS => open,
+	M_AXI_ARVALID => arvalid,
+	M_AXI_ARREADY => arready,
+	M_AXI_RID => "0",
+	M_AXI_RDATA => rdata,
+	M_AXI_RRESP => rresp,
+	M_AXI_RLAST => '1',
+	M_AXI_RVALID => rvalid,
+	M_AXI_RREADY => rready
+);
+
+-- single beat slave with exclusive access support
+slave: process(axi_clock)
+variable write_addr: std_logic_vector(63 downto 0);
+variable write_lock: std_logic;
+variable got_addr: boolean := false;
+variable got_data: boolean := false;
+begin
+if(rising_edge(axi_clock)) then
+if(reset='0') then
+	signal_value <= std_logic_vector(to_unsigned(3, 64));
+	reads <= 0;
+	last_write_lock <= '0';
+	arready <= '0';
+	rvalid <= '0';
+	awready <= '0';
+	wready <= '0';
+	bvalid <= '0';
+	got_addr := false;
+	got_data := false;
+else
+	arready <= '0';
+	awready <= '0';
+	wready <= '0';
+	if(rvalid='1' and rready='1') then
+		rvalid <= '0';
+	elsif(arvalid='1' and arready='0' and rvalid='0') then
+		arready <= '1';
+		rvalid <= '1';
+		rdata <= signal_value;
+		reads <= reads + 1;
+		if(araddr = BAD_ADDR) then
+			rresp <= "11";
+		elsif(arlock='1' and exclusive_support='1') then
+			rresp <= "01";
+		else
+			rresp <= "00";
+		end if;
+	end if;
+	if(awvalid='1' and awready='0' and not got_addr) then
+		awready <= '1';
+		write_addr := awaddr;
+		write_lock := awlock;
+		got_addr := true;
+	end if;
+	if(wvalid='1' and wready='0' and not got_data) then
+		wready <= '1';
+		got_data := true;
+	end if;
+	if(bvalid='1' and bready='1') then
+		bvalid <= '0';
+	elsif(got_addr and got_data and bvalid='0') then
+		got_addr := false;
+		got_data := false;
+		bvalid <= '1';
+		last_write_lock <= write_lock;
+		if(write_lock='1' and fail_next_exclusive='1') then
+			-- another agent touched the monitored location
+			bresp <= "00";
+		elsif(write_lock='1') then
+			signal_value <= wdata;
+			bresp <= "01";
+		else
+			signal_value <= wdata;
+			bresp <= "00";
+		end if;
+	end if;
+end if;
+end if;
+end process;
+
+stimuli: process
+begin
+  reset <= '0';
+  sig_start <= '0';
+  sig_addr <= (others => '0');
+  fail_next_exclusive <= '0';
+  exclusive_support <= '1';
+  wait for 45 ns;
+  reset <= '1';
+  -- plain decrement
+  wait for 20 ns;
+  sig_addr <= SIG_HANDLE;
+  sig_start <= '1';
+  wait for 20 ns;
+  sig_start <= '0';
+  wait for 20 ns;
+  assert sig_status(0) = '1' report "engine should be busy" severity error;
+  wait until sig_status(0) = '0';
+  assert sig_status = "010" report "first decrement did not complete" severity error;
+  assert signal_value = std_logic_vector(to_unsigned(2, 64)) report "signal value should be 2" severity error;
+  assert reads = 1 and last_write_lock = '1' report "decrement should be one exclusive read/write pair" severity error;
+  -- the first exclusive write fails and has to be retried
+  wait for 20 ns;
+  fail_next_exclusive <= '1';
+  sig_start <= '1';
+  wait for 20 ns;
+  sig_start <= '0';
+  wait until bvalid = '1';
+  fail_next_exclusive <= '0';
+  wait until sig_status(0) = '0';
+  assert sig_status = "010" report "retried decrement did not complete" severity error;
+  assert signal_value = std_logic_vector(to_unsigned(1, 64)) report "signal value should be 1" severity error;
+  assert reads = 3 report "failed exclusive write should be retried from the read" severity error;
+  -- a slave without exclusive access support gets a plain read-modify-write
+  wait for 20 ns;
+  exclusive_support <= '0';
+  sig_start <= '1';
+  wait for 20 ns;
+  sig_start <= '0';
+  wait for 20 ns;
+  wait until sig_status(0) = '0';
+  assert sig_status = "010" report "fallback decrement did not complete" severity error;
+  assert signal_value = std_logic_vector(to_unsigned(0, 64)) report "signal value should be 0" severity error;
+  assert reads = 4 and last_write_lock = '0' report "fallback should be one plain read/write pair" severity error;
+  exclusive_support <= '1';
+  -- a slave error is reported and leaves the value untouched
+  wait for 20 ns;
+  sig_addr <= BAD_ADDR;
+  sig_start <= '1';
+  wait for 20 ns;
+  sig_start <= '0';
+  wait for 20 ns;
+  wait until sig_status(0) = '0';
+  assert sig_status = "110" report "slave error not reported" severity error;
+  assert signal_value = std_logic_vector(to_unsigned(0, 64)) report "signal value should still be 0" severity error;
+  wait;
+end process;
+
+clock_P: process
+begin
+clock <= '0';
+wait for 10 ns;
+clock <= '1';
+wait for 10 ns;
+end process;
+
+-- host memory runs on its own clock
+axi_clock_P: process
+begin
+axi_clock <= '0';
+wait for 4 ns;
+axi_clock <= '1';
+wait for 4 ns;
+end process;
+
+end behav;
@@ -21,6 +21,8 @@ add_files "packet_processor_top.vhd"
 
 add_files "interrupt_controller/interrupt_controller.vhd"
 
+add_files "completion_signal/completion_signal_engine.vhd"
+
 add_files "memory_controller/memory_controller_pp.vhd"
 add_files "memory_controller/external_memory/external_memory_interface_pp.vhd"
 
@@ -28,6 +30,7 @@ add_files "${common_dir}/axi_lite/axi_lite_master.vhd"
 add_files "${common_dir}/axi_full/axi_full_master.vhd"
 add_files "${common_dir}/interrupts/interrupt_arbiter.vhd"
 add_files "${common_dir}/interrupts/interrupt_demux.vhd"
+add_files "${common_dir}/mem_router/instruction_cache.vhd"
 add_files "${common_dir}/mem_router/mem_router.vhd"
 add_files "${common_dir}/mem_router/singleclock_bram.vhd"
 add_files "${common_dir}/mem_router/bram_sp.vhd"
@@ -22,7 +22,12 @@ use IEEE.math_real.all;
 entity INTERRUPT_CONTROLLER is
 generic(
 	-- N is number of Accelerator Cores
-	N: integer := 4
+	N: integer := 4;
+	-- reset values of the coalescing configuration
+	-- an interrupt is raised as soon as THRESHOLD events are pending or
+	-- the oldest pending event has waited TIMEOUT cycles
+	C_COALESCE_THRESHOLD: integer := 1;
+	C_COALESCE_TIMEOUT: integer := 0
 );
 port(
 	-- incoming interrupts
@@ -34,6 +39,14 @@ port(
 	RCV_WORK_LEFT: out std_logic;
 	RCV_WORK_LEFT_RESPONSE: in std_logic;
 	RCV_WORK_LEFT_RESPONSE_WRITE: in std_logic;
+	-- pending interrupt bitmap (cleared on read)
+	-- bits N-1..0 cores, N remove core, N+1 add core, N+2 completion, N+3 DMA
+	RCV_INT_PENDING: out std_logic_vector(N+3 downto 0);
+	RCV_INT_PENDING_READ: in std_logic;
+	-- coalescing configuration: 47..32 threshold, 31..0 timeout
+	RCV_INT_COALESCE: out std_logic_vector(47 downto 0);
+	RCV_INT_COALESCE_RESPONSE: in std_logic_vector(47 downto 0);
+	RCV_INT_COALESCE_RESPONSE_WRITE: in std_logic;
 	-- outgoing interrupts
     	SND_INT_LANES: out std_logic_vector(N+3 downto 0);
 	SND_INT_LANES_RESPONSE: in std_logic_vector(N+3 downto 0);
@@ -50,20 +63,43 @@ architecture IC_RTL of INTERRUPT_CONTROLLER is
 
 --internal registers
 -- STATE:
--- 0 -> IDLE
--- 1 -> SEND
-signal STATE: std_logic;
+-- 00 -> COLLECT (gather events until threshold or timeout is reached)
+-- 01 -> SEND (wait for the cpu to take the interrupt)
+-- 10 -> SERVICE (wait for the cpu to read the pending bitmap)
+signal STATE: std_logic_vector(1 downto 0);
 signal READY: std_logic;
 signal INUMSLV: std_logic_vector(integer(ceil(log2(real(N+5))))-1 downto 0);
 -- INTERRUPT TYPE:
--- 1 -> PROCESSING FINISHED
--- 2 -> TRANSACTION FINISHED
+-- one bit per class of pending events, see PENDING_TO_TYPE
 signal ITYPE: std_logic_vector(5 downto 0);
 signal REG_WORK_LEFT: std_logic;
+-- coalescing
+signal PENDING: std_logic_vector(N+3 downto 0);
+signal PENDING_SNAPSHOT: std_logic_vector(N+3 downto 0);
+signal PENDING_CNT: unsigned(15 downto 0);
+signal TIMER: unsigned(31 downto 0);
+signal REG_THRESHOLD: unsigned(15 downto 0);
+signal REG_TIMEOUT: unsigned(31 downto 0);
 -- outgoing signals form arbiter
 signal INT_NUM_OUT: std_logic_vector(integer(ceil(log2(real(N+5))))-1 downto 0);
 signal ISIG: std_logic;
 
+-- maps the pending bitmap to the cpu interrupt lines
+-- 100000 -> core(s) finished, 010000 -> DMA, 001000 -> completion, 000100 -> add core, 000010 -> remove core
+function PENDING_TO_TYPE(P: std_logic_vector(N+3 downto 0)) return std_logic_vector is
+	variable T: std_logic_vector(5 downto 0);
+begin
+	T := (others => '0');
+	for I in 0 to N-1 loop
+		T(5) := T(5) OR P(I);
+	end loop;
+	T(4) := P(N+3);
+	T(3) := P(N+2);
+	T(2) := P(N+1);
+	T(1) := P(N);
+	return T;
+end function;
+
 -- for sending interrupts: MSB for DEC, 2nd highest for DMA and rest for cores
 component INTERRUPT_DEMUX
 generic(
@@ -126,25 +162,42 @@ port map(
 	CLK => CLK
 );
 
-READY <= ISIG NOR STATE;
+-- events are only collected into the pending bitmap, so the arbiter can keep running while the cpu is busy
+READY <= NOT ISIG;
+
+RCV_INT_PENDING <= PENDING_SNAPSHOT;
+RCV_INT_COALESCE <= std_logic_vector(REG_THRESHOLD) & std_logic_vector(REG_TIMEOUT);
 
 processing: process(CLK)
+variable NEW_EVENT: std_logic_vector(N+3 downto 0);
 begin
 if(rising_edge(CLK)) then
 if(RE='0') then
-	STATE <= '0';
+	STATE <= "00";
 	ITYPE <= (others=>'0');
 	INUMSLV <= (others=>'0');
 	REG_WORK_LEFT <= '0';
 	RCV_WORK_LEFT <= '0';
 	RCV_INT_TYPE <= (others => '0');
 	RCV_INT_NUM <= (others => '0');
+	PENDING <= (others => '0');
+	PENDING_SNAPSHOT <= (others => '0');
+	PENDING_CNT <= (others => '0');
+	TIMER <= (others => '0');
+	REG_THRESHOLD <= to_unsigned(C_COALESCE_THRESHOLD, REG_THRESHOLD'length);
+	REG_TIMEOUT <= to_unsigned(C_COALESCE_TIMEOUT, REG_TIMEOUT'length);
 else	
 	-- internal signals
 	STATE <= STATE;
 	ITYPE <= ITYPE;
 	INUMSLV <= INUMSLV;
 	REG_WORK_LEFT <= REG_WORK_LEFT;
+	PENDING <= PENDING;
+	PENDING_SNAPSHOT <= PENDING_SNAPSHOT;
+	PENDING_CNT <= PENDING_CNT;
+	TIMER <= TIMER;
+	REG_THRESHOLD <= REG_THRESHOLD;
+	REG_TIMEOUT <= REG_TIMEOUT;
 	-- outgoing signals
 	RCV_INT_TYPE <= ITYPE;
 	RCV_INT_NUM <= INUMSLV;
@@ -155,65 +208,71 @@ else
 			--forwarding value
 			RCV_WORK_LEFT <= RCV_WORK_LEFT_RESPONSE;
 		end if;
-		case STATE is
-			when '0' => 	
-				if(ISIG='1') then
-					-- work arrived interupt
-					if(to_integer(unsigned(INT_NUM_OUT)) = N+4) then
-						-- if the PP tries to reset the work register to 0, but an aql interrupt is pending in the same cycle, 
-						-- use the conservative guess that more work is there (but the PP hasnt seen it yet) and leave the reg at value 1
-						REG_WORK_LEFT <= '1';
-						--forwarding value
-						RCV_WORK_LEFT <= '1';
-					-- DMA finished interrupt
-					elsif(to_integer(unsigned(INT_NUM_OUT)) = N+3) then
-						STATE <= '1';
-						ITYPE <= "010000";
-						INUMSLV <= INT_NUM_OUT;
-						--interrupt forwarding
-						RCV_INT_TYPE <= "010000";
-						RCV_INT_NUM <= INT_NUM_OUT;
-					-- decrement completion signal finished interrupt
-					elsif(to_integer(unsigned(INT_NUM_OUT)) = N+2) then
-						STATE <= '1';
-						ITYPE <= "001000";
-						INUMSLV <= INT_NUM_OUT;
-						--interrupt forwarding
-						RCV_INT_TYPE <= "001000";
-						RCV_INT_NUM <= INT_NUM_OUT;
-					-- add core interrupt
-					elsif(to_integer(unsigned(INT_NUM_OUT)) = N+1) then
-						STATE <= '1';
-						ITYPE <= "000100";
-						INUMSLV <= INT_NUM_OUT;
-						--interrupt forwarding
-						RCV_INT_TYPE <= "000100";
-						RCV_INT_NUM <= INT_NUM_OUT;
-					-- remove core interrupt
-					elsif(to_integer(unsigned(INT_NUM_OUT)) = N) then
-						STATE <= '1';
-						ITYPE <= "000010";
-						INUMSLV <= INT_NUM_OUT;
-						--interrupt forwarding
-						RCV_INT_TYPE <= "000010";
-						RCV_INT_NUM <= INT_NUM_OUT;
-					else
-						STATE <= '1';
-						ITYPE <= "100000";
-						INUMSLV <= INT_NUM_OUT;
-						--interrupt forwarding
-						RCV_INT_TYPE <= "100000";
-						RCV_INT_NUM <= INT_NUM_OUT;
+		if(RCV_INT_COALESCE_RESPONSE_WRITE='1') then
+			REG_THRESHOLD <= unsigned(RCV_INT_COALESCE_RESPONSE(47 downto 32));
+			REG_TIMEOUT <= unsigned(RCV_INT_COALESCE_RESPONSE(31 downto 0));
+		end if;
+		-- collect incoming event
+		NEW_EVENT := (others => '0');
+		if(ISIG='1') then
+			-- work arrived interupt
+			if(to_integer(unsigned(INT_NUM_OUT)) = N+4) then
+				-- if the PP tries to reset the work register to 0, but an aql interrupt is pending in the same cycle, 
+				-- use the conservative guess that more work is there (but the PP hasnt seen it yet) and leave the reg at value 1
+				REG_WORK_LEFT <= '1';
+				--forwarding value
+				RCV_WORK_LEFT <= '1';
+			-- DMA, completion, add/remove core or core finished interrupt
+			else
+				NEW_EVENT(to_integer(unsigned(INT_NUM_OUT))) := '1';
+				INUMSLV <= INT_NUM_OUT;
+				--forwarding value
+				RCV_INT_NUM <= INT_NUM_OUT;
+			end if;
+		end if;
+		if(RCV_INT_PENDING_READ='1') then
+			-- hand all collected events to the cpu and start collecting again,
+			-- an event arriving in this cycle stays pending for the next round
+			PENDING_SNAPSHOT <= PENDING;
+			PENDING <= NEW_EVENT;
+			if(unsigned(NEW_EVENT) = 0) then
+				PENDING_CNT <= (others => '0');
+			else
+				PENDING_CNT <= to_unsigned(1, PENDING_CNT'length);
+			end if;
+			TIMER <= (others => '0');
+			STATE <= "00";
+			ITYPE <= "000000";
+			RCV_INT_TYPE <= "000000";
+		else
+			PENDING <= PENDING OR NEW_EVENT;
+			if(unsigned(NEW_EVENT) /= 0 and PENDING_CNT /= x"FFFF") then
+				PENDING_CNT <= PENDING_CNT + 1;
+			end if;
+			case STATE is
+				when "00" =>
+					if(unsigned(PENDING) /= 0) then
+						if(PENDING_CNT >= REG_THRESHOLD or TIMER >= REG_TIMEOUT) then
+							STATE <= "01";
+							ITYPE <= PENDING_TO_TYPE(PENDING);
+							--interrupt forwarding
+							RCV_INT_TYPE <= PENDING_TO_TYPE(PENDING);
+						else
+							TIMER <= TIMER + 1;
+						end if;
 					end if;
-				end if;
-			when '1' =>
-				if(RCV_INT_RESPONSE = '1') then
-					STATE <= '0';
-					ITYPE <= "000000";
-					RCV_INT_TYPE <= "000000";
-				end if;
-			when others => STATE <= STATE;
-		end case;
+				when "01" =>
+					if(RCV_INT_RESPONSE = '1') then
+						STATE <= "10";
+						ITYPE <= "000000";
+						RCV_INT_TYPE <= "000000";
+					end if;
+				when "10" =>
+					-- the pending bitmap read above releases this state
+					STATE <= STATE;
+				when others => STATE <= "00";
+			end case;
+		end if;
 	end if;
 end if;
 end if;
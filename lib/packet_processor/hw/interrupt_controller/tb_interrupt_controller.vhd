@@ -16,6 +16,8 @@
 
 package config is
 	constant SLAVES: integer := 2;
+	constant COALESCE_THRESHOLD: integer := 2;
+	constant COALESCE_TIMEOUT: integer := 16;
 end config;
 
 use work.config.all;
@@ -29,17 +31,22 @@ end tb_interrupt_controller;
 
 architecture behav of tb_interrupt_controller is
 
-signal sigIN: std_logic_vector(SLAVES+2 downto 0);
-signal sigINresp: std_logic_vector(SLAVES+2 downto 0);
+signal sigIN: std_logic_vector(SLAVES+4 downto 0);
+signal sigINresp: std_logic_vector(SLAVES+4 downto 0);
 signal sigitype: std_logic_vector(5 downto 0);
-signal siginum: std_logic_vector(integer(ceil(log2(real(SLAVES+3))))-1 downto 0);
+signal siginum: std_logic_vector(integer(ceil(log2(real(SLAVES+5))))-1 downto 0);
 signal iresponse: std_logic;
 signal aql_left: std_logic;
 signal aql_left_resp: std_logic;
 signal aql_left_resp_write: std_logic;
-signal sigcuint: std_logic_vector(SLAVES+1 downto 0);
-signal sigcuint_resp: std_logic_vector(SLAVES+1 downto 0);
-signal sigcunum: std_logic_vector(integer(ceil(log2(real(SLAVES+2))))-1 downto 0);
+signal pending: std_logic_vector(SLAVES+3 downto 0);
+signal pending_read: std_logic;
+signal coalesce: std_logic_vector(47 downto 0);
+signal coalesce_resp: std_logic_vector(47 downto 0);
+signal coalesce_resp_write: std_logic;
+signal sigcuint: std_logic_vector(SLAVES+3 downto 0);
+signal sigcuint_resp: std_logic_vector(SLAVES+3 downto 0);
+signal sigcunum: std_logic_vector(integer(ceil(log2(real(SLAVES+4))))-1 downto 0);
 signal sigworkint: std_logic;
 signal enable: std_logic;
 signal reset: std_logic;
@@ -47,20 +54,27 @@ signal clock: std_logic;
 
 component INTERRUPT_CONTROLLER
 generic(
-	N: integer := 4
+	N: integer := 4;
+	C_COALESCE_THRESHOLD: integer := 1;
+	C_COALESCE_TIMEOUT: integer := 0
 );
 port(
-    	RCV_INT_LANES: in std_logic_vector(N+2 downto 0);
-    	RCV_INT_LANES_RESPONSE: out std_logic_vector(N+2 downto 0);
+    	RCV_INT_LANES: in std_logic_vector(N+4 downto 0);
+    	RCV_INT_LANES_RESPONSE: out std_logic_vector(N+4 downto 0);
 	RCV_INT_TYPE: out std_logic_vector(5 downto 0);
-	RCV_INT_NUM: out std_logic_vector(integer(ceil(log2(real(N+3))))-1 downto 0);
+	RCV_INT_NUM: out std_logic_vector(integer(ceil(log2(real(N+5))))-1 downto 0);
 	RCV_INT_RESPONSE: in std_logic;
 	RCV_WORK_LEFT: out std_logic;
 	RCV_WORK_LEFT_RESPONSE: in std_logic;
 	RCV_WORK_LEFT_RESPONSE_WRITE: in std_logic;
-    	SND_INT_LANES: out std_logic_vector(N+1 downto 0);
-	SND_INT_LANES_RESPONSE: in std_logic_vector(N+1 downto 0);
-	SND_INT_NUM: in std_logic_vector(integer(ceil(log2(real(N+2))))-1 downto 0);
+	RCV_INT_PENDING: out std_logic_vector(N+3 downto 0);
+	RCV_INT_PENDING_READ: in std_logic;
+	RCV_INT_COALESCE: out std_logic_vector(47 downto 0);
+	RCV_INT_COALESCE_RESPONSE: in std_logic_vector(47 downto 0);
+	RCV_INT_COALESCE_RESPONSE_WRITE: in std_logic;
+    	SND_INT_LANES: out std_logic_vector(N+3 downto 0);
+	SND_INT_LANES_RESPONSE: in std_logic_vector(N+3 downto 0);
+	SND_INT_NUM: in std_logic_vector(integer(ceil(log2(real(N+4))))-1 downto 0);
 	SND_INT_SIG: in std_logic;
     	EN: in std_logic;
 	RE: in std_logic;
@@ -72,7 +86,9 @@ begin
 
 uut: INTERRUPT_CONTROLLER
 generic map(
-	N => SLAVES
+	N => SLAVES,
+	C_COALESCE_THRESHOLD => COALESCE_THRESHOLD,
+	C_COALESCE_TIMEOUT => COALESCE_TIMEOUT
 )
 port map(
 	RCV_INT_LANES => sigIN,
@@ -83,6 +99,11 @@ port map(
 	RCV_WORK_LEFT => aql_left,
 	RCV_WORK_LEFT_RESPONSE => aql_left_resp,
 	RCV_WORK_LEFT_RESPONSE_WRITE => aql_left_resp_write,
+	RCV_INT_PENDING => pending,
+	RCV_INT_PENDING_READ => pending_read,
+	RCV_INT_COALESCE => coalesce,
+	RCV_INT_COALESCE_RESPONSE => coalesce_resp,
+	RCV_INT_COALESCE_RESPONSE_WRITE => coalesce_resp_write,
     	SND_INT_LANES => sigcuint,
 	SND_INT_LANES_RESPONSE => sigcuint_resp,
 	SND_INT_NUM => sigcunum,
@@ -99,77 +120,110 @@ begin
   iresponse <= '0';
   aql_left_resp <= '0';
   aql_left_resp_write <= '0';
-  sigcuint_resp <= "0000";
-  sigcunum <= "00";
+  pending_read <= '0';
+  coalesce_resp <= (others => '0');
+  coalesce_resp_write <= '0';
+  sigIN <= "0000000";
+  sigcuint_resp <= "000000";
+  sigcunum <= "000";
   sigworkint <= '0';
   -- TPC sends a signal that aql packets have arrived
   wait for 25 ns;
   reset <= '1';
-  sigIN <= "10000";
-  wait for 10 ns;
-  sigIN <= "00000";
+  sigIN <= "1000000";
+  wait for 20 ns;
+  sigIN <= "0000000";
   -- PP starts dispatching jobs when the work bit is set
   if(aql_left /= '1') then
   	wait until aql_left = '1';
   end if;
   wait for 25 ns;
   -- notify CU 1
-  sigcunum <= "01";
+  sigcunum <= "001";
   sigworkint <= '1';
   wait for 20 ns;
-  sigcunum <= "00";
+  sigcunum <= "000";
   sigworkint <= '0';
   -- CU is processing the job
-  if(sigcuint /= "0010") then
-  	wait until sigcuint = "0010";
+  if(sigcuint /= "000010") then
+  	wait until sigcuint = "000010";
   end if;
   wait for 25 ns;
-  sigcuint_resp <= "0010";
+  sigcuint_resp <= "000010";
   wait for 20 ns;
-  sigcuint_resp <= "0000";
+  sigcuint_resp <= "000000";
+  -- CU 1 and the DMA engine finish shortly after each other,
+  -- the threshold of two events lets both arrive with one interrupt
   wait for 100 ns;
-  sigIN <= "00010";
+  sigIN <= "0000010";
   wait for 20 ns;
-  sigIN <= "00000";
-  -- when the PP gets the job response it sends the ack
-  if(sigitype /= "100000") then
-  	wait until sigitype = "100000";
+  sigIN <= "0000000";
+  wait for 40 ns;
+  assert sigitype = "000000" report "interrupt raised below coalescing threshold" severity error;
+  sigIN <= "0100000";
+  wait for 20 ns;
+  sigIN <= "0000000";
+  if(sigitype /= "110000") then
+  	wait until sigitype = "110000";
   end if;
   wait for 25 ns;
   iresponse <= '1';
   wait for 20 ns;
   iresponse <= '0';
+  -- PP drains the pending bitmap in one exception
   wait for 20 ns;
-  -- PP sends the completion signal
-  -- notify DMA via DEC signal
-  sigcunum <= "11";
-  sigworkint <= '1';
+  pending_read <= '1';
   wait for 20 ns;
-  sigcunum <= "00";
-  sigworkint <= '0';
-  -- DMA controller is processing the job
-  if(sigcuint /= "1000") then
-  	wait until sigcuint = "1000";
+  pending_read <= '0';
+  assert pending = "100010" report "pending bitmap should hold DMA and CU 1" severity error;
+  -- a single completion event is delivered after the coalescing timeout
+  wait for 20 ns;
+  sigIN <= "0010000";
+  wait for 20 ns;
+  sigIN <= "0000000";
+  wait for (COALESCE_TIMEOUT-4)*20 ns;
+  assert sigitype = "000000" report "interrupt raised before the coalescing timeout" severity error;
+  if(sigitype /= "001000") then
+  	wait until sigitype = "001000" for 10*20 ns;
   end if;
+  assert sigitype = "001000" report "no interrupt after the coalescing timeout" severity error;
   wait for 25 ns;
-  sigcuint_resp <= "1000";
+  iresponse <= '1';
   wait for 20 ns;
-  sigcuint_resp <= "0000";
-  wait for 100 ns;
-  sigIN <= "00100";
+  iresponse <= '0';
   wait for 20 ns;
-  sigIN <= "00000";
-  -- when the PP gets the completion job response it sends the ack and signals that no more work is left
-  if(sigitype /= "001000") then
-  	wait until sigitype = "001000";
+  pending_read <= '1';
+  wait for 20 ns;
+  pending_read <= '0';
+  assert pending = "010000" report "pending bitmap should hold the completion event" severity error;
+  -- switch off coalescing and signal that no more work is left
+  wait for 20 ns;
+  coalesce_resp <= x"000100000000";
+  coalesce_resp_write <= '1';
+  wait for 20 ns;
+  coalesce_resp_write <= '0';
+  -- without coalescing the next event is delivered at once
+  wait for 20 ns;
+  sigIN <= "0000001";
+  wait for 20 ns;
+  sigIN <= "0000000";
+  if(sigitype /= "100000") then
+  	wait until sigitype = "100000" for 6*20 ns;
   end if;
+  assert sigitype = "100000" report "interrupt delayed without coalescing" severity error;
   wait for 25 ns;
   iresponse <= '1';
   wait for 20 ns;
   iresponse <= '0';
   wait for 20 ns;
+  pending_read <= '1';
+  wait for 20 ns;
+  pending_read <= '0';
+  assert pending = "000001" report "pending bitmap should hold CU 0" severity error;
   aql_left_resp <= '0';
   aql_left_resp_write <= '1';
+  wait for 20 ns;
+  aql_left_resp_write <= '0';
   wait;
 end process;
 
@@ -182,4 +236,3 @@ wait for 10 ns;
 end process;
 
 end behav;
-
@@ -33,7 +33,11 @@ entity external_memory_interface_pp is
 		C_DATA_AXI_CACHEABLE_TXN		: boolean		:= false;
 		C_IRQ_WORK_LEFT_ADDR			: std_logic_vector	:= x"0002000000000000";
 		C_IRQ_SND_NUM_ADDR			: std_logic_vector	:= x"0002000000000008";
-		C_IRQ_RCV_NUM_ADDR			: std_logic_vector	:= x"0002000000000010"
+		C_IRQ_RCV_NUM_ADDR			: std_logic_vector	:= x"0002000000000010";
+		C_IRQ_PENDING_ADDR			: std_logic_vector	:= x"0002000000000018";
+		C_IRQ_COALESCE_ADDR			: std_logic_vector	:= x"0002000000000020";
+		C_CMPL_DEC_ADDR				: std_logic_vector	:= x"0002000000000028";
+		C_CMPL_DEC_STATUS_ADDR			: std_logic_vector	:= x"0002000000000030"
     );
     port(
         clk                     : in    std_logic;
@@ -61,6 +65,16 @@ entity external_memory_interface_pp is
 	RCV_WORK_LEFT_RESPONSE_WRITE	: out std_logic;
 	SND_INT_NUM			: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
 	SND_INT_SIG			: out std_logic;
+	RCV_INT_PENDING			: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_PENDING_READ		: out std_logic;
+	RCV_INT_COALESCE		: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_COALESCE_RESPONSE	: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_COALESCE_RESPONSE_WRITE	: out std_logic;
+	
+	-- to completion signal engine
+	CMPL_DEC_SIG_ADDR		: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	CMPL_DEC_START			: out std_logic;
+	CMPL_DEC_STATUS			: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
 	
 	-- AXI clock and reset
 	cmd_axi_aclk      : in    std_logic; 
@@ -229,7 +243,7 @@ end component axi_full_master;
     signal s_write_busy    : std_logic;
 
 -- requested memory location
-    type mem_location is (NONE,WORK_LEFT,SND_IRQ,RCV_IRQ_NUM,CMD_AXI,DATA_AXI);
+    type mem_location is (NONE,WORK_LEFT,SND_IRQ,RCV_IRQ_NUM,IRQ_PENDING,IRQ_COALESCE,CMPL_DEC,CMPL_DEC_STATUS,CMD_AXI,DATA_AXI);
     signal access_location : mem_location;
     signal access_location_delayed : mem_location;
 
@@ -387,6 +401,18 @@ begin
 	-- get number of interrupt device
 	elsif(data_addr = C_IRQ_RCV_NUM_ADDR) then
 		access_location <= RCV_IRQ_NUM;
+	-- get and clear pending interrupt bitmap
+	elsif(data_addr = C_IRQ_PENDING_ADDR) then
+		access_location <= IRQ_PENDING;
+	-- interrupt coalescing configuration
+	elsif(data_addr = C_IRQ_COALESCE_ADDR) then
+		access_location <= IRQ_COALESCE;
+	-- start completion signal decrement
+	elsif(data_addr = C_CMPL_DEC_ADDR) then
+		access_location <= CMPL_DEC;
+	-- state of completion signal engine
+	elsif(data_addr = C_CMPL_DEC_STATUS_ADDR) then
+		access_location <= CMPL_DEC_STATUS;
 	-- address points to CMD AXI bus
 	elsif((data_addr >= C_CMD_LOW_ADDR) AND (data_addr < C_CMD_HIGH_ADDR)) then
 		access_location <= CMD_AXI;
@@ -406,6 +432,11 @@ begin
 	RCV_WORK_LEFT_RESPONSE_WRITE 	<= '0';
 	SND_INT_SIG 			<= '0';
 	SND_INT_NUM 			<= std_logic_vector(resize(unsigned(data_din),SND_INT_NUM'length));
+	RCV_INT_PENDING_READ		<= '0';
+	RCV_INT_COALESCE_RESPONSE	<= data_din;
+	RCV_INT_COALESCE_RESPONSE_WRITE	<= '0';
+	CMPL_DEC_SIG_ADDR		<= data_din;
+	CMPL_DEC_START			<= '0';
 	a_cmd_addr 	<= (others => '0');
 	a_cmd_dw 	<= (others => '0');
 	a_data_addr 	<= (others => '0');
@@ -421,9 +452,12 @@ begin
 
 	if(data_re = '1') then
 		-- send interrupt
-		if(access_location = SND_IRQ) then
+		if(access_location = SND_IRQ or access_location = CMPL_DEC) then
 			-- cannot be read
         		address_error_exc_load  <= '1';
+		-- get and clear pending interrupt bitmap
+		elsif(access_location = IRQ_PENDING) then
+			RCV_INT_PENDING_READ <= '1'; -- only one cycle
 		-- address points to CMD AXI bus
 		elsif(access_location = CMD_AXI) then
 			s_read_busy <= '1';
@@ -435,7 +469,7 @@ begin
 			a_data_addr <= data_addr;
 			a_data_re <= '1';
 		-- else address is invalid or no memory operation performed
-		elsif(access_location /= WORK_LEFT and access_location /= RCV_IRQ_NUM) then
+		elsif(access_location /= WORK_LEFT and access_location /= RCV_IRQ_NUM and access_location /= IRQ_COALESCE and access_location /= CMPL_DEC_STATUS) then
         		address_error_exc_load  <= '1';
 		end if;
 	elsif(data_we = '1') then
@@ -448,9 +482,17 @@ begin
 			-- default value is correct value
 			SND_INT_SIG <= '1'; -- only one cycle
 		-- get number of interrupt device
-		elsif(access_location = RCV_IRQ_NUM) then
+		elsif(access_location = RCV_IRQ_NUM or access_location = IRQ_PENDING or access_location = CMPL_DEC_STATUS) then
 			-- cannot be written
         		address_error_exc_store <= '1';
+		-- interrupt coalescing configuration
+		elsif(access_location = IRQ_COALESCE) then
+			-- default value is correct value
+			RCV_INT_COALESCE_RESPONSE_WRITE <= '1'; -- only one cycle
+		-- start completion signal decrement
+		elsif(access_location = CMPL_DEC) then
+			-- default value is correct value
+			CMPL_DEC_START <= '1'; -- only one cycle
 		-- address points to CMD AXI bus
 		elsif(access_location = CMD_AXI) then
 			s_write_busy <= '1';
@@ -470,7 +512,7 @@ begin
 	end if;
 end process;
 
-collect_data: process(access_location_delayed,RCV_WORK_LEFT,RCV_INT_NUM,a_cmd_dr_del,a_data_dr_del)
+collect_data: process(access_location_delayed,RCV_WORK_LEFT,RCV_INT_NUM,RCV_INT_PENDING,RCV_INT_COALESCE,CMPL_DEC_STATUS,a_cmd_dr_del,a_data_dr_del)
 begin
 	-- access to WORK_LEFT register in interrupt controller
 	if(access_location_delayed = WORK_LEFT) then
@@ -479,6 +521,15 @@ begin
 	-- get number of interrupt device
 	elsif(access_location_delayed = RCV_IRQ_NUM) then
 		data_dout <= RCV_INT_NUM;
+	-- pending interrupt bitmap captured by the read
+	elsif(access_location_delayed = IRQ_PENDING) then
+		data_dout <= RCV_INT_PENDING;
+	-- interrupt coalescing configuration
+	elsif(access_location_delayed = IRQ_COALESCE) then
+		data_dout <= RCV_INT_COALESCE;
+	-- state of completion signal engine
+	elsif(access_location_delayed = CMPL_DEC_STATUS) then
+		data_dout <= CMPL_DEC_STATUS;
 	-- address points to CMD AXI bus
 	elsif(access_location_delayed = CMD_AXI) then
 		data_dout <= a_cmd_dr_del;
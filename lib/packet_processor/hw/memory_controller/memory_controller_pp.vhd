@@ -41,12 +41,22 @@ entity memory_controller_pp is
 	C_IRQ_WORK_LEFT_ADDR		: std_logic_vector	:= x"0002000000000000";
 	C_IRQ_SND_NUM_ADDR		: std_logic_vector	:= x"0002000000000008";
 	C_IRQ_RCV_NUM_ADDR		: std_logic_vector	:= x"0002000000000010";
+	C_IRQ_PENDING_ADDR		: std_logic_vector	:= x"0002000000000018";
+	C_IRQ_COALESCE_ADDR		: std_logic_vector	:= x"0002000000000020";
+	C_CMPL_DEC_ADDR			: std_logic_vector	:= x"0002000000000028";
+	C_CMPL_DEC_STATUS_ADDR		: std_logic_vector	:= x"0002000000000030";
         C_IMEM_LOW_ADDR       		: std_logic_vector	:= x"0003000000000000";
     	C_IMEM_BRAM_SIZE       		: integer 		:= 16348;
         C_IMEM_INIT_FILE  		: string 		:= "";
         C_DMEM_LOW_ADDR       		: std_logic_vector 	:= x"0003000002000000";
         C_DMEM_BRAM_SIZE       		: integer 		:= 16348;
-        C_DMEM_INIT_FILE  		: string 		:= ""
+        C_DMEM_INIT_FILE  		: string 		:= "";
+	C_ICACHE_ENABLE			: boolean		:= false;
+	C_ICACHE_LOW_ADDR		: std_logic_vector	:= x"0001000000003000";
+	C_ICACHE_SIZE			: integer		:= 65536;
+	C_ICACHE_LINES			: integer		:= 64;
+	C_ICACHE_LINE_SIZE		: integer		:= 32;
+	C_ICACHE_PREFETCH		: boolean		:= true
     );
     port(
         clk                     : in    std_logic;
@@ -80,6 +90,16 @@ entity memory_controller_pp is
 	RCV_WORK_LEFT_RESPONSE_WRITE	: out std_logic;
 	SND_INT_NUM			: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
 	SND_INT_SIG			: out std_logic;
+	RCV_INT_PENDING			: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_PENDING_READ		: out std_logic;
+	RCV_INT_COALESCE		: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_COALESCE_RESPONSE	: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_COALESCE_RESPONSE_WRITE	: out std_logic;
+	
+	-- to completion signal engine
+	CMPL_DEC_SIG_ADDR		: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	CMPL_DEC_START			: out std_logic;
+	CMPL_DEC_STATUS			: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
 	
 	-- AXI clock and reset
 	cmd_axi_aclk      : in    std_logic; 
@@ -166,7 +186,11 @@ component external_memory_interface_pp is
 		C_DATA_AXI_CACHEABLE_TXN		: boolean		:= false;
 		C_IRQ_WORK_LEFT_ADDR			: std_logic_vector	:= x"0002000000000000";
 		C_IRQ_SND_NUM_ADDR			: std_logic_vector	:= x"0002000000000008";
-		C_IRQ_RCV_NUM_ADDR			: std_logic_vector	:= x"0002000000000010"
+		C_IRQ_RCV_NUM_ADDR			: std_logic_vector	:= x"0002000000000010";
+		C_IRQ_PENDING_ADDR			: std_logic_vector	:= x"0002000000000018";
+		C_IRQ_COALESCE_ADDR			: std_logic_vector	:= x"0002000000000020";
+		C_CMPL_DEC_ADDR				: std_logic_vector	:= x"0002000000000028";
+		C_CMPL_DEC_STATUS_ADDR			: std_logic_vector	:= x"0002000000000030"
     );
     port(
         clk                     : in    std_logic;
@@ -194,6 +218,16 @@ component external_memory_interface_pp is
 	RCV_WORK_LEFT_RESPONSE_WRITE	: out std_logic;
 	SND_INT_NUM			: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
 	SND_INT_SIG			: out std_logic;
+	RCV_INT_PENDING			: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_PENDING_READ		: out std_logic;
+	RCV_INT_COALESCE		: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_COALESCE_RESPONSE	: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_COALESCE_RESPONSE_WRITE	: out std_logic;
+	
+	-- to completion signal engine
+	CMPL_DEC_SIG_ADDR		: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	CMPL_DEC_START			: out std_logic;
+	CMPL_DEC_STATUS			: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
 	
 	-- AXI clock and reset
 	cmd_axi_aclk      : in    std_logic; 
@@ -273,7 +307,13 @@ Generic(
     DMEM_ADDR       : std_logic_vector := x"00000000";
     DMEM_SIZE       : integer := 16#1000#;
     DMEM_WIDTH      : integer := 32;
-    DMEM_INIT_FILE  : string := ""
+    DMEM_INIT_FILE  : string := "";
+    ICACHE_ENABLE   : boolean := false;
+    ICACHE_ADDR     : std_logic_vector := x"00010000";
+    ICACHE_SIZE     : integer := 16#10000#;
+    ICACHE_LINES    : integer := 64;
+    ICACHE_LINE_SIZE: integer := 32;
+    ICACHE_PREFETCH : boolean := true
 );
 Port (
     clk             : in    std_logic;
@@ -342,7 +382,11 @@ external_memory_interface_inst: external_memory_interface_pp
 		C_DATA_AXI_CACHEABLE_TXN=> C_DATA_AXI_CACHEABLE_TXN,
 		C_IRQ_WORK_LEFT_ADDR	=> C_IRQ_WORK_LEFT_ADDR,	
 		C_IRQ_SND_NUM_ADDR	=> C_IRQ_SND_NUM_ADDR,	
-		C_IRQ_RCV_NUM_ADDR	=> C_IRQ_RCV_NUM_ADDR	
+		C_IRQ_RCV_NUM_ADDR	=> C_IRQ_RCV_NUM_ADDR,
+		C_IRQ_PENDING_ADDR	=> C_IRQ_PENDING_ADDR,
+		C_IRQ_COALESCE_ADDR	=> C_IRQ_COALESCE_ADDR,
+		C_CMPL_DEC_ADDR		=> C_CMPL_DEC_ADDR,
+		C_CMPL_DEC_STATUS_ADDR	=> C_CMPL_DEC_STATUS_ADDR
     )
     port map(
         clk                     => clk,
@@ -369,6 +413,16 @@ external_memory_interface_inst: external_memory_interface_pp
 	RCV_WORK_LEFT_RESPONSE_WRITE	=> RCV_WORK_LEFT_RESPONSE_WRITE,
 	SND_INT_NUM			=> SND_INT_NUM,
 	SND_INT_SIG			=> SND_INT_SIG,
+	RCV_INT_PENDING			=> RCV_INT_PENDING,
+	RCV_INT_PENDING_READ		=> RCV_INT_PENDING_READ,
+	RCV_INT_COALESCE		=> RCV_INT_COALESCE,
+	RCV_INT_COALESCE_RESPONSE	=> RCV_INT_COALESCE_RESPONSE,
+	RCV_INT_COALESCE_RESPONSE_WRITE	=> RCV_INT_COALESCE_RESPONSE_WRITE,
+	
+	-- to completion signal engine
+	CMPL_DEC_SIG_ADDR		=> CMPL_DEC_SIG_ADDR,
+	CMPL_DEC_START			=> CMPL_DEC_START,
+	CMPL_DEC_STATUS			=> CMPL_DEC_STATUS,
 	
 	-- AXI clock and reset
 	cmd_axi_aclk      => cmd_axi_aclk,
@@ -447,7 +501,13 @@ generic map(
     DMEM_ADDR       	=> C_DMEM_LOW_ADDR,
     DMEM_SIZE       	=> C_DMEM_BRAM_SIZE,
     DMEM_WIDTH      	=> C_CPU_DATA_WIDTH,
-    DMEM_INIT_FILE      => C_DMEM_INIT_FILE
+    DMEM_INIT_FILE      => C_DMEM_INIT_FILE,
+    ICACHE_ENABLE       => C_ICACHE_ENABLE,
+    ICACHE_ADDR         => C_ICACHE_LOW_ADDR,
+    ICACHE_SIZE         => C_ICACHE_SIZE,
+    ICACHE_LINES        => C_ICACHE_LINES,
+    ICACHE_LINE_SIZE    => C_ICACHE_LINE_SIZE,
+    ICACHE_PREFETCH     => C_ICACHE_PREFETCH
 )
 port map(
     clk            => clk, 
@@ -26,6 +26,8 @@ entity packet_processor_top is
         -- interrupts
         G_TIMER_INTERRUPT               : boolean := false;
 	G_NUM_ACCELERATOR_CORES		: integer := 1;
+	G_IRQ_COALESCE_THRESHOLD	: integer := 1;
+	G_IRQ_COALESCE_TIMEOUT		: integer := 0;
         -- exceptions
         G_EXC_ADDRESS_ERROR_LOAD        : boolean := false;
         G_EXC_ADDRESS_ERROR_FETCH       : boolean := false;
@@ -42,6 +44,12 @@ entity packet_processor_top is
         -- memory configuration
         G_MEM_NUM_4K_DATA_MEMS          : integer := 2;
         G_MEM_NUM_4K_INSTR_MEMS         : integer := 3;
+        -- optional instruction cache for a text region in dram
+        G_ICACHE_ENABLE                 : boolean := false;
+        G_ICACHE_LINES                  : integer := 64;
+        G_ICACHE_LINE_SIZE              : integer := 32;
+        G_ICACHE_PREFETCH               : boolean := true;
+        G_DRAM_TEXT_SIZE                : integer := 65536;
 	-- configuration addresses	
 	C_CMD_LOW_ADDR			: std_logic_vector	:= x"0002000000000000";
 	C_CMD_HIGH_ADDR			: std_logic_vector	:= x"0002000000100000";
@@ -55,10 +63,17 @@ entity packet_processor_top is
 	C_IRQ_WORK_LEFT_ADDR		: std_logic_vector	:= x"0002000000000000";
 	C_IRQ_SND_NUM_ADDR		: std_logic_vector	:= x"0002000000000008";
 	C_IRQ_RCV_NUM_ADDR		: std_logic_vector	:= x"0002000000000010";
+	C_IRQ_PENDING_ADDR		: std_logic_vector	:= x"0002000000000018";
+	C_IRQ_COALESCE_ADDR		: std_logic_vector	:= x"0002000000000020";
+	C_CMPL_DEC_ADDR			: std_logic_vector	:= x"0002000000000028";
+	C_CMPL_DEC_STATUS_ADDR		: std_logic_vector	:= x"0002000000000030";
+	C_SIG_AXI_ADDR_WIDTH		: integer		:= 64;
+	C_SIG_AXI_DATA_WIDTH		: integer		:= 64;
     	C_IMEM_LOW_ADDR       		: std_logic_vector	:= x"0003000000000000";
         C_IMEM_INIT_FILE    		: string 		:= "";
     	C_DMEM_LOW_ADDR       		: std_logic_vector 	:= x"0003000002000000";
-        C_DMEM_INIT_FILE    		: string 		:= ""
+        C_DMEM_INIT_FILE    		: string 		:= "";
+	C_DRAM_TEXT_LOW_ADDR		: std_logic_vector	:= x"0001000000003000"
     );
     port(
         tp_clk                  : in  std_logic;
@@ -94,6 +109,8 @@ entity packet_processor_top is
 	cmd_axi_aresetn   : in    std_logic;
 	data_axi_aclk     : in    std_logic;                                              
 	data_axi_aresetn  : in    std_logic;
+	sig_axi_aclk      : in    std_logic;
+	sig_axi_aresetn   : in    std_logic;
 	
 	cmd_axi_awaddr	: out std_logic_vector(C_CMD_AXI_ADDR_WIDTH-1 downto 0);   
 	cmd_axi_awprot	: out std_logic_vector(2 downto 0);
@@ -151,7 +168,46 @@ entity packet_processor_top is
 	data_axi_rresp	: in  std_logic_vector(1 downto 0);
 	data_axi_rlast	: in  std_logic;
 	data_axi_rvalid	: in  std_logic;
-	data_axi_rready	: out std_logic
+	data_axi_rready	: out std_logic;
+
+	-- completion signal updates in host memory
+	sig_axi_awid	: out std_logic_vector(0 downto 0);
+	sig_axi_awaddr	: out std_logic_vector(C_SIG_AXI_ADDR_WIDTH-1 downto 0);
+	sig_axi_awlen	: out std_logic_vector(7 downto 0);
+	sig_axi_awsize	: out std_logic_vector(2 downto 0);
+	sig_axi_awburst	: out std_logic_vector(1 downto 0);
+	sig_axi_awlock	: out std_logic;
+	sig_axi_awcache	: out std_logic_vector(3 downto 0);
+	sig_axi_awprot	: out std_logic_vector(2 downto 0);
+	sig_axi_awqos	: out std_logic_vector(3 downto 0);
+	sig_axi_awvalid	: out std_logic;
+	sig_axi_awready	: in  std_logic;
+	sig_axi_wdata	: out std_logic_vector(C_SIG_AXI_DATA_WIDTH-1 downto 0);
+	sig_axi_wstrb	: out std_logic_vector(C_SIG_AXI_DATA_WIDTH/8-1 downto 0);
+	sig_axi_wlast	: out std_logic;
+	sig_axi_wvalid	: out std_logic;
+	sig_axi_wready	: in  std_logic;
+	sig_axi_bid	: in  std_logic_vector(0 downto 0);
+	sig_axi_bresp	: in  std_logic_vector(1 downto 0);
+	sig_axi_bvalid	: in  std_logic;
+	sig_axi_bready	: out std_logic;
+	sig_axi_arid	: out std_logic_vector(0 downto 0);
+	sig_axi_araddr	: out std_logic_vector(C_SIG_AXI_ADDR_WIDTH-1 downto 0);
+	sig_axi_arlen	: out std_logic_vector(7 downto 0);
+	sig_axi_arsize	: out std_logic_vector(2 downto 0);
+	sig_axi_arburst	: out std_logic_vector(1 downto 0);
+	sig_axi_arlock	: out std_logic;
+	sig_axi_arcache	: out std_logic_vector(3 downto 0);
+	sig_axi_arprot	: out std_logic_vector(2 downto 0);
+	sig_axi_arqos	: out std_logic_vector(3 downto 0);
+	sig_axi_arvalid	: out std_logic;
+	sig_axi_arready	: in  std_logic;
+	sig_axi_rid	: in  std_logic_vector(0 downto 0);
+	sig_axi_rdata	: in  std_logic_vector(C_SIG_AXI_DATA_WIDTH-1 downto 0);
+	sig_axi_rresp	: in  std_logic_vector(1 downto 0);
+	sig_axi_rlast	: in  std_logic;
+	sig_axi_rvalid	: in  std_logic;
+	sig_axi_rready	: out std_logic
     );
 end entity;
 
@@ -239,12 +295,22 @@ component memory_controller_pp is
 	C_IRQ_WORK_LEFT_ADDR	: std_logic_vector	:= x"0002000000000000";
 	C_IRQ_SND_NUM_ADDR	: std_logic_vector	:= x"0002000000000008";
 	C_IRQ_RCV_NUM_ADDR	: std_logic_vector	:= x"0002000000000010";
+	C_IRQ_PENDING_ADDR	: std_logic_vector	:= x"0002000000000018";
+	C_IRQ_COALESCE_ADDR	: std_logic_vector	:= x"0002000000000020";
+	C_CMPL_DEC_ADDR		: std_logic_vector	:= x"0002000000000028";
+	C_CMPL_DEC_STATUS_ADDR	: std_logic_vector	:= x"0002000000000030";
     	C_IMEM_LOW_ADDR       	: std_logic_vector	:= x"0003000000000000";
     	C_IMEM_BRAM_SIZE       	: integer 		:= 16348;
         C_IMEM_INIT_FILE  	: string 		:= "";
     	C_DMEM_LOW_ADDR       	: std_logic_vector 	:= x"0003000002000000";
     	C_DMEM_BRAM_SIZE       	: integer 		:= 16348;
-        C_DMEM_INIT_FILE  	: string 		:= ""
+        C_DMEM_INIT_FILE  	: string 		:= "";
+	C_ICACHE_ENABLE		: boolean		:= false;
+	C_ICACHE_LOW_ADDR	: std_logic_vector	:= x"0001000000003000";
+	C_ICACHE_SIZE		: integer		:= 65536;
+	C_ICACHE_LINES		: integer		:= 64;
+	C_ICACHE_LINE_SIZE	: integer		:= 32;
+	C_ICACHE_PREFETCH	: boolean		:= true
     );
     port(
         clk                     : in    std_logic;
@@ -278,6 +344,14 @@ component memory_controller_pp is
 	RCV_WORK_LEFT_RESPONSE_WRITE	: out std_logic;
 	SND_INT_NUM			: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
 	SND_INT_SIG			: out std_logic;
+	RCV_INT_PENDING			: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_PENDING_READ		: out std_logic;
+	RCV_INT_COALESCE		: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_COALESCE_RESPONSE	: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	RCV_INT_COALESCE_RESPONSE_WRITE	: out std_logic;
+	CMPL_DEC_SIG_ADDR		: out std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
+	CMPL_DEC_START			: out std_logic;
+	CMPL_DEC_STATUS			: in std_logic_vector(C_CPU_DATA_WIDTH-1 downto 0);
 
 	-- AXI clock and reset
 	cmd_axi_aclk   	: in    std_logic;                                              
@@ -347,9 +421,64 @@ component memory_controller_pp is
     );
 end component;
 
+component COMPLETION_SIGNAL_ENGINE
+generic(
+	C_M_AXI_ADDR_WIDTH: integer := 64;
+	C_M_AXI_DATA_WIDTH: integer := 64
+);
+port(
+	SIG_ADDR: in std_logic_vector(C_M_AXI_ADDR_WIDTH-1 downto 0);
+	SIG_START: in std_logic;
+	SIG_STATUS: out std_logic_vector(2 downto 0);
+	RE: in std_logic;
+	CLK: in std_logic;
+	M_AXI_ACLK: in std_logic;
+	M_AXI_ARESETN: in std_logic;
+	M_AXI_AWID: out std_logic_vector(0 downto 0);
+	M_AXI_AWADDR: out std_logic_vector(C_M_AXI_ADDR_WIDTH-1 downto 0);
+	M_AXI_AWLEN: out std_logic_vector(7 downto 0);
+	M_AXI_AWSIZE: out std_logic_vector(2 downto 0);
+	M_AXI_AWBURST: out std_logic_vector(1 downto 0);
+	M_AXI_AWLOCK: out std_logic;
+	M_AXI_AWCACHE: out std_logic_vector(3 downto 0);
+	M_AXI_AWPROT: out std_logic_vector(2 downto 0);
+	M_AXI_AWQOS: out std_logic_vector(3 downto 0);
+	M_AXI_AWVALID: out std_logic;
+	M_AXI_AWREADY: in std_logic;
+	M_AXI_WDATA: out std_logic_vector(C_M_AXI_DATA_WIDTH-1 downto 0);
+	M_AXI_WSTRB: out std_logic_vector(C_M_AXI_DATA_WIDTH/8-1 downto 0);
+	M_AXI_WLAST: out std_logic;
+	M_AXI_WVALID: out std_logic;
+	M_AXI_WREADY: in std_logic;
+	M_AXI_BID: in std_logic_vector(0 downto 0);
+	M_AXI_BRESP: in std_logic_vector(1 downto 0);
+	M_AXI_BVALID: in std_logic;
+	M_AXI_BREADY: out std_logic;
+	M_AXI_ARID: out std_logic_vector(0 downto 0);
+	M_AXI_ARADDR: out std_logic_vector(C_M_AXI_ADDR_WIDTH-1 downto 0);
+	M_AXI_ARLEN: out std_logic_vector(7 downto 0);
+	M_AXI_ARSIZE: out std_logic_vector(2 downto 0);
+	M_AXI_ARBURST: out std_logic_vector(1 downto 0);
+	M_AXI_ARLOCK: out std_logic;
+	M_AXI_ARCACHE: out std_logic_vector(3 downto 0);
+	M_AXI_ARPROT: out std_logic_vector(2 downto 0);
+	M_AXI_ARQOS: out std_logic_vector(3 downto 0);
+	M_AXI_ARVALID: out std_logic;
+	M_AXI_ARREADY: in std_logic;
+	M_AXI_RID: in std_logic_vector(0 downto 0);
+	M_AXI_RDATA: in std_logic_vector(C_M_AXI_DATA_WIDTH-1 downto 0);
+	M_AXI_RRESP: in std_logic_vector(1 downto 0);
+	M_AXI_RLAST: in std_logic;
+	M_AXI_RVALID: in std_logic;
+	M_AXI_RREADY: out std_logic
+);
+end component;
+
 component INTERRUPT_CONTROLLER
 generic(
-	N: integer := 4
+	N: integer := 4;
+	C_COALESCE_THRESHOLD: integer := 1;
+	C_COALESCE_TIMEOUT: integer := 0
 );
 port(
     	RCV_INT_LANES: in std_logic_vector(N+4 downto 0);
@@ -360,6 +489,11 @@ port(
 	RCV_WORK_LEFT: out std_logic;
 	RCV_WORK_LEFT_RESPONSE: in std_logic;
 	RCV_WORK_LEFT_RESPONSE_WRITE: in std_logic;
+	RCV_INT_PENDING: out std_logic_vector(N+3 downto 0);
+	RCV_INT_PENDING_READ: in std_logic;
+	RCV_INT_COALESCE: out std_logic_vector(47 downto 0);
+	RCV_INT_COALESCE_RESPONSE: in std_logic_vector(47 downto 0);
+	RCV_INT_COALESCE_RESPONSE_WRITE: in std_logic;
     	SND_INT_LANES: out std_logic_vector(N+3 downto 0);
 	SND_INT_LANES_RESPONSE: in std_logic_vector(N+3 downto 0);
 	SND_INT_NUM: in std_logic_vector(integer(ceil(log2(real(N+4))))-1 downto 0);
@@ -409,6 +543,13 @@ end component;
     signal s_aql_left: std_logic;
     signal s_aql_left_resp: std_logic;
     signal s_aql_left_resp_write: std_logic;
+    signal s_irq_pending: std_logic_vector(G_NUM_ACCELERATOR_CORES+3 downto 0);
+    signal s_irq_pending64: std_logic_vector(63 downto 0);
+    signal s_irq_pending_read: std_logic;
+    signal s_irq_coalesce: std_logic_vector(47 downto 0);
+    signal s_irq_coalesce64: std_logic_vector(63 downto 0);
+    signal s_irq_coalesce_resp64: std_logic_vector(63 downto 0);
+    signal s_irq_coalesce_resp_write: std_logic;
     signal s_snd_irq_lanes: std_logic_vector(G_NUM_ACCELERATOR_CORES+3 downto 0);
     signal s_snd_irq_lanes_resp: std_logic_vector(G_NUM_ACCELERATOR_CORES+3 downto 0);
     signal s_snd_irq_num: std_logic_vector(integer(ceil(log2(real(G_NUM_ACCELERATOR_CORES+4))))-1 downto 0);
@@ -417,6 +558,12 @@ end component;
     signal s_rcv_int_lanes: std_logic_vector(G_NUM_ACCELERATOR_CORES+4 downto 0);
     signal s_rcv_int_lanes_resp: std_logic_vector(G_NUM_ACCELERATOR_CORES+4 downto 0);
 
+-- signals for the completion signal engine
+    signal s_cmpl_dec_addr: std_logic_vector(63 downto 0);
+    signal s_cmpl_dec_start: std_logic;
+    signal s_cmpl_dec_status: std_logic_vector(2 downto 0);
+    signal s_cmpl_dec_status64: std_logic_vector(63 downto 0);
+
 -- /*end-folding-block*/
 
 begin
@@ -428,6 +575,9 @@ s_memctrl_halt <= not (cpu_enable); -- or s_cpu_hazard;
 s_rcv_irq_resp <= not(r_prev_cpu_irq_ack) and s_cpu_irq_ack and not(r_exception); 
 
 s_rcv_irq_num64 <= std_logic_vector(resize(unsigned(s_rcv_irq_num), s_rcv_irq_num64'length));
+s_irq_pending64 <= std_logic_vector(resize(unsigned(s_irq_pending), s_irq_pending64'length));
+s_irq_coalesce64 <= std_logic_vector(resize(unsigned(s_irq_coalesce), s_irq_coalesce64'length));
+s_cmpl_dec_status64 <= std_logic_vector(resize(unsigned(s_cmpl_dec_status), s_cmpl_dec_status64'length));
 s_snd_irq_num <= s_snd_irq_num64((integer(ceil(log2(real(G_NUM_ACCELERATOR_CORES+4))))-1) downto 0);
  
 s_rcv_int_lanes <= rcv_aql_irq & rcv_dma_irq & rcv_cpl_irq & rcv_add_irq & rcv_rem_irq & rcv_acc_irq_lanes;
@@ -531,12 +681,22 @@ inst_memory_controller: memory_controller_pp
 	C_IRQ_WORK_LEFT_ADDR	=> C_IRQ_WORK_LEFT_ADDR,
 	C_IRQ_SND_NUM_ADDR	=> C_IRQ_SND_NUM_ADDR,
 	C_IRQ_RCV_NUM_ADDR	=> C_IRQ_RCV_NUM_ADDR,
+	C_IRQ_PENDING_ADDR	=> C_IRQ_PENDING_ADDR,
+	C_IRQ_COALESCE_ADDR	=> C_IRQ_COALESCE_ADDR,
+	C_CMPL_DEC_ADDR		=> C_CMPL_DEC_ADDR,
+	C_CMPL_DEC_STATUS_ADDR	=> C_CMPL_DEC_STATUS_ADDR,
     	C_IMEM_LOW_ADDR         => C_IMEM_LOW_ADDR, 
     	C_IMEM_BRAM_SIZE      	=> G_MEM_NUM_4K_INSTR_MEMS*4096,
         C_IMEM_INIT_FILE        => C_IMEM_INIT_FILE,
     	C_DMEM_LOW_ADDR       	=> C_DMEM_LOW_ADDR, 
     	C_DMEM_BRAM_SIZE      	=> G_MEM_NUM_4K_DATA_MEMS*4096,
-        C_DMEM_INIT_FILE        => C_DMEM_INIT_FILE
+        C_DMEM_INIT_FILE        => C_DMEM_INIT_FILE,
+	C_ICACHE_ENABLE		=> G_ICACHE_ENABLE,
+	C_ICACHE_LOW_ADDR	=> C_DRAM_TEXT_LOW_ADDR,
+	C_ICACHE_SIZE		=> G_DRAM_TEXT_SIZE,
+	C_ICACHE_LINES		=> G_ICACHE_LINES,
+	C_ICACHE_LINE_SIZE	=> G_ICACHE_LINE_SIZE,
+	C_ICACHE_PREFETCH	=> G_ICACHE_PREFETCH
     )                                    
     port map(
         clk                   	=> tp_clk,
@@ -564,6 +724,14 @@ inst_memory_controller: memory_controller_pp
 	RCV_WORK_LEFT_RESPONSE_WRITE	=> s_aql_left_resp_write,
 	SND_INT_NUM			=> s_snd_irq_num64,
 	SND_INT_SIG			=> s_snd_irq_en,
+	RCV_INT_PENDING			=> s_irq_pending64,
+	RCV_INT_PENDING_READ		=> s_irq_pending_read,
+	RCV_INT_COALESCE		=> s_irq_coalesce64,
+	RCV_INT_COALESCE_RESPONSE	=> s_irq_coalesce_resp64,
+	RCV_INT_COALESCE_RESPONSE_WRITE	=> s_irq_coalesce_resp_write,
+	CMPL_DEC_SIG_ADDR		=> s_cmpl_dec_addr,
+	CMPL_DEC_START			=> s_cmpl_dec_start,
+	CMPL_DEC_STATUS			=> s_cmpl_dec_status64,
 
 	cmd_axi_aclk   	=> cmd_axi_aclk,
         cmd_axi_aresetn => cmd_axi_aresetn, 
@@ -631,7 +799,9 @@ inst_memory_controller: memory_controller_pp
 
 inst_interrupt_controller: INTERRUPT_CONTROLLER
 generic map(
-	N => G_NUM_ACCELERATOR_CORES
+	N => G_NUM_ACCELERATOR_CORES,
+	C_COALESCE_THRESHOLD => G_IRQ_COALESCE_THRESHOLD,
+	C_COALESCE_TIMEOUT => G_IRQ_COALESCE_TIMEOUT
 )
 port map(
 	RCV_INT_LANES => s_rcv_int_lanes,
@@ -642,6 +812,11 @@ port map(
 	RCV_WORK_LEFT => s_aql_left,
 	RCV_WORK_LEFT_RESPONSE => s_aql_left_resp,
 	RCV_WORK_LEFT_RESPONSE_WRITE => s_aql_left_resp_write,
+	RCV_INT_PENDING => s_irq_pending,
+	RCV_INT_PENDING_READ => s_irq_pending_read,
+	RCV_INT_COALESCE => s_irq_coalesce,
+	RCV_INT_COALESCE_RESPONSE => s_irq_coalesce_resp64(47 downto 0),
+	RCV_INT_COALESCE_RESPONSE_WRITE => s_irq_coalesce_resp_write,
     	SND_INT_LANES => s_snd_irq_lanes,
 	SND_INT_LANES_RESPONSE => s_snd_irq_lanes_resp,
 	SND_INT_NUM => s_snd_irq_num,
@@ -651,6 +826,58 @@ port map(
 	CLK => tp_clk
 );
 
+inst_completion_signal_engine: COMPLETION_SIGNAL_ENGINE
+generic map(
+	C_M_AXI_ADDR_WIDTH => C_SIG_AXI_ADDR_WIDTH,
+	C_M_AXI_DATA_WIDTH => C_SIG_AXI_DATA_WIDTH
+)
+port map(
+	SIG_ADDR => s_cmpl_dec_addr(C_SIG_AXI_ADDR_WIDTH-1 downto 0),
+	SIG_START => s_cmpl_dec_start,
+	SIG_STATUS => s_cmpl_dec_status,
+	RE => tp_rstn,
+	CLK => tp_clk,
+	M_AXI_ACLK => sig_axi_aclk,
+	M_AXI_ARESETN => sig_axi_aresetn,
+	M_AXI_AWID => sig_axi_awid,
+	M_AXI_AWADDR => sig_axi_awaddr,
+	M_AXI_AWLEN => sig_axi_awlen,
+	M_AXI_AWSIZE => sig_axi_awsize,
+	M_AXI_AWBURST => sig_axi_awburst,
+	M_AXI_AWLOCK => sig_axi_awlock,
+	M_AXI_AWCACHE => sig_axi_awcache,
+	M_AXI_AWPROT => sig_axi_awprot,
+	M_AXI_AWQOS => sig_axi_awqos,
+	M_AXI_AWVALID => sig_axi_awvalid,
+	M_AXI_AWREADY => sig_axi_awready,
+	M_AXI_WDATA => sig_axi_wdata,
+	M_AXI_WSTRB => sig_axi_wstrb,
+	M_AXI_WLAST => sig_axi_wlast,
+	M_AXI_WVALID => sig_axi_wvalid,
+	M_AXI_WREADY => sig_axi_wready,
+	M_AXI_BID => sig_axi_bid,
+	M_AXI_BRESP => sig_axi_bresp,
+	M_AXI_BVALID => sig_axi_bvalid,
+	M_AXI_BREADY => sig_axi_bready,
+	M_AXI_ARID => sig_axi_arid,
+	M_AXI_ARADDR => sig_axi_araddr,
+	M_AXI_ARLEN => sig_axi_arlen,
+	M_AXI_ARSIZE => sig_axi_arsize,
+	M_AXI_ARBURST => sig_axi_arburst,
+	M_AXI_ARLOCK => sig_axi_arlock,
+	M_AXI_ARCACHE => sig_axi_arcache,
+	M_AXI_ARPROT => sig_axi_arprot,
+	M_AXI_ARQOS => sig_axi_arqos,
+	M_AXI_ARVALID => sig_axi_arvalid,
+	M_AXI_ARREADY => sig_axi_arready,
+	M_AXI_RID => sig_axi_rid,
+	M_AXI_RDATA => sig_axi_rdata,
+	M_AXI_RRESP => sig_axi_rresp,
+	M_AXI_RLAST => sig_axi_rlast,
+	M_AXI_RVALID => sig_axi_rvalid,
+	M_AXI_RREADY => sig_axi_rready
+);
+
 shift_registers: process(tp_clk)
 begin
 	if(rising_edge(tp_clk)) then
@@ -0,0 +1,103 @@
+#!/bin/bash
+
+# GHDL counterpart of sim_packet_processor.do, see lib/common/sim/ghdl.sh
+#
+# usage: sim_packet_processor.sh [-b <packets>] [-c <max cycles>] [-w] [-e]
+#
+# inst_dram is loaded with dram.mem and dram_text.mem of the firmware and
+# saved to dram_out.mem at the end of the run for aql2mem -d. A packet is
+# done with its READ_INDEX update, so -b takes the number of packets of the
+# workload.
+
+cd $(dirname $(readlink -f $0))
+
+hsarepo=../../../..
+src=$hsarepo/lib
+mips64dir=$src/ext/mips64
+ppdir=$src/packet_processor/hw
+commondir=$src/common
+core_software=$src/packet_processor/sw/core/vsim
+dram_data=$core_software
+
+# 10 ms like the .do file
+ghdl_default_cycles=500000
+source $commondir/sim/ghdl.sh
+ghdl_options "$@"
+
+# the simulation.env file, otherwise the environment of the shell
+if [ -f $core_software/simulation.env ]; then
+	source $core_software/simulation.env
+else
+	MIPS_AQL_QUEUE_LENGTH=$SIZE_AQL_QUEUE
+fi
+INSTR_MEM_BLOCKS=${MIPS_NUM_TEXT_MEM_BLOCKS:-1}
+DATA_MEM_BLOCKS=${MIPS_NUM_DATA_MEM_BLOCKS:-1}
+ACCELERATOR_CORES=${MIPS_NUM_ACCELERATOR_CORES:-1}
+ICACHE_ENABLE=$([ "$MIPS_ICACHE_ENABLE" == "1" ] && echo true || echo false)
+ICACHE_LINES=${MIPS_ICACHE_LINES:-64}
+ICACHE_LINE_SIZE=${MIPS_ICACHE_LINE_SIZE:-32}
+ICACHE_PREFETCH=$([ "${MIPS_ICACHE_PREFETCH:-1}" == "1" ] && echo true || echo false)
+DRAM_TEXT_OFFSET=${MIPS_DRAM_TEXT_OFFSET:-12288}
+DRAM_TEXT_SIZE=$([ "${MIPS_DRAM_TEXT_SIZE:-0}" -gt 0 ] && echo $MIPS_DRAM_TEXT_SIZE || echo 65536)
+AQL_QUEUE_LENGTH=${MIPS_AQL_QUEUE_LENGTH:-128}
+
+ghdl_analyze \
+	$mips64dir/alu_pkg_64.vhd \
+	$mips64dir/asip_alu/asip_instruction_components_pkg_64.vhd \
+	$mips64dir/asip_alu/asip_alu_64.vhd \
+	$mips64dir/asip_alu/asip_decode_64.vhd \
+	$mips64dir/stage_pc_64.vhd \
+	$mips64dir/instruction_fetch_64.vhd \
+	$mips64dir/stage_if_id_64.vhd \
+	$mips64dir/branching_unit_64.vhd \
+	$mips64dir/decoder_unit_64.vhd \
+	$mips64dir/hazard_detection_unit_64.vhd \
+	$mips64dir/forwarding_unit_64.vhd \
+	$mips64dir/instruction_decode_64.vhd \
+	$mips64dir/stage_id_ex_64.vhd \
+	$mips64dir/execute_64.vhd \
+	$mips64dir/stage_ex_mem_64.vhd \
+	$mips64dir/memory_access_64.vhd \
+	$mips64dir/stage_mem_wb_64.vhd \
+	$mips64dir/write_back_64.vhd \
+	$mips64dir/coprocessor0_64.vhd \
+	$mips64dir/cpu_top_64.vhd \
+	$commondir/axi_lite/axi_lite_master.vhd \
+	$commondir/axi_full/axi_full_master.vhd \
+	$ppdir/memory_controller/external_memory/external_memory_interface_pp.vhd \
+	$commondir/mem_router/bram_sp.vhd \
+	$commondir/mem_router/singleclock_bram.vhd \
+	$commondir/mem_router/instruction_cache.vhd \
+	$commondir/mem_router/mem_router.vhd \
+	$ppdir/memory_controller/memory_controller_pp.vhd \
+	$commondir/interrupts/interrupt_demux.vhd \
+	$commondir/interrupts/interrupt_arbiter.vhd \
+	$ppdir/interrupt_controller/interrupt_controller.vhd \
+	$ppdir/completion_signal/completion_signal_engine.vhd \
+	$ppdir/packet_processor_top.vhd \
+	$commondir/axi_lite/axi_lite_slave.vhd \
+	$commondir/sim/generic_memory.vhd \
+	$commondir/sim/mti_file_pkg.vhd \
+	$commondir/sim/burst_memory.vhd \
+	$commondir/sim/axi_arbiter.vhd \
+	$commondir/sim/bench_statistics.vhd \
+	$ppdir/tb_packet_processor_top.vhd
+
+rm -f dram_out.mem
+ghdl_run tb_packet_processor_top \
+	G_MEM_NUM_4K_DATA_MEMS=$DATA_MEM_BLOCKS \
+	G_MEM_NUM_4K_INSTR_MEMS=$INSTR_MEM_BLOCKS \
+	G_NUM_ACCELERATOR_CORES=$ACCELERATOR_CORES \
+	G_ICACHE_ENABLE=$ICACHE_ENABLE \
+	G_ICACHE_LINES=$ICACHE_LINES \
+	G_ICACHE_LINE_SIZE=$ICACHE_LINE_SIZE \
+	G_ICACHE_PREFETCH=$ICACHE_PREFETCH \
+	G_DRAM_TEXT_OFFSET=$DRAM_TEXT_OFFSET \
+	G_DRAM_TEXT_SIZE=$DRAM_TEXT_SIZE \
+	G_IMEM_INIT_FILE=$core_software/instr.hex \
+	G_DMEM_INIT_FILE=$core_software/data.hex \
+	G_AQL_STIMULUS_FILE=$dram_data/dram.stim \
+	G_AQL_QUEUE_LENGTH=$AQL_QUEUE_LENGTH \
+	G_DRAM_INIT_FILE=$dram_data/dram.mem \
+	G_DRAM_TEXT_FILE=$core_software/dram_text.mem \
+	G_DRAM_DUMP_FILE=dram_out.mem
@@ -45,6 +45,13 @@ package config is
 	constant CONF_IRQ_WORK_LEFT_ADDR	: std_logic_vector	:= x"0002000000000000";
 	constant CONF_IRQ_SND_NUM_ADDR		: std_logic_vector	:= x"0002000000000008";
 	constant CONF_IRQ_RCV_NUM_ADDR		: std_logic_vector	:= x"0002000000000010";
+	constant CONF_IRQ_PENDING_ADDR		: std_logic_vector	:= x"0002000000000018";
+	constant CONF_IRQ_COALESCE_ADDR		: std_logic_vector	:= x"0002000000000020";
+	constant CONF_CMPL_DEC_ADDR		: std_logic_vector	:= x"0002000000000028";
+	constant CONF_CMPL_DEC_STATUS_ADDR	: std_logic_vector	:= x"0002000000000030";
+	constant CONF_SIG_LOW_ADDR		: std_logic_vector	:= x"0000000000000000";
+	constant CONF_SIG_AXI_ADDR_WIDTH	: integer		:= 64;
+	constant CONF_SIG_AXI_DATA_WIDTH	: integer		:= 64;
     	constant CONF_IMEM_LOW_ADDR       	: std_logic_vector	:= x"0003000000000000";
     	constant CONF_DMEM_LOW_ADDR       	: std_logic_vector 	:= x"0003000002000000";
 end config;
@@ -54,6 +61,8 @@ use work.config.all;
 library ieee;
 use IEEE.std_logic_1164.all;
 use IEEE.math_real.all;
+use IEEE.numeric_std.all;
+use std.textio.all;
 
 
 entity tb_packet_processor_top IS
@@ -61,14 +70,35 @@ generic(
         G_MEM_NUM_4K_DATA_MEMS          : integer := 4;
         G_MEM_NUM_4K_INSTR_MEMS         : integer := 4;
 	G_NUM_ACCELERATOR_CORES		: integer := 1;
+	G_IRQ_COALESCE_THRESHOLD	: integer := 1;
+	G_IRQ_COALESCE_TIMEOUT		: integer := 0;
+	G_ICACHE_ENABLE			: boolean := false;
+	G_ICACHE_LINES			: integer := 64;
+	G_ICACHE_LINE_SIZE		: integer := 32;
+	G_ICACHE_PREFETCH		: boolean := true;
+	G_DRAM_TEXT_OFFSET		: integer := 16#3000#;
+	G_DRAM_TEXT_SIZE		: integer := 65536;
         G_IMEM_INIT_FILE    		: string  := "";
-        G_DMEM_INIT_FILE    		: string  := ""
+        G_DMEM_INIT_FILE    		: string  := "";
+	-- AQL stimulus of aql2mem for streamed workloads, skipped if it does not exist
+	G_AQL_STIMULUS_FILE		: string  := "";
+	-- SIZE_AQL_QUEUE of global_conf.sh, locates READ_INDEX for the monitor
+	G_AQL_QUEUE_LENGTH		: integer := 128;
+	-- dram contents for simulators without "mem load", see sim_packet_processor.sh
+	G_DRAM_INIT_FILE		: string  := "";
+	G_DRAM_TEXT_FILE		: string  := "";
+	G_DRAM_DUMP_FILE		: string  := "";
+	-- benchmark mode: stop after this many READ_INDEX updates or cycles, 0 runs on
+	G_BENCH_PACKETS			: integer := 0;
+	G_BENCH_MAX_CYCLES		: integer := 0
 );
 end tb_packet_processor_top;
 
 architecture behav of tb_packet_processor_top is
 signal s_rcv_acc_irq_lanes		: std_logic_vector(G_NUM_ACCELERATOR_CORES-1 downto 0);
 signal s_rcv_aql_irq			: std_logic;
+signal s_initial_aql_irq		: std_logic;
+signal s_producer_aql_irq		: std_logic;
 signal s_rcv_dma_irq			: std_logic;
 signal s_rcv_cpl_irq			: std_logic;
 signal s_rcv_add_irq			: std_logic;
@@ -145,6 +175,118 @@ signal s_data_axi_rresp			: std_logic_vector(1 downto 0);
 signal s_data_axi_rlast			: std_logic;
 signal s_data_axi_rvalid		: std_logic;
 signal s_data_axi_rready		: std_logic;
+signal s_sig_axi_awid			: std_logic_vector(0 downto 0);
+signal s_sig_axi_awaddr			: std_logic_vector(CONF_SIG_AXI_ADDR_WIDTH-1 downto 0);
+signal s_sig_axi_awlen			: std_logic_vector(7 downto 0);
+signal s_sig_axi_awsize			: std_logic_vector(2 downto 0);
+signal s_sig_axi_awburst		: std_logic_vector(1 downto 0);
+signal s_sig_axi_awlock			: std_logic;
+signal s_sig_axi_awcache		: std_logic_vector(3 downto 0);
+signal s_sig_axi_awprot			: std_logic_vector(2 downto 0);
+signal s_sig_axi_awqos			: std_logic_vector(3 downto 0);
+signal s_sig_axi_awvalid		: std_logic;
+signal s_sig_axi_awready		: std_logic;
+signal s_sig_axi_wdata			: std_logic_vector(CONF_SIG_AXI_DATA_WIDTH-1 downto 0);
+signal s_sig_axi_wstrb			: std_logic_vector(CONF_SIG_AXI_DATA_WIDTH/8-1 downto 0);
+signal s_sig_axi_wlast			: std_logic;
+signal s_sig_axi_wvalid			: std_logic;
+signal s_sig_axi_wready			: std_logic;
+signal s_sig_axi_bid			: std_logic_vector(0 downto 0);
+signal s_sig_axi_bresp			: std_logic_vector(1 downto 0);
+signal s_sig_axi_bvalid			: std_logic;
+signal s_sig_axi_bready			: std_logic;
+signal s_sig_axi_arid			: std_logic_vector(0 downto 0);
+signal s_sig_axi_araddr			: std_logic_vector(CONF_SIG_AXI_ADDR_WIDTH-1 downto 0);
+signal s_sig_axi_arlen			: std_logic_vector(7 downto 0);
+signal s_sig_axi_arsize			: std_logic_vector(2 downto 0);
+signal s_sig_axi_arburst		: std_logic_vector(1 downto 0);
+signal s_sig_axi_arlock			: std_logic;
+signal s_sig_axi_arcache		: std_logic_vector(3 downto 0);
+signal s_sig_axi_arprot			: std_logic_vector(2 downto 0);
+signal s_sig_axi_arqos			: std_logic_vector(3 downto 0);
+signal s_sig_axi_arvalid		: std_logic;
+signal s_sig_axi_arready		: std_logic;
+signal s_sig_axi_rid			: std_logic_vector(0 downto 0);
+signal s_sig_axi_rdata			: std_logic_vector(CONF_SIG_AXI_DATA_WIDTH-1 downto 0);
+signal s_sig_axi_rresp			: std_logic_vector(1 downto 0);
+signal s_sig_axi_rlast			: std_logic;
+signal s_sig_axi_rvalid			: std_logic;
+signal s_sig_axi_rready			: std_logic;
+
+-- inst_dram behind the arbiter of the packet processor and the signal engine
+signal s_dram_axi_awid			: std_logic_vector(0 downto 0);
+signal s_dram_axi_awaddr		: std_logic_vector(CONF_DATA_AXI_ADDR_WIDTH-1 downto 0);
+signal s_dram_axi_awlen			: std_logic_vector(7 downto 0);
+signal s_dram_axi_awsize		: std_logic_vector(2 downto 0);
+signal s_dram_axi_awburst		: std_logic_vector(1 downto 0);
+signal s_dram_axi_awlock		: std_logic;
+signal s_dram_axi_awcache		: std_logic_vector(3 downto 0);
+signal s_dram_axi_awprot		: std_logic_vector(2 downto 0);
+signal s_dram_axi_awqos			: std_logic_vector(3 downto 0);
+signal s_dram_axi_awvalid		: std_logic;
+signal s_dram_axi_awready		: std_logic;
+signal s_dram_axi_wdata			: std_logic_vector(CONF_DATA_AXI_DATA_WIDTH-1 downto 0);
+signal s_dram_axi_wstrb			: std_logic_vector(CONF_DATA_AXI_DATA_WIDTH/8-1 downto 0);
+signal s_dram_axi_wlast			: std_logic;
+signal s_dram_axi_wvalid		: std_logic;
+signal s_dram_axi_wready		: std_logic;
+signal s_dram_axi_bid			: std_logic_vector(0 downto 0);
+signal s_dram_axi_bresp			: std_logic_vector(1 downto 0);
+signal s_dram_axi_bvalid		: std_logic;
+signal s_dram_axi_bready		: std_logic;
+signal s_dram_axi_arid			: std_logic_vector(0 downto 0);
+signal s_dram_axi_araddr		: std_logic_vector(CONF_DATA_AXI_ADDR_WIDTH-1 downto 0);
+signal s_dram_axi_arlen			: std_logic_vector(7 downto 0);
+signal s_dram_axi_arsize		: std_logic_vector(2 downto 0);
+signal s_dram_axi_arburst		: std_logic_vector(1 downto 0);
+signal s_dram_axi_arlock		: std_logic;
+signal s_dram_axi_arcache		: std_logic_vector(3 downto 0);
+signal s_dram_axi_arprot		: std_logic_vector(2 downto 0);
+signal s_dram_axi_arqos			: std_logic_vector(3 downto 0);
+signal s_dram_axi_arvalid		: std_logic;
+signal s_dram_axi_arready		: std_logic;
+signal s_dram_axi_rid			: std_logic_vector(0 downto 0);
+signal s_dram_axi_rdata			: std_logic_vector(CONF_DATA_AXI_DATA_WIDTH-1 downto 0);
+signal s_dram_axi_rresp			: std_logic_vector(1 downto 0);
+signal s_dram_axi_rlast			: std_logic;
+signal s_dram_axi_rvalid		: std_logic;
+signal s_dram_axi_rready		: std_logic;
+
+-- completion signals in device memory go to inst_dram, all others to inst_host_mem
+signal s_sig_aw_dram			: std_logic;
+signal s_sig_ar_dram			: std_logic;
+signal s_sigd_axi_awvalid		: std_logic;
+signal s_sigd_axi_awready		: std_logic;
+signal s_sigd_axi_wvalid		: std_logic;
+signal s_sigd_axi_wready		: std_logic;
+signal s_sigd_axi_bid			: std_logic_vector(0 downto 0);
+signal s_sigd_axi_bresp			: std_logic_vector(1 downto 0);
+signal s_sigd_axi_bvalid		: std_logic;
+signal s_sigd_axi_bready		: std_logic;
+signal s_sigd_axi_arvalid		: std_logic;
+signal s_sigd_axi_arready		: std_logic;
+signal s_sigd_axi_rid			: std_logic_vector(0 downto 0);
+signal s_sigd_axi_rdata			: std_logic_vector(CONF_SIG_AXI_DATA_WIDTH-1 downto 0);
+signal s_sigd_axi_rresp			: std_logic_vector(1 downto 0);
+signal s_sigd_axi_rlast			: std_logic;
+signal s_sigd_axi_rvalid		: std_logic;
+signal s_sigd_axi_rready		: std_logic;
+signal s_sigh_axi_awvalid		: std_logic;
+signal s_sigh_axi_awready		: std_logic;
+signal s_sigh_axi_wvalid		: std_logic;
+signal s_sigh_axi_wready		: std_logic;
+signal s_sigh_axi_bid			: std_logic_vector(0 downto 0);
+signal s_sigh_axi_bresp			: std_logic_vector(1 downto 0);
+signal s_sigh_axi_bvalid		: std_logic;
+signal s_sigh_axi_bready		: std_logic;
+signal s_sigh_axi_arvalid		: std_logic;
+signal s_sigh_axi_arready		: std_logic;
+signal s_sigh_axi_rid			: std_logic_vector(0 downto 0);
+signal s_sigh_axi_rdata			: std_logic_vector(CONF_SIG_AXI_DATA_WIDTH-1 downto 0);
+signal s_sigh_axi_rresp			: std_logic_vector(1 downto 0);
+signal s_sigh_axi_rlast			: std_logic;
+signal s_sigh_axi_rvalid		: std_logic;
+signal s_sigh_axi_rready		: std_logic;
 signal halt				: std_logic;
 signal reset				: std_logic;
 signal clock				: std_logic;
@@ -152,6 +294,23 @@ signal cmd_clock			: std_logic;
 signal cmd_reset			: std_logic;
 signal data_clock			: std_logic;
 signal data_reset			: std_logic;
+signal sig_clock			: std_logic;
+signal sig_reset			: std_logic;
+
+-- producer access to the queue in inst_dram
+signal s_dram_bd_en			: std_logic;
+signal s_dram_bd_we			: std_logic;
+signal s_dram_bd_addr			: std_logic_vector(CONF_DATA_AXI_ADDR_WIDTH-1 downto 0);
+signal s_dram_bd_din			: std_logic_vector(CONF_DATA_AXI_DATA_WIDTH-1 downto 0);
+signal s_dram_bd_dout			: std_logic_vector(CONF_DATA_AXI_DATA_WIDTH-1 downto 0);
+
+-- benchmark counters
+signal s_bench_completion		: std_logic;
+signal s_bench_beat			: std_logic;
+signal s_bench_irqs			: std_logic_vector(G_NUM_ACCELERATOR_CORES+4 downto 0);
+signal s_bench_done			: std_logic;
+-- without a packet or cycle limit the clocks run on like in the .do file
+constant BENCH_LIMITED			: boolean := G_BENCH_PACKETS > 0 or G_BENCH_MAX_CYCLES > 0;
 
 component packet_processor_top is
     generic(
@@ -160,6 +319,8 @@ component packet_processor_top is
         -- interrupts
         G_TIMER_INTERRUPT               : boolean := false;
 	G_NUM_ACCELERATOR_CORES		: integer := 1;
+	G_IRQ_COALESCE_THRESHOLD	: integer := 1;
+	G_IRQ_COALESCE_TIMEOUT		: integer := 0;
         -- exceptions
         G_EXC_ADDRESS_ERROR_LOAD        : boolean := true;
         G_EXC_ADDRESS_ERROR_FETCH       : boolean := true;
@@ -176,6 +337,12 @@ component packet_processor_top is
         -- memory configuration
         G_MEM_NUM_4K_DATA_MEMS          : integer := 2;
         G_MEM_NUM_4K_INSTR_MEMS         : integer := 3;
+        -- optional instruction cache for a text region in dram
+        G_ICACHE_ENABLE                 : boolean := false;
+        G_ICACHE_LINES                  : integer := 64;
+        G_ICACHE_LINE_SIZE              : integer := 32;
+        G_ICACHE_PREFETCH               : boolean := true;
+        G_DRAM_TEXT_SIZE                : integer := 65536;
 	-- configuration addresses	
 	C_CMD_LOW_ADDR			: std_logic_vector	:= x"0002000000000000";
 	C_CMD_HIGH_ADDR			: std_logic_vector	:= x"0002000000100000";
@@ -189,10 +356,17 @@ component packet_processor_top is
 	C_IRQ_WORK_LEFT_ADDR		: std_logic_vector	:= x"0002000000000000";
 	C_IRQ_SND_NUM_ADDR		: std_logic_vector	:= x"0002000000000008";
 	C_IRQ_RCV_NUM_ADDR		: std_logic_vector	:= x"0002000000000010";
+	C_IRQ_PENDING_ADDR		: std_logic_vector	:= x"0002000000000018";
+	C_IRQ_COALESCE_ADDR		: std_logic_vector	:= x"0002000000000020";
+	C_CMPL_DEC_ADDR			: std_logic_vector	:= x"0002000000000028";
+	C_CMPL_DEC_STATUS_ADDR		: std_logic_vector	:= x"0002000000000030";
+	C_SIG_AXI_ADDR_WIDTH		: integer		:= 64;
+	C_SIG_AXI_DATA_WIDTH		: integer		:= 64;
     	C_IMEM_LOW_ADDR       		: std_logic_vector	:= x"0003000000000000";
         C_IMEM_INIT_FILE    		: string 		:= "";
     	C_DMEM_LOW_ADDR       		: std_logic_vector 	:= x"0003000002000000";
-        C_DMEM_INIT_FILE    		: string 		:= ""
+        C_DMEM_INIT_FILE    		: string 		:= "";
+	C_DRAM_TEXT_LOW_ADDR		: std_logic_vector	:= x"0001000000003000"
     );
     port(
         tp_clk                  : in  std_logic;
@@ -228,6 +402,8 @@ component packet_processor_top is
 	cmd_axi_aresetn   : in    std_logic;
 	data_axi_aclk     : in    std_logic;                                              
 	data_axi_aresetn  : in    std_logic;
+	sig_axi_aclk      : in    std_logic;
+	sig_axi_aresetn   : in    std_logic;
 	
 	cmd_axi_awaddr	: out std_logic_vector(C_CMD_AXI_ADDR_WIDTH-1 downto 0);   
 	cmd_axi_awprot	: out std_logic_vector(2 downto 0);
@@ -285,7 +461,45 @@ component packet_processor_top is
 	data_axi_rresp	: in  std_logic_vector(1 downto 0);
 	data_axi_rlast	: in  std_logic;
 	data_axi_rvalid	: in  std_logic;
-	data_axi_rready	: out std_logic
+	data_axi_rready	: out std_logic;
+
+	sig_axi_awid	: out std_logic_vector(0 downto 0);
+	sig_axi_awaddr	: out std_logic_vector(C_SIG_AXI_ADDR_WIDTH-1 downto 0);
+	sig_axi_awlen	: out std_logic_vector(7 downto 0);
+	sig_axi_awsize	: out std_logic_vector(2 downto 0);
+	sig_axi_awburst	: out std_logic_vector(1 downto 0);
+	sig_axi_awlock	: out std_logic;
+	sig_axi_awcache	: out std_logic_vector(3 downto 0);
+	sig_axi_awprot	: out std_logic_vector(2 downto 0);
+	sig_axi_awqos	: out std_logic_vector(3 downto 0);
+	sig_axi_awvalid	: out std_logic;
+	sig_axi_awready	: in  std_logic;
+	sig_axi_wdata	: out std_logic_vector(C_SIG_AXI_DATA_WIDTH-1 downto 0);
+	sig_axi_wstrb	: out std_logic_vector(C_SIG_AXI_DATA_WIDTH/8-1 downto 0);
+	sig_axi_wlast	: out std_logic;
+	sig_axi_wvalid	: out std_logic;
+	sig_axi_wready	: in  std_logic;
+	sig_axi_bid	: in  std_logic_vector(0 downto 0);
+	sig_axi_bresp	: in  std_logic_vector(1 downto 0);
+	sig_axi_bvalid	: in  std_logic;
+	sig_axi_bready	: out std_logic;
+	sig_axi_arid	: out std_logic_vector(0 downto 0);
+	sig_axi_araddr	: out std_logic_vector(C_SIG_AXI_ADDR_WIDTH-1 downto 0);
+	sig_axi_arlen	: out std_logic_vector(7 downto 0);
+	sig_axi_arsize	: out std_logic_vector(2 downto 0);
+	sig_axi_arburst	: out std_logic_vector(1 downto 0);
+	sig_axi_arlock	: out std_logic;
+	sig_axi_arcache	: out std_logic_vector(3 downto 0);
+	sig_axi_arprot	: out std_logic_vector(2 downto 0);
+	sig_axi_arqos	: out std_logic_vector(3 downto 0);
+	sig_axi_arvalid	: out std_logic;
+	sig_axi_arready	: in  std_logic;
+	sig_axi_rid	: in  std_logic_vector(0 downto 0);
+	sig_axi_rdata	: in  std_logic_vector(C_SIG_AXI_DATA_WIDTH-1 downto 0);
+	sig_axi_rresp	: in  std_logic_vector(1 downto 0);
+	sig_axi_rlast	: in  std_logic;
+	sig_axi_rvalid	: in  std_logic;
+	sig_axi_rready	: out std_logic
     );
 end component;
 
@@ -414,6 +628,39 @@ begin
   end if;
 end procedure;
 
+-- names of the accelerator lanes in s_bench_irqs, highest lane first
+function acc_lane_names(n: integer) return string is
+begin
+  if n = 0 then
+    return "";
+  end if;
+  return ",acc" & integer'image(n-1) & acc_lane_names(n-1);
+end function;
+
+-- reads the next hexadecimal number of a stimulus line
+procedure read_hex(l: inout line; value: out std_logic_vector(63 downto 0)) is
+  variable c: character;
+  variable good: boolean;
+  variable digit: integer;
+  variable tmp: unsigned(63 downto 0) := (others => '0');
+begin
+  read(l, c, good);
+  while good and c = ' ' loop
+    read(l, c, good);
+  end loop;
+  while good and c /= ' ' loop
+    case c is
+      when '0' to '9' => digit := character'pos(c) - character'pos('0');
+      when 'a' to 'f' => digit := character'pos(c) - character'pos('a') + 10;
+      when 'A' to 'F' => digit := character'pos(c) - character'pos('A') + 10;
+      when others     => report "invalid hex digit " & c & " in " & G_AQL_STIMULUS_FILE severity failure;
+    end case;
+    tmp := shift_left(tmp, 4) + to_unsigned(digit, 64);
+    read(l, c, good);
+  end loop;
+  value := std_logic_vector(tmp);
+end procedure;
+
 begin
 
 uut: packet_processor_top
@@ -423,6 +670,8 @@ uut: packet_processor_top
         -- interrupts                     
         G_TIMER_INTERRUPT               => CONF_TIMER_INTERRUPT,               
 	G_NUM_ACCELERATOR_CORES		=> G_NUM_ACCELERATOR_CORES,		
+	G_IRQ_COALESCE_THRESHOLD	=> G_IRQ_COALESCE_THRESHOLD,
+	G_IRQ_COALESCE_TIMEOUT		=> G_IRQ_COALESCE_TIMEOUT,
         -- exceptions                    
         G_EXC_ADDRESS_ERROR_LOAD        => CONF_EXC_ADDRESS_ERROR_LOAD,        
         G_EXC_ADDRESS_ERROR_FETCH       => CONF_EXC_ADDRESS_ERROR_FETCH,       
@@ -439,6 +688,11 @@ uut: packet_processor_top
         -- memory configuration          
         G_MEM_NUM_4K_DATA_MEMS          => G_MEM_NUM_4K_DATA_MEMS,          
         G_MEM_NUM_4K_INSTR_MEMS         => G_MEM_NUM_4K_INSTR_MEMS,         
+        G_ICACHE_ENABLE                 => G_ICACHE_ENABLE,
+        G_ICACHE_LINES                  => G_ICACHE_LINES,
+        G_ICACHE_LINE_SIZE              => G_ICACHE_LINE_SIZE,
+        G_ICACHE_PREFETCH               => G_ICACHE_PREFETCH,
+        G_DRAM_TEXT_SIZE                => G_DRAM_TEXT_SIZE,
 	-- configuration addresses	 
 	C_CMD_LOW_ADDR			=> CONF_CMD_LOW_ADDR,			
 	C_CMD_HIGH_ADDR			=> CONF_CMD_HIGH_ADDR,			
@@ -452,10 +706,17 @@ uut: packet_processor_top
 	C_IRQ_WORK_LEFT_ADDR		=> CONF_IRQ_WORK_LEFT_ADDR,		
 	C_IRQ_SND_NUM_ADDR		=> CONF_IRQ_SND_NUM_ADDR,
 	C_IRQ_RCV_NUM_ADDR		=> CONF_IRQ_RCV_NUM_ADDR,		
+	C_IRQ_PENDING_ADDR		=> CONF_IRQ_PENDING_ADDR,
+	C_IRQ_COALESCE_ADDR		=> CONF_IRQ_COALESCE_ADDR,
+	C_CMPL_DEC_ADDR			=> CONF_CMPL_DEC_ADDR,
+	C_CMPL_DEC_STATUS_ADDR		=> CONF_CMPL_DEC_STATUS_ADDR,
+	C_SIG_AXI_ADDR_WIDTH		=> CONF_SIG_AXI_ADDR_WIDTH,
+	C_SIG_AXI_DATA_WIDTH		=> CONF_SIG_AXI_DATA_WIDTH,
     	C_IMEM_LOW_ADDR       		=> CONF_IMEM_LOW_ADDR,       		
         C_IMEM_INIT_FILE    		=> G_IMEM_INIT_FILE,
     	C_DMEM_LOW_ADDR       		=> CONF_DMEM_LOW_ADDR,
-        C_DMEM_INIT_FILE    		=> G_DMEM_INIT_FILE
+        C_DMEM_INIT_FILE    		=> G_DMEM_INIT_FILE,
+	C_DRAM_TEXT_LOW_ADDR		=> std_logic_vector(unsigned(CONF_DATA_LOW_ADDR) + to_unsigned(G_DRAM_TEXT_OFFSET, 64))
     )                                    
     port map(
         tp_clk              	=> clock,    
@@ -490,6 +751,8 @@ uut: packet_processor_top
         cmd_axi_aresetn => cmd_reset,
         data_axi_aclk   => data_clock,
         data_axi_aresetn=> data_reset,
+        sig_axi_aclk    => sig_clock,
+        sig_axi_aresetn => sig_reset,
 
 	cmd_axi_awaddr	=> s_cmd_axi_awaddr,
 	cmd_axi_awprot	=> s_cmd_axi_awprot,
@@ -547,7 +810,45 @@ uut: packet_processor_top
         data_axi_rresp	=> s_data_axi_rresp,	
         data_axi_rlast	=> s_data_axi_rlast,	
         data_axi_rvalid	=> s_data_axi_rvalid,	
-        data_axi_rready	=> s_data_axi_rready
+        data_axi_rready	=> s_data_axi_rready,
+
+	sig_axi_awid	=> s_sig_axi_awid,
+	sig_axi_awaddr	=> s_sig_axi_awaddr,
+	sig_axi_awlen	=> s_sig_axi_awlen,
+	sig_axi_awsize	=> s_sig_axi_awsize,
+	sig_axi_awburst	=> s_sig_axi_awburst,
+	sig_axi_awlock	=> s_sig_axi_awlock,
+	sig_axi_awcache	=> s_sig_axi_awcache,
+	sig_axi_awprot	=> s_sig_axi_awprot,
+	sig_axi_awqos	=> s_sig_axi_awqos,
+	sig_axi_awvalid	=> s_sig_axi_awvalid,
+	sig_axi_awready	=> s_sig_axi_awready,
+	sig_axi_wdata	=> s_sig_axi_wdata,
+	sig_axi_wstrb	=> s_sig_axi_wstrb,
+	sig_axi_wlast	=> s_sig_axi_wlast,
+	sig_axi_wvalid	=> s_sig_axi_wvalid,
+	sig_axi_wready	=> s_sig_axi_wready,
+	sig_axi_bid	=> s_sig_axi_bid,
+	sig_axi_bresp	=> s_sig_axi_bresp,
+	sig_axi_bvalid	=> s_sig_axi_bvalid,
+	sig_axi_bready	=> s_sig_axi_bready,
+	sig_axi_arid	=> s_sig_axi_arid,
+	sig_axi_araddr	=> s_sig_axi_araddr,
+	sig_axi_arlen	=> s_sig_axi_arlen,
+	sig_axi_arsize	=> s_sig_axi_arsize,
+	sig_axi_arburst	=> s_sig_axi_arburst,
+	sig_axi_arlock	=> s_sig_axi_arlock,
+	sig_axi_arcache	=> s_sig_axi_arcache,
+	sig_axi_arprot	=> s_sig_axi_arprot,
+	sig_axi_arqos	=> s_sig_axi_arqos,
+	sig_axi_arvalid	=> s_sig_axi_arvalid,
+	sig_axi_arready	=> s_sig_axi_arready,
+	sig_axi_rid	=> s_sig_axi_rid,
+	sig_axi_rdata	=> s_sig_axi_rdata,
+	sig_axi_rresp	=> s_sig_axi_rresp,
+	sig_axi_rlast	=> s_sig_axi_rlast,
+	sig_axi_rvalid	=> s_sig_axi_rvalid,
+	sig_axi_rready	=> s_sig_axi_rready
    );
 
 inst_dram: entity work.burst_memory
@@ -555,7 +856,10 @@ inst_dram: entity work.burst_memory
 		C_LOW_ADDR		=> CONF_DATA_LOW_ADDR,
 		C_AXI_ADDR_WIDTH	=> CONF_DATA_AXI_ADDR_WIDTH,
 		C_AXI_DATA_WIDTH	=> CONF_DATA_AXI_DATA_WIDTH,
-		C_NUM_1K_BRAM_BLOCKS	=> 4096
+		C_NUM_1K_BRAM_BLOCKS	=> 4096,
+		C_INIT_FILE		=> G_DRAM_INIT_FILE,
+		C_OVERLAY_FILE		=> G_DRAM_TEXT_FILE,
+		C_DUMP_FILE		=> G_DRAM_DUMP_FILE
     )
     port map(
         clk       	=> clock,
@@ -563,45 +867,260 @@ inst_dram: entity work.burst_memory
 	
 	S_AXI_ACLK	=> data_clock,
 	S_AXI_ARESETN	=> data_reset,
-	S_AXI_AWID	=> s_data_axi_awid,
-	S_AXI_AWADDR	=> s_data_axi_awaddr,	
-	S_AXI_AWLEN	=> s_data_axi_awlen,	
-	S_AXI_AWSIZE	=> s_data_axi_awsize,	
-	S_AXI_AWBURST	=> s_data_axi_awburst,	
-	S_AXI_AWLOCK	=> s_data_axi_awlock,	
-	S_AXI_AWCACHE	=> s_data_axi_awcache,	
-	S_AXI_AWPROT	=> s_data_axi_awprot,	
-	S_AXI_AWQOS	=> s_data_axi_awqos,	
+	S_AXI_AWID	=> s_dram_axi_awid,
+	S_AXI_AWADDR	=> s_dram_axi_awaddr,	
+	S_AXI_AWLEN	=> s_dram_axi_awlen,	
+	S_AXI_AWSIZE	=> s_dram_axi_awsize,	
+	S_AXI_AWBURST	=> s_dram_axi_awburst,	
+	S_AXI_AWLOCK	=> s_dram_axi_awlock,	
+	S_AXI_AWCACHE	=> s_dram_axi_awcache,	
+	S_AXI_AWPROT	=> s_dram_axi_awprot,	
+	S_AXI_AWQOS	=> s_dram_axi_awqos,	
+	S_AXI_AWREGION  => (others => '0'),
+	S_AXI_AWVALID	=> s_dram_axi_awvalid,	
+	S_AXI_AWREADY	=> s_dram_axi_awready,	
+	S_AXI_WDATA	=> s_dram_axi_wdata,	
+	S_AXI_WSTRB	=> s_dram_axi_wstrb,	
+	S_AXI_WLAST	=> s_dram_axi_wlast,	
+	S_AXI_WVALID	=> s_dram_axi_wvalid,	
+	S_AXI_WREADY	=> s_dram_axi_wready,
+	S_AXI_BID	=> s_dram_axi_bid,	
+	S_AXI_BRESP	=> s_dram_axi_bresp,	
+	S_AXI_BVALID	=> s_dram_axi_bvalid,	
+	S_AXI_BREADY	=> s_dram_axi_bready,
+	S_AXI_ARID	=> s_dram_axi_arid,	
+	S_AXI_ARADDR	=> s_dram_axi_araddr,	
+	S_AXI_ARLEN	=> s_dram_axi_arlen,	
+	S_AXI_ARSIZE	=> s_dram_axi_arsize,	
+	S_AXI_ARBURST	=> s_dram_axi_arburst,	
+	S_AXI_ARLOCK	=> s_dram_axi_arlock,	
+	S_AXI_ARCACHE	=> s_dram_axi_arcache,	
+	S_AXI_ARPROT	=> s_dram_axi_arprot,	
+	S_AXI_ARQOS	=> s_dram_axi_arqos,
+	S_AXI_ARREGION  => (others => '0'),
+	S_AXI_ARVALID	=> s_dram_axi_arvalid,	
+	S_AXI_ARREADY	=> s_dram_axi_arready,	
+	S_AXI_RID	=> s_dram_axi_rid,
+	S_AXI_RDATA	=> s_dram_axi_rdata,	
+	S_AXI_RRESP	=> s_dram_axi_rresp,	
+	S_AXI_RLAST	=> s_dram_axi_rlast,	
+	S_AXI_RVALID	=> s_dram_axi_rvalid,	
+	S_AXI_RREADY	=> s_dram_axi_rready,
+	BD_EN		=> s_dram_bd_en,
+	BD_WE		=> s_dram_bd_we,
+	BD_ADDR		=> s_dram_bd_addr,
+	BD_DIN		=> s_dram_bd_din,
+	BD_DOUT		=> s_dram_bd_dout,
+	DUMP		=> s_bench_done
+);
+
+-- the packet processor and the device memory half of the signal engine share
+-- inst_dram, data_clock and sig_clock run in phase so the arbiter uses the former
+inst_dram_arbiter: entity work.axi_arbiter
+    generic map(
+		C_AXI_ADDR_WIDTH	=> CONF_DATA_AXI_ADDR_WIDTH,
+		C_AXI_DATA_WIDTH	=> CONF_DATA_AXI_DATA_WIDTH
+    )
+    port map(
+	ACLK		=> data_clock,
+	ARESETN		=> data_reset,
+
+	S0_AXI_AWID	=> s_data_axi_awid,
+	S0_AXI_AWADDR	=> s_data_axi_awaddr,
+	S0_AXI_AWLEN	=> s_data_axi_awlen,
+	S0_AXI_AWSIZE	=> s_data_axi_awsize,
+	S0_AXI_AWBURST	=> s_data_axi_awburst,
+	S0_AXI_AWLOCK	=> s_data_axi_awlock,
+	S0_AXI_AWCACHE	=> s_data_axi_awcache,
+	S0_AXI_AWPROT	=> s_data_axi_awprot,
+	S0_AXI_AWQOS	=> s_data_axi_awqos,
+	S0_AXI_AWVALID	=> s_data_axi_awvalid,
+	S0_AXI_AWREADY	=> s_data_axi_awready,
+	S0_AXI_WDATA	=> s_data_axi_wdata,
+	S0_AXI_WSTRB	=> s_data_axi_wstrb,
+	S0_AXI_WLAST	=> s_data_axi_wlast,
+	S0_AXI_WVALID	=> s_data_axi_wvalid,
+	S0_AXI_WREADY	=> s_data_axi_wready,
+	S0_AXI_BID	=> s_data_axi_bid,
+	S0_AXI_BRESP	=> s_data_axi_bresp,
+	S0_AXI_BVALID	=> s_data_axi_bvalid,
+	S0_AXI_BREADY	=> s_data_axi_bready,
+	S0_AXI_ARID	=> s_data_axi_arid,
+	S0_AXI_ARADDR	=> s_data_axi_araddr,
+	S0_AXI_ARLEN	=> s_data_axi_arlen,
+	S0_AXI_ARSIZE	=> s_data_axi_arsize,
+	S0_AXI_ARBURST	=> s_data_axi_arburst,
+	S0_AXI_ARLOCK	=> s_data_axi_arlock,
+	S0_AXI_ARCACHE	=> s_data_axi_arcache,
+	S0_AXI_ARPROT	=> s_data_axi_arprot,
+	S0_AXI_ARQOS	=> s_data_axi_arqos,
+	S0_AXI_ARVALID	=> s_data_axi_arvalid,
+	S0_AXI_ARREADY	=> s_data_axi_arready,
+	S0_AXI_RID	=> s_data_axi_rid,
+	S0_AXI_RDATA	=> s_data_axi_rdata,
+	S0_AXI_RRESP	=> s_data_axi_rresp,
+	S0_AXI_RLAST	=> s_data_axi_rlast,
+	S0_AXI_RVALID	=> s_data_axi_rvalid,
+	S0_AXI_RREADY	=> s_data_axi_rready,
+
+	S1_AXI_AWID	=> s_sig_axi_awid,
+	S1_AXI_AWADDR	=> s_sig_axi_awaddr,
+	S1_AXI_AWLEN	=> s_sig_axi_awlen,
+	S1_AXI_AWSIZE	=> s_sig_axi_awsize,
+	S1_AXI_AWBURST	=> s_sig_axi_awburst,
+	S1_AXI_AWLOCK	=> s_sig_axi_awlock,
+	S1_AXI_AWCACHE	=> s_sig_axi_awcache,
+	S1_AXI_AWPROT	=> s_sig_axi_awprot,
+	S1_AXI_AWQOS	=> s_sig_axi_awqos,
+	S1_AXI_AWVALID	=> s_sigd_axi_awvalid,
+	S1_AXI_AWREADY	=> s_sigd_axi_awready,
+	S1_AXI_WDATA	=> s_sig_axi_wdata,
+	S1_AXI_WSTRB	=> s_sig_axi_wstrb,
+	S1_AXI_WLAST	=> s_sig_axi_wlast,
+	S1_AXI_WVALID	=> s_sigd_axi_wvalid,
+	S1_AXI_WREADY	=> s_sigd_axi_wready,
+	S1_AXI_BID	=> s_sigd_axi_bid,
+	S1_AXI_BRESP	=> s_sigd_axi_bresp,
+	S1_AXI_BVALID	=> s_sigd_axi_bvalid,
+	S1_AXI_BREADY	=> s_sigd_axi_bready,
+	S1_AXI_ARID	=> s_sig_axi_arid,
+	S1_AXI_ARADDR	=> s_sig_axi_araddr,
+	S1_AXI_ARLEN	=> s_sig_axi_arlen,
+	S1_AXI_ARSIZE	=> s_sig_axi_arsize,
+	S1_AXI_ARBURST	=> s_sig_axi_arburst,
+	S1_AXI_ARLOCK	=> s_sig_axi_arlock,
+	S1_AXI_ARCACHE	=> s_sig_axi_arcache,
+	S1_AXI_ARPROT	=> s_sig_axi_arprot,
+	S1_AXI_ARQOS	=> s_sig_axi_arqos,
+	S1_AXI_ARVALID	=> s_sigd_axi_arvalid,
+	S1_AXI_ARREADY	=> s_sigd_axi_arready,
+	S1_AXI_RID	=> s_sigd_axi_rid,
+	S1_AXI_RDATA	=> s_sigd_axi_rdata,
+	S1_AXI_RRESP	=> s_sigd_axi_rresp,
+	S1_AXI_RLAST	=> s_sigd_axi_rlast,
+	S1_AXI_RVALID	=> s_sigd_axi_rvalid,
+	S1_AXI_RREADY	=> s_sigd_axi_rready,
+
+	M_AXI_AWID	=> s_dram_axi_awid,
+	M_AXI_AWADDR	=> s_dram_axi_awaddr,
+	M_AXI_AWLEN	=> s_dram_axi_awlen,
+	M_AXI_AWSIZE	=> s_dram_axi_awsize,
+	M_AXI_AWBURST	=> s_dram_axi_awburst,
+	M_AXI_AWLOCK	=> s_dram_axi_awlock,
+	M_AXI_AWCACHE	=> s_dram_axi_awcache,
+	M_AXI_AWPROT	=> s_dram_axi_awprot,
+	M_AXI_AWQOS	=> s_dram_axi_awqos,
+	M_AXI_AWVALID	=> s_dram_axi_awvalid,
+	M_AXI_AWREADY	=> s_dram_axi_awready,
+	M_AXI_WDATA	=> s_dram_axi_wdata,
+	M_AXI_WSTRB	=> s_dram_axi_wstrb,
+	M_AXI_WLAST	=> s_dram_axi_wlast,
+	M_AXI_WVALID	=> s_dram_axi_wvalid,
+	M_AXI_WREADY	=> s_dram_axi_wready,
+	M_AXI_BID	=> s_dram_axi_bid,
+	M_AXI_BRESP	=> s_dram_axi_bresp,
+	M_AXI_BVALID	=> s_dram_axi_bvalid,
+	M_AXI_BREADY	=> s_dram_axi_bready,
+	M_AXI_ARID	=> s_dram_axi_arid,
+	M_AXI_ARADDR	=> s_dram_axi_araddr,
+	M_AXI_ARLEN	=> s_dram_axi_arlen,
+	M_AXI_ARSIZE	=> s_dram_axi_arsize,
+	M_AXI_ARBURST	=> s_dram_axi_arburst,
+	M_AXI_ARLOCK	=> s_dram_axi_arlock,
+	M_AXI_ARCACHE	=> s_dram_axi_arcache,
+	M_AXI_ARPROT	=> s_dram_axi_arprot,
+	M_AXI_ARQOS	=> s_dram_axi_arqos,
+	M_AXI_ARVALID	=> s_dram_axi_arvalid,
+	M_AXI_ARREADY	=> s_dram_axi_arready,
+	M_AXI_RID	=> s_dram_axi_rid,
+	M_AXI_RDATA	=> s_dram_axi_rdata,
+	M_AXI_RRESP	=> s_dram_axi_rresp,
+	M_AXI_RLAST	=> s_dram_axi_rlast,
+	M_AXI_RVALID	=> s_dram_axi_rvalid,
+	M_AXI_RREADY	=> s_dram_axi_rready
+);
+
+-- address decoder of the signal engine, it keeps REG_ADDR for the whole
+-- decrement so the responses can be selected by the same decode
+s_sig_aw_dram <= '1' when unsigned(s_sig_axi_awaddr) >= unsigned(CONF_DATA_LOW_ADDR) and unsigned(s_sig_axi_awaddr) < unsigned(CONF_DATA_HIGH_ADDR) else '0';
+s_sig_ar_dram <= '1' when unsigned(s_sig_axi_araddr) >= unsigned(CONF_DATA_LOW_ADDR) and unsigned(s_sig_axi_araddr) < unsigned(CONF_DATA_HIGH_ADDR) else '0';
+
+s_sigd_axi_awvalid <= s_sig_axi_awvalid and s_sig_aw_dram;
+s_sigd_axi_wvalid  <= s_sig_axi_wvalid and s_sig_aw_dram;
+s_sigd_axi_bready  <= s_sig_axi_bready and s_sig_aw_dram;
+s_sigd_axi_arvalid <= s_sig_axi_arvalid and s_sig_ar_dram;
+s_sigd_axi_rready  <= s_sig_axi_rready and s_sig_ar_dram;
+s_sigh_axi_awvalid <= s_sig_axi_awvalid and not s_sig_aw_dram;
+s_sigh_axi_wvalid  <= s_sig_axi_wvalid and not s_sig_aw_dram;
+s_sigh_axi_bready  <= s_sig_axi_bready and not s_sig_aw_dram;
+s_sigh_axi_arvalid <= s_sig_axi_arvalid and not s_sig_ar_dram;
+s_sigh_axi_rready  <= s_sig_axi_rready and not s_sig_ar_dram;
+
+s_sig_axi_awready <= s_sigd_axi_awready when s_sig_aw_dram = '1' else s_sigh_axi_awready;
+s_sig_axi_wready  <= s_sigd_axi_wready  when s_sig_aw_dram = '1' else s_sigh_axi_wready;
+s_sig_axi_bid     <= s_sigd_axi_bid     when s_sig_aw_dram = '1' else s_sigh_axi_bid;
+s_sig_axi_bresp   <= s_sigd_axi_bresp   when s_sig_aw_dram = '1' else s_sigh_axi_bresp;
+s_sig_axi_bvalid  <= s_sigd_axi_bvalid  when s_sig_aw_dram = '1' else s_sigh_axi_bvalid;
+s_sig_axi_arready <= s_sigd_axi_arready when s_sig_ar_dram = '1' else s_sigh_axi_arready;
+s_sig_axi_rid     <= s_sigd_axi_rid     when s_sig_ar_dram = '1' else s_sigh_axi_rid;
+s_sig_axi_rdata   <= s_sigd_axi_rdata   when s_sig_ar_dram = '1' else s_sigh_axi_rdata;
+s_sig_axi_rresp   <= s_sigd_axi_rresp   when s_sig_ar_dram = '1' else s_sigh_axi_rresp;
+s_sig_axi_rlast   <= s_sigd_axi_rlast   when s_sig_ar_dram = '1' else s_sigh_axi_rlast;
+s_sig_axi_rvalid  <= s_sigd_axi_rvalid  when s_sig_ar_dram = '1' else s_sigh_axi_rvalid;
+
+-- host memory holding the completion signals outside of device memory
+inst_host_mem: entity work.burst_memory
+    generic map(
+		C_LOW_ADDR		=> CONF_SIG_LOW_ADDR,
+		C_AXI_ADDR_WIDTH	=> CONF_SIG_AXI_ADDR_WIDTH,
+		C_AXI_DATA_WIDTH	=> CONF_SIG_AXI_DATA_WIDTH,
+		C_NUM_1K_BRAM_BLOCKS	=> 4
+    )
+    port map(
+        clk       	=> clock,
+        rstn            => reset,
+	
+	S_AXI_ACLK	=> sig_clock,
+	S_AXI_ARESETN	=> sig_reset,
+	S_AXI_AWID	=> s_sig_axi_awid,
+	S_AXI_AWADDR	=> s_sig_axi_awaddr,
+	S_AXI_AWLEN	=> s_sig_axi_awlen,
+	S_AXI_AWSIZE	=> s_sig_axi_awsize,
+	S_AXI_AWBURST	=> s_sig_axi_awburst,
+	S_AXI_AWLOCK	=> s_sig_axi_awlock,
+	S_AXI_AWCACHE	=> s_sig_axi_awcache,
+	S_AXI_AWPROT	=> s_sig_axi_awprot,
+	S_AXI_AWQOS	=> s_sig_axi_awqos,
 	S_AXI_AWREGION  => (others => '0'),
-	S_AXI_AWVALID	=> s_data_axi_awvalid,	
-	S_AXI_AWREADY	=> s_data_axi_awready,	
-	S_AXI_WDATA	=> s_data_axi_wdata,	
-	S_AXI_WSTRB	=> s_data_axi_wstrb,	
-	S_AXI_WLAST	=> s_data_axi_wlast,	
-	S_AXI_WVALID	=> s_data_axi_wvalid,	
-	S_AXI_WREADY	=> s_data_axi_wready,
-	S_AXI_BID	=> s_data_axi_bid,	
-	S_AXI_BRESP	=> s_data_axi_bresp,	
-	S_AXI_BVALID	=> s_data_axi_bvalid,	
-	S_AXI_BREADY	=> s_data_axi_bready,
-	S_AXI_ARID	=> s_data_axi_arid,	
-	S_AXI_ARADDR	=> s_data_axi_araddr,	
-	S_AXI_ARLEN	=> s_data_axi_arlen,	
-	S_AXI_ARSIZE	=> s_data_axi_arsize,	
-	S_AXI_ARBURST	=> s_data_axi_arburst,	
-	S_AXI_ARLOCK	=> s_data_axi_arlock,	
-	S_AXI_ARCACHE	=> s_data_axi_arcache,	
-	S_AXI_ARPROT	=> s_data_axi_arprot,	
-	S_AXI_ARQOS	=> s_data_axi_arqos,
+	S_AXI_AWVALID	=> s_sigh_axi_awvalid,
+	S_AXI_AWREADY	=> s_sigh_axi_awready,
+	S_AXI_WDATA	=> s_sig_axi_wdata,
+	S_AXI_WSTRB	=> s_sig_axi_wstrb,
+	S_AXI_WLAST	=> s_sig_axi_wlast,
+	S_AXI_WVALID	=> s_sigh_axi_wvalid,
+	S_AXI_WREADY	=> s_sigh_axi_wready,
+	S_AXI_BID	=> s_sigh_axi_bid,
+	S_AXI_BRESP	=> s_sigh_axi_bresp,
+	S_AXI_BVALID	=> s_sigh_axi_bvalid,
+	S_AXI_BREADY	=> s_sigh_axi_bready,
+	S_AXI_ARID	=> s_sig_axi_arid,
+	S_AXI_ARADDR	=> s_sig_axi_araddr,
+	S_AXI_ARLEN	=> s_sig_axi_arlen,
+	S_AXI_ARSIZE	=> s_sig_axi_arsize,
+	S_AXI_ARBURST	=> s_sig_axi_arburst,
+	S_AXI_ARLOCK	=> s_sig_axi_arlock,
+	S_AXI_ARCACHE	=> s_sig_axi_arcache,
+	S_AXI_ARPROT	=> s_sig_axi_arprot,
+	S_AXI_ARQOS	=> s_sig_axi_arqos,
 	S_AXI_ARREGION  => (others => '0'),
-	S_AXI_ARVALID	=> s_data_axi_arvalid,	
-	S_AXI_ARREADY	=> s_data_axi_arready,	
-	S_AXI_RID	=> s_data_axi_rid,
-	S_AXI_RDATA	=> s_data_axi_rdata,	
-	S_AXI_RRESP	=> s_data_axi_rresp,	
-	S_AXI_RLAST	=> s_data_axi_rlast,	
-	S_AXI_RVALID	=> s_data_axi_rvalid,	
-	S_AXI_RREADY	=> s_data_axi_rready
+	S_AXI_ARVALID	=> s_sigh_axi_arvalid,
+	S_AXI_ARREADY	=> s_sigh_axi_arready,
+	S_AXI_RID	=> s_sigh_axi_rid,
+	S_AXI_RDATA	=> s_sigh_axi_rdata,
+	S_AXI_RRESP	=> s_sigh_axi_rresp,
+	S_AXI_RLAST	=> s_sigh_axi_rlast,
+	S_AXI_RVALID	=> s_sigh_axi_rvalid,
+	S_AXI_RREADY	=> s_sigh_axi_rready
 );
 
 inst_config: generic_memory
@@ -657,33 +1176,161 @@ begin
   reset 	<= '0';
   cmd_reset 	<= '0';
   data_reset 	<= '0';
+  sig_reset 	<= '0';
   halt 		<= '1';
   -- for the moment no interrupts arrive
-  s_rcv_aql_irq	<= '0';
+  s_initial_aql_irq <= '0';
   s_rcv_add_irq <= '0';
   s_rcv_rem_irq <= '0';
   wait for 25 ns;
   reset <= '1';
   cmd_reset <= '1';
   data_reset <= '1';
+  sig_reset <= '1';
   wait for 5 ns;
   halt <= '0';
 
   -- TPC sends a signal that aql packets have arrived
   -- PP starts dispatching jobs when the work bit is set
   wait for 25 ns;
-  s_rcv_aql_irq <= '1';
+  s_initial_aql_irq <= '1';
   wait for 20 ns;
-  s_rcv_aql_irq <= '0';
+  s_initial_aql_irq <= '0';
+  wait;
+end process;
+
+s_rcv_aql_irq <= s_initial_aql_irq or s_producer_aql_irq;
+
+-- host side producer of streamed workloads, replays the stimulus file of aql2mem
+-- (see tools/packet_tools/src/stimulus.h) through the backdoor of inst_dram
+aql_producer: process
+  file stimulus		: text;
+  variable status	: file_open_status;
+  variable l		: line;
+  variable c		: character;
+  variable good		: boolean;
+  variable word		: std_logic_vector(63 downto 0);
+  variable value	: std_logic_vector(63 downto 0);
+begin
+  s_producer_aql_irq <= '0';
+  s_dram_bd_en <= '0';
+  s_dram_bd_we <= '0';
+  s_dram_bd_addr <= (others => '0');
+  s_dram_bd_din <= (others => '0');
+  if G_AQL_STIMULUS_FILE = "" then
+    wait;
+  end if;
+  file_open(status, stimulus, G_AQL_STIMULUS_FILE, read_mode);
+  if status /= open_ok then
+    wait;
+  end if;
+
+  -- start behind the initial AQL interrupt
+  wait for 100 ns;
+  wait until rising_edge(data_clock);
+  while not endfile(stimulus) loop
+    readline(stimulus, l);
+    read(l, c, good);
+    if good and c /= '#' then
+      case c is
+        when 'D' =>
+          read_hex(l, value);
+          while unsigned(value) /= 0 loop
+            wait until rising_edge(data_clock);
+            value := std_logic_vector(unsigned(value) - 1);
+          end loop;
+        when 'M' =>
+          read_hex(l, word);
+          read_hex(l, value);
+          s_dram_bd_addr <= std_logic_vector(unsigned(CONF_DATA_LOW_ADDR) + shift_left(unsigned(word), 3));
+          s_dram_bd_din <= value;
+          s_dram_bd_we <= '1';
+          s_dram_bd_en <= '1';
+          wait until rising_edge(data_clock);
+          s_dram_bd_we <= '0';
+          s_dram_bd_en <= '0';
+        when 'R' =>
+          read_hex(l, word);
+          read_hex(l, value);
+          s_dram_bd_addr <= std_logic_vector(unsigned(CONF_DATA_LOW_ADDR) + shift_left(unsigned(word), 3));
+          s_dram_bd_en <= '1';
+          -- BD_DOUT still holds the word of the previous access until the next edge
+          loop
+            wait until rising_edge(data_clock);
+            wait until falling_edge(data_clock);
+            exit when unsigned(s_dram_bd_dout) >= unsigned(value);
+          end loop;
+          s_dram_bd_en <= '0';
+          wait until rising_edge(data_clock);
+        when 'I' =>
+          s_producer_aql_irq <= '1';
+          wait until rising_edge(data_clock);
+          s_producer_aql_irq <= '0';
+          wait until rising_edge(data_clock);
+        when others =>
+          report "unknown command " & c & " in " & G_AQL_STIMULUS_FILE severity failure;
+      end case;
+    end if;
+  end loop;
+  file_close(stimulus);
+  report "AQL stimulus " & G_AQL_STIMULUS_FILE & " replayed" severity note;
   wait;
 end process;
 
+-- reports every READ_INDEX update of the packet processor with its simulated
+-- time, the last one tells when the workload completed (aql2mem -d -t)
+read_index_monitor: process
+  constant READ_INDEX_ADDR : unsigned(CONF_DATA_AXI_ADDR_WIDTH-1 downto 0) :=
+    unsigned(CONF_DATA_LOW_ADDR) + to_unsigned(G_AQL_QUEUE_LENGTH*64 + G_AQL_QUEUE_LENGTH*4, CONF_DATA_AXI_ADDR_WIDTH);
+  variable address	: unsigned(CONF_DATA_AXI_ADDR_WIDTH-1 downto 0) := (others => '0');
+begin
+  wait until rising_edge(data_clock);
+  s_bench_completion <= '0';
+  -- the address of a burst is taken in the same cycle as its first beat at the latest
+  if s_data_axi_awvalid = '1' and s_data_axi_awready = '1' then
+    address := unsigned(s_data_axi_awaddr);
+  end if;
+  if s_data_axi_wvalid = '1' and s_data_axi_wready = '1' then
+    if address = READ_INDEX_ADDR then
+      report "READ_INDEX " & integer'image(to_integer(unsigned(s_data_axi_wdata(30 downto 0)))) severity note;
+      s_bench_completion <= '1';
+    end if;
+    address := address + CONF_DATA_AXI_DATA_WIDTH/8;
+  end if;
+end process;
+
+-- a packet is done with its READ_INDEX update, the data AXI bus carries the DMA transfers
+s_bench_beat <= (s_data_axi_rvalid and s_data_axi_rready) or (s_data_axi_wvalid and s_data_axi_wready);
+s_bench_irqs <= s_rcv_aql_irq & s_rcv_dma_irq & s_rcv_cpl_irq & s_rcv_add_irq & s_rcv_rem_irq & s_rcv_acc_irq_lanes;
+
+inst_bench: entity work.bench_statistics
+    generic map(
+		C_NAME			=> "packet_processor",
+		C_NUM_IRQS		=> G_NUM_ACCELERATOR_CORES+5,
+		C_IRQ_NAMES		=> "aql,dma,cpl,add,rem" & acc_lane_names(G_NUM_ACCELERATOR_CORES),
+		C_PACKETS		=> G_BENCH_PACKETS,
+		C_MAX_CYCLES		=> G_BENCH_MAX_CYCLES
+    )
+    port map(
+	clk		=> clock,
+	rstn		=> reset,
+	completion	=> s_bench_completion,
+	bus_beat	=> s_bench_beat,
+	irq		=> s_bench_irqs,
+	done		=> s_bench_done
+);
+
+-- in benchmark mode the clocks stop once the benchmark is done, which ends
+-- the simulation
 clock_P: process
 begin
 clock <= '0';
 wait for 10 ns;
 clock <= '1';
 wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
 end process;
 
 cmd_clock_P: process
@@ -692,6 +1339,9 @@ cmd_clock <= '0';
 wait for 10 ns;
 cmd_clock <= '1';
 wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
 end process;
 
 data_clock_P: process
@@ -700,6 +1350,20 @@ data_clock <= '0';
 wait for 10 ns;
 data_clock <= '1';
 wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
+end process;
+
+sig_clock_P: process
+begin
+sig_clock <= '0';
+wait for 10 ns;
+sig_clock <= '1';
+wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
 end process;
 
 end behav;
@@ -7,7 +7,23 @@ export PP_SIZE_DISPATCH_WINDOW=8  # must be power of 2
 
 # number of 64 bit values possible to store
 export PP_STACK_SIZE=128
-export PP_HEAP_SIZE=$(((DRAM_SIZE - PP_DRAM_RESERVED) / 8))
+
+# optional text region in DRAM, fetched through the instruction cache
+# functions marked with DRAM_TEXT are placed there
+export PP_ICACHE_ENABLE=0
+export PP_ICACHE_LINES=64       # must be power of 2
+export PP_ICACHE_LINE_SIZE=32   # bytes, must be power of 2 and at least 16
+export PP_ICACHE_PREFETCH=1
+export PP_DRAM_TEXT_SIZE=$((PP_ICACHE_ENABLE * 65536))
+export PP_DRAM_TEXT_OFFSET=$(((PP_DRAM_RESERVED + 4095) / 4096 * 4096))
+if [ $PP_DRAM_TEXT_SIZE -gt 0 ]; then
+    export PP_HEAP_OFFSET=$((PP_DRAM_TEXT_OFFSET + PP_DRAM_TEXT_SIZE))
+else
+    export PP_HEAP_OFFSET=$PP_DRAM_RESERVED
+fi
+
+# number of 64 bit values possible to store
+export PP_HEAP_SIZE=$(((DRAM_SIZE - PP_HEAP_OFFSET) / 8))
 
 export PP_TEXT_SIZE=$(expr 4096 \* $PP_NUM_TEXT_MEM_BLOCKS)
 export PP_DATA_SIZE=$(expr 4096 \* $PP_NUM_DATA_MEM_BLOCKS)
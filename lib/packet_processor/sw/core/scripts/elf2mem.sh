@@ -4,6 +4,7 @@ source conf.sh
 
 text_origin=0x0003000000000000
 data_origin=0x0003000002000000
+dram_origin=0x0001000000000000
 
 if [ -z "$2" ]; then
     output=.
@@ -11,8 +12,8 @@ else
     output=$2
 fi
 
-# dump all segments
-${MIPS64_GCC_PATH}/bin/${MIPS64_GCC_PREFIX}-readelf -l $1 | tail -n 3 > segments_dump
+# dump all segments, the dram text segment is handled separately
+${MIPS64_GCC_PATH}/bin/${MIPS64_GCC_PREFIX}-readelf -l $1 | grep -v "^ *[0-9]* *\.dram_text *$" | tail -n 3 > segments_dump
 
 # remove leading white spaces
 sed "s/^[ \t]*//" -i segments_dump
@@ -89,5 +90,33 @@ echo "// instance=/tb_packet_processor_top/inst_write_data/bram
 # add : for modelsim
 gawk '{$1=$1":"}1' data >> $output/data.mem
 
+# process dram text section, it is loaded into the dram next to the queues
+
+if [ -a $output/dram_text.mem ]; then
+    rm $output/dram_text.mem
+fi
+
+if [ $PP_DRAM_TEXT_SIZE -gt 0 ]; then
+    ${MIPS64_GCC_PATH}/bin/${MIPS64_GCC_PREFIX}-readelf -x .dram_text $1 | cut -c3-53 | tail -n +3 | head -n -1 > dram_text
+
+    gawk '{printf "%s ",$1;
+    printf "%s%s%s%s",substr($3,7,2),substr($3,5,2),substr($3,3,2),substr($3,1,2);
+    printf "%s%s%s%s ",substr($2,7,2),substr($2,5,2),substr($2,3,2),substr($2,1,2);
+    printf "%s%s%s%s",substr($5,7,2),substr($5,5,2),substr($5,3,2),substr($5,1,2);
+    printf "%s%s%s%s\n",substr($4,7,2),substr($4,5,2),substr($4,3,2),substr($4,1,2)};' dram_text > tmp_dram_text
+
+    # update addresses (doubleword addresses vs byte addresses)
+    gawk --non-decimal-data "{\$1=(\$1-$dram_origin)/8}1" tmp_dram_text > dram_text
+
+    # header for modelsim
+    echo "// instance=/tb_packet_processor_top/inst_dram/bram
+// format=mti addressradix=d dataradix=h version=1.0 wordsperline=2" > $output/dram_text.mem
+
+    # add : for modelsim
+    gawk '{$1=$1":"}1' dram_text >> $output/dram_text.mem
+
+    rm dram_text tmp_dram_text
+fi
+
 # clean up
 rm segments_dump segments text_sections data_sections text data tmp_text tmp_data
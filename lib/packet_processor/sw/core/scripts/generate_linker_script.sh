@@ -12,6 +12,7 @@ MEMORY
 		TEXT : ORIGIN = 0x0003000000000000, LENGTH = $PP_TEXT_SIZE
 		DATA : ORIGIN = 0x0003000002000000, LENGTH = $PP_DATA_SIZE
 		DRAM : ORIGIN = 0x0001000000000000, LENGTH = $DRAM_SIZE
+		DRAM_TEXT : ORIGIN = 0x0001000000000000 + $PP_DRAM_TEXT_OFFSET, LENGTH = $PP_DRAM_TEXT_SIZE
 	}
 
 REGION_ALIAS(\"REGION_TEXT\", TEXT);
@@ -30,7 +31,7 @@ stack_size = $PP_STACK_SIZE;
 heap_size = $PP_HEAP_SIZE;
 
 _stack_start = ORIGIN(DATA) + $PP_DATA_SIZE - 8;
-_heap_start = ORIGIN(DRAM) + $PP_DRAM_RESERVED;
+_heap_start = ORIGIN(DRAM) + $PP_HEAP_OFFSET;
 
 SECTIONS
 {
@@ -78,6 +79,10 @@ SECTIONS
             	. = ORIGIN(DATA) + LENGTH(DATA) - 1;
             	BYTE(0x00);
 	} > REGION_DATA
+	.dram_text ALIGN(4):
+	{
+		*(.dram_text .dram_text.*)
+	} > DRAM_TEXT
 	. = _heap_start;
 	.heap ALIGN(8):
         {
@@ -5,5 +5,12 @@ source conf.sh
 echo "\
 export MIPS_NUM_TEXT_MEM_BLOCKS=$PP_NUM_TEXT_MEM_BLOCKS
 export MIPS_NUM_DATA_MEM_BLOCKS=$PP_NUM_DATA_MEM_BLOCKS
-export MIPS_NUM_ACCELERATOR_CORES=$NUM_ACCELERATOR_CORES\
+export MIPS_NUM_ACCELERATOR_CORES=$NUM_ACCELERATOR_CORES
+export MIPS_ICACHE_ENABLE=$PP_ICACHE_ENABLE
+export MIPS_ICACHE_LINES=$PP_ICACHE_LINES
+export MIPS_ICACHE_LINE_SIZE=$PP_ICACHE_LINE_SIZE
+export MIPS_ICACHE_PREFETCH=$PP_ICACHE_PREFETCH
+export MIPS_DRAM_TEXT_OFFSET=$PP_DRAM_TEXT_OFFSET
+export MIPS_DRAM_TEXT_SIZE=$PP_DRAM_TEXT_SIZE
+export MIPS_AQL_QUEUE_LENGTH=$SIZE_AQL_QUEUE\
 " > $1/simulation.env
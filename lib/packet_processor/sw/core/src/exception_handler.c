@@ -362,14 +362,11 @@ static void exception_handler() {
     switch(exc_code) {
         case C_CP0_CAUSE_EXC_CODE_INT:{
             // Interrupt
+            // the cause bits only tell which classes of events are pending,
+            // all of them are serviced from the pending bitmap at once
             unsigned int interrupt_code = (cause & 0xFC00) >> 10;
-            switch(interrupt_code){
-                case 32: interrupt_kernel(); break;
-                case 16: interrupt_transfer(); break;
-                case 8 : interrupt_completion(); break;
-                case 4 : interrupt_add_core(); break;
-                case 2 : interrupt_remove_core(); break;
-		default: break;
+            if(interrupt_code != 0){
+                interrupt_pending();
             }
             break;}
         /*case C_CP0_CAUSE_EXC_CODE_ADEL:
@@ -39,6 +39,9 @@ volatile uint64_t launch_request_write_index = 0;
 struct decrement_request_t dec_queue[DISPATCH_WINDOW_SIZE];
 volatile uint64_t dec_request_read_index = 0;
 volatile uint64_t dec_request_write_index = 0;
+// request currently handled by the completion signal engine
+struct decrement_request_t current_dec_request;
+bool cmpl_engine_active = false;
 
 int main(){
 	// initialize dispatch window stack
@@ -169,6 +172,10 @@ void process_aql_packets(){
 			// if the queue is empty, set the AQL_LEFT register to 0 (disable the Packet Processor)
 			if(current_packet_number == *WRITE_INDEX){
 				*AQL_LEFT = 0;
+				// a doorbell between the check and the clear would be lost
+				if(current_packet_number != *WRITE_INDEX){
+					*AQL_LEFT = 1;
+				}
 			}
 		}
 	}
@@ -228,20 +235,79 @@ void process_launch_queue(){
 
 void process_dec_queue(){
 	disable_interrupts();
+	if(cmpl_engine_active){
+		uint64_t status = *CMPL_DEC_STATUS_ADDR;
+		if(!(status & CMPL_DEC_BUSY)){
+			cmpl_engine_active = false;
+			if(status & CMPL_DEC_ERROR){
+				// let the TPC decrement the signal instead
+				*CMPL_SIG_ADDR       = current_dec_request.signal_handle;
+				*CMPL_SIG_PASID_ADDR = current_dec_request.pasid;
+				send_completion_interrupt();
+			}else{
+				interrupt_completion();
+			}
+		}
+	}
 	if(dec_request_read_index != dec_request_write_index && current_cmpl_packet_id == UINT32_MAX){
-		// write configuration to registers
+		// start the completion signal engine
 		uint64_t dec_queue_index = dec_request_read_index & (DISPATCH_WINDOW_SIZE-1);
-		*CMPL_SIG_ADDR         = dec_queue[dec_queue_index].signal_handle;
-		*CMPL_SIG_PASID_ADDR   = dec_queue[dec_queue_index].pasid;	
-		current_cmpl_packet_id = dec_queue[dec_queue_index].packet_id;
-		// send interrupt to TPC
-		send_completion_interrupt();
+		current_dec_request    = dec_queue[dec_queue_index];
+		current_cmpl_packet_id = current_dec_request.packet_id;
+		*CMPL_DEC_ADDR         = current_dec_request.signal_handle;
+		cmpl_engine_active     = true;
 		++dec_request_read_index;
 	}
 	enable_interrupts();
 }
 
+void interrupt_pending(){
+	// the interrupt controller collects events until they are read,
+	// so keep draining until nothing arrived during the last round
+	uint64_t pending = *IRQ_PENDING_ADDR;
+	while(pending != 0){
+		if(pending & IRQ_PENDING_CORES){
+			for(uint32_t core=0; core<AVAILABLE_CORES; ++core){
+				if(pending & IRQ_PENDING_CORE(core)){
+					interrupt_kernel(core);
+				}
+			}
+		}
+		if(pending & IRQ_PENDING_TRANSFER){
+			interrupt_transfer();
+		}
+		if(pending & IRQ_PENDING_COMPLETION){
+			interrupt_completion();
+		}
+		if(pending & IRQ_PENDING_ADD_CORE){
+			interrupt_add_core();
+		}
+		if(pending & IRQ_PENDING_REMOVE_CORE){
+			interrupt_remove_core();
+		}
+		pending = *IRQ_PENDING_ADDR;
+	}
+}
+
+// a packet whose transfer hit a bus error is dropped, its completion signal
+// is left untouched so the host never sees it as completed
+DRAM_TEXT void retire_failed_packet(uint32_t packet_id){
+	free((void *)(pending_packets[packet_id].local_kernarg_address));
+	if(pending_packets[packet_id].status != GET_KERNARG){
+		free((void *)(pending_packets[packet_id].local_image_address));
+	}
+	free_slots[remaining_dispatch_slots] = packet_id;
+	++remaining_dispatch_slots;
+	pending_packets[packet_id].kp_addr->header = HSA_PACKET_TYPE_INVALID;
+	++(*READ_INDEX);
+}
+
 void interrupt_transfer(){
+	if(*DMA_STATUS_ADDR != DMA_STATUS_OK){
+		retire_failed_packet(current_dma_packet_id);
+		current_dma_packet_id = UINT32_MAX;
+		return;
+	}
 	switch(pending_packets[current_dma_packet_id].status){
 		case GET_KERNARG:{
 			hsa_kernel_dispatch_packet_t *kp = pending_packets[current_dma_packet_id].kp_addr;
@@ -249,7 +315,7 @@ void interrupt_transfer(){
 			uint64_t src_address = *local_kernargs;
 			uint8_t colormodel = *(((volatile uint8_t*)local_kernargs)+16);
 			// transfer source image to on board DRAM
-			int storage = kp->grid_size_x*kp->grid_size_y*get_pixel_storage(colormodel);
+			uint64_t storage = get_image_storage(kp->grid_size_x, kp->grid_size_y, colormodel);
 			void *dram_dest = malloc(storage);
 			pending_packets[current_dma_packet_id].local_image_address = (uint64_t)dram_dest;
 			pending_packets[current_dma_packet_id].status = GET_IMAGE;
@@ -275,7 +341,7 @@ void interrupt_transfer(){
 			int32_t *custom_mask = NULL;
 			uint16_t normalization = 0;
 			if(kernel == CUSTOM_FILTER3x3 || kernel == CUSTOM_FILTER5x5){
-				custom_mask   = ((int32_t*)local_kernargs)+5;
+				custom_mask   = ((int32_t*)local_kernargs)+6;
 				normalization = *(((volatile uint16_t*)local_kernargs)+10);
 			}else if(kernel == GAUSS3x3){
 				normalization = gauss_3x3_normalization;
@@ -324,14 +390,14 @@ void interrupt_transfer(){
 	current_dma_packet_id = UINT32_MAX;
 }
 
-void interrupt_kernel(){
+void interrupt_kernel(unsigned int core){
 	// copy the image from on-board DRAM to main memory
-	uint64_t packet_id = core_usage[*RCV_INT_ADDR].packet_id;
+	uint64_t packet_id = core_usage[core].packet_id;
 	hsa_kernel_dispatch_packet_t *kp = pending_packets[packet_id].kp_addr;
 	volatile uint64_t *local_kernargs = (volatile uint64_t*)pending_packets[packet_id].local_kernarg_address;
 	uint64_t dst_address = *((local_kernargs)+1);
 	uint8_t colormodel = *(((volatile uint8_t*)local_kernargs)+16);
-	int storage = kp->grid_size_x*kp->grid_size_y*get_pixel_storage(colormodel);
+	uint64_t storage = get_image_storage(kp->grid_size_x, kp->grid_size_y, colormodel);
 	// write DMA configuration to queue
 	uint64_t dma_queue_index = dma_request_write_index & (DISPATCH_WINDOW_SIZE-1);
 	dma_queue[dma_queue_index].packet_id      = packet_id;
@@ -343,8 +409,8 @@ void interrupt_kernel(){
 	++dma_request_write_index;
 	// update core bookkeeping information
 	pending_packets[packet_id].status = STORE_IMAGE;
-	core_usage[*RCV_INT_ADDR].packet_id = UINT32_MAX;
-	core_usage[*RCV_INT_ADDR].running = false;
+	core_usage[core].packet_id = UINT32_MAX;
+	core_usage[core].running = false;
 }
 
 void interrupt_completion(){
@@ -358,15 +424,15 @@ void interrupt_completion(){
 	++(*READ_INDEX);
 }
 
-void interrupt_add_core(){
+DRAM_TEXT void interrupt_add_core(){
 	send_added_core_interrupt();
 }
 
-void interrupt_remove_core(){
+DRAM_TEXT void interrupt_remove_core(){
 	send_removed_core_interrupt();
 }
 
-void write_mask_to_core(const uint32_t core, const fpga_operation_type_t operation, int32_t *custom_mask){
+DRAM_TEXT void write_mask_to_core(const uint32_t core, const fpga_operation_type_t operation, int32_t *custom_mask){
 	const int8_t *mask0 = NULL;
 	const int8_t *mask1 = NULL;
 	bool needs_write = false;
@@ -429,15 +495,13 @@ void write_mask_to_core(const uint32_t core, const fpga_operation_type_t operati
 		default: break;
 	}
 	if(needs_write){
+		// the predefined masks are bytes, expand them from doubleword loads
+		// instead of emulated byte loads
 		if(write_both){
 			volatile int32_t *mask0_entry = (volatile int32_t *)(BASE_ACCEL_ADDR+core*ACCEL_ADDR_SPACE_LEN+MASK0_OFFSET);
 			volatile int32_t *mask1_entry = (volatile int32_t *)(BASE_ACCEL_ADDR+core*ACCEL_ADDR_SPACE_LEN+MASK1_OFFSET);
-			for(int i=0; i<25; ++i){
-				*mask0_entry = (int32_t)(mask0[i]);
-				*mask1_entry = (int32_t)(mask1[i]);
-				++mask0_entry;
-				++mask1_entry;
-			}
+			mem_expand_int8(mask0_entry, mask0, 25);
+			mem_expand_int8(mask1_entry, mask1, 25);
 		}else if(write_custom){
 			volatile int32_t *mask0_entry = (volatile int32_t *)(BASE_ACCEL_ADDR+core*ACCEL_ADDR_SPACE_LEN+MASK0_OFFSET);
 			for(int i=0; i<custom_length; ++i){
@@ -446,10 +510,7 @@ void write_mask_to_core(const uint32_t core, const fpga_operation_type_t operati
 			}
 		}else{
 			volatile int32_t *mask0_entry = (volatile int32_t *)(BASE_ACCEL_ADDR+core*ACCEL_ADDR_SPACE_LEN+MASK0_OFFSET);
-			for(int i=0; i<25; ++i){
-				*mask0_entry = (int32_t)(mask0[i]);
-				++mask0_entry;
-			}
+			mem_expand_int8(mask0_entry, mask0, 25);
 		}
 	}
 }
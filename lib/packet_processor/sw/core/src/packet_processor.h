@@ -24,6 +24,7 @@
 #include "hsa_packets.h"
 #include "hsa_fpga.h"
 #include "address_conf.h"
+#include "mem_copy.h"
 
 #ifndef MAX_QUEUE_LENGTH
 #define MAX_QUEUE_LENGTH 128
@@ -37,6 +38,14 @@
 #define DISPATCH_WINDOW_SIZE 8
 #endif
 
+// functions that are not on the dispatch path can be moved to the dram text
+// region, they are fetched through the instruction cache
+#if defined(PP_ICACHE_ENABLE) && PP_ICACHE_ENABLE
+#define DRAM_TEXT __attribute__((section(".dram_text")))
+#else
+#define DRAM_TEXT
+#endif
+
 typedef enum {
 	GET_KERNARG = 0x00,
 	GET_IMAGE = 0x01,
@@ -93,9 +102,20 @@ void process_dma_queue();
 void process_launch_queue();
 void process_dec_queue();
 
+// bits of the pending interrupt bitmap
+#define IRQ_PENDING_CORE(core)  (((uint64_t)1) << (core))
+#define IRQ_PENDING_CORES       ((((uint64_t)1) << AVAILABLE_CORES)-1)
+#define IRQ_PENDING_REMOVE_CORE (((uint64_t)1) << (AVAILABLE_CORES))
+#define IRQ_PENDING_ADD_CORE    (((uint64_t)1) << (AVAILABLE_CORES+1))
+#define IRQ_PENDING_COMPLETION  (((uint64_t)1) << (AVAILABLE_CORES+2))
+#define IRQ_PENDING_TRANSFER    (((uint64_t)1) << (AVAILABLE_CORES+3))
+
 // custom_mask ignored for fixed functions
 void write_mask_to_core(const uint32_t core, const fpga_operation_type_t operation, int32_t *custom_mask);
 
+// drops a packet after a failed DMA transfer
+void retire_failed_packet(uint32_t packet_id);
+
 // helper functions
 static inline void send_dma_interrupt(){
 	*SND_INT = AVAILABLE_CORES+3;	
@@ -17,8 +17,9 @@
 #ifndef PACKET_PROCESSOR_EXCEPTIONS_H_
 #define PACKET_PROCESSOR_EXCEPTIONS_H_
 
+void interrupt_pending();
 void interrupt_transfer();
-void interrupt_kernel();
+void interrupt_kernel(unsigned int core);
 void interrupt_completion();
 void interrupt_add_core();
 void interrupt_remove_core();
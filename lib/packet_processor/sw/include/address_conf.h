@@ -36,11 +36,16 @@
 #define DEF_AQL_LEFT 			(DEF_BASE_CONFIG_SPACE + 0x00000)
 #define DEF_SND_INT 			(DEF_BASE_CONFIG_SPACE + 0x00008)
 #define DEF_RCV_INT_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00010)
+#define DEF_IRQ_PENDING_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00018)
+#define DEF_IRQ_COALESCE_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00020)
+#define DEF_CMPL_DEC_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00028)
+#define DEF_CMPL_DEC_STATUS_ADDR 	(DEF_BASE_CONFIG_SPACE + 0x00030)
 #define DEF_DMA_HOST_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00050)
 #define DEF_DMA_DEVICE_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00058)
 #define DEF_DMA_PAYLOAD_SIZE_ADDR 	(DEF_BASE_CONFIG_SPACE + 0x00060)
 #define DEF_DMA_LDST_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00068)
 #define DEF_DMA_PASID_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x0006C)
+#define DEF_DMA_STATUS_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00070)
 #define DEF_CMPL_SIG_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x00080)
 #define DEF_CMPL_SIG_PASID_ADDR 	(DEF_BASE_CONFIG_SPACE + 0x00088)
 #define DEF_BASE_ACCEL_ADDR 		(DEF_BASE_CONFIG_SPACE + 0x01000)
@@ -63,6 +68,11 @@ volatile uint64_t * const BASE_FREE_MEM             = (volatile uint64_t * const
 volatile uint64_t * const AQL_LEFT           = (volatile uint64_t * const)      DEF_AQL_LEFT;
 volatile uint64_t * const SND_INT            = (volatile uint64_t * const)      DEF_SND_INT;
 const volatile uint64_t * const RCV_INT_ADDR = (const volatile uint64_t * const)DEF_RCV_INT_ADDR;
+// pending interrupt bitmap, reading it clears the returned bits
+// bits 0..AVAILABLE_CORES-1 cores, then remove core, add core, completion and DMA
+const volatile uint64_t * const IRQ_PENDING_ADDR = (const volatile uint64_t * const)DEF_IRQ_PENDING_ADDR;
+// coalescing configuration: bits 47..32 event threshold, bits 31..0 timeout in cycles
+volatile uint64_t * const IRQ_COALESCE_ADDR      = (volatile uint64_t * const)      DEF_IRQ_COALESCE_ADDR;
 
 // DMA register addresses
 volatile uint64_t * const DMA_HOST_ADDR         = (volatile uint64_t * const)DEF_DMA_HOST_ADDR;
@@ -70,11 +80,22 @@ volatile uint64_t * const DMA_DEVICE_ADDR       = (volatile uint64_t * const)DEF
 volatile uint64_t * const DMA_PAYLOAD_SIZE_ADDR = (volatile uint64_t * const)DEF_DMA_PAYLOAD_SIZE_ADDR;
 volatile uint32_t * const DMA_LDST_ADDR         = (volatile uint32_t * const)DEF_DMA_LDST_ADDR;
 volatile uint32_t * const DMA_PASID_ADDR        = (volatile uint32_t * const)DEF_DMA_PASID_ADDR;
+// result of the last transfer, written before the DMA interrupt is sent back
+volatile uint32_t * const DMA_STATUS_ADDR       = (volatile uint32_t * const)DEF_DMA_STATUS_ADDR;
+#define DMA_STATUS_OK    0x0
+#define DMA_STATUS_ERROR 0x1
 
 // completion signal addresse
 volatile uint64_t * const CMPL_SIG_ADDR       = (volatile uint64_t * const)DEF_CMPL_SIG_ADDR;
 volatile uint32_t * const CMPL_SIG_PASID_ADDR = (volatile uint32_t * const)DEF_CMPL_SIG_PASID_ADDR;
 
+// completion signal engine, writing a signal handle starts decrementing its value
+volatile uint64_t * const CMPL_DEC_ADDR              = (volatile uint64_t * const)      DEF_CMPL_DEC_ADDR;
+const volatile uint64_t * const CMPL_DEC_STATUS_ADDR = (const volatile uint64_t * const)DEF_CMPL_DEC_STATUS_ADDR;
+#define CMPL_DEC_BUSY  0x1
+#define CMPL_DEC_DONE  0x2
+#define CMPL_DEC_ERROR 0x4
+
 // image processing config addresses
 volatile char * const BASE_ACCEL_ADDR = (volatile char * const)DEF_BASE_ACCEL_ADDR;
 const uint32_t ACCEL_ADDR_SPACE_LEN   = (const uint32_t) 0x01000;
@@ -25,6 +25,7 @@ add_files "memory_controller/memory_controller_racp.vhd"
 
 add_files "${common_dir}/axi_lite/axi_lite_master.vhd"
 add_files "${common_dir}/interrupts/interrupt_demux.vhd"
+add_files "${common_dir}/mem_router/instruction_cache.vhd"
 add_files "${common_dir}/mem_router/mem_router.vhd"
 add_files "${common_dir}/mem_router/singleclock_bram.vhd"
 add_files "${common_dir}/mem_router/bram_sp.vhd"
@@ -57,7 +57,11 @@ generic(
         G_MEM_NUM_4K_DATA_MEMS          : integer := 4;
         G_MEM_NUM_4K_INSTR_MEMS         : integer := 4;
         G_IMEM_INIT_FILE    		: string  := "";
-        G_DMEM_INIT_FILE    		: string  := ""
+        G_DMEM_INIT_FILE    		: string  := "";
+	-- benchmark mode: commands sent one after the other, stop after this many
+	-- replies to the packet processor or cycles, 0 runs on
+	G_BENCH_PACKETS			: integer := 0;
+	G_BENCH_MAX_CYCLES		: integer := 0
 );
 end tb_rom_accel_cmd_processor_top;
 
@@ -91,6 +95,13 @@ signal clock				: std_logic;
 signal data_clock			: std_logic;
 signal data_reset			: std_logic;
 
+-- benchmark counters
+signal s_bench_beat			: std_logic;
+signal s_bench_irqs			: std_logic_vector(CONF_NUM_HW_INTERRUPTS+CONF_NUM_SND_INTERRUPTS-1 downto 0);
+signal s_bench_done			: std_logic;
+-- without a packet or cycle limit the clocks run on like in the .do file
+constant BENCH_LIMITED			: boolean := G_BENCH_PACKETS > 0 or G_BENCH_MAX_CYCLES > 0;
+
 component rom_accel_cmd_processor_top is
     generic(
 	G_START_ADDRESS			: std_logic_vector(31 downto 0)	:= x"00000000";
@@ -198,6 +209,35 @@ component generic_memory is
     );
 end component;
 
+procedure handshake_controller(signal i_snd_irq: in std_logic; signal o_snd_irq_ack: out std_logic; 
+			       signal o_rcv_irq: out std_logic; signal i_rcv_irq_ack: in std_logic; constant TIMEOUT: in time) is
+begin
+  o_snd_irq_ack <= '0';
+  o_rcv_irq <= '0';
+  if(i_snd_irq = '1') then
+    wait for 20 ns;
+    o_snd_irq_ack <= '1';
+    wait until i_snd_irq = '0';
+    o_snd_irq_ack <= '0';
+    wait for TIMEOUT;
+    -- controller finished the transfer
+    o_rcv_irq <= '1';
+    wait until i_rcv_irq_ack = '1';
+    o_rcv_irq <= '0';
+  end if;
+end procedure;
+
+procedure oneway_handshake(signal i_snd_irq: in std_logic; signal o_snd_irq_ack: out std_logic) is
+begin
+  o_snd_irq_ack <= '0';
+  if(i_snd_irq = '1') then
+    wait for 20 ns;
+    o_snd_irq_ack <= '1';
+    wait until i_snd_irq = '0';
+    o_snd_irq_ack <= '0';
+  end if;
+end procedure;
+
 begin
 
 uut: rom_accel_cmd_processor_top
@@ -305,33 +345,73 @@ inst_config: generic_memory
 	S_AXI_RREADY	=> s_data_axi_rready
 );
 
+-- datamover, its transfer is done after 10 us
+handshake_controller(s_snd_irq(0), s_snd_irq_ack(0), s_rcv_irq(0), s_rcv_irq_ack(0), 10 us);
+-- processing element and packet processor
+oneway_handshake(s_snd_irq(1), s_snd_irq_ack(1));
+oneway_handshake(s_snd_irq(2), s_snd_irq_ack(2));
+
 stimuli: process
+  variable commands : integer := 0;
 begin
   reset 	<= '0';
   data_reset 	<= '0';
   halt 		<= '1';
   -- for the moment no interrupts arrive
-  s_rcv_irq		<= (others => '0');	
-  s_snd_irq_ack 	<= (others => '0');
+  s_rcv_irq(1)		<= '0';
   wait for 25 ns;
   reset <= '1';
   data_reset <= '1';
   halt <= '0';
 
-  -- write testcase
+  -- write testcase, in benchmark mode the next one follows the reply to the packet processor
   wait for 100 ns;
-  s_rcv_irq <= "10";
-  wait until s_rcv_irq_ack = "10";
-  s_rcv_irq <= "00";
+  loop
+    s_rcv_irq(1) <= '1';
+    wait until s_rcv_irq_ack(1) = '1';
+    s_rcv_irq(1) <= '0';
+    commands := commands + 1;
+    exit when commands >= G_BENCH_PACKETS;
+    if(s_snd_irq(2) /= '1') then
+      wait until s_snd_irq(2) = '1';
+    end if;
+    wait until s_snd_irq(2) = '0';
+  end loop;
   wait;
 end process;
 
+-- a packet is done with the reply to the packet processor (snd lane 2)
+s_bench_beat <= (s_data_axi_rvalid and s_data_axi_rready) or (s_data_axi_wvalid and s_data_axi_wready);
+s_bench_irqs <= s_rcv_irq & s_snd_irq;
+
+inst_bench: entity work.bench_statistics
+    generic map(
+		C_NAME			=> "rom_accel_cmd_processor",
+		C_NUM_IRQS		=> CONF_NUM_HW_INTERRUPTS+CONF_NUM_SND_INTERRUPTS,
+		C_IRQ_NAMES		=> "rcv1,rcv0,snd2,snd1,snd0",
+		C_PACKETS		=> G_BENCH_PACKETS,
+		C_MAX_CYCLES		=> G_BENCH_MAX_CYCLES
+    )
+    port map(
+	clk		=> clock,
+	rstn		=> reset,
+	completion	=> s_snd_irq(2),
+	bus_beat	=> s_bench_beat,
+	irq		=> s_bench_irqs,
+	done		=> s_bench_done
+);
+
+-- in benchmark mode the clocks stop once the benchmark is done, which ends
+-- the simulation
 clock_P: process
 begin
 clock <= '0';
 wait for 10 ns;
 clock <= '1';
 wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
 end process;
 
 data_clock_P: process
@@ -340,6 +420,9 @@ data_clock <= '0';
 wait for 10 ns;
 data_clock <= '1';
 wait for 10 ns;
+if BENCH_LIMITED and s_bench_done = '1' then
+  wait;
+end if;
 end process;
 
 end behav;
@@ -27,6 +27,7 @@ typedef enum {
 typedef enum {
 	UINT16_GRAY_SCALE = 0x0,
 	UINT8_RGB         = 0x1,
+	UINT8_RGBX        = 0x2,	// RGB padded to 32 bit per pixel, see get_image_storage()
 } fpga_colormodel_t;
 
 // define supported FPGA operations
@@ -53,10 +54,23 @@ static inline int get_pixel_storage(uint64_t colormodel){
 	switch(colormodel){
 		case UINT16_GRAY_SCALE: return 2;
 		case UINT8_RGB: return 3;
+		case UINT8_RGBX: return 4;
 		default: return 0;
 	}
 }
 
+// bytes of an image in memory and of its transfers, images of padded color
+// models end on a multiple of IMAGE_ALIGNMENT, see hsa_fpga.h
+#define IMAGE_ALIGNMENT 64
+
+static inline uint64_t get_image_storage(uint32_t sizex, uint32_t sizey, uint64_t colormodel){
+	uint64_t storage = (uint64_t)sizex*sizey*get_pixel_storage(colormodel);
+	if(colormodel == UINT8_RGBX){
+		storage = (storage + IMAGE_ALIGNMENT-1) & ~(uint64_t)(IMAGE_ALIGNMENT-1);
+	}
+	return storage;
+}
+
 // available filter masks
 const int8_t sobelX_3x3_mask[25] = { 0, 0, 0, 0, 0,
 				     0, 1, 0,-1, 0,
@@ -53,15 +53,15 @@ void handle_interrupt_from_packetprocessor(){
     execution_done = 0;
 }
 
-static inline uint32_t compute_bpp(uint16_t color_model){
-    return (uint32_t)get_pixel_storage(color_model);
-}
-
-static inline uint32_t pe_encode_op(uint8_t color, uint8_t border,
+// the padded bit lies above the fields of the unpadded color models, so
+// their encoding stays the same; with it the PE takes 32 bit per pixel and
+// leaves the fourth byte 0
+static inline uint32_t pe_encode_op(uint8_t padded, uint8_t color, uint8_t border,
                                     uint8_t kernel, uint8_t norm_and_thresh){
 
     uint32_t result = 0;
 
+    append(result, 1, padded);
     append(result, 1, color);
     append(result, 2, border);
     append(result, 3, kernel);
@@ -85,6 +85,7 @@ static inline void write_task_config_to_pe( fpga_operation_type_t task,
                                             uint16_t normalization, uint16_t threshold){
 
     uint8_t color = 1;
+    uint8_t padded = 0;
     switch(color_model){
         case UINT16_GRAY_SCALE:
             color = 1;
@@ -92,6 +93,10 @@ static inline void write_task_config_to_pe( fpga_operation_type_t task,
         case UINT8_RGB:
             color = 0;
             break;
+        case UINT8_RGBX:
+            color = 0;
+            padded = 1;
+            break;
     }
 
     uint32_t window_width = 0;
@@ -212,14 +217,14 @@ static inline void write_task_config_to_pe( fpga_operation_type_t task,
     uint32_t pe_op;
     if(op_type == 0 && normalize_val != 0){
         write_32(BASE_ADDR_CFG_PE, PE_CFG_NORMALIZE_VAL, normalize_val);
-        pe_op = pe_encode_op(color, border, op_type, 1);
+        pe_op = pe_encode_op(padded, color, border, op_type, 1);
     }
     else if (op_type == 1 && threshold_val != 0){
         write_32(BASE_ADDR_CFG_PE, PE_CFG_THRESHOLD_VAL, threshold_val);
-        pe_op = pe_encode_op(color, border, op_type, 1);
+        pe_op = pe_encode_op(padded, color, border, op_type, 1);
     }
     else {
-        pe_op = pe_encode_op(color, border, op_type, 0);
+        pe_op = pe_encode_op(padded, color, border, op_type, 0);
     }
 
     write_32(BASE_ADDR_CFG_PE, PE_CFG_WINDOW_WIDTH, window_width);
@@ -242,10 +247,7 @@ static inline void run_computation(){
     uint64_t addr_dst           = read_64(BASE_ADDR_CFG, CFG_DST_ADDR);
 
     // compute config values
-    uint32_t bytes_per_pixel = compute_bpp(color_model); 
-    //uint64_t size_in = (uint64_t)img_width * (uint64_t)img_height
-    //                                       * (uint64_t)bytes_per_pixel;
-    uint64_t size_in = img_width * img_height * bytes_per_pixel;
+    uint64_t size_in = get_image_storage(img_width, img_height, color_model);
     uint64_t size_out = size_in;
 
     // write config to pe
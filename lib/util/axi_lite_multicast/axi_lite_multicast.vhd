@@ -0,0 +1,208 @@
+-- Copyright (C) 2017 Philipp Holzinger
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+-- Write multicast for the code space of the cores. A write to the slave port
+-- is repeated on every master port selected by the target mask in the address:
+--
+--   slave address:  [C_OFFSET_WIDTH+C_NUM_MASTERS-1 : C_OFFSET_WIDTH] target mask
+--                   [C_OFFSET_WIDTH-1 : 0]                            offset
+--   master k:       C_M_BASE_ADDR + k*2^C_OFFSET_WIDTH + offset
+--
+-- The master ports are written in parallel, the response is sent once all of
+-- them have answered and holds the worst of their responses. An empty mask
+-- is answered with SLVERR. Reads are not supported and answered with DECERR.
+
+entity axi_lite_multicast is
+	generic (
+		C_NUM_MASTERS		: integer		:= 4;
+		C_OFFSET_WIDTH		: integer		:= 25;
+		C_M_BASE_ADDR		: std_logic_vector	:= x"0004000000000000";
+		C_AXI_ADDR_WIDTH	: integer		:= 64;
+		C_AXI_DATA_WIDTH	: integer		:= 64
+	);
+	port (
+		aclk		: in std_logic;
+		aresetn		: in std_logic;
+
+		-- Ports of Axi Slave Bus Interface S_AXI
+		s_axi_awaddr	: in std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
+		s_axi_awprot	: in std_logic_vector(2 downto 0);
+		s_axi_awvalid	: in std_logic;
+		s_axi_awready	: out std_logic;
+		s_axi_wdata	: in std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
+		s_axi_wstrb	: in std_logic_vector((C_AXI_DATA_WIDTH/8)-1 downto 0);
+		s_axi_wvalid	: in std_logic;
+		s_axi_wready	: out std_logic;
+		s_axi_bresp	: out std_logic_vector(1 downto 0);
+		s_axi_bvalid	: out std_logic;
+		s_axi_bready	: in std_logic;
+		s_axi_araddr	: in std_logic_vector(C_AXI_ADDR_WIDTH-1 downto 0);
+		s_axi_arprot	: in std_logic_vector(2 downto 0);
+		s_axi_arvalid	: in std_logic;
+		s_axi_arready	: out std_logic;
+		s_axi_rdata	: out std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
+		s_axi_rresp	: out std_logic_vector(1 downto 0);
+		s_axi_rvalid	: out std_logic;
+		s_axi_rready	: in std_logic;
+
+		-- write channels of the master ports, master k at slice k
+		m_axi_awaddr	: out std_logic_vector(C_NUM_MASTERS*C_AXI_ADDR_WIDTH-1 downto 0);
+		m_axi_awprot	: out std_logic_vector(C_NUM_MASTERS*3-1 downto 0);
+		m_axi_awvalid	: out std_logic_vector(C_NUM_MASTERS-1 downto 0);
+		m_axi_awready	: in std_logic_vector(C_NUM_MASTERS-1 downto 0);
+		m_axi_wdata	: out std_logic_vector(C_NUM_MASTERS*C_AXI_DATA_WIDTH-1 downto 0);
+		m_axi_wstrb	: out std_logic_vector(C_NUM_MASTERS*(C_AXI_DATA_WIDTH/8)-1 downto 0);
+		m_axi_wvalid	: out std_logic_vector(C_NUM_MASTERS-1 downto 0);
+		m_axi_wready	: in std_logic_vector(C_NUM_MASTERS-1 downto 0);
+		m_axi_bresp	: in std_logic_vector(C_NUM_MASTERS*2-1 downto 0);
+		m_axi_bvalid	: in std_logic_vector(C_NUM_MASTERS-1 downto 0);
+		m_axi_bready	: out std_logic_vector(C_NUM_MASTERS-1 downto 0)
+	);
+end axi_lite_multicast;
+
+architecture arch_imp of axi_lite_multicast is
+
+	type write_state_t is (W_IDLE, W_SEND, W_RESPONSE);
+	type read_state_t is (R_IDLE, R_RESPONSE);
+
+	constant C_NONE		: std_logic_vector(C_NUM_MASTERS-1 downto 0) := (others => '0');
+	constant C_RESP_OKAY	: std_logic_vector(1 downto 0) := "00";
+	constant C_RESP_SLVERR	: std_logic_vector(1 downto 0) := "10";
+	constant C_RESP_DECERR	: std_logic_vector(1 downto 0) := "11";
+
+	signal r_write_state	: write_state_t;
+	signal r_read_state	: read_state_t;
+
+	-- the write being multicast
+	signal r_offset		: unsigned(C_AXI_ADDR_WIDTH-1 downto 0);
+	signal r_prot		: std_logic_vector(2 downto 0);
+	signal r_data		: std_logic_vector(C_AXI_DATA_WIDTH-1 downto 0);
+	signal r_strb		: std_logic_vector((C_AXI_DATA_WIDTH/8)-1 downto 0);
+	signal r_resp		: std_logic_vector(1 downto 0);
+
+	-- masters that still have to accept the address, the data or to respond
+	signal r_pending_aw	: std_logic_vector(C_NUM_MASTERS-1 downto 0);
+	signal r_pending_w	: std_logic_vector(C_NUM_MASTERS-1 downto 0);
+	signal r_pending_b	: std_logic_vector(C_NUM_MASTERS-1 downto 0);
+
+	signal s_accept_write	: std_logic;
+	signal s_accept_read	: std_logic;
+
+begin
+
+-- address and data of a write are taken together
+s_accept_write	<= '1' when r_write_state = W_IDLE and s_axi_awvalid = '1' and s_axi_wvalid = '1' else '0';
+s_axi_awready	<= s_accept_write;
+s_axi_wready	<= s_accept_write;
+s_axi_bvalid	<= '1' when r_write_state = W_RESPONSE else '0';
+s_axi_bresp	<= r_resp;
+
+s_accept_read	<= '1' when r_read_state = R_IDLE and s_axi_arvalid = '1' else '0';
+s_axi_arready	<= s_accept_read;
+s_axi_rvalid	<= '1' when r_read_state = R_RESPONSE else '0';
+s_axi_rresp	<= C_RESP_DECERR;
+s_axi_rdata	<= (others => '0');
+
+gen_masters: for k in 0 to C_NUM_MASTERS-1 generate
+	m_axi_awaddr((k+1)*C_AXI_ADDR_WIDTH-1 downto k*C_AXI_ADDR_WIDTH) <= std_logic_vector(resize(unsigned(C_M_BASE_ADDR), C_AXI_ADDR_WIDTH)
+		+ shift_left(to_unsigned(k, C_AXI_ADDR_WIDTH), C_OFFSET_WIDTH) + r_offset);
+	m_axi_awprot((k+1)*3-1 downto k*3) <= r_prot;
+	m_axi_wdata((k+1)*C_AXI_DATA_WIDTH-1 downto k*C_AXI_DATA_WIDTH) <= r_data;
+	m_axi_wstrb((k+1)*(C_AXI_DATA_WIDTH/8)-1 downto k*(C_AXI_DATA_WIDTH/8)) <= r_strb;
+end generate gen_masters;
+
+m_axi_awvalid	<= r_pending_aw;
+m_axi_wvalid	<= r_pending_w;
+m_axi_bready	<= r_pending_b;
+
+write_path: process(aclk)
+	variable v_mask		: std_logic_vector(C_NUM_MASTERS-1 downto 0);
+	variable v_resp		: std_logic_vector(1 downto 0);
+begin
+	if(rising_edge(aclk)) then
+		if(aresetn = '0') then
+			r_write_state	<= W_IDLE;
+			r_offset	<= (others => '0');
+			r_prot		<= (others => '0');
+			r_data		<= (others => '0');
+			r_strb		<= (others => '0');
+			r_resp		<= C_RESP_OKAY;
+			r_pending_aw	<= (others => '0');
+			r_pending_w	<= (others => '0');
+			r_pending_b	<= (others => '0');
+		else
+			case r_write_state is
+				when W_IDLE =>
+					if(s_accept_write = '1') then
+						v_mask := s_axi_awaddr(C_OFFSET_WIDTH+C_NUM_MASTERS-1 downto C_OFFSET_WIDTH);
+						r_offset	<= resize(unsigned(s_axi_awaddr(C_OFFSET_WIDTH-1 downto 0)), C_AXI_ADDR_WIDTH);
+						r_prot		<= s_axi_awprot;
+						r_data		<= s_axi_wdata;
+						r_strb		<= s_axi_wstrb;
+						r_pending_aw	<= v_mask;
+						r_pending_w	<= v_mask;
+						r_pending_b	<= v_mask;
+						if(v_mask = C_NONE) then
+							r_resp		<= C_RESP_SLVERR;
+							r_write_state	<= W_RESPONSE;
+						else
+							r_resp		<= C_RESP_OKAY;
+							r_write_state	<= W_SEND;
+						end if;
+					end if;
+
+				when W_SEND =>
+					-- every master takes address and data at its own pace
+					r_pending_aw	<= r_pending_aw and not m_axi_awready;
+					r_pending_w	<= r_pending_w and not m_axi_wready;
+					v_resp := r_resp;
+					for k in 0 to C_NUM_MASTERS-1 loop
+						if(r_pending_b(k) = '1' and m_axi_bvalid(k) = '1' and unsigned(m_axi_bresp(2*k+1 downto 2*k)) > unsigned(v_resp)) then
+							v_resp := m_axi_bresp(2*k+1 downto 2*k);
+						end if;
+					end loop;
+					r_resp		<= v_resp;
+					r_pending_b	<= r_pending_b and not m_axi_bvalid;
+					if((r_pending_b and not m_axi_bvalid) = C_NONE) then
+						r_write_state	<= W_RESPONSE;
+					end if;
+
+				when W_RESPONSE =>
+					if(s_axi_bready = '1') then
+						r_write_state	<= W_IDLE;
+					end if;
+			end case;
+		end if;
+	end if;
+end process write_path;
+
+read_path: process(aclk)
+begin
+	if(rising_edge(aclk)) then
+		if(aresetn = '0') then
+			r_read_state <= R_IDLE;
+		elsif(s_accept_read = '1') then
+			r_read_state <= R_RESPONSE;
+		elsif(r_read_state = R_RESPONSE and s_axi_rready = '1') then
+			r_read_state <= R_IDLE;
+		end if;
+	end if;
+end process read_path;
+
+end arch_imp;
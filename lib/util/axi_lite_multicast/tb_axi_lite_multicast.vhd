@@ -0,0 +1,285 @@
+-- Copyright (C) 2017 Philipp Holzinger
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+library ieee;
+use IEEE.std_logic_1164.all;
+use IEEE.numeric_std.all;
+
+-- axi_lite_multicast with three AXI-Lite slaves that accept address and data
+-- at different paces, master k takes the address after k cycles and the data
+-- after N-1-k cycles
+entity tb_axi_lite_multicast IS
+end tb_axi_lite_multicast;
+
+architecture behav of tb_axi_lite_multicast is
+
+constant N: integer := 3;
+constant OFFSET_WIDTH: integer := 25;
+constant M_BASE_ADDR: std_logic_vector(63 downto 0) := x"0004000000000000";
+-- upper 4 GiB of the code space as used by the firmware, ignored by the unit
+constant WINDOW_ADDR: std_logic_vector(63 downto 0) := x"0004000100000000";
+
+type addr_array is array (0 to N-1) of std_logic_vector(63 downto 0);
+type int_array is array (0 to N-1) of integer;
+
+signal clock: std_logic;
+signal reset: std_logic;
+
+signal s_awaddr: std_logic_vector(63 downto 0);
+signal s_awvalid: std_logic;
+signal s_awready: std_logic;
+signal s_wdata: std_logic_vector(63 downto 0);
+signal s_wvalid: std_logic;
+signal s_wready: std_logic;
+signal s_bresp: std_logic_vector(1 downto 0);
+signal s_bvalid: std_logic;
+signal s_bready: std_logic;
+signal s_arvalid: std_logic;
+signal s_arready: std_logic;
+signal s_rresp: std_logic_vector(1 downto 0);
+signal s_rvalid: std_logic;
+signal s_rready: std_logic;
+
+signal m_awaddr: std_logic_vector(N*64-1 downto 0);
+signal m_awvalid: std_logic_vector(N-1 downto 0);
+signal m_awready: std_logic_vector(N-1 downto 0);
+signal m_wdata: std_logic_vector(N*64-1 downto 0);
+signal m_wvalid: std_logic_vector(N-1 downto 0);
+signal m_wready: std_logic_vector(N-1 downto 0);
+signal m_bresp: std_logic_vector(N*2-1 downto 0);
+signal m_bvalid: std_logic_vector(N-1 downto 0);
+signal m_bready: std_logic_vector(N-1 downto 0);
+
+-- slave models
+signal slave_resp: std_logic_vector(N*2-1 downto 0);
+signal writes: int_array;
+signal last_addr: addr_array;
+signal last_data: addr_array;
+
+function target(mask: std_logic_vector(N-1 downto 0); offset: integer) return std_logic_vector is
+begin
+	return std_logic_vector(unsigned(WINDOW_ADDR) + shift_left(resize(unsigned(mask), 64), OFFSET_WIDTH) + to_unsigned(offset, 64));
+end function;
+
+function slot(k: integer; offset: integer) return std_logic_vector is
+begin
+	return std_logic_vector(unsigned(M_BASE_ADDR) + shift_left(to_unsigned(k, 64), OFFSET_WIDTH) + to_unsigned(offset, 64));
+end function;
+
+begin
+
+uut: entity work.axi_lite_multicast
+generic map(
+	C_NUM_MASTERS => N,
+	C_OFFSET_WIDTH => OFFSET_WIDTH,
+	C_M_BASE_ADDR => M_BASE_ADDR,
+	C_AXI_ADDR_WIDTH => 64,
+	C_AXI_DATA_WIDTH => 64
+)
+port map(
+	aclk => clock,
+	aresetn => reset,
+	s_axi_awaddr => s_awaddr,
+	s_axi_awprot => "000",
+	s_axi_awvalid => s_awvalid,
+	s_axi_awready => s_awready,
+	s_axi_wdata => s_wdata,
+	s_axi_wstrb => x"FF",
+	s_axi_wvalid => s_wvalid,
+	s_axi_wready => s_wready,
+	s_axi_bresp => s_bresp,
+	s_axi_bvalid => s_bvalid,
+	s_axi_bready => s_bready,
+	s_axi_araddr => WINDOW_ADDR,
+	s_axi_arprot => "000",
+	s_axi_arvalid => s_arvalid,
+	s_axi_arready => s_arready,
+	s_axi_rdata => open,
+	s_axi_rresp => s_rresp,
+	s_axi_rvalid => s_rvalid,
+	s_axi_rready => s_rready,
+	m_axi_awaddr => m_awaddr,
+	m_axi_awprot => open,
+	m_axi_awvalid => m_awvalid,
+	m_axi_awready => m_awready,
+	m_axi_wdata => m_wdata,
+	m_axi_wstrb => open,
+	m_axi_wvalid => m_wvalid,
+	m_axi_wready => m_wready,
+	m_axi_bresp => m_bresp,
+	m_axi_bvalid => m_bvalid,
+	m_axi_bready => m_bready
+);
+
+slaves: for k in 0 to N-1 generate
+slave: process(clock)
+variable aw_wait: integer;
+variable w_wait: integer;
+variable got_aw: boolean;
+variable got_w: boolean;
+begin
+if(rising_edge(clock)) then
+if(reset='0') then
+	m_awready(k) <= '0';
+	m_wready(k) <= '0';
+	m_bvalid(k) <= '0';
+	m_bresp(2*k+1 downto 2*k) <= "00";
+	writes(k) <= 0;
+	last_addr(k) <= (others => '0');
+	last_data(k) <= (others => '0');
+	aw_wait := 0;
+	w_wait := 0;
+	got_aw := false;
+	got_w := false;
+else
+	if(m_awvalid(k)='1' and m_awready(k)='1') then
+		m_awready(k) <= '0';
+		last_addr(k) <= m_awaddr((k+1)*64-1 downto k*64);
+		got_aw := true;
+	elsif(m_awvalid(k)='1' and not got_aw) then
+		if(aw_wait = k) then
+			m_awready(k) <= '1';
+		else
+			aw_wait := aw_wait + 1;
+		end if;
+	end if;
+
+	if(m_wvalid(k)='1' and m_wready(k)='1') then
+		m_wready(k) <= '0';
+		last_data(k) <= m_wdata((k+1)*64-1 downto k*64);
+		got_w := true;
+	elsif(m_wvalid(k)='1' and not got_w) then
+		if(w_wait = N-1-k) then
+			m_wready(k) <= '1';
+		else
+			w_wait := w_wait + 1;
+		end if;
+	end if;
+
+	if(m_bvalid(k)='1') then
+		if(m_bready(k)='1') then
+			m_bvalid(k) <= '0';
+			aw_wait := 0;
+			w_wait := 0;
+			got_aw := false;
+			got_w := false;
+		end if;
+	elsif(got_aw and got_w) then
+		m_bvalid(k) <= '1';
+		m_bresp(2*k+1 downto 2*k) <= slave_resp(2*k+1 downto 2*k);
+		writes(k) <= writes(k) + 1;
+	end if;
+end if;
+end if;
+end process;
+end generate slaves;
+
+stimuli: process
+  variable resp: std_logic_vector(1 downto 0);
+
+  -- one write through the slave port, address and data are offered together
+  procedure axi_write(addr: std_logic_vector(63 downto 0); data: std_logic_vector(63 downto 0); bresp: out std_logic_vector(1 downto 0)) is
+  begin
+    wait until falling_edge(clock);
+    s_awaddr <= addr;
+    s_wdata <= data;
+    s_awvalid <= '1';
+    s_wvalid <= '1';
+    loop
+      wait until rising_edge(clock);
+      exit when s_awready = '1';
+    end loop;
+    assert s_wready = '1' report "address and data were not taken together" severity error;
+    s_awvalid <= '0';
+    s_wvalid <= '0';
+    s_bready <= '1';
+    loop
+      wait until rising_edge(clock);
+      exit when s_bvalid = '1';
+    end loop;
+    bresp := s_bresp;
+    s_bready <= '0';
+  end procedure;
+begin
+  reset <= '0';
+  s_awaddr <= (others => '0');
+  s_awvalid <= '0';
+  s_wdata <= (others => '0');
+  s_wvalid <= '0';
+  s_bready <= '0';
+  s_arvalid <= '0';
+  s_rready <= '0';
+  slave_resp <= (others => '0');
+  wait for 45 ns;
+  reset <= '1';
+
+  -- masters 0 and 2, each at the same offset of its own slot
+  axi_write(target("101", 16#1238#), x"0123456789ABCDEF", resp);
+  assert resp = "00" report "multicast to masters 0 and 2 not OKAY" severity error;
+  assert writes(0) = 1 and writes(1) = 0 and writes(2) = 1 report "multicast did not reach exactly masters 0 and 2" severity error;
+  assert last_addr(0) = slot(0, 16#1238#) report "wrong address at master 0" severity error;
+  assert last_addr(2) = slot(2, 16#1238#) report "wrong address at master 2" severity error;
+  assert last_data(0) = x"0123456789ABCDEF" and last_data(2) = x"0123456789ABCDEF" report "wrong data at masters 0 and 2" severity error;
+
+  -- all masters, the response waits for the slowest and keeps the worst one
+  slave_resp(3 downto 2) <= "10";
+  axi_write(target("111", 16#40#), x"00000000DEADBEEF", resp);
+  assert resp = "10" report "SLVERR of master 1 not forwarded" severity error;
+  assert writes(0) = 2 and writes(1) = 1 and writes(2) = 2 report "broadcast did not reach all masters" severity error;
+  for k in 0 to N-1 loop
+    assert last_addr(k) = slot(k, 16#40#) report "wrong broadcast address at master " & integer'image(k) severity error;
+    assert last_data(k) = x"00000000DEADBEEF" report "wrong broadcast data at master " & integer'image(k) severity error;
+  end loop;
+  slave_resp <= (others => '0');
+
+  -- the worst response of a previous write does not stick
+  axi_write(target("010", 16#8#), x"0000000000000001", resp);
+  assert resp = "00" report "response of the previous write kept" severity error;
+  assert writes(1) = 2 and last_addr(1) = slot(1, 16#8#) report "single target write to master 1" severity error;
+
+  -- an empty mask is answered by the unit itself
+  axi_write(target("000", 16#8#), x"0000000000000002", resp);
+  assert resp = "10" report "empty mask not answered with SLVERR" severity error;
+  assert writes(0) = 2 and writes(1) = 2 and writes(2) = 2 report "empty mask reached a master" severity error;
+
+  -- reads are not supported
+  wait until falling_edge(clock);
+  s_arvalid <= '1';
+  loop
+    wait until rising_edge(clock);
+    exit when s_arready = '1';
+  end loop;
+  s_arvalid <= '0';
+  s_rready <= '1';
+  loop
+    wait until rising_edge(clock);
+    exit when s_rvalid = '1';
+  end loop;
+  assert s_rresp = "11" report "read not answered with DECERR" severity error;
+  s_rready <= '0';
+
+  report "tb_axi_lite_multicast finished" severity note;
+  wait;
+end process;
+
+clock_P: process
+begin
+clock <= '0';
+wait for 10 ns;
+clock <= '1';
+wait for 10 ns;
+end process;
+
+end behav;
@@ -0,0 +1,87 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <cstring>
+#include <thread>
+
+#include "aql_queue.h"
+
+bool aql_queue_init(aql_queue_t &queue, uint64_t size){
+	if(size == 0 || (size & (size-1)) != 0){
+		std::cerr << "ERROR: queue size " << size << " is not a power of two" << std::endl;
+		return false;
+	}
+	hsa_kernel_dispatch_packet_t invalid;
+	std::memset(&invalid, 0, sizeof(invalid));
+	invalid.header = HSA_PACKET_TYPE_INVALID;
+	queue.size = size;
+	queue.ring.assign(size, invalid);
+	queue.pasids.assign(size, 0);
+	queue.write_index.store(0);
+	queue.read_index.store(0);
+	queue.doorbell.store(0);
+	queue.doorbells.store(0);
+	return true;
+}
+
+uint64_t aql_reserve(aql_queue_t &queue, uint64_t count){
+	const uint64_t index = queue.write_index.fetch_add(count, std::memory_order_relaxed);
+	// the slots are free once the consumer has released their previous packets
+	while(index + count - queue.read_index.load(std::memory_order_acquire) > queue.size){
+		std::this_thread::yield();
+	}
+	return index;
+}
+
+bool aql_try_reserve(aql_queue_t &queue, uint64_t count, uint64_t &index){
+	uint64_t current = queue.write_index.load(std::memory_order_relaxed);
+	do{
+		if(current + count - queue.read_index.load(std::memory_order_acquire) > queue.size){
+			return false;
+		}
+	}while(!queue.write_index.compare_exchange_weak(current, current + count, std::memory_order_relaxed));
+	index = current;
+	return true;
+}
+
+void aql_publish(aql_queue_t &queue, uint64_t index, uint16_t header, uint16_t setup){
+	uint32_t *word = (uint32_t*)aql_slot(queue, index);
+	__atomic_store_n(word, ((uint32_t)setup << 16) | header, __ATOMIC_RELEASE);
+}
+
+void aql_ring_doorbell(aql_queue_t &queue, uint64_t index){
+	// the doorbell only moves forward, a late batch does not hide an earlier larger one
+	uint64_t current = queue.doorbell.load(std::memory_order_relaxed);
+	while(current < index+1 && !queue.doorbell.compare_exchange_weak(current, index+1, std::memory_order_release)){}
+	queue.doorbells.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool aql_consume(aql_queue_t &queue, hsa_kernel_dispatch_packet_t &packet, uint32_t &pasid){
+	const uint64_t index = queue.read_index.load(std::memory_order_relaxed);
+	hsa_kernel_dispatch_packet_t *slot = aql_slot(queue, index);
+	uint32_t *word = (uint32_t*)slot;
+	const uint32_t header = __atomic_load_n(word, __ATOMIC_ACQUIRE);
+	if((header & ((1 << HSA_PACKET_HEADER_WIDTH_TYPE)-1)) == HSA_PACKET_TYPE_INVALID){
+		return false;
+	}
+	packet = *slot;
+	pasid = queue.pasids[index & (queue.size-1)];
+
+	// the producers see the slot free only after it is invalid again
+	__atomic_store_n(word, (uint32_t)HSA_PACKET_TYPE_INVALID, __ATOMIC_RELAXED);
+	queue.read_index.store(index+1, std::memory_order_release);
+	return true;
+}
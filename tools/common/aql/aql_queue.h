@@ -0,0 +1,79 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef AQL_QUEUE_H_
+#define AQL_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "hsa_packets.h"
+
+// Host side model of the AQL queue of the packet processor for several
+// producer threads, the same protocol as aql_queue.h of the command processor
+// firmware but with atomics in place of disabled interrupts:
+//
+//   index = aql_reserve(queue, n);		fetch-add on the write index, then
+//						wait until the ring has space
+//   ... write the bodies of aql_slot(queue, index) ... index+n-1
+//   aql_publish(queue, index+i, header, setup)	release store of the first 32 bits
+//   aql_ring_doorbell(queue, index+n-1);	once per batch
+//
+// No producer takes a lock. The consumer stops at the first slot whose header
+// is still INVALID, so slots published out of order wait for their
+// predecessors.
+
+#define AQL_CACHE_LINE 64
+
+typedef struct aql_queue_s {
+	uint64_t size;					// slots, a power of two
+	std::vector<hsa_kernel_dispatch_packet_t> ring;
+	std::vector<uint32_t> pasids;
+	alignas(AQL_CACHE_LINE) std::atomic<uint64_t> write_index;
+	alignas(AQL_CACHE_LINE) std::atomic<uint64_t> read_index;
+	alignas(AQL_CACHE_LINE) std::atomic<uint64_t> doorbell;	// one more than the last index rung for
+	std::atomic<uint64_t> doorbells;		// number of times the doorbell was rung
+} aql_queue_t;
+
+// an empty queue of <size> slots, false if <size> is not a power of two
+bool aql_queue_init(aql_queue_t &queue, uint64_t size);
+
+static inline hsa_kernel_dispatch_packet_t *aql_slot(aql_queue_t &queue, uint64_t index){
+	return &queue.ring[index & (queue.size-1)];
+}
+
+// reserves <count> consecutive slots and waits until the consumer has
+// released them, returns the index of the first
+uint64_t aql_reserve(aql_queue_t &queue, uint64_t count);
+
+// reserves <count> slots only if they are free right away
+bool aql_try_reserve(aql_queue_t &queue, uint64_t count, uint64_t &index);
+
+static inline void aql_set_pasid(aql_queue_t &queue, uint64_t index, uint32_t pasid){
+	queue.pasids[index & (queue.size-1)] = pasid;
+}
+
+// hands the packet with <index> to the consumer, the rest of the slot has to be written before
+void aql_publish(aql_queue_t &queue, uint64_t index, uint16_t header, uint16_t setup);
+
+// wakes up the consumer for all packets up to <index>
+void aql_ring_doorbell(aql_queue_t &queue, uint64_t index);
+
+// Packet processor side, one consumer only: takes the next packet if it is
+// published and releases its slot. False if there is none.
+bool aql_consume(aql_queue_t &queue, hsa_kernel_dispatch_packet_t &packet, uint32_t &pasid);
+
+#endif
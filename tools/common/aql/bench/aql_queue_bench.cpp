@@ -0,0 +1,140 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aql_queue.h"
+
+#ifndef MAX_QUEUE_LENGTH
+#define MAX_QUEUE_LENGTH 128
+#endif
+
+// Feeds one queue from several producer threads, once lock-free and once
+// with a mutex around reservation and publication as a single producer queue
+// would need it. The consumer checks that every packet arrives exactly once
+// and in the order of its producer, e.g. aql_queue_bench 4 1000000 8 for
+// four producers with a million packets each in batches of eight.
+
+static uint16_t dispatch_header(){
+	return (HSA_PACKET_TYPE_KERNEL_DISPATCH << HSA_PACKET_HEADER_TYPE)
+	       | (HSA_FENCE_SCOPE_SYSTEM << HSA_PACKET_HEADER_SCACQUIRE_FENCE_SCOPE)
+	       | (HSA_FENCE_SCOPE_SYSTEM << HSA_PACKET_HEADER_SCRELEASE_FENCE_SCOPE);
+}
+
+// the body of packet <sequence> of <producer>
+static void write_body(hsa_kernel_dispatch_packet_t *packet, unsigned int producer, uint64_t sequence){
+	packet->workgroup_size_x = 1;
+	packet->workgroup_size_y = 1;
+	packet->workgroup_size_z = 1;
+	packet->grid_size_x = 1920;
+	packet->grid_size_y = 1080;
+	packet->grid_size_z = 1;
+	packet->kernel_object = producer;
+	packet->kernarg_address = (void*)sequence;
+	packet->completion_signal.handle = 0;
+}
+
+static void produce(aql_queue_t &queue, unsigned int producer, uint64_t packets, uint64_t batch, std::mutex *lock){
+	for(uint64_t sequence=0; sequence<packets; sequence+=batch){
+		const uint64_t count = (packets - sequence < batch) ? packets - sequence : batch;
+		if(lock != NULL){
+			lock->lock();
+		}
+		const uint64_t index = aql_reserve(queue, count);
+		for(uint64_t i=0; i<count; ++i){
+			write_body(aql_slot(queue, index+i), producer, sequence+i);
+			aql_set_pasid(queue, index+i, producer);
+			aql_publish(queue, index+i, dispatch_header(), 2);
+		}
+		aql_ring_doorbell(queue, index+count-1);
+		if(lock != NULL){
+			lock->unlock();
+		}
+	}
+}
+
+// takes <total> packets, false if one is lost, duplicated or out of order
+static bool consume(aql_queue_t &queue, unsigned int producers, uint64_t total){
+	std::vector<uint64_t> next(producers, 0);
+	bool ok = true;
+	hsa_kernel_dispatch_packet_t packet;
+	uint32_t pasid;
+	for(uint64_t taken=0; taken<total; ){
+		if(!aql_consume(queue, packet, pasid)){
+			std::this_thread::yield();
+			continue;
+		}
+		const uint64_t producer = packet.kernel_object;
+		const uint64_t sequence = (uint64_t)packet.kernarg_address;
+		if(producer >= producers || pasid != producer || sequence != next[producer] || packet.grid_size_x != 1920){
+			if(ok){
+				std::cerr << "ERROR: packet " << taken << " of producer " << producer << " has sequence " << sequence << std::endl;
+			}
+			ok = false;
+		}else{
+			++next[producer];
+		}
+		++taken;
+	}
+	return ok;
+}
+
+static bool run(const char *what, unsigned int producers, uint64_t packets, uint64_t batch, uint64_t size, bool locked){
+	aql_queue_t queue;
+	if(!aql_queue_init(queue, size)){
+		return false;
+	}
+	std::mutex lock;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for(unsigned int p=0; p<producers; ++p){
+		threads.push_back(std::thread(produce, std::ref(queue), p, packets, batch, locked ? &lock : NULL));
+	}
+	const bool ok = consume(queue, producers, producers*packets);
+	for(unsigned int p=0; p<producers; ++p){
+		threads[p].join();
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << std::left << std::setw(12) << what << std::right << std::fixed << std::setprecision(3)
+		  << std::setw(9) << seconds << " s" << std::setw(10) << std::setprecision(2) << producers*packets / seconds / 1e6
+		  << " Mpackets/s" << std::setw(10) << queue.doorbells.load() << " doorbells" << (ok ? "" : "  FAILED") << std::endl;
+	return ok;
+}
+
+int main(int argc, char *argv[]){
+	if(argc < 2 || argc > 5){
+		std::cout << "wrong usage: aql_queue_bench <producers> [<packets per producer>] [<batch>] [<queue size>]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	const unsigned int producers = std::stoul(argv[1]);
+	const uint64_t packets = (argc > 2) ? std::stoull(argv[2]) : 1000000;
+	const uint64_t batch = (argc > 3) ? std::stoull(argv[3]) : 8;
+	const uint64_t size = (argc > 4) ? std::stoull(argv[4]) : MAX_QUEUE_LENGTH;
+	if(producers == 0 || batch == 0 || batch > size){
+		std::cerr << "ERROR: at least one producer and a batch between 1 and the queue size needed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << producers << " producers, " << packets << " packets each, batches of " << batch << ", " << size << " slots" << std::endl;
+	bool ok = run("lock-free", producers, packets, batch, size, false);
+	ok = run("mutex", producers, packets, batch, size, true) && ok;
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,147 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+
+#include "elf_file.h"
+
+#define ELF_CLASS_32		1
+#define ELF_CLASS_64		2
+#define ELF_DATA_LSB		1
+#define ELF_DATA_MSB		2
+#define ELF_PT_LOAD		1
+
+// reads an unsigned field of <size> bytes at <offset> in the byte order of the file
+static uint64_t field(const std::vector<uint8_t> &file, uint64_t offset, unsigned int size, bool big_endian){
+	uint64_t value = 0;
+	for(unsigned int i=0; i<size; ++i){
+		const uint64_t byte = file[offset + i];
+		value |= big_endian ? byte << (8*(size-1-i)) : byte << (8*i);
+	}
+	return value;
+}
+
+bool elf_is_elf(const char *filename){
+	std::ifstream file(filename, std::ios::binary);
+	char magic[4] = {0, 0, 0, 0};
+	file.read(magic, 4);
+	return file.gcount() == 4 && magic[0] == 0x7F && magic[1] == 'E' && magic[2] == 'L' && magic[3] == 'F';
+}
+
+bool elf_read(const char *filename, elf_file_t &elf){
+	std::ifstream file(filename, std::ios::binary);
+	if(!file.is_open()){
+		std::cerr << "ERROR: could not open file " << filename << std::endl;
+		return false;
+	}
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	if(data.size() < 52 || data[0] != 0x7F || data[1] != 'E' || data[2] != 'L' || data[3] != 'F'){
+		std::cerr << "ERROR: " << filename << " is not an ELF file" << std::endl;
+		return false;
+	}
+	if((data[4] != ELF_CLASS_32 && data[4] != ELF_CLASS_64) || (data[5] != ELF_DATA_LSB && data[5] != ELF_DATA_MSB)){
+		std::cerr << "ERROR: " << filename << ": unknown ELF class or byte order" << std::endl;
+		return false;
+	}
+	elf.is_64 = data[4] == ELF_CLASS_64;
+	elf.big_endian = data[5] == ELF_DATA_MSB;
+	if(elf.is_64 && data.size() < 64){
+		std::cerr << "ERROR: " << filename << ": truncated ELF header" << std::endl;
+		return false;
+	}
+	const bool be = elf.big_endian;
+
+	// the header fields that differ between the classes
+	elf.machine = field(data, 18, 2, be);
+	uint64_t phoff, phentsize, phnum;
+	if(elf.is_64){
+		elf.entry = field(data, 24, 8, be);
+		phoff = field(data, 32, 8, be);
+		phentsize = field(data, 54, 2, be);
+		phnum = field(data, 56, 2, be);
+	}else{
+		elf.entry = field(data, 24, 4, be);
+		phoff = field(data, 28, 4, be);
+		phentsize = field(data, 42, 2, be);
+		phnum = field(data, 44, 2, be);
+	}
+	if(phentsize < (elf.is_64 ? 56u : 32u) || phoff > data.size() || phnum * phentsize > data.size() - phoff){
+		std::cerr << "ERROR: " << filename << ": program headers outside of the file" << std::endl;
+		return false;
+	}
+
+	elf.segments.clear();
+	for(uint64_t i=0; i<phnum; ++i){
+		const uint64_t ph = phoff + i*phentsize;
+		uint64_t type, flags, offset, paddr, filesz;
+		if(elf.is_64){
+			type = field(data, ph, 4, be);
+			flags = field(data, ph+4, 4, be);
+			offset = field(data, ph+8, 8, be);
+			paddr = field(data, ph+24, 8, be);
+			filesz = field(data, ph+32, 8, be);
+		}else{
+			type = field(data, ph, 4, be);
+			offset = field(data, ph+4, 4, be);
+			paddr = field(data, ph+12, 4, be);
+			filesz = field(data, ph+16, 4, be);
+			flags = field(data, ph+24, 4, be);
+		}
+		if(type != ELF_PT_LOAD || filesz == 0){
+			continue;
+		}
+		if(offset > data.size() || filesz > data.size() - offset || paddr + filesz < paddr){
+			std::cerr << "ERROR: " << filename << ": segment " << i << " outside of the file" << std::endl;
+			return false;
+		}
+		elf_segment_t segment;
+		segment.address = paddr;
+		segment.flags = flags;
+		segment.bytes.assign(data.begin() + offset, data.begin() + offset + filesz);
+		elf.segments.push_back(segment);
+	}
+	return true;
+}
+
+uint64_t elf_region(const elf_file_t &elf, uint64_t begin, uint64_t end, unsigned int word_bytes, mti_image_t &image){
+	image.word_digits = 2*word_bytes;
+	uint64_t found = 0;
+	for(unsigned int s=0; s<elf.segments.size(); ++s){
+		const elf_segment_t &segment = elf.segments[s];
+		const uint64_t lo = (segment.address > begin) ? segment.address : begin;
+		const uint64_t hi = (segment.address + segment.bytes.size() < end) ? segment.address + segment.bytes.size() : end;
+		if(lo >= hi){
+			continue;
+		}
+
+		// assemble the words covered by the segment, then merge them with
+		// words that neighbouring segments share
+		const uint64_t first = (lo - begin) / word_bytes;
+		std::vector<uint64_t> words((hi - 1 - begin) / word_bytes - first + 1, 0);
+		for(uint64_t a=lo; a<hi; ++a){
+			const uint64_t b = (a - begin) % word_bytes;
+			const uint64_t byte = segment.bytes[a - segment.address];
+			words[(a - begin) / word_bytes - first] |= byte << (8*(elf.big_endian ? word_bytes-1-b : b));
+		}
+		for(uint64_t w=0; w<words.size(); ++w){
+			mti_set(image, first + w, mti_word(image, first + w) | words[w]);
+		}
+		found += hi - lo;
+	}
+	return found;
+}
@@ -0,0 +1,64 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ELF_FILE_H_
+#define ELF_FILE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "mti.h"
+
+// Loadable contents of the firmware ELF files, read from the program
+// headers. ELF32 and ELF64 in either byte order are supported, fields are
+// decoded in the byte order of the file.
+
+// MIPS64 firmware (packet processor, fpga_cmd_processor), see generate_linker_script.sh
+#define ELF64_TEXT_ORIGIN	UINT64_C(0x0003000000000000)
+#define ELF64_DATA_ORIGIN	UINT64_C(0x0003000002000000)
+#define ELF64_DRAM_ORIGIN	UINT64_C(0x0001000000000000)
+
+// MIPS32 firmware (accel_cmd_processor, rom_accel_cmd_processor)
+#define ELF32_TEXT_ORIGIN	UINT64_C(0x00000000)
+#define ELF32_DATA_ORIGIN	UINT64_C(0x01000000)
+
+// the file backed part of a PT_LOAD segment
+typedef struct elf_segment_s {
+	uint64_t address;		// physical load address
+	uint32_t flags;			// PF_X = 1, PF_W = 2, PF_R = 4
+	std::vector<uint8_t> bytes;	// p_filesz bytes, .bss beyond them is not part of the image
+} elf_segment_t;
+
+typedef struct elf_file_s {
+	bool is_64;
+	bool big_endian;
+	uint16_t machine;
+	uint64_t entry;
+	std::vector<elf_segment_t> segments;
+} elf_file_t;
+
+// true if <filename> starts with the ELF magic
+bool elf_is_elf(const char *filename);
+
+// reads the PT_LOAD segments, reports errors on std::cerr and returns false on failure
+bool elf_read(const char *filename, elf_file_t &elf);
+
+// Collects the bytes loaded to [<begin>, <end>) into words of <word_bytes>
+// bytes, assembled in the byte order of the file, at word addresses
+// relative to <begin>. Words only partly loaded are completed with zeros.
+// Returns the number of bytes found.
+uint64_t elf_region(const elf_file_t &elf, uint64_t begin, uint64_t end, unsigned int word_bytes, mti_image_t &image);
+
+#endif
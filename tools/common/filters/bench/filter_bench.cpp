@@ -0,0 +1,265 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "filters.h"
+
+// First checks every instruction set against a plain per-pixel version of
+// the semantics in filters.h for all kernels, color models and border modes,
+// then reports the throughput of every instruction set and thread count on a
+// <width> x <height> image, e.g. filter_bench 1920 1080 4.
+
+#define CHECK_WIDTH 37
+#define CHECK_HEIGHT 23
+#define REPETITIONS 5
+
+static const uint64_t kernels[] = {
+	FILTER_SOBELX3x3, FILTER_SOBELY3x3, FILTER_SOBELXY3x3, FILTER_SOBELX5x5, FILTER_SOBELY5x5, FILTER_SOBELXY5x5,
+	FILTER_GAUSS3x3, FILTER_GAUSS5x5, FILTER_MIN3x3, FILTER_MIN5x5, FILTER_MAX3x3, FILTER_MAX5x5,
+	FILTER_MEDIAN3x3, FILTER_MEDIAN5x5, FILTER_CUSTOM3x3, FILTER_CUSTOM5x5
+};
+
+static const filter_isa_t isas[] = {FILTER_ISA_SCALAR, FILTER_ISA_SSE41, FILTER_ISA_AVX2};
+
+static int window_size(uint64_t kernel){
+	switch(kernel){
+		case FILTER_SOBELX3x3: case FILTER_SOBELY3x3: case FILTER_SOBELXY3x3: case FILTER_GAUSS3x3:
+		case FILTER_MIN3x3: case FILTER_MAX3x3: case FILTER_MEDIAN3x3: case FILTER_CUSTOM3x3:
+			return 3;
+		default:
+			return 5;
+	}
+}
+
+// the masks of hsa_fpga.h written out once more, 5x5 from the 3x3 ones where they are separable
+static void reference_masks(uint64_t kernel, std::vector<int64_t> &x, std::vector<int64_t> &y){
+	const int64_t s3[3] = {1, 2, 1}, d3[3] = {1, 0, -1};
+	const int64_t s5[5] = {1, 4, 6, 4, 1}, d5[5] = {1, 2, 0, -2, -1};
+	const int k = window_size(kernel);
+	const int64_t *s = (k == 3) ? s3 : s5;
+	const int64_t *d = (k == 3) ? d3 : d5;
+	x.assign(k*k, 0);
+	y.assign(k*k, 0);
+	for(int r=0; r<k; ++r){
+		for(int c=0; c<k; ++c){
+			x[r*k+c] = s[r]*d[c];
+			y[r*k+c] = d[r]*s[c];
+		}
+	}
+}
+
+static int64_t reference_pixel(const filter_params_t &params, uint32_t width, uint32_t height, const uint8_t *src,
+			       int64_t px, int64_t py, unsigned int channel){
+	const int k = window_size(params.kernel);
+	const int radius = k/2;
+	const unsigned int storage = filter_pixel_storage(params.colormodel);
+	const bool rgb = (params.colormodel != FILTER_UINT16_GRAY_SCALE);
+	const int64_t max_value = rgb ? 255 : 65535;
+	std::vector<int64_t> window;
+	for(int dy=-radius; dy<=radius; ++dy){
+		for(int dx=-radius; dx<=radius; ++dx){
+			int64_t x = px + dx, y = py + dy;
+			if(x < 0 || y < 0 || x >= width || y >= height){
+				if(params.borderhandling == FILTER_CLAMP_TO_ZERO){
+					window.push_back(0);
+					continue;
+				}
+				x = std::min<int64_t>(std::max<int64_t>(x, 0), width-1);
+				y = std::min<int64_t>(std::max<int64_t>(y, 0), height-1);
+			}
+			if(rgb){
+				window.push_back(src[storage*(y*width+x) + channel]);
+			}else{
+				window.push_back(src[2*(y*width+x)] | (src[2*(y*width+x)+1] << 8));
+			}
+		}
+	}
+	std::vector<int64_t> mx, my;
+	reference_masks(params.kernel, mx, my);
+	// gauss is the outer product of the smoothing vector
+	const int64_t s3[3] = {1, 2, 1}, s5[5] = {1, 4, 6, 4, 1};
+	int64_t sx = 0, sy = 0, sg = 0, sc = 0;
+	for(int i=0; i<k*k; ++i){
+		sx += mx[i]*window[i];
+		sy += my[i]*window[i];
+		sg += ((k == 3) ? s3[i/3]*s3[i%3] : s5[i/5]*s5[i%5]) * window[i];
+		sc += (int64_t)params.mask[i]*window[i];
+	}
+	std::sort(window.begin(), window.end());
+	// only the two-mask operation of the PE applies the threshold
+	int64_t r;
+	bool thresholded = false;
+	switch(params.kernel){
+		case FILTER_SOBELX3x3: case FILTER_SOBELX5x5: r = std::abs(sx); break;
+		case FILTER_SOBELY3x3: case FILTER_SOBELY5x5: r = std::abs(sy); break;
+		case FILTER_SOBELXY3x3: case FILTER_SOBELXY5x5: r = std::abs(sx) + std::abs(sy); thresholded = true; break;
+		case FILTER_CUSTOM3x3: case FILTER_CUSTOM5x5: r = std::abs(sc); thresholded = true; break;
+		case FILTER_GAUSS3x3: r = sg >> 4; break;
+		case FILTER_GAUSS5x5: r = sg >> 8; break;
+		case FILTER_MIN3x3: case FILTER_MIN5x5: r = window.front(); break;
+		case FILTER_MAX3x3: case FILTER_MAX5x5: r = window.back(); break;
+		default: r = window[window.size()/2]; break;
+	}
+	r = std::min(r, max_value);
+	if(thresholded && params.threshold != 0){
+		r = (r >= params.threshold) ? max_value : 0;
+	}
+	return r;
+}
+
+static void reference_run(const filter_params_t &params, uint32_t width, uint32_t height, const uint8_t *src, uint8_t *dst){
+	const unsigned int storage = filter_pixel_storage(params.colormodel);
+	for(uint32_t y=0; y<height; ++y){
+		for(uint32_t x=0; x<width; ++x){
+			if(params.colormodel != FILTER_UINT16_GRAY_SCALE){
+				for(unsigned int c=0; c<3; ++c){
+					dst[storage*(y*width+x) + c] = reference_pixel(params, width, height, src, x, y, c);
+				}
+				if(storage == 4){
+					dst[4*(y*width+x) + 3] = 0;
+				}
+			}else{
+				const int64_t r = reference_pixel(params, width, height, src, x, y, 0);
+				dst[2*(y*width+x)] = r & 0xff;
+				dst[2*(y*width+x)+1] = r >> 8;
+			}
+		}
+	}
+}
+
+static std::string describe(const filter_params_t &params){
+	return std::string(filter_kernel_name(params.kernel)) + " colormodel " + std::to_string(params.colormodel)
+		+ ((params.borderhandling == FILTER_CLAMP_TO_EDGE) ? " edge" : " zero") + " threshold " + std::to_string(params.threshold)
+		+ " normalization " + std::to_string(params.normalization);
+}
+
+// every kernel, color model and border mode, custom filters with small and large masks
+static bool check(std::mt19937 &random){
+	std::vector<uint8_t> src(CHECK_WIDTH*CHECK_HEIGHT*4), expected(src.size()), result(src.size());
+	unsigned int checks = 0, failures = 0;
+	for(uint64_t kernel : kernels){
+		for(uint8_t colormodel : {FILTER_UINT16_GRAY_SCALE, FILTER_UINT8_RGB, FILTER_UINT8_RGBX}){
+			for(uint8_t border : {FILTER_CLAMP_TO_ZERO, FILTER_CLAMP_TO_EDGE}){
+				for(int variant=0; variant<3; ++variant){
+					filter_params_t params;
+					std::memset(&params, 0, sizeof(params));
+					params.kernel = kernel;
+					params.colormodel = colormodel;
+					params.borderhandling = border;
+					params.threshold = (variant == 1) ? ((colormodel == FILTER_UINT16_GRAY_SCALE) ? 20000 : 100) : 0;
+					if(kernel == FILTER_CUSTOM3x3 || kernel == FILTER_CUSTOM5x5){
+						// small weights, then weights whose sums leave int32
+						const int32_t range = (variant == 2) ? 1 << 20 : 8;
+						for(int i=0; i<25; ++i){
+							params.mask[i] = (int32_t)(random() % (2*range+1)) - range;
+						}
+						// not applied, set to see that it stays so
+						params.normalization = (variant == 2) ? 40 : random() % 6;
+					}
+					for(uint8_t &byte : src){
+						byte = random();
+					}
+					const uint32_t width = CHECK_WIDTH - variant;
+					const uint32_t bytes = width*CHECK_HEIGHT*filter_pixel_storage(colormodel);
+					reference_run(params, width, CHECK_HEIGHT, src.data(), expected.data());
+					for(filter_isa_t isa : isas){
+						if(!filter_isa_supported(isa)){
+							continue;
+						}
+						for(unsigned int threads : {1u, 3u}){
+							std::fill(result.begin(), result.end(), 0);
+							++checks;
+							if(!filter_run(params, width, CHECK_HEIGHT, src.data(), result.data(), threads, isa)
+							   || std::memcmp(expected.data(), result.data(), bytes) != 0){
+								std::cerr << "ERROR: " << describe(params) << " differs with " << filter_isa_name(isa)
+									  << " and " << threads << " threads" << std::endl;
+								++failures;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	std::cout << checks << " checks, " << failures << " failed" << std::endl;
+	return failures == 0;
+}
+
+int main(int argc, char *argv[]){
+	if(argc > 4){
+		std::cout << "wrong usage: filter_bench [<width>] [<height>] [<max threads>]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	const uint32_t width = (argc > 1) ? std::stoul(argv[1]) : 1920;
+	const uint32_t height = (argc > 2) ? std::stoul(argv[2]) : 1080;
+	const unsigned int max_threads = (argc > 3) ? std::stoul(argv[3]) : 4;
+
+	std::mt19937 random(42);
+	if(!check(random)){
+		return EXIT_FAILURE;
+	}
+
+	std::vector<uint8_t> src((uint64_t)width*height*3), dst(src.size());
+	for(uint8_t &byte : src){
+		byte = random();
+	}
+	std::cout << width << "x" << height << " gray, Mpixel/s, best is " << filter_isa_name(filter_best_isa()) << std::endl;
+	std::cout << std::left << std::setw(18) << "kernel" << std::right;
+	for(filter_isa_t isa : isas){
+		if(filter_isa_supported(isa)){
+			for(unsigned int threads=1; threads<=max_threads; threads*=2){
+				std::cout << std::setw(10) << (std::string(filter_isa_name(isa)) + "/" + std::to_string(threads));
+			}
+		}
+	}
+	std::cout << std::endl;
+	for(uint64_t kernel : kernels){
+		filter_params_t params;
+		std::memset(&params, 0, sizeof(params));
+		params.kernel = kernel;
+		params.colormodel = FILTER_UINT16_GRAY_SCALE;
+		params.borderhandling = FILTER_CLAMP_TO_EDGE;
+		for(int i=0; i<25; ++i){
+			params.mask[i] = (i % 3) - 1;
+		}
+		std::cout << std::left << std::setw(18) << filter_kernel_name(kernel) << std::right << std::fixed << std::setprecision(1);
+		for(filter_isa_t isa : isas){
+			if(!filter_isa_supported(isa)){
+				continue;
+			}
+			for(unsigned int threads=1; threads<=max_threads; threads*=2){
+				double best = 0;
+				for(int r=0; r<REPETITIONS; ++r){
+					const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					filter_run(params, width, height, src.data(), dst.data(), threads, isa);
+					const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+					best = std::max(best, (double)width*height / seconds / 1e6);
+				}
+				std::cout << std::setw(10) << best;
+			}
+		}
+		std::cout << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
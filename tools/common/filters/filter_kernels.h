@@ -0,0 +1,159 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FILTER_KERNELS_H_
+#define FILTER_KERNELS_H_
+
+#include <cstdint>
+#include <vector>
+
+// Internal to the filter library. A filter is broken down into a job that
+// works on padded planes of int32 with one channel each; a row of a plane
+// holds two pixels of border on each side and a plane two rows above and
+// below the image.
+//
+// The kernels are templates over a vector type and are compiled once per
+// instruction set, filters_sse41.cpp and filters_avx2.cpp with their
+// compiler flags. Everything here has internal linkage so that the
+// instantiations of the translation units do not mix.
+
+#define FILTER_BORDER 2
+#define FILTER_MAX_TAPS 25
+
+typedef enum {
+	JOB_CONVOLVE,		// |sum| >> shift, PE operation 0
+	JOB_GRADIENT_XY,	// |sum0| + |sum1|, PE operation 1
+	JOB_MIN,
+	JOB_MAX,
+	JOB_MEDIAN
+} filter_job_op_t;
+
+typedef struct filter_tap_s {
+	int row;		// 0..4, row 2 is the row of the pixel
+	int dx;			// -2..2
+	int32_t weight;
+} filter_tap_t;
+
+typedef struct filter_comparator_s {
+	uint8_t low;
+	uint8_t high;
+} filter_comparator_t;
+
+typedef struct filter_job_s {
+	filter_job_op_t op;
+	std::vector<filter_tap_t> taps[2];		// non-zero weights of the masks, all window positions for min, max and median
+	std::vector<filter_comparator_t> network;	// median: compare-exchanges over the taps
+	unsigned int median;				// median: tap that holds the result after the network
+	int shift;
+	int32_t max_value;
+	int32_t threshold;				// 0 for none
+	bool wide;					// sums may leave int32, scalar only
+} filter_job_t;
+
+// computes <width> results of one row, rows[i] points to pixel 0 of plane row y+i-2
+typedef void (*filter_row_t)(const filter_job_t &job, const int32_t *const rows[5], uint32_t width, int32_t *out);
+
+void filter_row_scalar(const filter_job_t &job, const int32_t *const rows[5], uint32_t width, int32_t *out);
+void filter_row_sse41(const filter_job_t &job, const int32_t *const rows[5], uint32_t width, int32_t *out);
+void filter_row_avx2(const filter_job_t &job, const int32_t *const rows[5], uint32_t width, int32_t *out);
+
+namespace {
+
+// one lane of int64, no sum of a job leaves it
+struct scalar_vec {
+	typedef int64_t vec;
+	static const unsigned int N = 1;
+	static vec load(const int32_t *p){ return *p; }
+	static void store(int32_t *p, vec v){ *p = (int32_t)v; }
+	static vec set1(int64_t v){ return v; }
+	static vec add(vec a, vec b){ return a + b; }
+	static vec mul(vec a, vec b){ return a * b; }
+	static vec min(vec a, vec b){ return a < b ? a : b; }
+	static vec max(vec a, vec b){ return a > b ? a : b; }
+	static vec abs(vec a){ return a < 0 ? -a : a; }
+	static vec sra(vec a, int n){ return a >> n; }
+	// <hi> where a >= t, 0 elsewhere
+	static vec select_ge(vec a, vec t, vec hi){ return a >= t ? hi : 0; }
+};
+
+template<typename V>
+static inline typename V::vec convolve(const std::vector<filter_tap_t> &taps, const int32_t *const rows[5], uint32_t x){
+	typename V::vec sum = V::set1(0);
+	for(const filter_tap_t &tap : taps){
+		sum = V::add(sum, V::mul(V::load(rows[tap.row] + x + tap.dx), V::set1(tap.weight)));
+	}
+	return sum;
+}
+
+template<typename V>
+static inline typename V::vec median(const filter_job_t &job, const int32_t *const rows[5], uint32_t x){
+	typename V::vec window[FILTER_MAX_TAPS];
+	const unsigned int n = job.taps[0].size();
+	for(unsigned int i=0; i<n; ++i){
+		window[i] = V::load(rows[job.taps[0][i].row] + x + job.taps[0][i].dx);
+	}
+	for(const filter_comparator_t &c : job.network){
+		const typename V::vec low = V::min(window[c.low], window[c.high]);
+		window[c.high] = V::max(window[c.low], window[c.high]);
+		window[c.low] = low;
+	}
+	return window[job.median];
+}
+
+// results for pixels <x0> up to <x1>, x1-x0 a multiple of V::N
+template<typename V>
+static void filter_span(const filter_job_t &job, const int32_t *const rows[5], uint32_t x0, uint32_t x1, int32_t *out){
+	typedef typename V::vec vec;
+	const vec max_value = V::set1(job.max_value);
+	const vec threshold = V::set1(job.threshold);
+	for(uint32_t x=x0; x<x1; x+=V::N){
+		vec r;
+		switch(job.op){
+			case JOB_CONVOLVE:
+				r = V::min(V::sra(V::abs(convolve<V>(job.taps[0], rows, x)), job.shift), max_value);
+				break;
+			case JOB_GRADIENT_XY:
+				r = V::min(V::add(V::abs(convolve<V>(job.taps[0], rows, x)), V::abs(convolve<V>(job.taps[1], rows, x))), max_value);
+				break;
+			case JOB_MIN:
+			case JOB_MAX:{
+				r = V::load(rows[job.taps[0][0].row] + x + job.taps[0][0].dx);
+				for(unsigned int i=1; i<job.taps[0].size(); ++i){
+					const vec v = V::load(rows[job.taps[0][i].row] + x + job.taps[0][i].dx);
+					r = (job.op == JOB_MIN) ? V::min(r, v) : V::max(r, v);
+				}
+				break;}
+			default:
+				r = median<V>(job, rows, x);
+				break;
+		}
+		if(job.threshold != 0){
+			r = V::select_ge(r, threshold, max_value);
+		}
+		V::store(out + x, r);
+	}
+}
+
+// the vector kernel for whole vectors, the scalar one for the rest of the row
+template<typename V>
+static void filter_row_with(const filter_job_t &job, const int32_t *const rows[5], uint32_t width, int32_t *out){
+	const uint32_t split = job.wide ? 0 : width - width % V::N;
+	filter_span<V>(job, rows, 0, split, out);
+	filter_span<scalar_vec>(job, rows, split, width, out);
+}
+
+}
+
+#endif
@@ -0,0 +1,422 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <thread>
+
+#include "filters.h"
+#include "filter_kernels.h"
+
+// masks of hsa_fpga.h, row-major with the size of the window
+static const int32_t sobelX_3x3[9] = { 1, 0,-1,
+				       2, 0,-2,
+				       1, 0,-1};
+static const int32_t sobelY_3x3[9] = { 1, 2, 1,
+				       0, 0, 0,
+				      -1,-2,-1};
+static const int32_t sobelX_5x5[25] = { 1, 2, 0, -2,-1,
+					4, 8, 0, -8,-4,
+					6,12, 0,-12,-6,
+					4, 8, 0, -8,-4,
+					1, 2, 0, -2,-1};
+static const int32_t sobelY_5x5[25] = { 1, 4,  6, 4, 1,
+					2, 8, 12, 8, 2,
+					0, 0,  0, 0, 0,
+				       -2,-8,-12,-8,-2,
+				       -1,-4, -6,-4,-1};
+static const int32_t gauss_3x3[9] = { 1, 2, 1,
+				      2, 4, 2,
+				      1, 2, 1};
+static const int32_t gauss_5x5[25] = { 1, 4, 6, 4, 1,
+				       4,16,24,16, 4,
+				       6,24,36,24, 6,
+				       4,16,24,16, 4,
+				       1, 4, 6, 4, 1};
+#define GAUSS_3x3_NORMALIZATION 4
+#define GAUSS_5x5_NORMALIZATION 8
+
+// kernarg offsets, see process_aql_packets() and interrupt_transfer() of the packet processor
+#define KERNARG_COLORMODEL	16
+#define KERNARG_BORDER		17
+#define KERNARG_THRESHOLD	18
+#define KERNARG_NORMALIZATION	20
+#define KERNARG_MASK		24
+
+// rows of one thread at least, fewer rows are not worth a thread
+#define MIN_ROWS_PER_THREAD 16
+
+typedef struct kernel_info_s {
+	uint64_t kernel;
+	const char *name;
+	unsigned int size;
+} kernel_info_t;
+
+static const kernel_info_t kernel_infos[] = {
+	{FILTER_SOBELX3x3, "SOBELX3x3", 3},
+	{FILTER_SOBELY3x3, "SOBELY3x3", 3},
+	{FILTER_SOBELXY3x3, "SOBELXY3x3", 3},
+	{FILTER_SOBELX5x5, "SOBELX5x5", 5},
+	{FILTER_SOBELY5x5, "SOBELY5x5", 5},
+	{FILTER_SOBELXY5x5, "SOBELXY5x5", 5},
+	{FILTER_GAUSS3x3, "GAUSS3x3", 3},
+	{FILTER_GAUSS5x5, "GAUSS5x5", 5},
+	{FILTER_MIN3x3, "MIN_FILTER3x3", 3},
+	{FILTER_MIN5x5, "MIN_FILTER5x5", 5},
+	{FILTER_MAX3x3, "MAX_FILTER3x3", 3},
+	{FILTER_MAX5x5, "MAX_FILTER5x5", 5},
+	{FILTER_MEDIAN3x3, "MEDIAN_FILTER3x3", 3},
+	{FILTER_MEDIAN5x5, "MEDIAN_FILTER5x5", 5},
+	{FILTER_CUSTOM3x3, "CUSTOM_FILTER3x3", 3},
+	{FILTER_CUSTOM5x5, "CUSTOM_FILTER5x5", 5},
+};
+
+static const kernel_info_t *find_kernel(uint64_t kernel){
+	for(const kernel_info_t &info : kernel_infos){
+		if(info.kernel == kernel){
+			return &info;
+		}
+	}
+	return NULL;
+}
+
+const char *filter_kernel_name(uint64_t kernel){
+	const kernel_info_t *info = find_kernel(kernel);
+	return (info != NULL) ? info->name : NULL;
+}
+
+unsigned int filter_pixel_storage(uint8_t colormodel){
+	switch(colormodel){
+		case FILTER_UINT16_GRAY_SCALE: return 2;
+		case FILTER_UINT8_RGB: return 3;
+		case FILTER_UINT8_RGBX: return 4;
+		default: return 0;
+	}
+}
+
+bool filter_params_from_kernargs(uint64_t kernel, const void *kernargs, filter_params_t &params){
+	const kernel_info_t *info = find_kernel(kernel);
+	if(info == NULL){
+		return false;
+	}
+	const uint8_t *bytes = (const uint8_t*)kernargs;
+	std::memset(&params, 0, sizeof(params));
+	params.kernel = kernel;
+	params.colormodel = bytes[KERNARG_COLORMODEL];
+	params.borderhandling = bytes[KERNARG_BORDER];
+	std::memcpy(&params.threshold, bytes + KERNARG_THRESHOLD, sizeof(params.threshold));
+	if(kernel == FILTER_CUSTOM3x3 || kernel == FILTER_CUSTOM5x5){
+		std::memcpy(&params.normalization, bytes + KERNARG_NORMALIZATION, sizeof(params.normalization));
+		std::memcpy(params.mask, bytes + KERNARG_MASK, info->size*info->size*sizeof(int32_t));
+	}
+	return true;
+}
+
+// Batcher's odd-even merge sort of <n> (a power of two) values, reduced to
+// the compare-exchanges of the first <used> values that decide position
+// <target>. Values behind <used> stand for the largest possible value and
+// never move.
+static std::vector<filter_comparator_t> median_network(unsigned int n, unsigned int used, unsigned int target){
+	std::vector<filter_comparator_t> all;
+	for(unsigned int p=1; p<n; p<<=1){
+		for(unsigned int k=p; k>=1; k>>=1){
+			for(unsigned int j=k%p; j+k<n; j+=2*k){
+				for(unsigned int i=0; i<k && i+j+k<n; ++i){
+					if((i+j)/(2*p) == (i+j+k)/(2*p) && i+j+k < used){
+						all.push_back({(uint8_t)(i+j), (uint8_t)(i+j+k)});
+					}
+				}
+			}
+		}
+	}
+	std::vector<filter_comparator_t> network;
+	std::set<unsigned int> needed = {target};
+	for(std::vector<filter_comparator_t>::reverse_iterator it=all.rbegin(); it!=all.rend(); ++it){
+		if(needed.count(it->low) != 0 || needed.count(it->high) != 0){
+			needed.insert(it->low);
+			needed.insert(it->high);
+			network.push_back(*it);
+		}
+	}
+	std::reverse(network.begin(), network.end());
+	return network;
+}
+
+static void add_taps(std::vector<filter_tap_t> &taps, const int32_t *mask, unsigned int size, bool all){
+	const int radius = size/2;
+	for(unsigned int i=0; i<size*size; ++i){
+		if(all || mask[i] != 0){
+			taps.push_back({(int)(i/size) - radius + FILTER_BORDER, (int)(i%size) - radius, all ? 1 : mask[i]});
+		}
+	}
+}
+
+static int64_t weight_sum(const std::vector<filter_tap_t> &taps){
+	int64_t sum = 0;
+	for(const filter_tap_t &tap : taps){
+		sum += (tap.weight < 0) ? -(int64_t)tap.weight : tap.weight;
+	}
+	return sum;
+}
+
+static bool make_job(const filter_params_t &params, filter_job_t &job){
+	const kernel_info_t *info = find_kernel(params.kernel);
+	if(info == NULL){
+		std::cerr << "ERROR: unknown filter kernel " << params.kernel << std::endl;
+		return false;
+	}
+	if(filter_pixel_storage(params.colormodel) == 0){
+		std::cerr << "ERROR: unknown color model " << (unsigned int)params.colormodel << std::endl;
+		return false;
+	}
+	if(params.borderhandling != FILTER_CLAMP_TO_ZERO && params.borderhandling != FILTER_CLAMP_TO_EDGE){
+		std::cerr << "ERROR: unknown border handling " << (unsigned int)params.borderhandling << std::endl;
+		return false;
+	}
+	const unsigned int size = info->size;
+	job.taps[0].clear();
+	job.taps[1].clear();
+	job.network.clear();
+	job.median = 0;
+	job.shift = 0;
+	job.max_value = (params.colormodel == FILTER_UINT16_GRAY_SCALE) ? UINT16_MAX : UINT8_MAX;
+	job.threshold = 0;
+	switch(params.kernel){
+		case FILTER_SOBELX3x3: job.op = JOB_CONVOLVE; add_taps(job.taps[0], sobelX_3x3, size, false); break;
+		case FILTER_SOBELY3x3: job.op = JOB_CONVOLVE; add_taps(job.taps[0], sobelY_3x3, size, false); break;
+		case FILTER_SOBELX5x5: job.op = JOB_CONVOLVE; add_taps(job.taps[0], sobelX_5x5, size, false); break;
+		case FILTER_SOBELY5x5: job.op = JOB_CONVOLVE; add_taps(job.taps[0], sobelY_5x5, size, false); break;
+		case FILTER_SOBELXY3x3:
+			job.op = JOB_GRADIENT_XY;
+			add_taps(job.taps[0], sobelX_3x3, size, false);
+			add_taps(job.taps[1], sobelY_3x3, size, false);
+			break;
+		case FILTER_SOBELXY5x5:
+			job.op = JOB_GRADIENT_XY;
+			add_taps(job.taps[0], sobelX_5x5, size, false);
+			add_taps(job.taps[1], sobelY_5x5, size, false);
+			break;
+		case FILTER_GAUSS3x3: job.op = JOB_CONVOLVE; job.shift = GAUSS_3x3_NORMALIZATION; add_taps(job.taps[0], gauss_3x3, size, false); break;
+		case FILTER_GAUSS5x5: job.op = JOB_CONVOLVE; job.shift = GAUSS_5x5_NORMALIZATION; add_taps(job.taps[0], gauss_5x5, size, false); break;
+		case FILTER_CUSTOM3x3:
+		case FILTER_CUSTOM5x5:
+			// operation 1 with an empty second mask
+			job.op = JOB_GRADIENT_XY;
+			add_taps(job.taps[0], params.mask, size, false);
+			break;
+		case FILTER_MIN3x3: case FILTER_MIN5x5: job.op = JOB_MIN; add_taps(job.taps[0], NULL, size, true); break;
+		case FILTER_MAX3x3: case FILTER_MAX5x5: job.op = JOB_MAX; add_taps(job.taps[0], NULL, size, true); break;
+		default:
+			job.op = JOB_MEDIAN;
+			add_taps(job.taps[0], NULL, size, true);
+			job.median = size*size/2;
+			job.network = median_network((size == 3) ? 16 : 32, size*size, job.median);
+			break;
+	}
+	// the firmware only enables the threshold for operation 1
+	if(job.op == JOB_GRADIENT_XY){
+		job.threshold = params.threshold;
+	}
+	job.wide = (weight_sum(job.taps[0]) + weight_sum(job.taps[1])) * job.max_value > INT32_MAX;
+	return true;
+}
+
+const char *filter_deviation(const filter_params_t &params){
+	switch(params.kernel){
+		case FILTER_SOBELY5x5:
+			return "the rom_accel_cmd_processor firmware loads the SOBELX5x5 mask for SOBELY5x5";
+		case FILTER_CUSTOM3x3:
+			return "the packet processor writes the 3x3 mask to the first 9 coefficients, not to the middle "
+			       "of the 5x5 layout of the predefined 3x3 masks, and leaves mask1 of the previous dispatch";
+		case FILTER_CUSTOM5x5:
+			return "the packet processor leaves mask1 of the previous dispatch, 0 only if the core ran no SOBELXY before";
+		default:
+			return NULL;
+	}
+}
+
+bool filter_isa_supported(filter_isa_t isa){
+	switch(isa){
+		case FILTER_ISA_BEST:
+		case FILTER_ISA_SCALAR:
+			return true;
+#if defined(__x86_64__) || defined(__i386__)
+		case FILTER_ISA_SSE41:
+			return __builtin_cpu_supports("sse4.1");
+		case FILTER_ISA_AVX2:
+			return __builtin_cpu_supports("avx2");
+#endif
+		default:
+			return false;
+	}
+}
+
+filter_isa_t filter_best_isa(){
+	if(filter_isa_supported(FILTER_ISA_AVX2)){
+		return FILTER_ISA_AVX2;
+	}
+	if(filter_isa_supported(FILTER_ISA_SSE41)){
+		return FILTER_ISA_SSE41;
+	}
+	return FILTER_ISA_SCALAR;
+}
+
+const char *filter_isa_name(filter_isa_t isa){
+	switch(isa){
+		case FILTER_ISA_BEST: return "best";
+		case FILTER_ISA_SCALAR: return "scalar";
+		case FILTER_ISA_SSE41: return "sse4.1";
+		case FILTER_ISA_AVX2: return "avx2";
+		default: return "unknown";
+	}
+}
+
+void filter_row_scalar(const filter_job_t &job, const int32_t *const rows[5], uint32_t width, int32_t *out){
+	filter_row_with<scalar_vec>(job, rows, width, out);
+}
+
+typedef struct plane_s {
+	uint32_t stride;
+	std::vector<int32_t> data;
+} plane_t;
+
+static inline const int32_t *plane_row(const plane_t &plane, int64_t y){
+	return plane.data.data() + (y + FILTER_BORDER)*plane.stride + FILTER_BORDER;
+}
+
+// one padded plane per channel of rows <y0> up to <y1> of the padded image
+static void fill_planes(std::vector<plane_t> &planes, const filter_params_t &params, uint32_t width, uint32_t height,
+			const uint8_t *src, int64_t y0, int64_t y1){
+	const unsigned int channels = planes.size();
+	const unsigned int storage = filter_pixel_storage(params.colormodel);
+	const bool edge = (params.borderhandling == FILTER_CLAMP_TO_EDGE);
+	for(int64_t y=y0; y<y1; ++y){
+		const bool outside = (y < 0 || y >= (int64_t)height);
+		const int64_t sy = std::min<int64_t>(std::max<int64_t>(y, 0), height-1);
+		const uint8_t *line = src + sy*width*storage;
+		for(unsigned int c=0; c<channels; ++c){
+			int32_t *row = (int32_t*)plane_row(planes[c], y);
+			if(outside && !edge){
+				std::fill(row - FILTER_BORDER, row + width + FILTER_BORDER, 0);
+				continue;
+			}
+			if(storage == 2){
+				for(uint32_t x=0; x<width; ++x){
+					row[x] = line[2*x] | (line[2*x+1] << 8);
+				}
+			}else{
+				for(uint32_t x=0; x<width; ++x){
+					row[x] = line[storage*x+c];
+				}
+			}
+			for(int b=1; b<=FILTER_BORDER; ++b){
+				row[-b] = edge ? row[0] : 0;
+				row[width-1+b] = edge ? row[width-1] : 0;
+			}
+		}
+	}
+}
+
+static void filter_rows(filter_row_t kernel, const filter_job_t &job, const std::vector<plane_t> &planes, const filter_params_t &params,
+			uint32_t width, uint8_t *dst, uint32_t y0, uint32_t y1){
+	const unsigned int channels = planes.size();
+	const unsigned int storage = filter_pixel_storage(params.colormodel);
+	std::vector<int32_t> out(channels*width);
+	for(uint32_t y=y0; y<y1; ++y){
+		for(unsigned int c=0; c<channels; ++c){
+			const int32_t *rows[5];
+			for(int i=0; i<5; ++i){
+				rows[i] = plane_row(planes[c], (int64_t)y + i - FILTER_BORDER);
+			}
+			kernel(job, rows, width, out.data() + c*width);
+		}
+		uint8_t *line = dst + (uint64_t)y*width*storage;
+		if(storage == 2){
+			for(uint32_t x=0; x<width; ++x){
+				line[2*x] = out[x] & 0xff;
+				line[2*x+1] = out[x] >> 8;
+			}
+		}else if(storage == 3){
+			for(uint32_t x=0; x<width; ++x){
+				line[3*x] = out[x];
+				line[3*x+1] = out[width+x];
+				line[3*x+2] = out[2*width+x];
+			}
+		}else{
+			for(uint32_t x=0; x<width; ++x){
+				line[4*x] = out[x];
+				line[4*x+1] = out[width+x];
+				line[4*x+2] = out[2*width+x];
+				line[4*x+3] = 0;
+			}
+		}
+	}
+}
+
+bool filter_run(const filter_params_t &params, uint32_t width, uint32_t height, const uint8_t *src, uint8_t *dst,
+		unsigned int threads, filter_isa_t isa){
+	filter_job_t job;
+	if(!make_job(params, job)){
+		return false;
+	}
+	if(!filter_isa_supported(isa)){
+		std::cerr << "ERROR: the CPU does not support " << filter_isa_name(isa) << std::endl;
+		return false;
+	}
+	if(isa == FILTER_ISA_BEST){
+		isa = filter_best_isa();
+	}
+	const filter_row_t kernel = (isa == FILTER_ISA_AVX2) ? filter_row_avx2 : (isa == FILTER_ISA_SSE41) ? filter_row_sse41 : filter_row_scalar;
+	if(width == 0 || height == 0){
+		return true;
+	}
+
+	if(threads == 0){
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	threads = std::max(1u, std::min(threads, (height + MIN_ROWS_PER_THREAD-1) / MIN_ROWS_PER_THREAD));
+	const unsigned int channels = (params.colormodel == FILTER_UINT16_GRAY_SCALE) ? 1 : 3;
+	std::vector<plane_t> planes(channels);
+	for(plane_t &plane : planes){
+		plane.stride = width + 2*FILTER_BORDER;
+		plane.data.resize((uint64_t)plane.stride*(height + 2*FILTER_BORDER));
+	}
+
+	// each thread fills its rows of the planes, then filters them once all rows are there
+	std::vector<std::thread> workers;
+	const uint32_t band = (height + threads-1) / threads;
+	for(unsigned int t=0; t<threads; ++t){
+		const int64_t y0 = (int64_t)t*band - ((t == 0) ? FILTER_BORDER : 0);
+		const int64_t y1 = std::min<int64_t>((int64_t)(t+1)*band, height) + ((t == threads-1) ? FILTER_BORDER : 0);
+		workers.push_back(std::thread(fill_planes, std::ref(planes), std::cref(params), width, height, src, y0, y1));
+	}
+	for(std::thread &worker : workers){
+		worker.join();
+	}
+	workers.clear();
+	for(unsigned int t=0; t<threads; ++t){
+		const uint32_t y0 = t*band;
+		const uint32_t y1 = std::min<uint64_t>((uint64_t)(t+1)*band, height);
+		if(y0 < y1){
+			workers.push_back(std::thread(filter_rows, kernel, std::cref(job), std::cref(planes), std::cref(params), width, dst, y0, y1));
+		}
+	}
+	for(std::thread &worker : workers){
+		worker.join();
+	}
+	return true;
+}
@@ -0,0 +1,126 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FILTERS_H_
+#define FILTERS_H_
+
+#include <cstdint>
+
+// Host reference of the filters of the image accelerator, as validation
+// oracle for simulation output and as CPU fallback. Images are in the device
+// format: UINT16_GRAY_SCALE as little endian uint16, UINT8_RGB as three
+// bytes per pixel, UINT8_RGBX as four with the fourth byte 0 in results,
+// rows without padding.
+//
+// Semantics, per channel of a pixel and its k x k window (k = 3 or 5), as
+// write_task_config_to_pe() of the rom_accel_cmd_processor firmware sets up
+// the PE:
+//
+//   border	CLAMP_TO_ZERO reads 0 outside of the image, CLAMP_TO_EDGE
+//		the nearest pixel of the image
+//   operation 0	SOBELX/Y, GAUSS: |sum(mask*window)| >> normalization. The
+//		normalization is 4 and 8 for GAUSS 3x3 and 5x5 and 0 for
+//		SOBEL, the threshold is not applied.
+//   operation 1	SOBELXY, CUSTOM: |sum(mask0*window)| + |sum(mask1*window)|,
+//		then the threshold. CUSTOM takes the mask of the kernel
+//		arguments as mask0 and 0 as mask1, its normalization is not
+//		applied.
+//   MIN/MAX	smallest and largest value of the window (operations 3, 4)
+//   MEDIAN	middle value of the window (operation 2)
+//
+// Results are saturated to the channel range (0..65535 or 0..255). A
+// non-zero threshold turns the result into a binary image, the channel
+// maximum where it is >= threshold and 0 elsewhere. The masks are those of
+// hsa_fpga.h, custom masks come row-major from the kernel arguments. The PE
+// itself is not part of this tree, the arithmetic within an operation
+// follows the filters of hsa_fpga.h.
+//
+// Where the firmware configures the PE differently from the filter above,
+// filter_deviation() says how. Those results are not what the accelerator
+// computes: aql2mem -d -r and cycles_suite.sh report them as deviations and
+// the scheduler of the host runtime keeps such frames on the agent.
+
+// kernel objects, color models and border handling modes, see hsa_fpga.h
+#define FILTER_SOBELX3x3		0x01
+#define FILTER_SOBELY3x3		0x02
+#define FILTER_SOBELXY3x3		0x03
+#define FILTER_SOBELX5x5		0x04
+#define FILTER_SOBELY5x5		0x05
+#define FILTER_SOBELXY5x5		0x06
+#define FILTER_GAUSS3x3			0x11
+#define FILTER_GAUSS5x5			0x12
+#define FILTER_MIN3x3			0x21
+#define FILTER_MIN5x5			0x22
+#define FILTER_MAX3x3			0x23
+#define FILTER_MAX5x5			0x24
+#define FILTER_MEDIAN3x3		0x25
+#define FILTER_MEDIAN5x5		0x26
+#define FILTER_CUSTOM3x3		0x31
+#define FILTER_CUSTOM5x5		0x32
+
+#define FILTER_UINT16_GRAY_SCALE	0x0
+#define FILTER_UINT8_RGB		0x1
+#define FILTER_UINT8_RGBX		0x2
+#define FILTER_CLAMP_TO_ZERO		0x0
+#define FILTER_CLAMP_TO_EDGE		0x1
+
+typedef enum {
+	FILTER_ISA_BEST = 0,		// the widest the CPU supports
+	FILTER_ISA_SCALAR,
+	FILTER_ISA_SSE41,
+	FILTER_ISA_AVX2
+} filter_isa_t;
+
+typedef struct filter_params_s {
+	uint64_t kernel;
+	uint8_t colormodel;
+	uint8_t borderhandling;
+	uint16_t threshold;
+	uint16_t normalization;		// custom filters only, not applied
+	int32_t mask[25];		// custom filters only, 9 or 25 values
+} filter_params_t;
+
+// Reads the parameters from kernel arguments in the layout of the packet
+// processor: src(64) | dst(64) | colormodel(8) | borderhandling(8) |
+// threshold(16) and for custom filters normalization(16) | padding(16) |
+// mask(9 or 25 x 32). False for an unknown kernel.
+bool filter_params_from_kernargs(uint64_t kernel, const void *kernargs, filter_params_t &params);
+
+// bytes per pixel, 0 for an unknown color model
+unsigned int filter_pixel_storage(uint8_t colormodel);
+
+// name of a kernel object as in hsa_fpga.h, NULL if unknown
+const char *filter_kernel_name(uint64_t kernel);
+
+// how the accelerator differs from the filter of <params>, NULL where it
+// computes the same
+const char *filter_deviation(const filter_params_t &params);
+
+// whether this CPU runs the kernels of <isa>
+bool filter_isa_supported(filter_isa_t isa);
+
+// the instruction set FILTER_ISA_BEST stands for on this CPU
+filter_isa_t filter_best_isa();
+
+const char *filter_isa_name(filter_isa_t isa);
+
+// Filters the <width> x <height> image <src> into <dst>, which must not
+// overlap. Rows are split over <threads> threads, 0 takes one per core.
+// All instruction sets give the same result. False and a message on
+// std::cerr for unknown parameters or an instruction set the CPU lacks.
+bool filter_run(const filter_params_t &params, uint32_t width, uint32_t height, const uint8_t *src, uint8_t *dst,
+		unsigned int threads = 0, filter_isa_t isa = FILTER_ISA_BEST);
+
+#endif
@@ -0,0 +1,52 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "filter_kernels.h"
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+namespace {
+
+struct avx2_vec {
+	typedef __m256i vec;
+	static const unsigned int N = 8;
+	static vec load(const int32_t *p){ return _mm256_loadu_si256((const __m256i*)p); }
+	static void store(int32_t *p, vec v){ _mm256_storeu_si256((__m256i*)p, v); }
+	static vec set1(int64_t v){ return _mm256_set1_epi32((int32_t)v); }
+	static vec add(vec a, vec b){ return _mm256_add_epi32(a, b); }
+	static vec mul(vec a, vec b){ return _mm256_mullo_epi32(a, b); }
+	static vec min(vec a, vec b){ return _mm256_min_epi32(a, b); }
+	static vec max(vec a, vec b){ return _mm256_max_epi32(a, b); }
+	static vec abs(vec a){ return _mm256_abs_epi32(a); }
+	static vec sra(vec a, int n){ return _mm256_sra_epi32(a, _mm_cvtsi32_si128(n)); }
+	static vec select_ge(vec a, vec t, vec hi){ return _mm256_andnot_si256(_mm256_cmpgt_epi32(t, a), hi); }
+};
+
+}
+
+void filter_row_avx2(const filter_job_t &job, const int32_t *const rows[5], uint32_t width, int32_t *out){
+	filter_row_with<avx2_vec>(job, rows, width, out);
+}
+
+#else
+
+// built without AVX2, filter_run() does not select it
+void filter_row_avx2(const filter_job_t &job, const int32_t *const rows[5], uint32_t width, int32_t *out){
+	filter_row_with<scalar_vec>(job, rows, width, out);
+}
+
+#endif
@@ -0,0 +1,52 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "filter_kernels.h"
+
+#ifdef __SSE4_1__
+
+#include <smmintrin.h>
+
+namespace {
+
+struct sse41_vec {
+	typedef __m128i vec;
+	static const unsigned int N = 4;
+	static vec load(const int32_t *p){ return _mm_loadu_si128((const __m128i*)p); }
+	static void store(int32_t *p, vec v){ _mm_storeu_si128((__m128i*)p, v); }
+	static vec set1(int64_t v){ return _mm_set1_epi32((int32_t)v); }
+	static vec add(vec a, vec b){ return _mm_add_epi32(a, b); }
+	static vec mul(vec a, vec b){ return _mm_mullo_epi32(a, b); }
+	static vec min(vec a, vec b){ return _mm_min_epi32(a, b); }
+	static vec max(vec a, vec b){ return _mm_max_epi32(a, b); }
+	static vec abs(vec a){ return _mm_abs_epi32(a); }
+	static vec sra(vec a, int n){ return _mm_sra_epi32(a, _mm_cvtsi32_si128(n)); }
+	static vec select_ge(vec a, vec t, vec hi){ return _mm_andnot_si128(_mm_cmpgt_epi32(t, a), hi); }
+};
+
+}
+
+void filter_row_sse41(const filter_job_t &job, const int32_t *const rows[5], uint32_t width, int32_t *out){
+	filter_row_with<sse41_vec>(job, rows, width, out);
+}
+
+#else
+
+// built without SSE4.1, filter_run() does not select it
+void filter_row_sse41(const filter_job_t &job, const int32_t *const rows[5], uint32_t width, int32_t *out){
+	filter_row_with<scalar_vec>(job, rows, width, out);
+}
+
+#endif
@@ -0,0 +1,191 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "mti.h"
+
+// Writes and reads a DRAM image of the packet processor testbench with the
+// library and with the getline/stoull/ostream code the tools used before,
+// e.g. mti_bench 256 for an image of 256 MiB (about 750 MB of MTI text).
+
+static double seconds_since(std::chrono::steady_clock::time_point start){
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char *what, double seconds, uint64_t bytes){
+	std::cout << std::left << std::setw(28) << what << std::right << std::fixed << std::setprecision(3)
+		  << std::setw(9) << seconds << " s" << std::setw(10) << std::setprecision(1) << bytes / seconds / 1e6 << " MB/s" << std::endl;
+}
+
+static uint64_t file_size(const char *filename){
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	return file.is_open() ? (uint64_t)file.tellg() : 0;
+}
+
+static uint64_t image_checksum(const mti_image_t &image){
+	uint64_t sum = 0;
+	for(mti_runs_t::const_iterator it=image.runs.begin(); it!=image.runs.end(); ++it){
+		for(uint64_t i=0; i<it->second.size(); ++i){
+			sum = sum*31 + (it->first + i) + it->second[i];
+		}
+	}
+	return sum;
+}
+
+// the tokenizer and stream based parser the tools carried before
+static void legacy_tokenize(std::string line, std::vector<std::string> &vec, char separator){
+	unsigned int last = 0;
+	unsigned int length = 0;
+	for(unsigned int i=0; i<line.length(); ++i){
+		if(line[i]==separator){
+			vec.push_back(line.substr(last,length));
+			last = i+1;
+			length = 0;
+		}else{
+			++length;
+		}
+	}
+	if(line.length() >= 1 && line[line.length()-1]!=separator){
+		vec.push_back(line.substr(last,length));
+	}
+}
+
+static bool legacy_read(const char *filename, mti_image_t &image){
+	std::ifstream file(filename);
+	if(!file.is_open()){
+		return false;
+	}
+	std::string line = "";
+	while(std::getline(file,line)){
+		if(line.compare(0, 2, "//")==0){
+			continue;
+		}
+		std::vector<std::string> tokens;
+		legacy_tokenize(line, tokens, ' ');
+		if(tokens.empty()){
+			continue;
+		}
+		uint64_t index = std::stoull(tokens[0].substr(0, tokens[0].length()-1));
+		for(unsigned int t=1; t<tokens.size(); ++t){
+			mti_set(image, index++, std::stoull(tokens[t], NULL, 16));
+		}
+	}
+	return true;
+}
+
+static bool legacy_write(const char *filename, const mti_image_t &image){
+	std::ofstream file(filename);
+	if(!file.is_open()){
+		return false;
+	}
+	file << "// instance=" << image.instance << std::endl;
+	file << "// format=mti addressradix=d dataradix=h version=1.0 wordsperline=2" << std::endl;
+	for(mti_runs_t::const_iterator it=image.runs.begin(); it!=image.runs.end(); ++it){
+		for(uint64_t i=0; i<it->second.size(); i+=2){
+			file << std::dec << it->first + i << ": " << std::hex << std::setw(16) << std::setfill('0') << it->second[i];
+			if(i+1 < it->second.size()){
+				file << " " << std::setw(16) << std::setfill('0') << it->second[i+1];
+			}
+			file << std::endl;
+		}
+	}
+	return !file.fail();
+}
+
+int main(int argc, char *argv[]){
+	uint64_t mib = 256;
+	if(argc > 3 || (argc >= 2 && (!mti_parse_dec(argv[1], mib) || mib == 0))){
+		std::cout << "wrong usage: optional arguments are the image size in MiB (default 256) and the file to use (default bench.mem)" << std::endl;
+		return EXIT_FAILURE;
+	}
+	const char *filename = (argc == 3) ? argv[2] : "bench.mem";
+
+	// queue, arena and a gap like the images of aql2mem, filled with a xorshift sequence
+	mti_image_t image;
+	mti_init(image);
+	image.instance = "/tb_packet_processor_top/inst_dram/bram";
+	const uint64_t words = mib << 17;
+	uint64_t x = UINT64_C(0x9E3779B97F4A7C15);
+	std::vector<uint64_t> &queue = image.runs[0];
+	std::vector<uint64_t> &arena = image.runs[words/16];
+	queue.resize(words/32);
+	arena.resize(words - queue.size());
+	for(uint64_t i=0; i<queue.size(); ++i){
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		queue[i] = x;
+	}
+	for(uint64_t i=0; i<arena.size(); ++i){
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		arena[i] = x;
+	}
+	const uint64_t checksum = image_checksum(image);
+	std::cout << "image of " << mib << " MiB in " << image.runs.size() << " runs" << std::endl;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if(!legacy_write(filename, image)){
+		std::cerr << "ERROR: could not write file " << filename << std::endl;
+		return EXIT_FAILURE;
+	}
+	const double legacy_write_time = seconds_since(start);
+	const uint64_t bytes = file_size(filename);
+
+	start = std::chrono::steady_clock::now();
+	if(!mti_write(filename, MTI_FORMAT_MTI, image)){
+		return EXIT_FAILURE;
+	}
+	const double write_time = seconds_since(start);
+	if(file_size(filename) != bytes){
+		std::cerr << "ERROR: ostream and buffered writer disagree on the file size" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "MTI file of " << bytes / 1000000 << " MB" << std::endl;
+
+	image.runs.clear();
+	start = std::chrono::steady_clock::now();
+	mti_image_t legacy;
+	mti_init(legacy);
+	if(!legacy_read(filename, legacy)){
+		std::cerr << "ERROR: could not read file " << filename << std::endl;
+		return EXIT_FAILURE;
+	}
+	const double legacy_read_time = seconds_since(start);
+	const bool legacy_ok = image_checksum(legacy) == checksum;
+	legacy.runs.clear();
+
+	start = std::chrono::steady_clock::now();
+	if(!mti_read(filename, image)){
+		return EXIT_FAILURE;
+	}
+	const double read_time = seconds_since(start);
+	const bool ok = image_checksum(image) == checksum;
+	std::remove(filename);
+
+	report("write ostream", legacy_write_time, bytes);
+	report("write mti_write", write_time, bytes);
+	report("read getline/stoull", legacy_read_time, bytes);
+	report("read mti_read", read_time, bytes);
+	if(!ok || !legacy_ok){
+		std::cerr << "ERROR: image read back differs from the image written" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,541 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mti.h"
+
+// the buffer is handed to the file whenever it grows beyond this size
+#define MTI_WRITER_BUFFER_SIZE	(1 << 20)
+
+// value of a hex digit, 0xFF for any other character
+static unsigned char hex_value[256];
+static bool hex_value_ready = false;
+
+static void init_hex_value(){
+	if(hex_value_ready){
+		return;
+	}
+	memset(hex_value, 0xFF, sizeof(hex_value));
+	for(unsigned int c=0; c<10; ++c){
+		hex_value['0'+c] = c;
+	}
+	for(unsigned int c=0; c<6; ++c){
+		hex_value['a'+c] = 10+c;
+		hex_value['A'+c] = 10+c;
+	}
+	hex_value_ready = true;
+}
+
+void mti_init(mti_image_t &image){
+	image.instance = "";
+	image.words_per_line = 0;
+	image.word_digits = 0;
+	image.runs.clear();
+}
+
+bool mti_parse_hex(std::string_view s, uint64_t &value){
+	init_hex_value();
+	if(s.empty() || s.length() > 16){
+		return false;
+	}
+	uint64_t v = 0;
+	for(size_t i=0; i<s.length(); ++i){
+		const unsigned char digit = hex_value[(unsigned char)s[i]];
+		if(digit == 0xFF){
+			return false;
+		}
+		v = (v << 4) | digit;
+	}
+	value = v;
+	return true;
+}
+
+bool mti_parse_dec(std::string_view s, uint64_t &value){
+	if(s.empty()){
+		return false;
+	}
+	uint64_t v = 0;
+	for(size_t i=0; i<s.length(); ++i){
+		const unsigned int digit = (unsigned char)s[i] - '0';
+		if(digit > 9 || v > (UINT64_MAX - digit) / 10){
+			return false;
+		}
+		v = v*10 + digit;
+	}
+	value = v;
+	return true;
+}
+
+void mti_split(std::string_view line, char separator, std::vector<std::string_view> &items){
+	items.clear();
+	size_t begin = 0;
+	while(begin < line.length()){
+		size_t end = begin;
+		while(end < line.length() && line[end] != separator && line[end] != '\t'){
+			++end;
+		}
+		if(end > begin){
+			items.push_back(line.substr(begin, end-begin));
+		}
+		begin = end+1;
+	}
+}
+
+uint64_t mti_word(const mti_image_t &image, uint64_t address){
+	mti_runs_t::const_iterator it = image.runs.upper_bound(address);
+	if(it == image.runs.begin()){
+		return 0;
+	}
+	--it;
+	return (address - it->first < it->second.size()) ? it->second[address - it->first] : 0;
+}
+
+uint64_t mti_end(const mti_image_t &image){
+	if(image.runs.empty()){
+		return 0;
+	}
+	mti_runs_t::const_reverse_iterator last = image.runs.rbegin();
+	return last->first + last->second.size();
+}
+
+void mti_set(mti_image_t &image, uint64_t address, uint64_t value){
+	// files are mostly read in ascending order, so try the last run first
+	mti_runs_t::iterator it = image.runs.end();
+	if(!image.runs.empty()){
+		--it;
+		if(address < it->first){
+			it = image.runs.upper_bound(address);
+			if(it == image.runs.begin()){
+				it = image.runs.end();
+			}else{
+				--it;
+			}
+		}
+	}
+	if(it != image.runs.end() && address - it->first < it->second.size()){
+		it->second[address - it->first] = value;
+		return;
+	}
+	if(it == image.runs.end() || address != it->first + it->second.size()){
+		it = image.runs.insert(std::make_pair(address, std::vector<uint64_t>())).first;
+	}
+	it->second.push_back(value);
+
+	mti_runs_t::iterator next = it;
+	++next;
+	if(next != image.runs.end() && next->first == address+1){
+		it->second.insert(it->second.end(), next->second.begin(), next->second.end());
+		image.runs.erase(next);
+	}
+}
+
+// the mapping behind the reader is given back in steps of this size
+#define MTI_READER_RELEASE_SIZE	(UINT64_C(64) << 20)
+
+bool mti_reader_open(mti_reader_t &reader, const char *filename){
+	reader.filename = filename;
+	reader.data = NULL;
+	reader.length = 0;
+	reader.position = 0;
+	reader.released = 0;
+	reader.line_number = 0;
+	reader.address_radix = 10;
+	reader.address = 0;
+	reader.chunks = 0;
+	reader.chunk = 0;
+	reader.tokens.clear();
+	reader.token = 0;
+	reader.failed = false;
+	reader.instance = "";
+	reader.words_per_line = 0;
+	reader.word_digits = 0;
+	reader.file_digits = 0;
+
+	const int fd = open(filename, O_RDONLY);
+	if(fd < 0){
+		std::cerr << "ERROR: could not open file " << filename << std::endl;
+		return false;
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0){
+		std::cerr << "ERROR: could not stat file " << filename << std::endl;
+		close(fd);
+		return false;
+	}
+	reader.length = st.st_size;
+	if(reader.length != 0){
+		void *data = mmap(NULL, reader.length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(data == MAP_FAILED){
+			std::cerr << "ERROR: could not map file " << filename << std::endl;
+			close(fd);
+			return false;
+		}
+		madvise(data, reader.length, MADV_SEQUENTIAL);
+		reader.data = (const char *)data;
+	}
+	close(fd);
+	return true;
+}
+
+void mti_reader_close(mti_reader_t &reader){
+	if(reader.data != NULL){
+		munmap((void *)reader.data, reader.length);
+		reader.data = NULL;
+	}
+	reader.tokens.clear();
+}
+
+// value of <key>=... in an MTI header line, empty if the key is missing
+static std::string_view header_value(std::string_view line, std::string_view key){
+	size_t pos = 0;
+	while((pos = line.find(key, pos)) != std::string_view::npos){
+		if((pos == 0 || line[pos-1] == ' ' || line[pos-1] == '\t') && pos + key.length() < line.length() && line[pos + key.length()] == '='){
+			const size_t begin = pos + key.length() + 1;
+			size_t end = begin;
+			while(end < line.length() && line[end] != ' ' && line[end] != '\t'){
+				++end;
+			}
+			return line.substr(begin, end-begin);
+		}
+		pos += key.length();
+	}
+	return std::string_view();
+}
+
+static bool reader_error(mti_reader_t &reader, const char *what, std::string_view token){
+	std::cerr << "ERROR: " << reader.filename << ":" << reader.line_number << ": " << what << " " << token << std::endl;
+	reader.failed = true;
+	return false;
+}
+
+// splits the next line with words into reader.tokens, false at the end of the file
+static bool reader_line(mti_reader_t &reader){
+	while(reader.position < reader.length){
+		// hand the pages of the lines already parsed back to the kernel
+		if(reader.position - reader.released >= MTI_READER_RELEASE_SIZE){
+			const size_t page = sysconf(_SC_PAGESIZE);
+			const size_t end = (reader.position / page) * page;
+			madvise((void *)(reader.data + reader.released), end - reader.released, MADV_DONTNEED);
+			reader.released = end;
+		}
+
+		std::string_view text(reader.data + reader.position, reader.length - reader.position);
+		size_t eol = text.find('\n');
+		std::string_view line = text.substr(0, eol);
+		reader.position = (eol == std::string_view::npos) ? reader.length : reader.position + eol + 1;
+		++reader.line_number;
+		if(!line.empty() && line.back() == '\r'){
+			line.remove_suffix(1);
+		}
+
+		if(line.compare(0, 2, "//") == 0){
+			// comment or MTI header
+			std::string_view value = header_value(line, "instance");
+			if(!value.empty()){
+				reader.instance = std::string(value);
+			}
+			value = header_value(line, "addressradix");
+			if(!value.empty()){
+				reader.address_radix = (value == "h") ? 16 : 10;
+			}
+			value = header_value(line, "dataradix");
+			if(!value.empty() && value != "h"){
+				return reader_error(reader, "only hexadecimal data is supported, not dataradix", value);
+			}
+			value = header_value(line, "wordsperline");
+			uint64_t words_per_line = 0;
+			if(!value.empty() && mti_parse_dec(value, words_per_line)){
+				reader.words_per_line = words_per_line;
+			}
+			continue;
+		}
+
+		std::vector<std::string_view> &tokens = reader.tokens;
+		mti_split(line, ' ', tokens);
+		reader.token = 0;
+		if(!tokens.empty() && tokens[0][0] == '@'){
+			// $readmemh address
+			if(!mti_parse_hex(tokens[0].substr(1), reader.address)){
+				return reader_error(reader, "invalid address", tokens[0]);
+			}
+			reader.token = 1;
+		}else if(!tokens.empty() && tokens[0].back() == ':'){
+			std::string_view digits = tokens[0].substr(0, tokens[0].length()-1);
+			if(!((reader.address_radix == 16) ? mti_parse_hex(digits, reader.address) : mti_parse_dec(digits, reader.address))){
+				return reader_error(reader, "invalid address", tokens[0]);
+			}
+			reader.token = 1;
+		}
+		if(reader.token < tokens.size()){
+			return true;
+		}
+	}
+	return false;
+}
+
+bool mti_reader_next(mti_reader_t &reader, uint64_t &address, uint64_t &value){
+	if(reader.failed){
+		return false;
+	}
+	if(reader.token >= reader.tokens.size() && !reader_line(reader)){
+		return false;
+	}
+
+	// the first word fixes the width, wider words are returned as <chunks>
+	// 64 bit words, the least significant one first
+	const std::string_view token = reader.tokens[reader.token];
+	if(reader.chunks == 0){
+		reader.chunks = (token.length() + 15) / 16;
+		reader.word_digits = (token.length() > 16) ? 16 : token.length();
+		reader.file_digits = token.length();
+	}
+	if(token.length() > reader.chunks*16){
+		return reader_error(reader, "invalid data", token);
+	}
+	const size_t skip = 16*reader.chunk;
+	value = 0;
+	if(token.length() > skip){
+		const size_t end = token.length() - skip;
+		const size_t begin = (end > 16) ? end-16 : 0;
+		if(!mti_parse_hex(token.substr(begin, end-begin), value)){
+			return reader_error(reader, "invalid data", token);
+		}
+	}
+	address = reader.address*reader.chunks + reader.chunk;
+
+	if(++reader.chunk == reader.chunks){
+		reader.chunk = 0;
+		++reader.token;
+		++reader.address;
+	}
+	return true;
+}
+
+bool mti_read(const char *filename, mti_image_t &image){
+	mti_init(image);
+	mti_reader_t reader;
+	if(!mti_reader_open(reader, filename)){
+		return false;
+	}
+	uint64_t address = 0;
+	uint64_t value = 0;
+	while(mti_reader_next(reader, address, value)){
+		mti_set(image, address, value);
+	}
+	image.instance = reader.instance;
+	image.words_per_line = reader.words_per_line;
+	image.word_digits = reader.word_digits;
+	mti_reader_close(reader);
+	return !reader.failed;
+}
+
+bool mti_parse_format(std::string_view s, mti_format_t &format){
+	if(s == "mti"){
+		format = MTI_FORMAT_MTI;
+	}else if(s == "bin"){
+		format = MTI_FORMAT_BINARY;
+	}else if(s == "sparse"){
+		format = MTI_FORMAT_SPARSE;
+	}else if(s == "readmemh"){
+		format = MTI_FORMAT_READMEMH;
+	}else{
+		return false;
+	}
+	return true;
+}
+
+bool mti_writer_open(mti_writer_t &writer, const char *filename, bool binary){
+	writer.file.open(filename, binary ? std::ios::out | std::ios::binary : std::ios::out);
+	if(!writer.file.is_open()){
+		std::cerr << "ERROR: could not open file " << filename << std::endl;
+		return false;
+	}
+	writer.buffer.clear();
+	writer.buffer.reserve(MTI_WRITER_BUFFER_SIZE + 256);
+	return true;
+}
+
+static void writer_flush(mti_writer_t &writer){
+	writer.file.write(writer.buffer.data(), writer.buffer.size());
+	writer.buffer.clear();
+}
+
+static inline void writer_check(mti_writer_t &writer){
+	if(writer.buffer.size() >= MTI_WRITER_BUFFER_SIZE){
+		writer_flush(writer);
+	}
+}
+
+void mti_writer_text(mti_writer_t &writer, std::string_view text){
+	writer.buffer.append(text.data(), text.length());
+	writer_check(writer);
+}
+
+void mti_writer_dec(mti_writer_t &writer, uint64_t value){
+	char digits[20];
+	unsigned int count = 0;
+	do{
+		digits[count++] = '0' + value % 10;
+		value /= 10;
+	}while(value != 0);
+	while(count != 0){
+		writer.buffer.push_back(digits[--count]);
+	}
+	writer_check(writer);
+}
+
+void mti_writer_hex(mti_writer_t &writer, uint64_t value, unsigned int digits){
+	static const char hex[] = "0123456789abcdef";
+	if(digits == 0){
+		digits = 1;
+		for(uint64_t rest=value >> 4; rest!=0; rest >>= 4){
+			++digits;
+		}
+	}
+	for(unsigned int i=digits; i>0; --i){
+		writer.buffer.push_back((4*(i-1) < 64) ? hex[(value >> (4*(i-1))) & 0xF] : '0');
+	}
+	writer_check(writer);
+}
+
+void mti_writer_repeat(mti_writer_t &writer, std::string_view text, uint64_t count){
+	if(text.empty() || count == 0){
+		return;
+	}
+	if(count * text.length() < MTI_WRITER_BUFFER_SIZE){
+		for(uint64_t i=0; i<count; ++i){
+			writer.buffer.append(text.data(), text.length());
+		}
+		writer_check(writer);
+		return;
+	}
+	// fill the empty buffer with as many copies as fit and write it repeatedly
+	writer_flush(writer);
+	const uint64_t copies = (MTI_WRITER_BUFFER_SIZE > text.length()) ? MTI_WRITER_BUFFER_SIZE / text.length() : 1;
+	for(uint64_t i=0; i<copies; ++i){
+		writer.buffer.append(text.data(), text.length());
+	}
+	for(uint64_t blocks=count/copies; blocks>0; --blocks){
+		writer.file.write(writer.buffer.data(), writer.buffer.size());
+	}
+	writer.buffer.resize((count % copies) * text.length());
+	writer_check(writer);
+}
+
+void mti_writer_le64(mti_writer_t &writer, uint64_t value){
+	for(unsigned int b=0; b<8; ++b){
+		writer.buffer.push_back((char)(value >> (8*b)));
+	}
+	writer_check(writer);
+}
+
+bool mti_writer_close(mti_writer_t &writer){
+	writer_flush(writer);
+	writer.file.close();
+	return !writer.file.fail();
+}
+
+bool mti_write(const char *filename, mti_format_t format, const mti_image_t &image){
+	const unsigned int digits = (image.word_digits != 0) ? image.word_digits : 16;
+	const unsigned int words_per_line = (image.words_per_line != 0) ? image.words_per_line : 2;
+
+	// bytes of a word in the binary format
+	const unsigned int bytes = (digits + 1) / 2;
+	const std::string zero(bytes, '\0');
+
+	mti_writer_t writer;
+	if(!mti_writer_open(writer, filename, format == MTI_FORMAT_BINARY || format == MTI_FORMAT_SPARSE)){
+		return false;
+	}
+
+	if(format == MTI_FORMAT_MTI){
+		// header for modelsim
+		mti_writer_text(writer, "// instance=");
+		mti_writer_text(writer, image.instance);
+		mti_writer_text(writer, "\n// format=mti addressradix=d dataradix=h version=1.0 wordsperline=");
+		mti_writer_dec(writer, words_per_line);
+		mti_writer_text(writer, "\n");
+	}else if(format == MTI_FORMAT_READMEMH){
+		mti_writer_text(writer, "// ");
+		mti_writer_text(writer, image.instance);
+		mti_writer_text(writer, ", one ");
+		mti_writer_dec(writer, 4*digits);
+		mti_writer_text(writer, " bit word per line\n");
+	}else if(format == MTI_FORMAT_SPARSE){
+		mti_writer_text(writer, "AQLSPRS1");
+	}
+
+	uint64_t next = 0;
+	for(mti_runs_t::const_iterator it=image.runs.begin(); it!=image.runs.end(); ++it){
+		const uint64_t first = it->first;
+		const std::vector<uint64_t> &words = it->second;
+		switch(format){
+			case MTI_FORMAT_MTI:
+				for(uint64_t i=0; i<words.size(); i+=words_per_line){
+					mti_writer_dec(writer, first+i);
+					mti_writer_text(writer, ":");
+					for(uint64_t w=i; w<i+words_per_line && w<words.size(); ++w){
+						mti_writer_text(writer, " ");
+						mti_writer_hex(writer, words[w], digits);
+					}
+					mti_writer_text(writer, "\n");
+				}
+				break;
+			case MTI_FORMAT_READMEMH:
+				mti_writer_text(writer, "@");
+				mti_writer_hex(writer, first, 0);
+				mti_writer_text(writer, "\n");
+				for(uint64_t i=0; i<words.size(); ++i){
+					mti_writer_hex(writer, words[i], digits);
+					mti_writer_text(writer, "\n");
+				}
+				break;
+			case MTI_FORMAT_BINARY:
+				if(first < next){
+					std::cerr << "ERROR: overlapping memory runs at word " << first << std::endl;
+					return false;
+				}
+				mti_writer_repeat(writer, zero, first - next);
+				for(uint64_t i=0; i<words.size(); ++i){
+					for(unsigned int b=0; b<bytes; ++b){
+						writer.buffer.push_back((char)(words[i] >> (8*b)));
+					}
+					writer_check(writer);
+				}
+				next = first + words.size();
+				break;
+			case MTI_FORMAT_SPARSE:
+				mti_writer_le64(writer, first);
+				mti_writer_le64(writer, words.size());
+				for(uint64_t i=0; i<words.size(); ++i){
+					mti_writer_le64(writer, words[i]);
+				}
+				break;
+		}
+	}
+
+	if(!mti_writer_close(writer)){
+		std::cerr << "ERROR: could not write file " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
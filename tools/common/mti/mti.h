@@ -0,0 +1,138 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MTI_H_
+#define MTI_H_
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Memory files of the host tools: ModelSim "mem load"/"mem save" files
+// (format=mti), Verilog $readmemh files and plain hex lines as written by
+// mti2hex, plus the binary formats of aql2mem.
+//
+// A memory image is kept as runs of consecutive words keyed by the address
+// of their first word, so sparse images like the DRAM of the packet
+// processor testbench cost memory only for the words they contain.
+
+// runs of consecutive words, keyed by the address of the first word
+typedef std::map<uint64_t, std::vector<uint64_t> > mti_runs_t;
+
+typedef struct mti_image_s {
+	std::string instance;		// instance= of the MTI header, may be empty
+	unsigned int words_per_line;	// wordsperline= of the MTI header, 0 if unknown
+	unsigned int word_digits;	// hex digits per word, 0 if unknown
+	mti_runs_t runs;
+} mti_image_t;
+
+void mti_init(mti_image_t &image);
+
+// Parses <filename> through a read only mapping of the whole file. Lines are
+// "<address>: <word> ...", "@<hex address>" followed by words, or words that
+// continue at the next address; "//" lines are comments or the MTI header.
+// Words wider than 64 bit are split into 64 bit words, least significant
+// first, and the addresses scaled accordingly. Reports errors on std::cerr
+// and returns false on failure.
+bool mti_read(const char *filename, mti_image_t &image);
+
+// Streaming access to the same files: the words are returned in file order
+// without being stored, and the parts of the mapping already parsed are
+// handed back to the kernel, so memory use does not grow with the file.
+typedef struct mti_reader_s {
+	std::string filename;
+	const char *data;		// read only mapping of the file, NULL if empty
+	size_t length;
+	size_t position;		// start of the next line
+	size_t released;		// the mapping before this offset was released
+	uint64_t line_number;
+	unsigned int address_radix;
+	uint64_t address;		// next word, in words of the file
+	uint64_t chunks;		// 64 bit words per word of the file, 0 before the first word
+	uint64_t chunk;			// next 64 bit word of the current word
+	std::vector<std::string_view> tokens;
+	size_t token;			// next token of the current line
+	bool failed;
+	// header of the file, the widths are known after the first word
+	std::string instance;
+	unsigned int words_per_line;
+	unsigned int word_digits;	// hex digits of the returned words, at most 16
+	unsigned int file_digits;	// hex digits of the words of the file
+} mti_reader_t;
+
+bool mti_reader_open(mti_reader_t &reader, const char *filename);
+// next word and its address, false at the end of the file or if reading
+// failed, which is reported on std::cerr and sets reader.failed
+bool mti_reader_next(mti_reader_t &reader, uint64_t &address, uint64_t &value);
+void mti_reader_close(mti_reader_t &reader);
+
+// word at <address>, 0 if the image does not contain it
+uint64_t mti_word(const mti_image_t &image, uint64_t address);
+
+// one past the highest address of the image
+uint64_t mti_end(const mti_image_t &image);
+
+// stores <value> at <address>, runs that become adjacent are merged
+void mti_set(mti_image_t &image, uint64_t address, uint64_t value);
+
+// splits <line> at <separator> and tabs, empty items are dropped
+void mti_split(std::string_view line, char separator, std::vector<std::string_view> &items);
+
+// parse a complete string of hexadecimal or decimal digits, false on
+// an empty string, a stray character or an overflow of 64 bit
+bool mti_parse_hex(std::string_view s, uint64_t &value);
+bool mti_parse_dec(std::string_view s, uint64_t &value);
+
+// output formats of mti_write()
+typedef enum {
+	MTI_FORMAT_MTI,			// ModelSim mem load, wordsperline words per line
+	MTI_FORMAT_BINARY,		// raw little endian words from address 0 on, gaps filled with zeros
+	MTI_FORMAT_SPARSE,		// binary records, see mti_write()
+	MTI_FORMAT_READMEMH		// Verilog $readmemh, one word per line
+} mti_format_t;
+
+// parses mti, bin, sparse or readmemh
+bool mti_parse_format(std::string_view s, mti_format_t &format);
+
+// Collects output in a large buffer and hands it to the file in one piece,
+// numbers are formatted by hand instead of with stream manipulators.
+typedef struct mti_writer_s {
+	std::ofstream file;
+	std::string buffer;
+} mti_writer_t;
+
+bool mti_writer_open(mti_writer_t &writer, const char *filename, bool binary);
+void mti_writer_text(mti_writer_t &writer, std::string_view text);
+void mti_writer_dec(mti_writer_t &writer, uint64_t value);
+// <digits> hexadecimal digits with leading zeros, 0 for as many as needed
+void mti_writer_hex(mti_writer_t &writer, uint64_t value, unsigned int digits);
+// <count> copies of <text>, long repetitions are written from one block
+void mti_writer_repeat(mti_writer_t &writer, std::string_view text, uint64_t count);
+// <value> as 8 little endian bytes
+void mti_writer_le64(mti_writer_t &writer, uint64_t value);
+// flushes the buffer, returns false if the file could not be written
+bool mti_writer_close(mti_writer_t &writer);
+
+// Writes <image> in <format>. Words have word_digits hex digits (16 if
+// unknown), in the binary format word_digits/2 bytes, MTI files have
+// wordsperline words per line (2 if unknown).
+// The sparse format is the magic "AQLSPRS1" followed by one record per run:
+// first address and number of words as little endian uint64, then the words.
+bool mti_write(const char *filename, mti_format_t format, const mti_image_t &image);
+
+#endif
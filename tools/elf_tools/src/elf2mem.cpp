@@ -0,0 +1,212 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <cctype>
+#include <string>
+#include <vector>
+
+#include "mti.h"
+#include "elf_file.h"
+
+// Writes the memory images of a firmware ELF file for the testbenches,
+// replacing the readelf/gawk pipeline of scripts/elf2mem.sh:
+//   instr.mem      text, 32 bit words, four per line
+//   data.mem       data, 64 bit words two per line (ELF64) or 32 bit words four per line (ELF32)
+//   dram_text.mem  .dram_text of the packet processor (ELF64), only if present
+// The words are assembled from the program headers in the byte order of
+// the file. Besides MTI, raw little endian binaries and C arrays of 64 bit
+// words (segments.h, formatted as the code_segments.h of vsim2cmd) can be
+// written. Each array starts at the first loaded word of its region, the
+// <ARRAY>_OFFSET define holds its byte offset from the region origin.
+
+#define TB_INSTANCE "/tb_packet_processor_top/"
+
+typedef struct region_s {
+	const char *name;		// output file name without extension
+	const char *array;		// name of the C array
+	const char *instance;		// memory of the testbench
+	uint64_t origin;
+	unsigned int word_bytes;
+	unsigned int words_per_line;
+	bool optional;			// no files if nothing is loaded into it
+	mti_image_t image;
+} region_t;
+
+static void usage(){
+	std::cout << "wrong usage: elf2mem <elf file> [<output directory>] [-o mti,bin,c] [-t <text origin>] [-d <data origin>] [-r <dram origin>]" << std::endl;
+	std::cout << "origins are hexadecimal, the defaults follow the linker scripts of the MIPS64 and MIPS32 firmware" << std::endl;
+}
+
+static bool parse_origin(std::string s, uint64_t &origin){
+	if(s.compare(0, 2, "0x") == 0 || s.compare(0, 2, "0X") == 0){
+		s.erase(0, 2);
+	}
+	return mti_parse_hex(s, origin);
+}
+
+// 64 bit word <index> of the region, 32 bit regions hold the lower half at the even address
+static uint64_t region_word(const region_t &region, uint64_t index){
+	if(region.word_bytes == 4){
+		return (mti_word(region.image, 2*index+1) << 32) | (mti_word(region.image, 2*index) & 0xFFFFFFFF);
+	}
+	return mti_word(region.image, index);
+}
+
+static bool write_arrays(const std::string &filename, const std::vector<region_t> &regions){
+	mti_writer_t outfile;
+	if(!mti_writer_open(outfile, filename.c_str(), false)){
+		return false;
+	}
+	mti_writer_text(outfile, "// this file is machine generated by elf2mem, do not edit below!!!\n");
+	mti_writer_text(outfile, "#ifndef SEGMENTS_H_\n");
+	mti_writer_text(outfile, "#define SEGMENTS_H_\n\n");
+	mti_writer_text(outfile, "#include <stdint.h>\n\n");
+	for(unsigned int r=0; r<regions.size(); ++r){
+		const region_t &region = regions[r];
+		if(region.image.runs.empty()){
+			continue;
+		}
+		// the array starts at the first loaded 64 bit word of the region
+		const uint64_t first = (region.image.runs.begin()->first * region.word_bytes) / 8;
+		const uint64_t length = (mti_end(region.image)*region.word_bytes + 7) / 8 - first;
+		std::string macro(region.array);
+		for(unsigned int c=0; c<macro.length(); ++c){
+			macro[c] = toupper(macro[c]);
+		}
+		mti_writer_text(outfile, "// bytes from the origin of the memory to the first word\n");
+		mti_writer_text(outfile, "#define " + macro + "_OFFSET 0x");
+		mti_writer_hex(outfile, first*8, 0);
+		mti_writer_text(outfile, "\n");
+		mti_writer_text(outfile, "uint64_t ");
+		mti_writer_text(outfile, region.array);
+		mti_writer_text(outfile, "[");
+		mti_writer_dec(outfile, length);
+		mti_writer_text(outfile, "] = {\n    ");
+		for(uint64_t index=0; index<length; ++index){
+			mti_writer_text(outfile, "0x");
+			mti_writer_hex(outfile, region_word(region, first+index), 16);
+			if(index != length-1){
+				mti_writer_text(outfile, ", ");
+			}
+			if((index&1) == 1){
+				mti_writer_text(outfile, "\n    ");
+			}
+		}
+		mti_writer_text(outfile, "};\n\n");
+	}
+	mti_writer_text(outfile, "#endif\n");
+	if(!mti_writer_close(outfile)){
+		std::cerr << "ERROR: could not write file " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char *argv[]){
+
+	if(argc < 2){
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	elf_file_t elf;
+	if(!elf_read(argv[1], elf)){
+		return EXIT_FAILURE;
+	}
+
+	std::vector<region_t> regions(elf.is_64 ? 3 : 2);
+	regions[0] = {"instr", "text_segment", TB_INSTANCE "inst_write_instr/bram", elf.is_64 ? ELF64_TEXT_ORIGIN : ELF32_TEXT_ORIGIN, 4, 4, false, mti_image_t()};
+	regions[1] = {"data", "data_segment", TB_INSTANCE "inst_write_data/bram", elf.is_64 ? ELF64_DATA_ORIGIN : ELF32_DATA_ORIGIN,
+		      elf.is_64 ? 8u : 4u, elf.is_64 ? 2u : 4u, false, mti_image_t()};
+	if(elf.is_64){
+		regions[2] = {"dram_text", "dram_text_segment", TB_INSTANCE "inst_dram/bram", ELF64_DRAM_ORIGIN, 8, 2, true, mti_image_t()};
+	}
+
+	// output directory, formats and origins
+	std::string directory = ".";
+	bool write_mti = true;
+	bool write_bin = false;
+	bool write_c = false;
+	for(int i=2; i<argc; ++i){
+		const std::string arg(argv[i]);
+		if(arg.compare("-o")==0 && i+1 < argc){
+			std::vector<std::string_view> formats;
+			mti_split(argv[++i], ',', formats);
+			write_mti = write_bin = write_c = false;
+			for(unsigned int f=0; f<formats.size(); ++f){
+				if(formats[f] == "mti"){
+					write_mti = true;
+				}else if(formats[f] == "bin"){
+					write_bin = true;
+				}else if(formats[f] == "c"){
+					write_c = true;
+				}else{
+					std::cerr << "ERROR: unknown format " << formats[f] << ", expected mti, bin or c" << std::endl;
+					return EXIT_FAILURE;
+				}
+			}
+		}else if((arg.compare("-t")==0 || arg.compare("-d")==0 || arg.compare("-r")==0) && i+1 < argc){
+			const unsigned int r = (arg[1] == 't') ? 0 : (arg[1] == 'd') ? 1 : 2;
+			if(r >= regions.size() || !parse_origin(argv[++i], regions[r].origin)){
+				std::cerr << "ERROR: invalid origin " << argv[i] << " for " << arg << std::endl;
+				return EXIT_FAILURE;
+			}
+		}else if(i == 2 && arg[0] != '-'){
+			directory = arg;
+		}else{
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	// every region ends where the next one begins
+	for(unsigned int r=0; r<regions.size(); ++r){
+		region_t &region = regions[r];
+		uint64_t end = UINT64_MAX;
+		for(unsigned int o=0; o<regions.size(); ++o){
+			if(regions[o].origin > region.origin && regions[o].origin < end){
+				end = regions[o].origin;
+			}
+		}
+		mti_init(region.image);
+		region.image.instance = region.instance;
+		region.image.words_per_line = region.words_per_line;
+		elf_region(elf, region.origin, end, region.word_bytes, region.image);
+	}
+
+	for(unsigned int r=0; r<regions.size(); ++r){
+		const region_t &region = regions[r];
+		const std::string path = directory + "/" + region.name;
+		if(region.optional && region.image.runs.empty()){
+			// remove images of an earlier build
+			std::remove((path + ".mem").c_str());
+			std::remove((path + ".bin").c_str());
+			continue;
+		}
+		if(write_mti && !mti_write((path + ".mem").c_str(), MTI_FORMAT_MTI, region.image)){
+			return EXIT_FAILURE;
+		}
+		if(write_bin && !mti_write((path + ".bin").c_str(), MTI_FORMAT_BINARY, region.image)){
+			return EXIT_FAILURE;
+		}
+	}
+	if(write_c && !write_arrays(directory + "/segments.h", regions)){
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,275 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+
+#include "exporter.h"
+
+// data bytes per Intel HEX record
+#define IHEX_RECORD_LENGTH	16
+
+bool parse_export_formats(std::string_view list, std::vector<export_format_t> &formats){
+	std::vector<std::string_view> items;
+	mti_split(list, ',', items);
+	formats.clear();
+	for(unsigned int i=0; i<items.size(); ++i){
+		if(items[i] == "hex"){
+			formats.push_back(EXPORT_HEX);
+		}else if(items[i] == "coe"){
+			formats.push_back(EXPORT_COE);
+		}else if(items[i] == "xmem"){
+			formats.push_back(EXPORT_XMEM);
+		}else if(items[i] == "ihex"){
+			formats.push_back(EXPORT_IHEX);
+		}else if(items[i] == "bin"){
+			formats.push_back(EXPORT_BINARY);
+		}else{
+			return false;
+		}
+	}
+	return !formats.empty();
+}
+
+const char *export_extension(export_format_t format){
+	switch(format){
+		case EXPORT_HEX: return "hex";
+		case EXPORT_COE: return "coe";
+		case EXPORT_XMEM: return "xilinx.mem";
+		case EXPORT_IHEX: return "ihex";
+		case EXPORT_BINARY: return "bin";
+		default: return "";
+	}
+}
+
+// the word in hex, most significant part first
+// <word_digits> may leave the most significant part shorter than the others
+static void write_word(mti_writer_t &file, const std::vector<uint64_t> &parts, unsigned int part_digits, unsigned int word_digits){
+	const unsigned int ratio = parts.size();
+	if(ratio*part_digits <= 16){
+		// narrow words are assembled into one integer
+		uint64_t value = 0;
+		for(unsigned int entry=ratio; entry>0; --entry){
+			value = (part_digits*4 < 64) ? (value << (part_digits*4)) | parts[entry-1] : parts[entry-1];
+		}
+		mti_writer_hex(file, value, word_digits);
+	}else{
+		mti_writer_hex(file, parts[ratio-1], word_digits - (ratio-1)*part_digits);
+		for(unsigned int entry=ratio-1; entry>0; --entry){
+			mti_writer_hex(file, parts[entry-1], part_digits);
+		}
+	}
+}
+
+// the bytes of the word, least significant first
+static void word_bytes(const std::vector<uint64_t> &parts, unsigned int part_digits, std::vector<uint8_t> &bytes){
+	bytes.clear();
+	if((part_digits & 1) == 0){
+		for(unsigned int p=0; p<parts.size(); ++p){
+			for(unsigned int b=0; b<part_digits/2; ++b){
+				bytes.push_back(parts[p] >> (8*b));
+			}
+		}
+	}else{
+		// parts of odd digits share bytes with their neighbours
+		unsigned int byte = 0;
+		unsigned int bits = 0;
+		for(unsigned int p=0; p<parts.size(); ++p){
+			for(unsigned int n=0; n<part_digits; ++n){
+				byte |= ((parts[p] >> (4*n)) & 0xF) << bits;
+				bits += 4;
+				if(bits == 8){
+					bytes.push_back(byte);
+					byte = 0;
+					bits = 0;
+				}
+			}
+		}
+	}
+}
+
+static void ihex_byte(mti_writer_t &file, uint8_t value){
+	static const char hex[] = "0123456789ABCDEF";
+	const char digits[2] = {hex[value >> 4], hex[value & 0xF]};
+	mti_writer_text(file, std::string_view(digits, 2));
+}
+
+static void ihex_record(mti_writer_t &file, uint8_t type, uint16_t address, const uint8_t *data, size_t length){
+	uint8_t sum = length + (address >> 8) + (address & 0xFF) + type;
+	mti_writer_text(file, ":");
+	ihex_byte(file, length);
+	ihex_byte(file, address >> 8);
+	ihex_byte(file, address & 0xFF);
+	ihex_byte(file, type);
+	for(size_t i=0; i<length; ++i){
+		ihex_byte(file, data[i]);
+		sum += data[i];
+	}
+	ihex_byte(file, -sum);
+	mti_writer_text(file, "\n");
+}
+
+// writes the pending data record, preceded by an extended linear address record if needed
+static void ihex_flush(exporter_t &exporter){
+	if(exporter.ihex_record.empty()){
+		return;
+	}
+	const uint32_t upper = exporter.ihex_address >> 16;
+	if(upper != exporter.ihex_upper){
+		const uint8_t data[2] = {(uint8_t)(upper >> 8), (uint8_t)(upper & 0xFF)};
+		ihex_record(exporter.file, 4, 0, data, 2);
+		exporter.ihex_upper = upper;
+	}
+	ihex_record(exporter.file, 0, exporter.ihex_address & 0xFFFF, exporter.ihex_record.data(), exporter.ihex_record.size());
+	exporter.ihex_record.clear();
+}
+
+static void ihex_bytes(exporter_t &exporter, uint64_t address, const std::vector<uint8_t> &bytes){
+	if(address + bytes.size() > (UINT64_C(1) << 32)){
+		if(!exporter.failed){
+			std::cerr << "ERROR: Intel HEX is limited to 4 GiB, byte address " << address << " is too large" << std::endl;
+		}
+		exporter.failed = true;
+		return;
+	}
+	for(size_t i=0; i<bytes.size(); ++i){
+		const uint64_t a = address + i;
+		std::vector<uint8_t> &record = exporter.ihex_record;
+		if(!record.empty() && (a != exporter.ihex_address + record.size() || record.size() == IHEX_RECORD_LENGTH || (a & 0xFFFF) == 0)){
+			ihex_flush(exporter);
+		}
+		if(record.empty()){
+			exporter.ihex_address = a;
+		}
+		record.push_back(bytes[i]);
+	}
+}
+
+bool exporter_open(exporter_t &exporter, export_format_t format, const std::string &filename, unsigned int word_digits, bool big_endian){
+	exporter.format = format;
+	exporter.filename = filename;
+	exporter.word_digits = word_digits;
+	exporter.big_endian = big_endian;
+	exporter.next = 0;
+	exporter.count = 0;
+	exporter.ihex_upper = 0;
+	exporter.ihex_address = 0;
+	exporter.ihex_record.clear();
+	exporter.failed = false;
+
+	if((format == EXPORT_IHEX || format == EXPORT_BINARY) && (word_digits & 1) != 0){
+		std::cerr << "ERROR: " << export_extension(format) << " needs words of whole bytes" << std::endl;
+		return false;
+	}
+	if(!mti_writer_open(exporter.file, filename.c_str(), format == EXPORT_BINARY)){
+		return false;
+	}
+
+	switch(format){
+		case EXPORT_HEX:
+			exporter.zero = std::string(word_digits, '0') + "\n";
+			break;
+		case EXPORT_COE:
+			exporter.zero = std::string(word_digits, '0');
+			mti_writer_text(exporter.file, "memory_initialization_radix=16;\nmemory_initialization_vector=\n");
+			break;
+		case EXPORT_BINARY:
+			exporter.zero = std::string(word_digits/2, '\0');
+			break;
+		default:
+			break;
+	}
+	return true;
+}
+
+void exporter_word(exporter_t &exporter, uint64_t address, const std::vector<uint64_t> &parts, unsigned int part_digits){
+	mti_writer_t &file = exporter.file;
+	switch(exporter.format){
+		case EXPORT_HEX:
+			write_word(file, parts, part_digits, exporter.word_digits);
+			mti_writer_text(file, "\n");
+			break;
+		case EXPORT_COE:
+			if(exporter.count != 0){
+				mti_writer_text(file, ",\n");
+			}
+			write_word(file, parts, part_digits, exporter.word_digits);
+			break;
+		case EXPORT_XMEM:
+			if(exporter.count == 0 || address != exporter.next){
+				mti_writer_text(file, "@");
+				mti_writer_hex(file, address, 0);
+				mti_writer_text(file, "\n");
+			}
+			write_word(file, parts, part_digits, exporter.word_digits);
+			mti_writer_text(file, "\n");
+			break;
+		case EXPORT_IHEX:
+		case EXPORT_BINARY:
+			word_bytes(parts, part_digits, exporter.bytes);
+			exporter.bytes.resize(exporter.word_digits/2);
+			if(exporter.big_endian){
+				std::vector<uint8_t> &bytes = exporter.bytes;
+				for(size_t i=0; i<bytes.size()/2; ++i){
+					std::swap(bytes[i], bytes[bytes.size()-1-i]);
+				}
+			}
+			if(exporter.format == EXPORT_IHEX){
+				ihex_bytes(exporter, address*exporter.bytes.size(), exporter.bytes);
+			}else{
+				mti_writer_text(file, std::string_view((const char *)exporter.bytes.data(), exporter.bytes.size()));
+			}
+			break;
+	}
+	exporter.next = address+1;
+	++exporter.count;
+}
+
+void exporter_zeros(exporter_t &exporter, uint64_t address, uint64_t count){
+	if(count == 0){
+		return;
+	}
+	switch(exporter.format){
+		case EXPORT_HEX:
+		case EXPORT_BINARY:
+			mti_writer_repeat(exporter.file, exporter.zero, count);
+			break;
+		case EXPORT_COE:
+			if(exporter.count != 0){
+				mti_writer_text(exporter.file, ",\n");
+			}
+			mti_writer_repeat(exporter.file, exporter.zero + ",\n", count-1);
+			mti_writer_text(exporter.file, exporter.zero);
+			break;
+		default:
+			// sparse formats leave gaps out
+			return;
+	}
+	exporter.next = address+count;
+	exporter.count += count;
+}
+
+bool exporter_close(exporter_t &exporter){
+	if(exporter.format == EXPORT_COE){
+		mti_writer_text(exporter.file, ";\n");
+	}else if(exporter.format == EXPORT_IHEX){
+		ihex_flush(exporter);
+		ihex_record(exporter.file, 1, 0, NULL, 0);
+	}
+	if(!mti_writer_close(exporter.file)){
+		std::cerr << "ERROR: could not write file " << exporter.filename << std::endl;
+		return false;
+	}
+	return !exporter.failed;
+}
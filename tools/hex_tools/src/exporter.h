@@ -0,0 +1,72 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EXPORTER_H_
+#define EXPORTER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mti.h"
+
+// Output formats of mti2hex. All of them are fed the same stream of output
+// words in ascending order, so one parse of the input writes every format.
+typedef enum {
+	EXPORT_HEX,		// one word per line, gaps filled with zeros (.hex)
+	EXPORT_COE,		// Xilinx coefficient file for block memory generator (.coe)
+	EXPORT_XMEM,		// Xilinx/Vivado memory file with @ addresses, gaps skipped (.xilinx.mem)
+	EXPORT_IHEX,		// Intel HEX, 16 data bytes per record, gaps skipped (.ihex)
+	EXPORT_BINARY		// raw bytes from address 0 on, gaps filled with zeros (.bin)
+} export_format_t;
+
+// parses a comma separated list of hex, coe, xmem, ihex and bin
+bool parse_export_formats(std::string_view list, std::vector<export_format_t> &formats);
+
+// file extension of <format>, appended to the input name without "mem"
+const char *export_extension(export_format_t format);
+
+typedef struct exporter_s {
+	export_format_t format;
+	std::string filename;
+	mti_writer_t file;
+	unsigned int word_digits;	// hex digits per output word
+	bool big_endian;		// byte order of words in ihex and bin
+	uint64_t next;			// address of the next word without a gap
+	uint64_t count;			// words written so far
+	std::string zero;		// a zero word in the format, ready to repeat
+	uint32_t ihex_upper;		// upper 16 bit of the last extended linear address record
+	uint64_t ihex_address;		// byte address of the pending record
+	std::vector<uint8_t> ihex_record;
+	std::vector<uint8_t> bytes;	// scratch space for one word
+	bool failed;
+} exporter_t;
+
+bool exporter_open(exporter_t &exporter, export_format_t format, const std::string &filename, unsigned int word_digits, bool big_endian);
+
+// Writes the output word at <address>, in output words. The word is made of
+// the input words in <parts>, least significant first, with <part_digits>
+// hex digits each; the most significant part keeps what is left of the
+// word_digits of the exporter.
+void exporter_word(exporter_t &exporter, uint64_t address, const std::vector<uint64_t> &parts, unsigned int part_digits);
+
+// <count> zero words from <address> on
+void exporter_zeros(exporter_t &exporter, uint64_t address, uint64_t count);
+
+// finishes the file, false if it could not be written
+bool exporter_close(exporter_t &exporter);
+
+#endif
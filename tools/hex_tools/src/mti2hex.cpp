@@ -16,131 +16,130 @@
 #include <iostream>
 #include <cstdint>
 #include <string>
-#include <fstream>
 #include <vector>
-#include <stack>
 
-void tokenize(std::string line, std::vector<std::string> &vec, char separator){
-	unsigned int last = 0;
-	unsigned int length = 0;
-	for(unsigned int i=0; i<line.length(); ++i){
-		if(line[i]==separator){
-			std::string item = line.substr(last,length);
-			vec.push_back(item);
-			last = i+1;
-			length = 0;
-		}else{
-			++length;
-		}
-	}
-	if(line.length() > 1){
-		if(line[line.length()-1]!=separator){
-			std::string item = line.substr(last,length);
-			vec.push_back(item);
-		}
-	}
+#include "mti.h"
+#include "exporter.h"
+
+// Converts a memory file to words of the given width in one or more
+// formats, see exporter.h. The input is streamed once for all formats:
+// only the output word being assembled is kept, and runs of missing words
+// are handed to the exporters as one gap, so sparse dumps of large
+// memories convert at the speed of the disk with constant memory use.
+
+static void usage(){
+	std::cout << "wrong usage: mti2hex <mti file> [<word width in bits>] [-f hex,coe,xmem,ihex,bin] [-e little|big]" << std::endl;
+	std::cout << "the outputs replace the extension mem of the input, e.g. instr.hex, instr.coe, instr.xilinx.mem, instr.ihex and instr.bin" << std::endl;
 }
 
 int main(int argc, char *argv[]){
 	
-	if(argc != 2 && argc != 3){
-		std::cout << "wrong usage: argument must be file with configuration" << std::endl;
+	if(argc < 2){
+		usage();
 		return EXIT_FAILURE;
 	}
+
+	// optional width, formats and byte order
+	uint64_t width = 0;
+	std::vector<export_format_t> formats(1, EXPORT_HEX);
+	bool big_endian = false;
+	for(int i=2; i<argc; ++i){
+		const std::string arg(argv[i]);
+		if(arg.compare("-f")==0 && i+1 < argc){
+			if(!parse_export_formats(argv[++i], formats)){
+				std::cerr << "ERROR: unknown format in " << argv[i] << ", expected hex, coe, xmem, ihex or bin" << std::endl;
+				return EXIT_FAILURE;
+			}
+		}else if(arg.compare("-e")==0 && i+1 < argc){
+			const std::string order(argv[++i]);
+			if(order.compare("little")!=0 && order.compare("big")!=0){
+				std::cerr << "ERROR: byte order must be little or big" << std::endl;
+				return EXIT_FAILURE;
+			}
+			big_endian = order.compare("big")==0;
+		}else if(width == 0 && mti_parse_dec(arg, width) && width != 0){
+			continue;
+		}else{
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
 	
-	// open in and out files
-	std::ifstream mti_file(argv[1]);
-	if(!mti_file.is_open()){
-		std::cerr << "ERROR: could not open file " << argv[1] << std::endl;
+	// open mti file, the first word tells the data width
+	mti_reader_t reader;
+	if(!mti_reader_open(reader, argv[1])){
 		return EXIT_FAILURE;
 	}
-	std::string outfilename(argv[1]);
-	outfilename.replace(outfilename.length()-3,3,"hex");
-	std::ofstream outfile(outfilename);
-	std::string mti_line = "";
-
-	// read mti file header
-	std::getline(mti_file,mti_line);
-	std::getline(mti_file,mti_line);
-	
-	// get data width and initialize filler
-	std::getline(mti_file,mti_line);
-	std::vector<std::string> mti_header;
-	tokenize(mti_line,mti_header,' ');
-	if(mti_header.size() < 2 || mti_file.eof()){
-		std::cerr << "ERROR: first line after header without data not supported" << std::endl;
+	uint64_t address = 0;
+	uint64_t value = 0;
+	if(!mti_reader_next(reader, address, value)){
+		if(!reader.failed){
+			std::cerr << "ERROR: first line after header without data not supported" << std::endl;
+		}
 		return EXIT_FAILURE;
 	}
 	
-	unsigned int mtidata_width = mti_header[1].length();
-	unsigned int hexdata_width = mtidata_width;
-	if(argc==3){
-		hexdata_width = static_cast<unsigned int>(std::stoi(argv[2]))/4;
-		if(hexdata_width % mtidata_width != 0){
+	// get data width, the width of the file unless given; words wider than
+	// 64 bit come in parts of 16 digits, the most significant may be shorter
+	unsigned int mtidata_width = reader.word_digits;
+	unsigned int hexdata_width = reader.file_digits;
+	if(width != 0){
+		hexdata_width = width/4;
+		if(width % 4 != 0 || hexdata_width % reader.file_digits != 0){
 			std::cerr << "ERROR: hex data width must be multiple of mti data width" << std::endl;
 			return EXIT_FAILURE;
 		}
+		if(hexdata_width != reader.file_digits && reader.file_digits % mtidata_width != 0){
+			std::cerr << "ERROR: mti data wider than 64 bit must be a multiple of 64 bit to be combined" << std::endl;
+			return EXIT_FAILURE;
+		}
 	}
-	unsigned int ratio = hexdata_width / mtidata_width;
+	unsigned int ratio = (hexdata_width + mtidata_width-1) / mtidata_width;
 	
-	std::string filler = "";
-	for(unsigned int i=0; i<mtidata_width; ++i){
-		filler.append("0");
+	std::string stem(argv[1]);
+	stem.erase(stem.length() >= 3 ? stem.length()-3 : 0);
+	std::vector<exporter_t> exporters(formats.size());
+	for(unsigned int e=0; e<formats.size(); ++e){
+		if(!exporter_open(exporters[e], formats[e], stem + export_extension(formats[e]), hexdata_width, big_endian)){
+			return EXIT_FAILURE;
+		}
 	}
-	
-	// read data and dump it in new format
-	std::stack<std::string> stack;
-	unsigned int index = 0;
-	while(!mti_file.eof()){
-		std::vector<std::string> mti_strings;
-		tokenize(mti_line,mti_strings,' ');
-		int mti_index = std::stoi(mti_strings[0].substr(0,mti_strings[0].length()-1));
 
-		// fill with zeros if some values are not in the file
-		while(index < mti_index){
-			stack.push(filler);
-			++index;
-			if(index&1 == 0){
-				while(!stack.empty()){
-					outfile << stack.top();
-					stack.pop();
-				}
-			}
-			if(index % ratio == 0){
-				while(!stack.empty()){
-					outfile << stack.top();
-					stack.pop();
-				}
-				outfile << std::endl;
-			}
+	// words missing in the file and the rest of the last word are zero
+	std::vector<uint64_t> line(ratio, 0);
+	uint64_t line_address = 0;
+	bool line_used = false;
+	do{
+		if(address < line_address){
+			std::cerr << "ERROR: " << argv[1] << ":" << reader.line_number << ": addresses must ascend" << std::endl;
+			return EXIT_FAILURE;
 		}
-
-		// write data if present
-		for(unsigned int entry=1; entry<mti_strings.size(); ++entry){
-			stack.push(mti_strings[entry]);
-			++index;
-			if(index&1 == 0){
-				while(!stack.empty()){
-					outfile << stack.top();
-					stack.pop();
+		if(address - line_address >= ratio){
+			uint64_t gap = line_address;
+			if(line_used){
+				for(unsigned int e=0; e<exporters.size(); ++e){
+					exporter_word(exporters[e], line_address/ratio, line, mtidata_width);
 				}
+				line.assign(ratio, 0);
+				gap += ratio;
 			}
-			if(index % ratio == 0){
-				while(!stack.empty()){
-					outfile << stack.top();
-					stack.pop();
-				}
-				outfile << std::endl;
+			line_address = address - address % ratio;
+			for(unsigned int e=0; e<exporters.size(); ++e){
+				exporter_zeros(exporters[e], gap/ratio, (line_address-gap)/ratio);
 			}
 		}
-
-		// get next line
-		std::getline(mti_file,mti_line);
+		line[address - line_address] = value;
+		line_used = true;
+	}while(mti_reader_next(reader, address, value));
+	if(reader.failed){
+		return EXIT_FAILURE;
 	}
-	// write rest
-	while(!stack.empty()){
-		outfile << stack.top();
-		stack.pop();
+	mti_reader_close(reader);
+
+	bool ok = true;
+	for(unsigned int e=0; e<exporters.size(); ++e){
+		exporter_word(exporters[e], line_address/ratio, line, mtidata_width);
+		ok = exporter_close(exporters[e]) && ok;
 	}
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
-
@@ -0,0 +1,168 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hsa.h"
+#include "hsa_ext_fpga.h"
+#include "hsa_fpga_backend.h"
+#include "filters.h"
+
+// Bursts of GAUSS3x3 frames that all arrive at once, e.g. hsa_burst_bench
+// 640 480 160 5 for five bursts of 160 frames of 640x480. The model agent
+// filters a frame in AGENT_PIXEL_NS per pixel like a pipeline clocked at
+// 100 MHz. Reports when the frames of a burst are done, counted from its
+// start, with every frame on the agent and with the hybrid scheduler, and
+// checks every frame against the host filter.
+
+#define AGENT_PIXEL_NS 10
+
+typedef struct bench_kernargs_s {
+	uint64_t src;
+	uint64_t dst;
+	uint8_t colormodel;
+	uint8_t borderhandling;
+	uint16_t threshold;
+} __attribute__((packed)) bench_kernargs_t;
+
+// the model agent, the host filter slowed down to the pixel rate of the pipeline
+static void agent_filter(const hsa_kernel_dispatch_packet_t *packet, const void *kernargs, void *data){
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const bench_kernargs_t *args = (const bench_kernargs_t*)kernargs;
+	filter_params_t params;
+	filter_params_from_kernargs(packet->kernel_object, kernargs, params);
+	filter_run(params, packet->grid_size_x, packet->grid_size_y, (const uint8_t*)args->src, (uint8_t*)args->dst, 1);
+	std::this_thread::sleep_until(start + std::chrono::nanoseconds((uint64_t)AGENT_PIXEL_NS * packet->grid_size_x * packet->grid_size_y));
+}
+
+static double percentile(std::vector<double> values, double p){
+	std::sort(values.begin(), values.end());
+	return values[std::min(values.size()-1, (size_t)(p * values.size()))];
+}
+
+static bool run_bursts(hsa_queue_t *queue, const char *what, hsa_fpga_schedule_t schedule, uint32_t width, uint32_t height,
+		       uint32_t burst, uint32_t bursts, const std::vector<uint8_t> &src, const std::vector<uint8_t> &expected){
+	std::vector<bench_kernargs_t> args(burst);
+	std::vector<std::vector<uint8_t>> dst(burst, std::vector<uint8_t>(src.size()));
+	std::vector<hsa_signal_t> signals(burst);
+	const std::vector<hsa_signal_condition_t> conditions(burst, HSA_SIGNAL_CONDITION_EQ);
+	const std::vector<hsa_signal_value_t> values(burst, 0);
+	for(uint32_t i=0; i<burst; ++i){
+		std::memset(&args[i], 0, sizeof(args[i]));
+		args[i].src = (uint64_t)src.data();
+		args[i].dst = (uint64_t)dst[i].data();
+		args[i].colormodel = FILTER_UINT16_GRAY_SCALE;
+		args[i].borderhandling = FILTER_CLAMP_TO_EDGE;
+		hsa_signal_create(1, 0, NULL, &signals[i]);
+	}
+	hsa_fpga_scheduler_info_t before;
+	hsa_fpga_scheduler_get_info(&before);
+	std::vector<double> done_ms;
+	bool ok = true;
+	for(uint32_t b=0; b<bursts; ++b){
+		for(uint32_t i=0; i<burst; ++i){
+			std::fill(dst[i].begin(), dst[i].end(), 0);
+			hsa_signal_store_relaxed(signals[i], 1);
+		}
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(uint32_t i=0; i<burst; ++i){
+			hsa_fpga_dispatch_filter(queue, FILTER_GAUSS3x3, &args[i], width, height, signals[i], schedule, NULL);
+		}
+		for(uint32_t done=0; done<burst; ++done){
+			const uint32_t i = hsa_fpga_signal_wait_any(burst, signals.data(), conditions.data(), values.data(), UINT64_MAX,
+								   HSA_WAIT_STATE_BLOCKED, NULL);
+			done_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			// a finished frame keeps a value the wait does not take
+			hsa_signal_store_relaxed(signals[i], 1);
+			if(dst[i] != expected){
+				ok = false;
+			}
+		}
+	}
+	hsa_fpga_scheduler_info_t after;
+	hsa_fpga_scheduler_get_info(&after);
+	for(uint32_t i=0; i<burst; ++i){
+		hsa_signal_destroy(signals[i]);
+	}
+	std::cout << std::left << std::setw(8) << what << std::right << std::fixed << std::setprecision(1)
+		  << std::setw(9) << percentile(done_ms, 0.5) << std::setw(9) << percentile(done_ms, 0.99)
+		  << std::setw(9) << percentile(done_ms, 1.0) << std::setw(8) << after.cpu_frames - before.cpu_frames
+		  << std::setw(8) << std::setprecision(2) << after.agent_pixel_ns << (ok ? "" : "  FAILED") << std::endl;
+	return ok;
+}
+
+static hsa_status_t get_agent(hsa_agent_t agent, void *data){
+	*(hsa_agent_t*)data = agent;
+	return HSA_STATUS_INFO_BREAK;
+}
+
+int main(int argc, char *argv[]){
+	if(argc > 5){
+		std::cout << "wrong usage: hsa_burst_bench [<width>] [<height>] [<frames per burst>] [<bursts>]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	const uint32_t width = (argc > 1) ? std::stoul(argv[1]) : 640;
+	const uint32_t height = (argc > 2) ? std::stoul(argv[2]) : 480;
+	const uint32_t burst = (argc > 3) ? std::stoul(argv[3]) : 160;
+	const uint32_t bursts = (argc > 4) ? std::stoul(argv[4]) : 5;
+	if(width == 0 || height == 0 || burst == 0 || bursts == 0){
+		std::cerr << "ERROR: image, bursts and frames must not be empty" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if(hsa_init() != HSA_STATUS_SUCCESS){
+		return EXIT_FAILURE;
+	}
+	hsa_agent_t agent;
+	hsa_iterate_agents(get_agent, &agent);
+	hsa_queue_t *queue;
+	if(hsa_queue_create(agent, MAX_QUEUE_LENGTH, HSA_QUEUE_TYPE_MULTI, NULL, NULL, 0, 0, &queue) != HSA_STATUS_SUCCESS){
+		std::cerr << "ERROR: cannot create the queue" << std::endl;
+		hsa_shut_down();
+		return EXIT_FAILURE;
+	}
+	hsa_model_register_kernel(FILTER_GAUSS3x3, agent_filter, NULL);
+
+	std::vector<uint8_t> src((uint64_t)width*height*filter_pixel_storage(FILTER_UINT16_GRAY_SCALE)), expected(src.size());
+	for(uint64_t i=0; i<src.size(); ++i){
+		src[i] = (i*7919) >> 3;
+	}
+	filter_params_t params;
+	std::memset(&params, 0, sizeof(params));
+	params.kernel = FILTER_GAUSS3x3;
+	params.colormodel = FILTER_UINT16_GRAY_SCALE;
+	params.borderhandling = FILTER_CLAMP_TO_EDGE;
+	filter_run(params, width, height, src.data(), expected.data());
+
+	hsa_fpga_scheduler_info_t info;
+	hsa_fpga_scheduler_get_info(&info);
+	std::cout << bursts << " bursts of " << burst << " GAUSS3x3 " << width << "x" << height << " frames, agent "
+		  << AGENT_PIXEL_NS << " ns/pixel, " << info.cpu_workers << " CPU workers, ring of " << queue->size << std::endl;
+	std::cout << std::left << std::setw(8) << "" << std::right << std::setw(9) << "p50 ms" << std::setw(9) << "p99 ms"
+		  << std::setw(9) << "max ms" << std::setw(8) << "on cpu" << std::setw(8) << "ns/px" << std::endl;
+	bool ok = run_bursts(queue, "agent", HSA_FPGA_SCHEDULE_AGENT, width, height, burst, bursts, src, expected);
+	ok = run_bursts(queue, "hybrid", HSA_FPGA_SCHEDULE_AUTO, width, height, burst, bursts, src, expected) && ok;
+
+	hsa_queue_destroy(queue);
+	hsa_shut_down();
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,200 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "hsa.h"
+#include "hsa_ext_fpga.h"
+
+// Conversions of camera-style frames into DMA-ready images, e.g.
+// hsa_convert_bench 640 480 50. Checks every conversion against a plain
+// per-pixel loop on odd sizes and strides, then times both on the given
+// frame and reports the bytes the device reads per frame.
+
+static uint64_t storage(hsa_fpga_colormodel_t colormodel){
+	return (colormodel == HSA_FPGA_UINT8_RGBX) ? 4 : (colormodel == HSA_FPGA_UINT8_RGB) ? 3 : 2;
+}
+
+static void naive_rgba(const uint8_t *rgba, uint32_t width, uint32_t height, uint64_t stride, hsa_fpga_colormodel_t colormodel, uint8_t *image){
+	const uint64_t s = storage(colormodel);
+	for(uint32_t y=0; y<height; ++y){
+		for(uint32_t x=0; x<width; ++x){
+			uint8_t *p = image + ((uint64_t)y*width + x)*s;
+			for(unsigned int c=0; c<s; ++c){
+				p[c] = (c < 3) ? rgba[y*stride + 4*x + c] : 0;
+			}
+		}
+	}
+}
+
+static void naive_planar(const uint8_t *const planes[3], uint32_t width, uint32_t height, uint64_t stride, hsa_fpga_colormodel_t colormodel, uint8_t *image){
+	const uint64_t s = storage(colormodel);
+	for(uint32_t y=0; y<height; ++y){
+		for(uint32_t x=0; x<width; ++x){
+			uint8_t *p = image + ((uint64_t)y*width + x)*s;
+			for(unsigned int c=0; c<s; ++c){
+				p[c] = (c < 3) ? planes[c][y*stride + x] : 0;
+			}
+		}
+	}
+}
+
+static void naive_gray8(const uint8_t *gray, uint32_t width, uint32_t height, uint64_t stride, bool full_range, uint8_t *image){
+	for(uint32_t y=0; y<height; ++y){
+		for(uint32_t x=0; x<width; ++x){
+			const uint16_t v = full_range ? gray[y*stride + x]*257 : gray[y*stride + x];
+			std::memcpy(image + ((uint64_t)y*width + x)*2, &v, 2);
+		}
+	}
+}
+
+// a source of <height> rows of <stride> bytes, per plane for planar frames
+typedef struct frame_s {
+	std::vector<uint8_t> rgba;
+	std::vector<uint8_t> planes[3];
+	std::vector<uint8_t> gray;
+	uint64_t rgba_stride;
+	uint64_t plane_stride;
+} frame_t;
+
+static frame_t make_frame(uint32_t width, uint32_t height, uint32_t extra){
+	frame_t frame;
+	frame.rgba_stride = 4*(uint64_t)width + extra;
+	frame.plane_stride = width + extra;
+	frame.rgba.resize(frame.rgba_stride*height);
+	for(uint64_t i=0; i<frame.rgba.size(); ++i){
+		frame.rgba[i] = (i*7919) >> 5;
+	}
+	for(unsigned int c=0; c<3; ++c){
+		frame.planes[c].resize(frame.plane_stride*height);
+		for(uint64_t i=0; i<frame.planes[c].size(); ++i){
+			frame.planes[c][i] = (i*(31+c)) >> 2;
+		}
+	}
+	frame.gray = frame.planes[1];
+	return frame;
+}
+
+typedef std::function<hsa_status_t(const frame_t&, uint8_t*)> convert_fn_t;
+typedef std::function<void(const frame_t&, uint8_t*)> naive_fn_t;
+
+typedef struct conversion_s {
+	const char *name;
+	hsa_fpga_colormodel_t colormodel;
+	uint64_t source_bytes_per_pixel;
+	convert_fn_t convert;
+	naive_fn_t naive;
+} conversion_t;
+
+static std::vector<conversion_t> conversions(uint32_t width, uint32_t height){
+	std::vector<conversion_t> list;
+	const hsa_fpga_colormodel_t models[2] = {HSA_FPGA_UINT8_RGB, HSA_FPGA_UINT8_RGBX};
+	for(hsa_fpga_colormodel_t m : models){
+		const bool padded = (m == HSA_FPGA_UINT8_RGBX);
+		list.push_back({padded ? "rgba->rgbx" : "rgba->rgb", m, 4,
+			[=](const frame_t &f, uint8_t *image){ return hsa_fpga_convert_rgba(f.rgba.data(), width, height, f.rgba_stride, m, image); },
+			[=](const frame_t &f, uint8_t *image){ naive_rgba(f.rgba.data(), width, height, f.rgba_stride, m, image); }});
+		list.push_back({padded ? "planar->rgbx" : "planar->rgb", m, 3,
+			[=](const frame_t &f, uint8_t *image){
+				const uint8_t *planes[3] = {f.planes[0].data(), f.planes[1].data(), f.planes[2].data()};
+				return hsa_fpga_convert_planar(planes, width, height, f.plane_stride, m, image); },
+			[=](const frame_t &f, uint8_t *image){
+				const uint8_t *planes[3] = {f.planes[0].data(), f.planes[1].data(), f.planes[2].data()};
+				naive_planar(planes, width, height, f.plane_stride, m, image); }});
+	}
+	for(bool full_range : {false, true}){
+		list.push_back({full_range ? "gray8->16 full" : "gray8->16", HSA_FPGA_UINT16_GRAY_SCALE, 1,
+			[=](const frame_t &f, uint8_t *image){ return hsa_fpga_convert_gray8(f.gray.data(), width, height, f.plane_stride, full_range, image); },
+			[=](const frame_t &f, uint8_t *image){ naive_gray8(f.gray.data(), width, height, f.plane_stride, full_range, image); }});
+	}
+	return list;
+}
+
+// converts into a buffer full of garbage, the padding must come out 0 as well
+static bool check(uint32_t width, uint32_t height, uint32_t extra){
+	const frame_t frame = make_frame(width, height, extra);
+	bool ok = true;
+	for(const conversion_t &c : conversions(width, height)){
+		const uint64_t size = hsa_fpga_image_size(width, height, c.colormodel);
+		uint8_t *image = (uint8_t*)hsa_fpga_image_alloc(width, height, c.colormodel);
+		std::vector<uint8_t> expected(size, 0);
+		std::memset(image, 0xA5, size);
+		c.naive(frame, expected.data());
+		if(c.convert(frame, image) != HSA_STATUS_SUCCESS || std::memcmp(image, expected.data(), size) != 0){
+			std::cerr << "ERROR: " << c.name << " differs on " << width << "x" << height << " with stride +" << extra << std::endl;
+			ok = false;
+		}
+		hsa_fpga_image_free(image);
+	}
+	return ok;
+}
+
+template<typename F>
+static double time_ms(uint32_t repeat, F run){
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(uint32_t i=0; i<repeat; ++i){
+		run();
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+}
+
+int main(int argc, char *argv[]){
+	if(argc > 4){
+		std::cout << "wrong usage: hsa_convert_bench [<width>] [<height>] [<repeat>]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	const uint32_t width = (argc > 1) ? std::stoul(argv[1]) : 640;
+	const uint32_t height = (argc > 2) ? std::stoul(argv[2]) : 480;
+	const uint32_t repeat = (argc > 3) ? std::stoul(argv[3]) : 50;
+	if(width == 0 || height == 0 || repeat == 0){
+		std::cerr << "ERROR: image and repetitions must not be empty" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	bool ok = true;
+	uint32_t checks = 0;
+	for(uint32_t w : {1u, 15u, 16u, 17u, 33u, 64u, 101u}){
+		for(uint32_t h : {1u, 3u, 7u}){
+			for(uint32_t extra : {0u, 5u}){
+				ok = check(w, h, extra) && ok;
+				checks += 6;
+			}
+		}
+	}
+	std::cout << checks << " conversion checks " << (ok ? "passed" : "FAILED") << std::endl;
+
+	const frame_t frame = make_frame(width, height, 0);
+	std::cout << width << "x" << height << " frames, " << repeat << " repetitions" << std::endl;
+	std::cout << std::left << std::setw(16) << "" << std::right << std::setw(10) << "loop ms" << std::setw(10) << "ms"
+		  << std::setw(10) << "GB/s" << std::setw(9) << "speedup" << std::setw(12) << "DMA bytes" << std::endl;
+	for(const conversion_t &c : conversions(width, height)){
+		uint8_t *image = (uint8_t*)hsa_fpga_image_alloc(width, height, c.colormodel);
+		const double loop = time_ms(repeat, [&](){ c.naive(frame, image); });
+		const double simd = time_ms(repeat, [&](){ c.convert(frame, image); });
+		const uint64_t size = hsa_fpga_image_size(width, height, c.colormodel);
+		const double bytes = (double)width*height*c.source_bytes_per_pixel + size;
+		std::cout << std::left << std::setw(16) << c.name << std::right << std::fixed << std::setprecision(3)
+			  << std::setw(10) << loop << std::setw(10) << simd << std::setprecision(2) << std::setw(10) << bytes / simd / 1e6
+			  << std::setw(8) << loop / simd << "x" << std::setw(12) << size << std::endl;
+		hsa_fpga_image_free(image);
+	}
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
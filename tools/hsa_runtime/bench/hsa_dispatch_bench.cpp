@@ -0,0 +1,210 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hsa.h"
+#include "hsa_ext_fpga.h"
+#include "hsa_fpga_backend.h"
+
+// Dispatches empty kernels through the runtime from several producer threads
+// and waits for them with completion signals. Reports the round trip of a
+// single packet and the throughput of batches, e.g. hsa_dispatch_bench 4
+// 100000 16 for four producers with 100000 packets each in batches of 16.
+// Then one thread keeps <in flight> frames of FRAME_US each in flight and
+// reports the CPU time it takes to wait for them, polling and blocking.
+// The device is chosen by HSA_FPGA_BACKEND like for every application.
+
+#define BENCH_KERNEL 0x11
+#define FRAME_KERNEL 0x12
+#define FRAME_US 50
+#define FRAMES 2000
+
+typedef struct bench_kernargs_s {
+	uint64_t src;
+	uint64_t dst;
+	uint8_t colormodel;
+	uint8_t borderhandling;
+	uint16_t threshold;
+} __attribute__((packed)) bench_kernargs_t;
+
+// counts the dispatches of every producer, the destination address carries the producer
+static void count_kernel(const hsa_kernel_dispatch_packet_t *packet, const void *kernargs, void *data){
+	const bench_kernargs_t *args = (const bench_kernargs_t*)kernargs;
+	std::atomic<uint64_t> *counts = (std::atomic<uint64_t>*)data;
+	counts[args->dst].fetch_add(1, std::memory_order_relaxed);
+}
+
+// stands in for the device time of a frame
+static void frame_kernel(const hsa_kernel_dispatch_packet_t *packet, const void *kernargs, void *data){
+	std::this_thread::sleep_for(std::chrono::microseconds(FRAME_US));
+}
+
+static void submit(hsa_queue_t *queue, uint64_t kernel, const bench_kernargs_t *args, uint64_t count, hsa_signal_t completion){
+	const uint64_t index = hsa_queue_add_write_index_scacq_screl(queue, count);
+	while(index + count - hsa_queue_load_read_index_scacquire(queue) > queue->size){
+		std::this_thread::yield();
+	}
+	for(uint64_t i=0; i<count; ++i){
+		hsa_kernel_dispatch_packet_t *packet = (hsa_kernel_dispatch_packet_t*)queue->base_address + ((index+i) & (queue->size-1));
+		packet->workgroup_size_x = 1;
+		packet->workgroup_size_y = 1;
+		packet->workgroup_size_z = 1;
+		packet->grid_size_x = 1920;
+		packet->grid_size_y = 1080;
+		packet->grid_size_z = 1;
+		packet->private_segment_size = 0;
+		packet->group_segment_size = 0;
+		packet->kernel_object = kernel;
+		packet->kernarg_address = (void*)args;
+		packet->completion_signal = completion;
+		hsa_packet_publish(packet, hsa_packet_header_setup(HSA_PACKET_TYPE_KERNEL_DISPATCH, false,
+			HSA_FENCE_SCOPE_SYSTEM, HSA_FENCE_SCOPE_SYSTEM, 1 << HSA_KERNEL_DISPATCH_PACKET_SETUP_DIMENSIONS));
+	}
+	hsa_signal_store_screlease(queue->doorbell_signal, index+count-1);
+}
+
+static void produce(hsa_queue_t *queue, unsigned int producer, uint64_t packets, uint64_t batch){
+	bench_kernargs_t args;
+	std::memset(&args, 0, sizeof(args));
+	args.dst = producer;
+	hsa_signal_t completion;
+	hsa_signal_create(0, 0, NULL, &completion);
+	for(uint64_t sent=0; sent<packets; sent+=batch){
+		const uint64_t count = (packets - sent < batch) ? packets - sent : batch;
+		hsa_signal_store_relaxed(completion, count);
+		submit(queue, BENCH_KERNEL, &args, count, completion);
+		hsa_signal_wait_scacquire(completion, HSA_SIGNAL_CONDITION_EQ, 0, UINT64_MAX, HSA_WAIT_STATE_BLOCKED);
+	}
+	hsa_signal_destroy(completion);
+}
+
+// keeps <in_flight> frames with a signal each in flight until FRAMES are done
+static void run_frames(hsa_queue_t *queue, const char *what, uint32_t in_flight, hsa_wait_state_t wait_state){
+	bench_kernargs_t args;
+	std::memset(&args, 0, sizeof(args));
+	std::vector<hsa_signal_t> signals(in_flight);
+	const std::vector<hsa_signal_condition_t> conditions(in_flight, HSA_SIGNAL_CONDITION_EQ);
+	const std::vector<hsa_signal_value_t> values(in_flight, 0);
+	const std::clock_t cpu_start = std::clock();
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	uint64_t submitted = 0;
+	for(uint32_t i=0; i<in_flight; ++i){
+		hsa_signal_create(1, 0, NULL, &signals[i]);
+		if(submitted < FRAMES){
+			submit(queue, FRAME_KERNEL, &args, 1, signals[i]);
+			++submitted;
+		}
+	}
+	for(uint64_t done=0; done<submitted; ++done){
+		const uint32_t i = hsa_fpga_signal_wait_any(in_flight, signals.data(), conditions.data(), values.data(), UINT64_MAX, wait_state, NULL);
+		// a finished frame without a successor keeps a value the wait does not take
+		hsa_signal_store_relaxed(signals[i], 1);
+		if(submitted < FRAMES){
+			submit(queue, FRAME_KERNEL, &args, 1, signals[i]);
+			++submitted;
+		}
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const double cpu_seconds = (double)(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+	for(uint32_t i=0; i<in_flight; ++i){
+		hsa_signal_destroy(signals[i]);
+	}
+	std::cout << std::left << std::setw(12) << what << std::right << std::fixed << std::setprecision(3)
+		  << std::setw(9) << seconds << " s" << std::setw(9) << cpu_seconds << " s cpu" << std::setw(7) << std::setprecision(0)
+		  << 100.0 * cpu_seconds / seconds << " %" << std::endl;
+}
+
+static hsa_status_t get_agent(hsa_agent_t agent, void *data){
+	*(hsa_agent_t*)data = agent;
+	return HSA_STATUS_INFO_BREAK;
+}
+
+int main(int argc, char *argv[]){
+	if(argc < 2 || argc > 5){
+		std::cout << "wrong usage: hsa_dispatch_bench <producers> [<packets per producer>] [<batch>] [<in flight>]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	const unsigned int producers = std::stoul(argv[1]);
+	const uint64_t packets = (argc > 2) ? std::stoull(argv[2]) : 100000;
+	const uint64_t batch = (argc > 3) ? std::stoull(argv[3]) : 16;
+	const uint32_t in_flight = (argc > 4) ? std::stoul(argv[4]) : 32;
+	if(producers == 0 || batch == 0 || batch > MAX_QUEUE_LENGTH || in_flight == 0 || in_flight > MAX_QUEUE_LENGTH){
+		std::cerr << "ERROR: at least one producer, a batch and frames in flight between 1 and " << MAX_QUEUE_LENGTH << " needed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if(hsa_init() != HSA_STATUS_SUCCESS){
+		return EXIT_FAILURE;
+	}
+	hsa_agent_t agent;
+	hsa_iterate_agents(get_agent, &agent);
+	char name[64];
+	hsa_agent_get_info(agent, HSA_AGENT_INFO_NAME, name);
+	hsa_queue_t *queue;
+	if(hsa_queue_create(agent, MAX_QUEUE_LENGTH, HSA_QUEUE_TYPE_MULTI, NULL, NULL, 0, 0, &queue) != HSA_STATUS_SUCCESS){
+		std::cerr << "ERROR: cannot create the queue" << std::endl;
+		hsa_shut_down();
+		return EXIT_FAILURE;
+	}
+	std::vector<std::atomic<uint64_t>> counts(producers);
+	hsa_model_register_kernel(BENCH_KERNEL, count_kernel, counts.data());
+	hsa_model_register_kernel(FRAME_KERNEL, frame_kernel, NULL);
+	std::cout << name << ", " << producers << " producers, " << packets << " packets each, batches of " << batch << std::endl;
+
+	// round trip of single packets from one thread
+	const uint64_t singles = (packets < 10000) ? packets : 10000;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	produce(queue, 0, singles, 1);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << std::left << std::setw(12) << "round trip" << std::right << std::fixed << std::setprecision(2)
+		  << std::setw(9) << seconds / singles * 1e6 << " us" << std::endl;
+
+	counts[0].store(0);
+	start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for(unsigned int p=0; p<producers; ++p){
+		threads.push_back(std::thread(produce, queue, p, packets, batch));
+	}
+	for(unsigned int p=0; p<producers; ++p){
+		threads[p].join();
+	}
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	bool ok = true;
+	for(unsigned int p=0; p<producers; ++p){
+		if(counts[p].load() != packets){
+			std::cerr << "ERROR: producer " << p << " dispatched " << packets << " packets, " << counts[p].load() << " ran" << std::endl;
+			ok = false;
+		}
+	}
+	std::cout << std::left << std::setw(12) << "throughput" << std::right << std::fixed << std::setprecision(2)
+		  << std::setw(9) << producers*packets / seconds / 1e6 << " Mpackets/s" << (ok ? "" : "  FAILED") << std::endl;
+
+	std::cout << FRAMES << " frames of " << FRAME_US << " us, " << in_flight << " in flight" << std::endl;
+	run_frames(queue, "polling", in_flight, HSA_WAIT_STATE_ACTIVE);
+	run_frames(queue, "blocking", in_flight, HSA_WAIT_STATE_BLOCKED);
+
+	hsa_queue_destroy(queue);
+	hsa_shut_down();
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,144 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HSA_H_
+#define HSA_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "hsa_packets.h"
+
+// The subset of the HSA runtime API that applications of the FPGA need:
+// one agent with one AQL queue, signals and the queue index operations.
+// Packets are written to the ring in the layout of the packet processor
+// (address_conf.h) and published by storing their header last, e.g.
+//
+//   hsa_queue_t *queue;
+//   hsa_queue_create(agent, 128, HSA_QUEUE_TYPE_MULTI, NULL, NULL, 0, 0, &queue);
+//   uint64_t index = hsa_queue_add_write_index_scacq_screl(queue, 1);
+//   while(index - hsa_queue_load_read_index_scacquire(queue) >= queue->size){}
+//   hsa_kernel_dispatch_packet_t *packet = ... base_address + index % size ...
+//   ... fill in the packet, then store header and setup with release ...
+//   hsa_signal_store_screlease(queue->doorbell_signal, index);
+//   hsa_signal_wait_scacquire(completion, HSA_SIGNAL_CONDITION_EQ, 0, UINT64_MAX, HSA_WAIT_STATE_BLOCKED);
+//
+// Which device serves the queue is chosen at hsa_init() by the environment
+// variable HSA_FPGA_BACKEND, see hsa_fpga_backend.h.
+
+typedef enum {
+	HSA_STATUS_SUCCESS = 0x0,
+	HSA_STATUS_INFO_BREAK = 0x1,
+	HSA_STATUS_ERROR = 0x1000,
+	HSA_STATUS_ERROR_INVALID_ARGUMENT = 0x1001,
+	HSA_STATUS_ERROR_INVALID_QUEUE_CREATION = 0x1002,
+	HSA_STATUS_ERROR_OUT_OF_RESOURCES = 0x1008,
+	HSA_STATUS_ERROR_INVALID_AGENT = 0x100B,
+	HSA_STATUS_ERROR_INVALID_SIGNAL = 0x100E,
+	HSA_STATUS_ERROR_INVALID_QUEUE = 0x100F,
+	HSA_STATUS_ERROR_NOT_INITIALIZED = 0x100C
+} hsa_status_t;
+
+typedef int64_t hsa_signal_value_t;
+
+typedef struct hsa_agent_s {
+	uint64_t handle;
+} hsa_agent_t;
+
+typedef enum {
+	HSA_QUEUE_TYPE_MULTI = 0,
+	HSA_QUEUE_TYPE_SINGLE = 1
+} hsa_queue_type_t;
+
+typedef enum {
+	HSA_QUEUE_FEATURE_KERNEL_DISPATCH = 1,
+	HSA_QUEUE_FEATURE_AGENT_DISPATCH = 2
+} hsa_queue_feature_t;
+
+typedef struct hsa_queue_s {
+	hsa_queue_type_t type;
+	uint32_t features;
+	void *base_address;		// the AQL ring in the device memory
+	hsa_signal_t doorbell_signal;
+	uint32_t size;			// slots, a power of two
+	uint32_t reserved1;
+	uint64_t id;
+} hsa_queue_t;
+
+typedef enum {
+	HSA_SIGNAL_CONDITION_EQ = 0,
+	HSA_SIGNAL_CONDITION_NE = 1,
+	HSA_SIGNAL_CONDITION_LT = 2,
+	HSA_SIGNAL_CONDITION_GTE = 3
+} hsa_signal_condition_t;
+
+typedef enum {
+	HSA_WAIT_STATE_BLOCKED = 0,
+	HSA_WAIT_STATE_ACTIVE = 1
+} hsa_wait_state_t;
+
+// runtime
+hsa_status_t hsa_init();
+hsa_status_t hsa_shut_down();
+hsa_status_t hsa_status_string(hsa_status_t status, const char **status_string);
+
+// agents, the FPGA is the only one; HSA_AGENT_INFO_NAME (char[64]),
+// HSA_AGENT_INFO_QUEUES_MAX, HSA_AGENT_INFO_QUEUE_MIN_SIZE and
+// HSA_AGENT_INFO_QUEUE_MAX_SIZE (uint32_t) are supported
+hsa_status_t hsa_iterate_agents(hsa_status_t (*callback)(hsa_agent_t agent, void *data), void *data);
+hsa_status_t hsa_agent_get_info(hsa_agent_t agent, hsa_agent_info_t attribute, void *value);
+
+// queues, the packet processor serves one ring of MAX_QUEUE_LENGTH slots and
+// masks the indices with it, so <size> must be MAX_QUEUE_LENGTH; the segment
+// sizes must be 0 or UINT32_MAX and the callback is never called
+hsa_status_t hsa_queue_create(hsa_agent_t agent, uint32_t size, hsa_queue_type_t type,
+			      void (*callback)(hsa_status_t status, hsa_queue_t *source, void *data), void *data,
+			      uint32_t private_segment_size, uint32_t group_segment_size, hsa_queue_t **queue);
+hsa_status_t hsa_queue_destroy(hsa_queue_t *queue);
+uint64_t hsa_queue_load_read_index_scacquire(const hsa_queue_t *queue);
+uint64_t hsa_queue_load_write_index_relaxed(const hsa_queue_t *queue);
+uint64_t hsa_queue_load_write_index_scacquire(const hsa_queue_t *queue);
+void hsa_queue_store_write_index_relaxed(const hsa_queue_t *queue, uint64_t value);
+void hsa_queue_store_write_index_screlease(const hsa_queue_t *queue, uint64_t value);
+uint64_t hsa_queue_add_write_index_relaxed(const hsa_queue_t *queue, uint64_t value);
+uint64_t hsa_queue_add_write_index_scacq_screl(const hsa_queue_t *queue, uint64_t value);
+uint64_t hsa_queue_cas_write_index_scacq_screl(const hsa_queue_t *queue, uint64_t expected, uint64_t value);
+
+// signals, the handle is the address of the 64 bit value that the packet
+// processor decrements on completion; waits poll and then block, see
+// hsa_ext_fpga.h for the spin budget and waits for several signals
+hsa_status_t hsa_signal_create(hsa_signal_value_t initial_value, uint32_t num_consumers, const hsa_agent_t *consumers, hsa_signal_t *signal);
+hsa_status_t hsa_signal_destroy(hsa_signal_t signal);
+hsa_signal_value_t hsa_signal_load_relaxed(hsa_signal_t signal);
+hsa_signal_value_t hsa_signal_load_scacquire(hsa_signal_t signal);
+void hsa_signal_store_relaxed(hsa_signal_t signal, hsa_signal_value_t value);
+void hsa_signal_store_screlease(hsa_signal_t signal, hsa_signal_value_t value);
+void hsa_signal_add_screlease(hsa_signal_t signal, hsa_signal_value_t value);
+void hsa_signal_subtract_screlease(hsa_signal_t signal, hsa_signal_value_t value);
+hsa_signal_value_t hsa_signal_wait_scacquire(hsa_signal_t signal, hsa_signal_condition_t condition, hsa_signal_value_t compare_value,
+					     uint64_t timeout_hint, hsa_wait_state_t wait_state_hint);
+
+// packet header and setup in one word, for a release store to the first 32 bits of a slot
+static inline uint32_t hsa_packet_header_setup(hsa_packet_type_t type, bool barrier, hsa_fence_scope_t acquire, hsa_fence_scope_t release, uint16_t setup){
+	const uint16_t header = (type << HSA_PACKET_HEADER_TYPE) | ((barrier ? 1 : 0) << HSA_PACKET_HEADER_BARRIER)
+				| (acquire << HSA_PACKET_HEADER_SCACQUIRE_FENCE_SCOPE) | (release << HSA_PACKET_HEADER_SCRELEASE_FENCE_SCOPE);
+	return ((uint32_t)setup << 16) | header;
+}
+
+static inline void hsa_packet_publish(void *packet, uint32_t header_setup){
+	__atomic_store_n((uint32_t*)packet, header_setup, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,134 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HSA_EXT_FPGA_H_
+#define HSA_EXT_FPGA_H_
+
+#include "hsa.h"
+
+// Extensions of the FPGA runtime.
+//
+// A waiter with HSA_WAIT_STATE_BLOCKED polls the signals for the spin budget
+// and then sleeps on a futex until a completion or a host store changes one
+// of them, so many frames can be in flight per host thread without a core
+// spinning for each. HSA_WAIT_STATE_ACTIVE polls until the timeout. Timeouts
+// are in nanoseconds, UINT64_MAX waits forever.
+
+// spin budget of blocking waits in ns, 0 blocks right away; the default is
+// taken from the environment variable HSA_FPGA_WAIT_SPIN_NS at hsa_init()
+void hsa_fpga_set_wait_spin(uint64_t nanoseconds);
+
+// Waits until one of the <count> signals meets its condition. Returns its
+// index and its value in <satisfying_value> (may be NULL), UINT32_MAX on
+// timeout.
+uint32_t hsa_fpga_signal_wait_any(uint32_t count, const hsa_signal_t *signals, const hsa_signal_condition_t *conditions,
+				  const hsa_signal_value_t *compare_values, uint64_t timeout_hint, hsa_wait_state_t wait_state_hint,
+				  hsa_signal_value_t *satisfying_value);
+
+// Waits until each of the <count> signals has met its condition. A signal
+// is not looked at again once it met it, completion signals only move
+// towards their condition. Returns the number of leading signals that met
+// them, <count> unless the wait timed out.
+uint32_t hsa_fpga_signal_wait_all(uint32_t count, const hsa_signal_t *signals, const hsa_signal_condition_t *conditions,
+				  const hsa_signal_value_t *compare_values, uint64_t timeout_hint, hsa_wait_state_t wait_state_hint);
+
+// Hybrid scheduling of image filters. A frame goes to the agent through the
+// AQL queue or to a pool of CPU workers that run the host filters of
+// tools/common/filters, whichever is estimated to finish it first:
+//
+//   agent	pixels ahead of it in the ring plus its own, times the ns per
+//		pixel observed from READ_INDEX progress; a head packet that
+//		takes longer than that (a stalled dispatch window) slows the
+//		estimate down to what it observes
+//   CPU	ns of the queued CPU frames divided by the workers plus its
+//		own, with ns per pixel measured per filter and color model
+//
+// A full ring always sends the frame to the CPU, so a burst waits for CPU
+// capacity instead of queue slots. Either way the completion signal is
+// decremented by one once <dst> is written, a CPU frame is not ordered with
+// the packets of the queue. The CPU reads the images through the addresses
+// in the kernel arguments, like the model backend does.
+//
+// HSA_FPGA_CPU_WORKERS sets the number of workers (default one less than
+// the cores, at least one), HSA_FPGA_AGENT_PIXEL_NS the initial agent cost
+// (default one pixel per cycle at 100 MHz).
+
+typedef enum {
+	HSA_FPGA_SCHEDULE_AUTO = 0,	// the estimate decides
+	HSA_FPGA_SCHEDULE_AGENT = 1,	// always the queue, waits for a free slot
+	HSA_FPGA_SCHEDULE_CPU = 2	// always the CPU workers
+} hsa_fpga_schedule_t;
+
+typedef enum {
+	HSA_FPGA_PLACEMENT_AGENT = 0,
+	HSA_FPGA_PLACEMENT_CPU = 1
+} hsa_fpga_placement_t;
+
+typedef struct hsa_fpga_scheduler_info_s {
+	uint64_t agent_frames;
+	uint64_t cpu_frames;
+	double agent_pixel_ns;		// current estimate
+	uint32_t cpu_workers;
+} hsa_fpga_scheduler_info_t;
+
+// Dispatches the filter <kernel_object> of hsa_fpga.h on a <width> x
+// <height> image with the kernel arguments of the packet processor. The
+// arguments and the images must stay valid until <completion> (may be 0)
+// is decremented. <placement> (may be NULL) tells where the frame went.
+// HSA_STATUS_ERROR_INVALID_ARGUMENT if the CPU is asked for a kernel or
+// arguments the host filters do not support; AUTO sends those to the agent,
+// and also the filters the agent computes differently (filter_deviation()
+// of tools/common/filters), so a frame has the same pixels wherever it runs.
+hsa_status_t hsa_fpga_dispatch_filter(hsa_queue_t *queue, uint64_t kernel_object, const void *kernargs, uint32_t width, uint32_t height,
+				      hsa_signal_t completion, hsa_fpga_schedule_t schedule, hsa_fpga_placement_t *placement);
+
+void hsa_fpga_scheduler_get_info(hsa_fpga_scheduler_info_t *info);
+
+// DMA-ready images. Images live in buffers aligned to and padded to
+// HSA_FPGA_IMAGE_ALIGNMENT bytes, the padding is 0. The conversions write
+// the pixels in the device format with SSE4.1 where the CPU has it, rows of
+// the source are <stride> bytes apart. UINT8_RGBX keeps four bytes per
+// pixel, the firmware moves such images in whole 64 byte bursts without a
+// byte-wise tail.
+
+#define HSA_FPGA_IMAGE_ALIGNMENT 64
+
+typedef enum {
+	HSA_FPGA_UINT16_GRAY_SCALE = 0x0,
+	HSA_FPGA_UINT8_RGB = 0x1,
+	HSA_FPGA_UINT8_RGBX = 0x2		// RGB padded to 32 bit per pixel, the fourth byte 0
+} hsa_fpga_colormodel_t;
+
+// bytes of the buffer of an image including the padding, 0 for an unknown color model
+uint64_t hsa_fpga_image_size(uint32_t width, uint32_t height, hsa_fpga_colormodel_t colormodel);
+
+// a zeroed buffer for an image, NULL if the image is empty or memory is short
+void *hsa_fpga_image_alloc(uint32_t width, uint32_t height, hsa_fpga_colormodel_t colormodel);
+
+void hsa_fpga_image_free(void *image);
+
+// interleaved RGBA to UINT8_RGB or UINT8_RGBX, alpha is dropped
+hsa_status_t hsa_fpga_convert_rgba(const uint8_t *rgba, uint32_t width, uint32_t height, uint64_t stride,
+				   hsa_fpga_colormodel_t colormodel, void *image);
+
+// three planes R, G and B with the same stride to UINT8_RGB or UINT8_RGBX
+hsa_status_t hsa_fpga_convert_planar(const uint8_t *const planes[3], uint32_t width, uint32_t height, uint64_t stride,
+				     hsa_fpga_colormodel_t colormodel, void *image);
+
+// 8 bit gray to UINT16_GRAY_SCALE, <full_range> maps 255 to 65535 instead of 255
+hsa_status_t hsa_fpga_convert_gray8(const uint8_t *gray, uint32_t width, uint32_t height, uint64_t stride,
+				    bool full_range, void *image);
+
+#endif
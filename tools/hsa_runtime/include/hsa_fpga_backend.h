@@ -0,0 +1,85 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HSA_FPGA_BACKEND_H_
+#define HSA_FPGA_BACKEND_H_
+
+#include <cstdint>
+
+#include "hsa_packets.h"
+
+#ifndef MAX_QUEUE_LENGTH
+#define MAX_QUEUE_LENGTH 128
+#endif
+
+// The runtime sees the device through a backend: a host mapping of the
+// device memory of the packet processor and a doorbell. The queue lives at
+// the start of the device memory in the layout of address_conf.h, so a
+// backend only has to make the mapping coherent with the device and forward
+// doorbells; packets, indices and signals are handled by the runtime.
+//
+//   model	software packet processor in a thread of this process (default)
+//
+// A backend for the PCIe or AXI attached FPGA maps the BAR of the device
+// memory and writes the doorbell to SND_INT. The backend is chosen by the
+// environment variable HSA_FPGA_BACKEND.
+//
+// Only the queue is placed in device memory. Kernel arguments, images and
+// completion signals stay in host memory and packets carry their host
+// virtual addresses, which only the model backend can follow. A hardware
+// backend additionally needs an allocator for device memory behind
+// HSA_FREE_MEM_OFFSET, and the runtime has to place those objects there
+// (or translate them for the IOMMU of the device) before the packet is
+// published.
+
+// offsets into the device memory, see address_conf.h
+#define HSA_AQL_PKT_OFFSET	0
+#define HSA_PASID_BUF_OFFSET	(MAX_QUEUE_LENGTH*PACKETSIZE)
+#define HSA_READ_INDEX_OFFSET	(HSA_PASID_BUF_OFFSET + MAX_QUEUE_LENGTH*4)
+#define HSA_WRITE_INDEX_OFFSET	(HSA_READ_INDEX_OFFSET + 8)
+#define HSA_FREE_MEM_OFFSET	(HSA_WRITE_INDEX_OFFSET + 8)
+
+// size of the simulated DRAM of tb_packet_processor_top
+#define HSA_DEVICE_MEMORY_SIZE	(UINT64_C(4) << 20)
+
+typedef struct hsa_backend_s {
+	const char *name;
+	char *device_memory;			// host mapping of DEF_BASE_DEVICE_MEMORY
+	uint64_t device_memory_size;
+	// tells the device that packets up to <index> are published
+	void (*ring_doorbell)(struct hsa_backend_s *backend, uint64_t index);
+	// stops the device and releases the mapping and the backend itself
+	void (*close)(struct hsa_backend_s *backend);
+	void *state;
+} hsa_backend_t;
+
+// wakes up the host threads waiting for <signal>, a backend calls it after
+// the device changed the value, e.g. from its completion interrupt
+void hsa_fpga_signal_notify(hsa_signal_t signal);
+
+// the backend called <name>, NULL if there is none or it cannot be opened
+hsa_backend_t *hsa_backend_open(const char *name);
+
+hsa_backend_t *hsa_model_open();
+
+// Kernels of the model backend. The model copies the kernel arguments like
+// the packet processor does (20 bytes, 60 for CUSTOM_FILTER3x3 and 124 for
+// CUSTOM_FILTER5x5) and calls the function registered for the kernel object
+// of the packet. Addresses in the arguments are host pointers.
+typedef void (*hsa_model_kernel_t)(const hsa_kernel_dispatch_packet_t *packet, const void *kernargs, void *data);
+
+void hsa_model_register_kernel(uint64_t kernel_object, hsa_model_kernel_t kernel, void *data);
+
+#endif
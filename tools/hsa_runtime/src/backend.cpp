@@ -0,0 +1,43 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <cstring>
+
+#include "hsa_fpga_backend.h"
+
+typedef struct backend_entry_s {
+	const char *name;
+	hsa_backend_t *(*open)();
+} backend_entry_t;
+
+// new backends are added here
+static const backend_entry_t backends[] = {
+	{"model", hsa_model_open},
+};
+
+hsa_backend_t *hsa_backend_open(const char *name){
+	for(const backend_entry_t &entry : backends){
+		if(std::strcmp(entry.name, name) == 0){
+			return entry.open();
+		}
+	}
+	std::cerr << "ERROR: unknown backend " << name << ", available:";
+	for(const backend_entry_t &entry : backends){
+		std::cerr << " " << entry.name;
+	}
+	std::cerr << std::endl;
+	return NULL;
+}
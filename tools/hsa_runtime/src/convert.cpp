@@ -0,0 +1,147 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdlib>
+#include <cstring>
+
+#include "hsa_ext_fpga.h"
+#include "convert.h"
+
+// Conversions into DMA-ready images, see hsa_ext_fpga.h. The images are
+// packed like the device expects them, only the end of the buffer is padded.
+
+void convert_rgba_scalar(const uint8_t *rgba, uint32_t width, bool padded, uint8_t *dst){
+	const unsigned int storage = padded ? 4 : 3;
+	for(uint32_t x=0; x<width; ++x){
+		dst[storage*x] = rgba[4*x];
+		dst[storage*x+1] = rgba[4*x+1];
+		dst[storage*x+2] = rgba[4*x+2];
+		if(padded){
+			dst[4*x+3] = 0;
+		}
+	}
+}
+
+void convert_planar_scalar(const uint8_t *r, const uint8_t *g, const uint8_t *b, uint32_t width, bool padded, uint8_t *dst){
+	const unsigned int storage = padded ? 4 : 3;
+	for(uint32_t x=0; x<width; ++x){
+		dst[storage*x] = r[x];
+		dst[storage*x+1] = g[x];
+		dst[storage*x+2] = b[x];
+		if(padded){
+			dst[4*x+3] = 0;
+		}
+	}
+}
+
+void convert_gray8_scalar(const uint8_t *gray, uint32_t width, bool full_range, uint8_t *dst){
+	for(uint32_t x=0; x<width; ++x){
+		// little endian uint16, 257*v spreads 0..255 over 0..65535
+		dst[2*x] = gray[x];
+		dst[2*x+1] = full_range ? gray[x] : 0;
+	}
+}
+
+const convert_kernels_t convert_scalar = {convert_rgba_scalar, convert_planar_scalar, convert_gray8_scalar};
+
+static const convert_kernels_t &kernels(){
+	static const convert_kernels_t &best = __builtin_cpu_supports("sse4.1") ? convert_sse41 : convert_scalar;
+	return best;
+}
+
+static unsigned int pixel_storage(hsa_fpga_colormodel_t colormodel){
+	switch(colormodel){
+		case HSA_FPGA_UINT16_GRAY_SCALE: return 2;
+		case HSA_FPGA_UINT8_RGB: return 3;
+		case HSA_FPGA_UINT8_RGBX: return 4;
+		default: return 0;
+	}
+}
+
+uint64_t hsa_fpga_image_size(uint32_t width, uint32_t height, hsa_fpga_colormodel_t colormodel){
+	const uint64_t bytes = (uint64_t)width*height*pixel_storage(colormodel);
+	return (bytes + HSA_FPGA_IMAGE_ALIGNMENT-1) & ~(uint64_t)(HSA_FPGA_IMAGE_ALIGNMENT-1);
+}
+
+void *hsa_fpga_image_alloc(uint32_t width, uint32_t height, hsa_fpga_colormodel_t colormodel){
+	const uint64_t size = hsa_fpga_image_size(width, height, colormodel);
+	if(size == 0){
+		return NULL;
+	}
+	void *image = std::aligned_alloc(HSA_FPGA_IMAGE_ALIGNMENT, size);
+	if(image != NULL){
+		std::memset(image, 0, size);
+	}
+	return image;
+}
+
+void hsa_fpga_image_free(void *image){
+	std::free(image);
+}
+
+// zeroes the padding behind the pixels, a reused buffer may hold an older image there
+static void clear_padding(uint8_t *image, uint32_t width, uint32_t height, hsa_fpga_colormodel_t colormodel){
+	const uint64_t bytes = (uint64_t)width*height*pixel_storage(colormodel);
+	std::memset(image + bytes, 0, hsa_fpga_image_size(width, height, colormodel) - bytes);
+}
+
+static bool valid_rgb_target(uint32_t width, uint64_t stride, uint64_t source_storage, hsa_fpga_colormodel_t colormodel, const void *image){
+	return image != NULL && stride >= width*source_storage
+	       && (colormodel == HSA_FPGA_UINT8_RGB || colormodel == HSA_FPGA_UINT8_RGBX);
+}
+
+hsa_status_t hsa_fpga_convert_rgba(const uint8_t *rgba, uint32_t width, uint32_t height, uint64_t stride,
+				   hsa_fpga_colormodel_t colormodel, void *image){
+	if(rgba == NULL || !valid_rgb_target(width, stride, 4, colormodel, image)){
+		return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	const bool padded = (colormodel == HSA_FPGA_UINT8_RGBX);
+	const uint64_t row_bytes = (uint64_t)width*pixel_storage(colormodel);
+	uint8_t *dst = (uint8_t*)image;
+	for(uint32_t y=0; y<height; ++y){
+		kernels().rgba(rgba + y*stride, width, padded, dst + y*row_bytes);
+	}
+	clear_padding(dst, width, height, colormodel);
+	return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t hsa_fpga_convert_planar(const uint8_t *const planes[3], uint32_t width, uint32_t height, uint64_t stride,
+				     hsa_fpga_colormodel_t colormodel, void *image){
+	if(planes == NULL || planes[0] == NULL || planes[1] == NULL || planes[2] == NULL
+	   || !valid_rgb_target(width, stride, 1, colormodel, image)){
+		return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	const bool padded = (colormodel == HSA_FPGA_UINT8_RGBX);
+	const uint64_t row_bytes = (uint64_t)width*pixel_storage(colormodel);
+	uint8_t *dst = (uint8_t*)image;
+	for(uint32_t y=0; y<height; ++y){
+		kernels().planar(planes[0] + y*stride, planes[1] + y*stride, planes[2] + y*stride, width, padded, dst + y*row_bytes);
+	}
+	clear_padding(dst, width, height, colormodel);
+	return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t hsa_fpga_convert_gray8(const uint8_t *gray, uint32_t width, uint32_t height, uint64_t stride,
+				    bool full_range, void *image){
+	if(gray == NULL || image == NULL || stride < width){
+		return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	uint8_t *dst = (uint8_t*)image;
+	for(uint32_t y=0; y<height; ++y){
+		kernels().gray8(gray + y*stride, width, full_range, dst + (uint64_t)y*width*2);
+	}
+	clear_padding(dst, width, height, HSA_FPGA_UINT16_GRAY_SCALE);
+	return HSA_STATUS_SUCCESS;
+}
@@ -0,0 +1,37 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CONVERT_H_
+#define CONVERT_H_
+
+#include <cstdint>
+
+// Row kernels of the pixel conversions, once in plain C++ (convert.cpp) and
+// once with SSE4.1 (convert_sse41.cpp, built with -msse4.1). Each converts
+// <width> pixels of one row, <padded> writes RGBX instead of RGB.
+typedef struct convert_kernels_s {
+	void (*rgba)(const uint8_t *rgba, uint32_t width, bool padded, uint8_t *dst);
+	void (*planar)(const uint8_t *r, const uint8_t *g, const uint8_t *b, uint32_t width, bool padded, uint8_t *dst);
+	void (*gray8)(const uint8_t *gray, uint32_t width, bool full_range, uint8_t *dst);
+} convert_kernels_t;
+
+extern const convert_kernels_t convert_scalar;
+extern const convert_kernels_t convert_sse41;
+
+void convert_rgba_scalar(const uint8_t *rgba, uint32_t width, bool padded, uint8_t *dst);
+void convert_planar_scalar(const uint8_t *r, const uint8_t *g, const uint8_t *b, uint32_t width, bool padded, uint8_t *dst);
+void convert_gray8_scalar(const uint8_t *gray, uint32_t width, bool full_range, uint8_t *dst);
+
+#endif
@@ -0,0 +1,114 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "convert.h"
+
+#ifdef __SSE4_1__
+
+#include <smmintrin.h>
+
+// 16 pixels per step, the scalar kernels take the rest of a row
+
+static void rgba_sse41(const uint8_t *rgba, uint32_t width, bool padded, uint8_t *dst){
+	const uint32_t split = width - width % 16;
+	if(padded){
+		const __m128i rgb = _mm_set1_epi32(0x00FFFFFF);
+		for(uint32_t x=0; x<split; x+=4){
+			_mm_storeu_si128((__m128i*)(dst + 4*x), _mm_and_si128(_mm_loadu_si128((const __m128i*)(rgba + 4*x)), rgb));
+		}
+	}else{
+		// four pixels to twelve bytes in each vector, then three full vectors out of four
+		const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		for(uint32_t x=0; x<split; x+=16){
+			const __m128i s0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(rgba + 4*x)), pack);
+			const __m128i s1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(rgba + 4*x + 16)), pack);
+			const __m128i s2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(rgba + 4*x + 32)), pack);
+			const __m128i s3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(rgba + 4*x + 48)), pack);
+			_mm_storeu_si128((__m128i*)(dst + 3*x), _mm_or_si128(s0, _mm_slli_si128(s1, 12)));
+			_mm_storeu_si128((__m128i*)(dst + 3*x + 16), _mm_or_si128(_mm_srli_si128(s1, 4), _mm_slli_si128(s2, 8)));
+			_mm_storeu_si128((__m128i*)(dst + 3*x + 32), _mm_or_si128(_mm_srli_si128(s2, 8), _mm_slli_si128(s3, 4)));
+		}
+	}
+	convert_rgba_scalar(rgba + 4*split, width - split, padded, dst + (padded ? 4 : 3)*split);
+}
+
+// shuffle of <channel> of 16 pixels into byte 16*<part> onwards of the packed RGB pixels
+static __m128i planar_mask(unsigned int part, unsigned int channel){
+	alignas(16) int8_t mask[16];
+	for(unsigned int k=0; k<16; ++k){
+		const unsigned int byte = 16*part + k;
+		mask[k] = (byte % 3 == channel) ? byte / 3 : -1;
+	}
+	return _mm_load_si128((const __m128i*)mask);
+}
+
+static void planar_sse41(const uint8_t *r, const uint8_t *g, const uint8_t *b, uint32_t width, bool padded, uint8_t *dst){
+	const uint32_t split = width - width % 16;
+	if(padded){
+		const __m128i zero = _mm_setzero_si128();
+		for(uint32_t x=0; x<split; x+=16){
+			const __m128i vr = _mm_loadu_si128((const __m128i*)(r + x));
+			const __m128i vg = _mm_loadu_si128((const __m128i*)(g + x));
+			const __m128i vb = _mm_loadu_si128((const __m128i*)(b + x));
+			const __m128i rg_lo = _mm_unpacklo_epi8(vr, vg);
+			const __m128i rg_hi = _mm_unpackhi_epi8(vr, vg);
+			const __m128i bx_lo = _mm_unpacklo_epi8(vb, zero);
+			const __m128i bx_hi = _mm_unpackhi_epi8(vb, zero);
+			_mm_storeu_si128((__m128i*)(dst + 4*x), _mm_unpacklo_epi16(rg_lo, bx_lo));
+			_mm_storeu_si128((__m128i*)(dst + 4*x + 16), _mm_unpackhi_epi16(rg_lo, bx_lo));
+			_mm_storeu_si128((__m128i*)(dst + 4*x + 32), _mm_unpacklo_epi16(rg_hi, bx_hi));
+			_mm_storeu_si128((__m128i*)(dst + 4*x + 48), _mm_unpackhi_epi16(rg_hi, bx_hi));
+		}
+	}else if(split != 0){
+		__m128i masks[3][3];
+		for(unsigned int part=0; part<3; ++part){
+			for(unsigned int channel=0; channel<3; ++channel){
+				masks[part][channel] = planar_mask(part, channel);
+			}
+		}
+		for(uint32_t x=0; x<split; x+=16){
+			const __m128i vr = _mm_loadu_si128((const __m128i*)(r + x));
+			const __m128i vg = _mm_loadu_si128((const __m128i*)(g + x));
+			const __m128i vb = _mm_loadu_si128((const __m128i*)(b + x));
+			for(unsigned int part=0; part<3; ++part){
+				const __m128i out = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(vr, masks[part][0]), _mm_shuffle_epi8(vg, masks[part][1])),
+								 _mm_shuffle_epi8(vb, masks[part][2]));
+				_mm_storeu_si128((__m128i*)(dst + 3*x + 16*part), out);
+			}
+		}
+	}
+	convert_planar_scalar(r + split, g + split, b + split, width - split, padded, dst + (padded ? 4 : 3)*split);
+}
+
+static void gray8_sse41(const uint8_t *gray, uint32_t width, bool full_range, uint8_t *dst){
+	const uint32_t split = width - width % 16;
+	const __m128i zero = _mm_setzero_si128();
+	for(uint32_t x=0; x<split; x+=16){
+		const __m128i v = _mm_loadu_si128((const __m128i*)(gray + x));
+		const __m128i high = full_range ? v : zero;
+		_mm_storeu_si128((__m128i*)(dst + 2*x), _mm_unpacklo_epi8(v, high));
+		_mm_storeu_si128((__m128i*)(dst + 2*x + 16), _mm_unpackhi_epi8(v, high));
+	}
+	convert_gray8_scalar(gray + split, width - split, full_range, dst + 2*split);
+}
+
+const convert_kernels_t convert_sse41 = {rgba_sse41, planar_sse41, gray8_sse41};
+
+#else
+
+// built without SSE4.1, the runtime does not select it
+const convert_kernels_t convert_sse41 = {convert_rgba_scalar, convert_planar_scalar, convert_gray8_scalar};
+
+#endif
@@ -0,0 +1,259 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "hsa_fpga_backend.h"
+
+// Software model of the packet processor. The device memory is a POSIX
+// shared memory object, by default a private one that is unlinked right
+// away. With HSA_FPGA_SHM=<name> it stays under that name until the backend
+// is closed, so that another process, e.g. a trace tool or a simulator, can
+// attach to the same queue.
+//
+// The model thread takes the packets in order like process_aql_packets()
+// and completes each one before it looks at the next, so the barrier bit
+// holds trivially. It sleeps while the next slot is INVALID and is woken by
+// the doorbell.
+
+#define MODEL_SHM_PREFIX "/hsa_fpga_"
+
+// kernel argument sizes, see process_aql_packets() of the packet processor
+#define KERNARG_SIZE		20
+#define KERNARG_SIZE_CUSTOM3x3	60
+#define KERNARG_SIZE_CUSTOM5x5	124
+#define CUSTOM_FILTER3x3	0x31
+#define CUSTOM_FILTER5x5	0x32
+
+typedef struct model_kernel_s {
+	hsa_model_kernel_t kernel;
+	void *data;
+} model_kernel_t;
+
+typedef struct model_s {
+	hsa_backend_t backend;
+	std::string shm_name;
+	bool shm_keep;
+	std::thread thread;
+	std::mutex lock;
+	std::condition_variable doorbell;
+	uint64_t rings;				// doorbells so far, guarded by lock
+	std::atomic<bool> stop;
+} model_t;
+
+static std::mutex kernels_lock;
+static std::map<uint64_t, model_kernel_t> kernels;
+static std::set<uint64_t> reported_kernels;
+
+void hsa_model_register_kernel(uint64_t kernel_object, hsa_model_kernel_t kernel, void *data){
+	std::lock_guard<std::mutex> guard(kernels_lock);
+	if(kernel == NULL){
+		kernels.erase(kernel_object);
+	}else{
+		kernels[kernel_object] = {kernel, data};
+	}
+}
+
+static bool find_kernel(uint64_t kernel_object, model_kernel_t &kernel){
+	std::lock_guard<std::mutex> guard(kernels_lock);
+	std::map<uint64_t, model_kernel_t>::const_iterator it = kernels.find(kernel_object);
+	if(it == kernels.end()){
+		if(reported_kernels.insert(kernel_object).second){
+			std::cerr << "ERROR: no kernel registered for kernel object " << kernel_object
+				  << ", its packets complete without running" << std::endl;
+		}
+		return false;
+	}
+	kernel = it->second;
+	return true;
+}
+
+static void run_dispatch(const hsa_kernel_dispatch_packet_t *packet){
+	uint8_t kernargs[KERNARG_SIZE_CUSTOM5x5];
+	size_t size = KERNARG_SIZE;
+	if(packet->kernel_object == CUSTOM_FILTER3x3){
+		size = KERNARG_SIZE_CUSTOM3x3;
+	}else if(packet->kernel_object == CUSTOM_FILTER5x5){
+		size = KERNARG_SIZE_CUSTOM5x5;
+	}
+	std::memset(kernargs, 0, sizeof(kernargs));
+	if(packet->kernarg_address != NULL){
+		std::memcpy(kernargs, packet->kernarg_address, size);
+	}
+	model_kernel_t kernel;
+	if(find_kernel(packet->kernel_object, kernel)){
+		kernel.kernel(packet, kernargs, kernel.data);
+	}
+}
+
+// true once the dependencies of a barrier packet are met, <all> for barrier-and
+static bool barrier_ready(const hsa_barrier_and_packet_t *packet, bool all){
+	bool any_set = false;
+	bool any_pending = false;
+	for(unsigned int i=0; i<5; ++i){
+		if(packet->dep_signal[i].handle == 0){
+			continue;
+		}
+		if(__atomic_load_n((int64_t*)packet->dep_signal[i].handle, __ATOMIC_ACQUIRE) == 0){
+			any_set = true;
+		}else{
+			any_pending = true;
+		}
+	}
+	return all ? !any_pending : (any_set || !any_pending);
+}
+
+// executes the packet in <slot>, false if the model was stopped while it waited
+static bool process_packet(model_t *model, char *slot, unsigned int type){
+	switch(type){
+		case HSA_PACKET_TYPE_KERNEL_DISPATCH:
+			run_dispatch((const hsa_kernel_dispatch_packet_t*)slot);
+			break;
+		case HSA_PACKET_TYPE_BARRIER_AND:
+		case HSA_PACKET_TYPE_BARRIER_OR:
+			while(!barrier_ready((const hsa_barrier_and_packet_t*)slot, type == HSA_PACKET_TYPE_BARRIER_AND)){
+				if(model->stop.load()){
+					return false;
+				}
+				std::this_thread::yield();
+			}
+			break;
+		default:
+			break;
+	}
+	return true;
+}
+
+static void model_run(model_t *model){
+	char *memory = model->backend.device_memory;
+	uint64_t *read_index = (uint64_t*)(memory + HSA_READ_INDEX_OFFSET);
+	uint64_t seen = 0;
+	while(true){
+		const uint64_t index = __atomic_load_n(read_index, __ATOMIC_RELAXED);
+		char *slot = memory + HSA_AQL_PKT_OFFSET + PACKETSIZE*(index & (MAX_QUEUE_LENGTH-1));
+		const uint32_t header = __atomic_load_n((uint32_t*)slot, __ATOMIC_ACQUIRE);
+		const unsigned int type = (header >> HSA_PACKET_HEADER_TYPE) & ((1 << HSA_PACKET_HEADER_WIDTH_TYPE)-1);
+		if(type == HSA_PACKET_TYPE_INVALID){
+			std::unique_lock<std::mutex> guard(model->lock);
+			// a doorbell rung since the last look may be for this slot
+			model->doorbell.wait(guard, [&]{ return model->rings != seen || model->stop.load(); });
+			if(model->stop.load()){
+				return;
+			}
+			seen = model->rings;
+			continue;
+		}
+		if(!process_packet(model, slot, type)){
+			return;
+		}
+		const uint64_t signal = ((hsa_kernel_dispatch_packet_t*)slot)->completion_signal.handle;
+
+		// release the slot before the completion, a waiter may reuse it right away
+		__atomic_store_n((uint16_t*)slot, (uint16_t)HSA_PACKET_TYPE_INVALID, __ATOMIC_RELAXED);
+		__atomic_store_n(read_index, index+1, __ATOMIC_RELEASE);
+		if(signal != 0){
+			__atomic_fetch_sub((int64_t*)signal, 1, __ATOMIC_RELEASE);
+			hsa_fpga_signal_notify({signal});
+		}
+	}
+}
+
+static void model_ring_doorbell(hsa_backend_t *backend, uint64_t index){
+	// the worker reads WRITE_INDEX itself, a ring only wakes it up
+	(void)index;
+	model_t *model = (model_t*)backend->state;
+	{
+		std::lock_guard<std::mutex> guard(model->lock);
+		++model->rings;
+	}
+	model->doorbell.notify_one();
+}
+
+static void model_close(hsa_backend_t *backend){
+	model_t *model = (model_t*)backend->state;
+	{
+		std::lock_guard<std::mutex> guard(model->lock);
+		model->stop.store(true);
+	}
+	model->doorbell.notify_one();
+	model->thread.join();
+	munmap(backend->device_memory, backend->device_memory_size);
+	if(model->shm_keep){
+		shm_unlink(model->shm_name.c_str());
+	}
+	delete model;
+}
+
+hsa_backend_t *hsa_model_open(){
+	const char *name = std::getenv("HSA_FPGA_SHM");
+	model_t *model = new model_t;
+	model->shm_keep = (name != NULL);
+	model->shm_name = model->shm_keep ? std::string(name) : MODEL_SHM_PREFIX + std::to_string(getpid());
+	if(model->shm_name[0] != '/'){
+		model->shm_name = "/" + model->shm_name;
+	}
+
+	const int fd = shm_open(model->shm_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if(fd < 0){
+		std::cerr << "ERROR: cannot create shared memory " << model->shm_name << ": " << std::strerror(errno) << std::endl;
+		delete model;
+		return NULL;
+	}
+	void *memory = MAP_FAILED;
+	if(ftruncate(fd, HSA_DEVICE_MEMORY_SIZE) == 0){
+		memory = mmap(NULL, HSA_DEVICE_MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	if(memory == MAP_FAILED){
+		std::cerr << "ERROR: cannot map shared memory " << model->shm_name << ": " << std::strerror(errno) << std::endl;
+	}
+	close(fd);
+	if(!model->shm_keep || memory == MAP_FAILED){
+		shm_unlink(model->shm_name.c_str());
+	}
+	if(memory == MAP_FAILED){
+		delete model;
+		return NULL;
+	}
+
+	model->backend.name = "model";
+	model->backend.device_memory = (char*)memory;
+	model->backend.device_memory_size = HSA_DEVICE_MEMORY_SIZE;
+	model->backend.ring_doorbell = model_ring_doorbell;
+	model->backend.close = model_close;
+	model->backend.state = model;
+	model->rings = 0;
+	model->stop.store(false);
+
+	// an INVALID ring before the packet processor starts
+	for(uint64_t i=0; i<MAX_QUEUE_LENGTH; ++i){
+		*(uint16_t*)(model->backend.device_memory + HSA_AQL_PKT_OFFSET + PACKETSIZE*i) = HSA_PACKET_TYPE_INVALID;
+	}
+	model->thread = std::thread(model_run, model);
+	return &model->backend;
+}
@@ -0,0 +1,309 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "hsa.h"
+#include "hsa_fpga_backend.h"
+#include "scheduler.h"
+#include "signal.h"
+
+#define DEFAULT_BACKEND "model"
+#define AGENT_HANDLE 1
+#define AGENT_NAME "hsa_fpga"
+#define AGENT_VENDOR_NAME "FAU"
+
+static std::mutex runtime_lock;
+static unsigned int init_count = 0;
+static hsa_backend_t *backend = NULL;
+static hsa_queue_t queue;
+static bool queue_created = false;
+static signal_t doorbell;
+
+// Signals are recycled but never freed. The device may still notify the
+// waiters of a signal after one of them saw the completion and destroyed it,
+// for a recycled signal that is only a spurious wakeup.
+static std::mutex signals_lock;
+static std::vector<signal_t*> free_signals;
+
+static uint64_t *read_index(const hsa_queue_t *queue){
+	return (uint64_t*)((char*)queue->base_address - HSA_AQL_PKT_OFFSET + HSA_READ_INDEX_OFFSET);
+}
+
+static uint64_t *write_index(const hsa_queue_t *queue){
+	return (uint64_t*)((char*)queue->base_address - HSA_AQL_PKT_OFFSET + HSA_WRITE_INDEX_OFFSET);
+}
+
+static bool is_doorbell(hsa_signal_t signal){
+	return signal.handle == (uint64_t)&doorbell.value;
+}
+
+hsa_status_t hsa_init(){
+	std::lock_guard<std::mutex> guard(runtime_lock);
+	if(init_count == 0){
+		signal_wait_init();
+		scheduler_init();
+		const char *name = std::getenv("HSA_FPGA_BACKEND");
+		backend = hsa_backend_open(name != NULL ? name : DEFAULT_BACKEND);
+		if(backend == NULL){
+			return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
+		}
+	}
+	++init_count;
+	return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t hsa_shut_down(){
+	std::lock_guard<std::mutex> guard(runtime_lock);
+	if(init_count == 0){
+		return HSA_STATUS_ERROR_NOT_INITIALIZED;
+	}
+	if(--init_count == 0){
+		scheduler_shut_down();
+		backend->close(backend);
+		backend = NULL;
+		queue_created = false;
+	}
+	return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t hsa_status_string(hsa_status_t status, const char **status_string){
+	if(status_string == NULL){
+		return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	switch(status){
+		case HSA_STATUS_SUCCESS: *status_string = "success"; break;
+		case HSA_STATUS_INFO_BREAK: *status_string = "iteration stopped"; break;
+		case HSA_STATUS_ERROR: *status_string = "generic error"; break;
+		case HSA_STATUS_ERROR_INVALID_ARGUMENT: *status_string = "invalid argument"; break;
+		case HSA_STATUS_ERROR_INVALID_QUEUE_CREATION: *status_string = "invalid queue creation"; break;
+		case HSA_STATUS_ERROR_OUT_OF_RESOURCES: *status_string = "out of resources"; break;
+		case HSA_STATUS_ERROR_INVALID_AGENT: *status_string = "invalid agent"; break;
+		case HSA_STATUS_ERROR_INVALID_SIGNAL: *status_string = "invalid signal"; break;
+		case HSA_STATUS_ERROR_INVALID_QUEUE: *status_string = "invalid queue"; break;
+		case HSA_STATUS_ERROR_NOT_INITIALIZED: *status_string = "runtime not initialized"; break;
+		default: return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t hsa_iterate_agents(hsa_status_t (*callback)(hsa_agent_t agent, void *data), void *data){
+	if(backend == NULL){
+		return HSA_STATUS_ERROR_NOT_INITIALIZED;
+	}
+	if(callback == NULL){
+		return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	const hsa_status_t status = callback({AGENT_HANDLE}, data);
+	return (status == HSA_STATUS_INFO_BREAK) ? HSA_STATUS_SUCCESS : status;
+}
+
+hsa_status_t hsa_agent_get_info(hsa_agent_t agent, hsa_agent_info_t attribute, void *value){
+	if(backend == NULL){
+		return HSA_STATUS_ERROR_NOT_INITIALIZED;
+	}
+	if(agent.handle != AGENT_HANDLE){
+		return HSA_STATUS_ERROR_INVALID_AGENT;
+	}
+	if(value == NULL){
+		return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	switch(attribute){
+		case HSA_AGENT_INFO_NAME:
+			std::memset(value, 0, 64);
+			std::strncpy((char*)value, AGENT_NAME, 63);
+			break;
+		case HSA_AGENT_INFO_VENDOR_NAME:
+			std::memset(value, 0, 64);
+			std::strncpy((char*)value, AGENT_VENDOR_NAME, 63);
+			break;
+		case HSA_AGENT_INFO_QUEUES_MAX: *(uint32_t*)value = 1; break;
+		case HSA_AGENT_INFO_QUEUE_MIN_SIZE: *(uint32_t*)value = MAX_QUEUE_LENGTH; break;
+		case HSA_AGENT_INFO_QUEUE_MAX_SIZE: *(uint32_t*)value = MAX_QUEUE_LENGTH; break;
+		case HSA_AGENT_INFO_QUEUE_TYPE: *(uint32_t*)value = HSA_QUEUE_TYPE_MULTI; break;
+		default: return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t hsa_queue_create(hsa_agent_t agent, uint32_t size, hsa_queue_type_t type,
+			      void (*callback)(hsa_status_t status, hsa_queue_t *source, void *data), void *data,
+			      uint32_t private_segment_size, uint32_t group_segment_size, hsa_queue_t **queue_out){
+	std::lock_guard<std::mutex> guard(runtime_lock);
+	if(backend == NULL){
+		return HSA_STATUS_ERROR_NOT_INITIALIZED;
+	}
+	if(agent.handle != AGENT_HANDLE){
+		return HSA_STATUS_ERROR_INVALID_AGENT;
+	}
+	// the packet processor masks the indices with MAX_QUEUE_LENGTH, a smaller ring would overrun
+	if(queue_out == NULL || size != MAX_QUEUE_LENGTH){
+		return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	// the filters have no private or group segment, UINT32_MAX asks for the default
+	if((private_segment_size != 0 && private_segment_size != UINT32_MAX)
+	   || (group_segment_size != 0 && group_segment_size != UINT32_MAX)){
+		return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	// neither backend reports asynchronous queue errors, so the callback is never called
+	(void)callback;
+	(void)data;
+	if(queue_created){
+		return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
+	}
+
+	char *memory = backend->device_memory;
+	for(uint64_t i=0; i<MAX_QUEUE_LENGTH; ++i){
+		char *slot = memory + HSA_AQL_PKT_OFFSET + PACKETSIZE*i;
+		// the packet processor may be polling the header already
+		__atomic_store_n((uint32_t*)slot, (uint32_t)HSA_PACKET_TYPE_INVALID, __ATOMIC_RELAXED);
+		std::memset(slot + 4, 0, PACKETSIZE - 4);
+	}
+	// all packets belong to the process with PASID 0
+	std::memset(memory + HSA_PASID_BUF_OFFSET, 0, MAX_QUEUE_LENGTH*4);
+	__atomic_store_n((uint64_t*)(memory + HSA_READ_INDEX_OFFSET), 0, __ATOMIC_RELAXED);
+	__atomic_store_n((uint64_t*)(memory + HSA_WRITE_INDEX_OFFSET), 0, __ATOMIC_RELEASE);
+
+	doorbell.value = 0;
+	doorbell.event = 0;
+	doorbell.waiters = 0;
+	queue.type = type;
+	queue.features = HSA_QUEUE_FEATURE_KERNEL_DISPATCH;
+	queue.base_address = memory + HSA_AQL_PKT_OFFSET;
+	queue.doorbell_signal.handle = (uint64_t)&doorbell.value;
+	queue.size = MAX_QUEUE_LENGTH;
+	queue.reserved1 = 0;
+	queue.id = 0;
+	queue_created = true;
+	*queue_out = &queue;
+	return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t hsa_queue_destroy(hsa_queue_t *queue_in){
+	std::lock_guard<std::mutex> guard(runtime_lock);
+	if(!queue_created || queue_in != &queue){
+		return HSA_STATUS_ERROR_INVALID_QUEUE;
+	}
+	queue_created = false;
+	return HSA_STATUS_SUCCESS;
+}
+
+uint64_t hsa_queue_load_read_index_scacquire(const hsa_queue_t *queue){
+	return __atomic_load_n(read_index(queue), __ATOMIC_ACQUIRE);
+}
+
+uint64_t hsa_queue_load_write_index_relaxed(const hsa_queue_t *queue){
+	return __atomic_load_n(write_index(queue), __ATOMIC_RELAXED);
+}
+
+uint64_t hsa_queue_load_write_index_scacquire(const hsa_queue_t *queue){
+	return __atomic_load_n(write_index(queue), __ATOMIC_ACQUIRE);
+}
+
+void hsa_queue_store_write_index_relaxed(const hsa_queue_t *queue, uint64_t value){
+	__atomic_store_n(write_index(queue), value, __ATOMIC_RELAXED);
+}
+
+void hsa_queue_store_write_index_screlease(const hsa_queue_t *queue, uint64_t value){
+	__atomic_store_n(write_index(queue), value, __ATOMIC_RELEASE);
+}
+
+uint64_t hsa_queue_add_write_index_relaxed(const hsa_queue_t *queue, uint64_t value){
+	return __atomic_fetch_add(write_index(queue), value, __ATOMIC_RELAXED);
+}
+
+uint64_t hsa_queue_add_write_index_scacq_screl(const hsa_queue_t *queue, uint64_t value){
+	return __atomic_fetch_add(write_index(queue), value, __ATOMIC_ACQ_REL);
+}
+
+uint64_t hsa_queue_cas_write_index_scacq_screl(const hsa_queue_t *queue, uint64_t expected, uint64_t value){
+	__atomic_compare_exchange_n(write_index(queue), &expected, value, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+	return expected;
+}
+
+hsa_status_t hsa_signal_create(hsa_signal_value_t initial_value, uint32_t num_consumers, const hsa_agent_t *consumers, hsa_signal_t *signal){
+	if(signal == NULL || (num_consumers > 0 && consumers == NULL)){
+		return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	signal_t *s = NULL;
+	{
+		std::lock_guard<std::mutex> guard(signals_lock);
+		if(!free_signals.empty()){
+			s = free_signals.back();
+			free_signals.pop_back();
+		}
+	}
+	if(s == NULL){
+		s = new(std::nothrow) signal_t;
+		if(s == NULL){
+			return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
+		}
+		s->event = 0;
+		s->waiters = 0;
+	}
+	__atomic_store_n(&s->value, initial_value, __ATOMIC_RELAXED);
+	signal->handle = (uint64_t)&s->value;
+	return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t hsa_signal_destroy(hsa_signal_t signal){
+	if(signal.handle == 0 || is_doorbell(signal)){
+		return HSA_STATUS_ERROR_INVALID_SIGNAL;
+	}
+	std::lock_guard<std::mutex> guard(signals_lock);
+	free_signals.push_back(signal_of(signal));
+	return HSA_STATUS_SUCCESS;
+}
+
+hsa_signal_value_t hsa_signal_load_relaxed(hsa_signal_t signal){
+	return __atomic_load_n((hsa_signal_value_t*)signal.handle, __ATOMIC_RELAXED);
+}
+
+hsa_signal_value_t hsa_signal_load_scacquire(hsa_signal_t signal){
+	return __atomic_load_n((hsa_signal_value_t*)signal.handle, __ATOMIC_ACQUIRE);
+}
+
+void hsa_signal_store_relaxed(hsa_signal_t signal, hsa_signal_value_t value){
+	__atomic_store_n((hsa_signal_value_t*)signal.handle, value, __ATOMIC_RELAXED);
+	if(is_doorbell(signal)){
+		backend->ring_doorbell(backend, value);
+	}else{
+		signal_notify(signal_of(signal));
+	}
+}
+
+void hsa_signal_store_screlease(hsa_signal_t signal, hsa_signal_value_t value){
+	__atomic_store_n((hsa_signal_value_t*)signal.handle, value, __ATOMIC_RELEASE);
+	if(is_doorbell(signal)){
+		backend->ring_doorbell(backend, value);
+	}else{
+		signal_notify(signal_of(signal));
+	}
+}
+
+void hsa_signal_add_screlease(hsa_signal_t signal, hsa_signal_value_t value){
+	__atomic_fetch_add((hsa_signal_value_t*)signal.handle, value, __ATOMIC_RELEASE);
+	signal_notify(signal_of(signal));
+}
+
+void hsa_signal_subtract_screlease(hsa_signal_t signal, hsa_signal_value_t value){
+	__atomic_fetch_sub((hsa_signal_value_t*)signal.handle, value, __ATOMIC_RELEASE);
+	signal_notify(signal_of(signal));
+}
@@ -0,0 +1,349 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hsa.h"
+#include "hsa_ext_fpga.h"
+#include "hsa_fpga_backend.h"
+#include "filters.h"
+#include "scheduler.h"
+
+// Placement of filter frames between the agent and the CPU, see
+// hsa_ext_fpga.h. The scheduler remembers the pixels of the packets it put
+// into the ring. Whenever it looks at the queue, the pixels of the packets
+// the agent took since the last look and the time in between give the ns
+// per pixel of the agent, as long as the agent had work all the time.
+// Packets put into the ring around the scheduler count with the pixels of
+// the frame that is being placed.
+
+#define DEFAULT_AGENT_PIXEL_NS 10.0
+// weight of a new measurement in the running estimates
+#define COST_SMOOTHING 0.25
+// image of the first measurement of a filter on the CPU
+#define CALIBRATION_WIDTH 256
+#define CALIBRATION_HEIGHT 16
+
+typedef std::chrono::steady_clock clock_type;
+
+typedef struct cpu_frame_s {
+	filter_params_t params;
+	uint32_t width;
+	uint32_t height;
+	const uint8_t *src;
+	uint8_t *dst;
+	hsa_signal_t completion;
+	double estimate_ns;
+} cpu_frame_t;
+
+typedef struct slot_pixels_s {
+	uint64_t index;				// packet the entry belongs to
+	uint64_t pixels;
+} slot_pixels_t;
+
+typedef struct scheduler_s {
+	std::mutex lock;
+	std::condition_variable work;
+	std::deque<cpu_frame_t> frames;
+	std::vector<std::thread> workers;
+	uint32_t worker_count;
+	bool stop;
+	double cpu_backlog_ns;			// estimates of the queued and running CPU frames
+	std::map<uint32_t, double> cpu_pixel_ns;	// per kernel and color model, one worker
+	double agent_pixel_ns;
+	slot_pixels_t slots[MAX_QUEUE_LENGTH];
+	uint64_t sample_read;			// READ_INDEX at the last look
+	clock_type::time_point sample_time;	// of the last progress or since the agent has work
+	bool sample_busy;			// whether the agent had work at the last look
+	uint64_t agent_frames;
+	uint64_t cpu_frames;
+} scheduler_t;
+
+static scheduler_t scheduler;
+
+static uint32_t cost_key(const filter_params_t &params){
+	return ((uint32_t)params.kernel << 8) | params.colormodel;
+}
+
+static bool cpu_supports(uint64_t kernel_object, const void *kernargs, filter_params_t &params){
+	return filter_params_from_kernargs(kernel_object, kernargs, params) && filter_pixel_storage(params.colormodel) != 0
+	       && (params.borderhandling == FILTER_CLAMP_TO_ZERO || params.borderhandling == FILTER_CLAMP_TO_EDGE);
+}
+
+static double elapsed_ns(clock_type::time_point from, clock_type::time_point to){
+	return std::chrono::duration<double, std::nano>(to - from).count();
+}
+
+static void smooth(double &estimate, double measurement){
+	estimate += COST_SMOOTHING * (measurement - estimate);
+}
+
+void scheduler_init(){
+	std::lock_guard<std::mutex> guard(scheduler.lock);
+	scheduler.worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	scheduler.agent_pixel_ns = DEFAULT_AGENT_PIXEL_NS;
+	const char *workers = std::getenv("HSA_FPGA_CPU_WORKERS");
+	const char *pixel_ns = std::getenv("HSA_FPGA_AGENT_PIXEL_NS");
+	try{
+		if(workers != NULL){
+			scheduler.worker_count = std::max(1ul, std::stoul(workers));
+		}
+		if(pixel_ns != NULL){
+			scheduler.agent_pixel_ns = std::stod(pixel_ns);
+		}
+	}catch(const std::exception &e){
+		std::cerr << "ERROR: invalid HSA_FPGA_CPU_WORKERS or HSA_FPGA_AGENT_PIXEL_NS" << std::endl;
+	}
+	scheduler.stop = false;
+	scheduler.cpu_backlog_ns = 0;
+	for(uint64_t i=0; i<MAX_QUEUE_LENGTH; ++i){
+		scheduler.slots[i] = {UINT64_MAX, 0};
+	}
+	scheduler.sample_read = 0;
+	scheduler.sample_time = clock_type::now();
+	scheduler.sample_busy = false;
+	scheduler.agent_frames = 0;
+	scheduler.cpu_frames = 0;
+}
+
+void scheduler_shut_down(){
+	std::vector<std::thread> workers;
+	{
+		std::lock_guard<std::mutex> guard(scheduler.lock);
+		scheduler.stop = true;
+		workers.swap(scheduler.workers);
+	}
+	scheduler.work.notify_all();
+	for(std::thread &worker : workers){
+		worker.join();
+	}
+}
+
+static void cpu_worker(){
+	std::unique_lock<std::mutex> guard(scheduler.lock);
+	while(true){
+		scheduler.work.wait(guard, []{ return !scheduler.frames.empty() || scheduler.stop; });
+		// the frames queued before the shut down are still done
+		if(scheduler.frames.empty()){
+			return;
+		}
+		const cpu_frame_t frame = scheduler.frames.front();
+		scheduler.frames.pop_front();
+		guard.unlock();
+
+		const clock_type::time_point start = clock_type::now();
+		filter_run(frame.params, frame.width, frame.height, frame.src, frame.dst, 1);
+		const double ns = elapsed_ns(start, clock_type::now());
+
+		guard.lock();
+		scheduler.cpu_backlog_ns = std::max(0.0, scheduler.cpu_backlog_ns - frame.estimate_ns);
+		if(frame.width != 0 && frame.height != 0){
+			smooth(scheduler.cpu_pixel_ns[cost_key(frame.params)], ns / ((double)frame.width*frame.height));
+		}
+		guard.unlock();
+		if(frame.completion.handle != 0){
+			hsa_signal_subtract_screlease(frame.completion, 1);
+		}
+		guard.lock();
+	}
+}
+
+// ns per pixel of a filter on one worker, measured on a small image the first time
+static double cpu_pixel_ns(const filter_params_t &params){
+	{
+		std::lock_guard<std::mutex> guard(scheduler.lock);
+		std::map<uint32_t, double>::const_iterator it = scheduler.cpu_pixel_ns.find(cost_key(params));
+		if(it != scheduler.cpu_pixel_ns.end()){
+			return it->second;
+		}
+	}
+	std::vector<uint8_t> src(CALIBRATION_WIDTH*CALIBRATION_HEIGHT*filter_pixel_storage(params.colormodel), 0);
+	std::vector<uint8_t> dst(src.size());
+	double ns = 0;
+	// the first run warms up the caches and the allocator
+	for(int run=0; run<2; ++run){
+		const clock_type::time_point start = clock_type::now();
+		filter_run(params, CALIBRATION_WIDTH, CALIBRATION_HEIGHT, src.data(), dst.data(), 1);
+		ns = elapsed_ns(start, clock_type::now());
+	}
+	std::lock_guard<std::mutex> guard(scheduler.lock);
+	return scheduler.cpu_pixel_ns.emplace(cost_key(params), ns / (CALIBRATION_WIDTH*CALIBRATION_HEIGHT)).first->second;
+}
+
+// pixels of the packets <begin> up to <end> in the ring, <unknown> for a packet the scheduler did not put there
+static uint64_t ring_pixels(uint64_t begin, uint64_t end, uint64_t unknown, bool &complete){
+	uint64_t pixels = 0;
+	complete = true;
+	for(uint64_t i=begin; i<end; ++i){
+		const slot_pixels_t &slot = scheduler.slots[i & (MAX_QUEUE_LENGTH-1)];
+		if(slot.index == i){
+			pixels += slot.pixels;
+		}else{
+			pixels += unknown;
+			complete = false;
+		}
+	}
+	return pixels;
+}
+
+// takes the progress of the agent since the last look into its estimate, holds the lock
+static void agent_sample(clock_type::time_point now, uint64_t read, uint64_t write){
+	if(read != scheduler.sample_read){
+		bool complete = false;
+		const uint64_t pixels = (read - scheduler.sample_read <= MAX_QUEUE_LENGTH) ? ring_pixels(scheduler.sample_read, read, 0, complete) : 0;
+		if(scheduler.sample_busy && complete && pixels != 0){
+			smooth(scheduler.agent_pixel_ns, elapsed_ns(scheduler.sample_time, now) / pixels);
+		}
+		scheduler.sample_read = read;
+		scheduler.sample_time = now;
+	}else if(!scheduler.sample_busy){
+		scheduler.sample_time = now;
+	}
+	scheduler.sample_busy = (write != read);
+}
+
+// ns until the agent would have finished a frame of <pixels> put into the ring now, holds the lock
+static double agent_finish_ns(clock_type::time_point now, uint64_t read, uint64_t write, uint64_t pixels){
+	bool complete;
+	const uint64_t ahead = ring_pixels(read, write, pixels, complete);
+	double pixel_ns = scheduler.agent_pixel_ns;
+	if(write != read){
+		// the head packet takes longer than expected, e.g. no dispatch slot is free
+		const uint64_t head = ring_pixels(read, read+1, pixels, complete);
+		const double stalled_ns = elapsed_ns(scheduler.sample_time, now);
+		if(head != 0 && stalled_ns > head * pixel_ns){
+			pixel_ns = stalled_ns / head;
+		}
+	}
+	return (ahead + pixels) * pixel_ns;
+}
+
+static void dispatch_to_cpu(const filter_params_t &params, const void *kernargs, uint32_t width, uint32_t height,
+			    hsa_signal_t completion, double pixel_ns){
+	const uint64_t *addresses = (const uint64_t*)kernargs;
+	cpu_frame_t frame;
+	frame.params = params;
+	frame.width = width;
+	frame.height = height;
+	frame.src = (const uint8_t*)addresses[0];
+	frame.dst = (uint8_t*)addresses[1];
+	frame.completion = completion;
+	frame.estimate_ns = pixel_ns * width * height;
+	{
+		std::lock_guard<std::mutex> guard(scheduler.lock);
+		while(scheduler.workers.size() < scheduler.worker_count){
+			scheduler.workers.push_back(std::thread(cpu_worker));
+		}
+		scheduler.frames.push_back(frame);
+		scheduler.cpu_backlog_ns += frame.estimate_ns;
+		++scheduler.cpu_frames;
+	}
+	scheduler.work.notify_one();
+}
+
+static void dispatch_to_agent(hsa_queue_t *queue, uint64_t kernel_object, const void *kernargs, uint32_t width, uint32_t height,
+			      hsa_signal_t completion){
+	const uint64_t index = hsa_queue_add_write_index_scacq_screl(queue, 1);
+	while(index - hsa_queue_load_read_index_scacquire(queue) >= queue->size){
+		std::this_thread::yield();
+	}
+	hsa_kernel_dispatch_packet_t *packet = (hsa_kernel_dispatch_packet_t*)queue->base_address + (index & (queue->size-1));
+	packet->workgroup_size_x = 1;
+	packet->workgroup_size_y = 1;
+	packet->workgroup_size_z = 1;
+	packet->grid_size_x = width;
+	packet->grid_size_y = height;
+	packet->grid_size_z = 1;
+	packet->private_segment_size = 0;
+	packet->group_segment_size = 0;
+	packet->kernel_object = kernel_object;
+	// host pointer, see hsa_fpga_backend.h, only the model backend can follow it
+	packet->kernarg_address = (void*)kernargs;
+	packet->completion_signal = completion;
+	{
+		std::lock_guard<std::mutex> guard(scheduler.lock);
+		scheduler.slots[index & (MAX_QUEUE_LENGTH-1)] = {index, (uint64_t)width*height};
+		agent_sample(clock_type::now(), hsa_queue_load_read_index_scacquire(queue), index+1);
+		++scheduler.agent_frames;
+	}
+	hsa_packet_publish(packet, hsa_packet_header_setup(HSA_PACKET_TYPE_KERNEL_DISPATCH, false,
+		HSA_FENCE_SCOPE_SYSTEM, HSA_FENCE_SCOPE_SYSTEM, 2 << HSA_KERNEL_DISPATCH_PACKET_SETUP_DIMENSIONS));
+	hsa_signal_store_screlease(queue->doorbell_signal, index);
+}
+
+hsa_status_t hsa_fpga_dispatch_filter(hsa_queue_t *queue, uint64_t kernel_object, const void *kernargs, uint32_t width, uint32_t height,
+				      hsa_signal_t completion, hsa_fpga_schedule_t schedule, hsa_fpga_placement_t *placement){
+	if(queue == NULL || kernargs == NULL){
+		return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+	filter_params_t params;
+	const bool cpu_capable = cpu_supports(kernel_object, kernargs, params);
+	if(schedule == HSA_FPGA_SCHEDULE_CPU && !cpu_capable){
+		return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+	}
+
+	// the estimate only moves frames the CPU computes like the agent
+	const bool cpu_equivalent = cpu_capable && filter_deviation(params) == NULL;
+	bool on_cpu = (schedule == HSA_FPGA_SCHEDULE_CPU);
+	double pixel_ns = 0;
+	if(on_cpu || (cpu_equivalent && schedule == HSA_FPGA_SCHEDULE_AUTO)){
+		pixel_ns = cpu_pixel_ns(params);
+	}
+	if(cpu_equivalent && schedule == HSA_FPGA_SCHEDULE_AUTO){
+		const uint64_t write = hsa_queue_load_write_index_scacquire(queue);
+		const uint64_t read = hsa_queue_load_read_index_scacquire(queue);
+		const clock_type::time_point now = clock_type::now();
+		std::lock_guard<std::mutex> guard(scheduler.lock);
+		agent_sample(now, read, write);
+		if(write - read >= queue->size){
+			on_cpu = true;
+		}else{
+			const uint64_t pixels = (uint64_t)width*height;
+			const double cpu_ns = scheduler.cpu_backlog_ns / scheduler.worker_count + pixels * pixel_ns;
+			on_cpu = (cpu_ns < agent_finish_ns(now, read, write, pixels));
+		}
+	}
+
+	if(on_cpu){
+		dispatch_to_cpu(params, kernargs, width, height, completion, pixel_ns);
+	}else{
+		dispatch_to_agent(queue, kernel_object, kernargs, width, height, completion);
+	}
+	if(placement != NULL){
+		*placement = on_cpu ? HSA_FPGA_PLACEMENT_CPU : HSA_FPGA_PLACEMENT_AGENT;
+	}
+	return HSA_STATUS_SUCCESS;
+}
+
+void hsa_fpga_scheduler_get_info(hsa_fpga_scheduler_info_t *info){
+	if(info == NULL){
+		return;
+	}
+	std::lock_guard<std::mutex> guard(scheduler.lock);
+	info->agent_frames = scheduler.agent_frames;
+	info->cpu_frames = scheduler.cpu_frames;
+	info->agent_pixel_ns = scheduler.agent_pixel_ns;
+	info->cpu_workers = scheduler.worker_count;
+}
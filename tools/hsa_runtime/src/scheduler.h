@@ -0,0 +1,27 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include "hsa.h"
+
+// reads HSA_FPGA_CPU_WORKERS and HSA_FPGA_AGENT_PIXEL_NS at hsa_init()
+void scheduler_init();
+
+// finishes the frames of the CPU workers and stops them, at hsa_shut_down()
+void scheduler_shut_down();
+
+#endif
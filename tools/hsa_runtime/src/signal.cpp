@@ -0,0 +1,217 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hsa_ext_fpga.h"
+#include "hsa_fpga_backend.h"
+#include "signal.h"
+
+// Waiting for signals. A waiter first polls the values, then announces
+// itself in a waiter count and sleeps on an event word that every change of
+// the signal advances. The notifier advances the event before it reads the
+// waiter count and the waiter counts itself before it reads the event, so
+// either the waiter sees the new value or the notifier sees the waiter.
+//
+// Waits for one signal sleep on the event of that signal. Waits for several
+// signals sleep on one event shared by all signals, a wakeup for an
+// unrelated signal only costs another look at the values.
+
+#define DEFAULT_SPIN_NS 20000
+// steady_clock is read once per this many polls
+#define SPIN_CHECK_INTERVAL 64
+
+typedef std::chrono::steady_clock clock_type;
+
+static uint64_t spin_ns = DEFAULT_SPIN_NS;
+static uint32_t any_event = 0;
+static uint32_t any_waiters = 0;
+
+static long futex_wait(uint32_t *word, uint32_t expected, const struct timespec *timeout){
+	return syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0);
+}
+
+static void futex_wake(uint32_t *word){
+	syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+static bool spin_yields = false;
+
+static inline void cpu_relax(){
+	if(spin_yields){
+		// the notifier may need this core
+		std::this_thread::yield();
+		return;
+	}
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+void signal_wait_init(){
+	// a waiter that spins on the only core keeps the device model from running
+	spin_yields = (std::thread::hardware_concurrency() <= 1);
+	const char *value = std::getenv("HSA_FPGA_WAIT_SPIN_NS");
+	if(value == NULL){
+		return;
+	}
+	try{
+		hsa_fpga_set_wait_spin(std::stoull(value));
+	}catch(const std::exception &e){
+		std::cerr << "ERROR: invalid HSA_FPGA_WAIT_SPIN_NS " << value << std::endl;
+	}
+}
+
+void hsa_fpga_set_wait_spin(uint64_t nanoseconds){
+	__atomic_store_n(&spin_ns, nanoseconds, __ATOMIC_RELAXED);
+}
+
+void signal_notify(signal_t *signal){
+	__atomic_fetch_add(&signal->event, 1, __ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&signal->waiters, __ATOMIC_SEQ_CST) != 0){
+		futex_wake(&signal->event);
+	}
+	__atomic_fetch_add(&any_event, 1, __ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&any_waiters, __ATOMIC_SEQ_CST) != 0){
+		futex_wake(&any_event);
+	}
+}
+
+void hsa_fpga_signal_notify(hsa_signal_t signal){
+	signal_notify(signal_of(signal));
+}
+
+static bool condition_met(hsa_signal_condition_t condition, hsa_signal_value_t value, hsa_signal_value_t compare_value){
+	switch(condition){
+		case HSA_SIGNAL_CONDITION_EQ: return value == compare_value;
+		case HSA_SIGNAL_CONDITION_NE: return value != compare_value;
+		case HSA_SIGNAL_CONDITION_LT: return value < compare_value;
+		case HSA_SIGNAL_CONDITION_GTE: return value >= compare_value;
+		default: return true;
+	}
+}
+
+static clock_type::time_point deadline_of(clock_type::time_point start, uint64_t nanoseconds){
+	if(nanoseconds >= (uint64_t)std::chrono::nanoseconds::max().count() / 2){
+		return clock_type::time_point::max();
+	}
+	return start + std::chrono::nanoseconds(nanoseconds);
+}
+
+// Polls <done> until it is true or the spin budget is used up, then sleeps
+// on <event> between looks. False if <timeout_hint> passed first.
+template<typename check_t>
+static bool wait_until(check_t done, uint32_t *event, uint32_t *waiters, uint64_t timeout_hint, hsa_wait_state_t wait_state_hint){
+	const clock_type::time_point start = clock_type::now();
+	const clock_type::time_point deadline = deadline_of(start, timeout_hint);
+	const clock_type::time_point spin_end = (wait_state_hint == HSA_WAIT_STATE_ACTIVE)
+						? deadline : std::min(deadline, deadline_of(start, __atomic_load_n(&spin_ns, __ATOMIC_RELAXED)));
+	for(unsigned int polls=1; ; ++polls){
+		if(done()){
+			return true;
+		}
+		if(spin_yields || polls % SPIN_CHECK_INTERVAL == 0){
+			const clock_type::time_point now = clock_type::now();
+			if(now >= deadline){
+				return false;
+			}
+			if(now >= spin_end){
+				break;
+			}
+		}
+		cpu_relax();
+	}
+
+	__atomic_fetch_add(waiters, 1, __ATOMIC_SEQ_CST);
+	bool met = false;
+	while(true){
+		const uint32_t seen = __atomic_load_n(event, __ATOMIC_SEQ_CST);
+		if(done()){
+			met = true;
+			break;
+		}
+		if(deadline == clock_type::time_point::max()){
+			futex_wait(event, seen, NULL);
+			continue;
+		}
+		const clock_type::time_point now = clock_type::now();
+		if(now >= deadline){
+			break;
+		}
+		const int64_t left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+		const struct timespec timeout = {(time_t)(left / 1000000000), (long)(left % 1000000000)};
+		futex_wait(event, seen, &timeout);
+	}
+	__atomic_fetch_sub(waiters, 1, __ATOMIC_SEQ_CST);
+	return met;
+}
+
+// <timeout_hint> is in nanoseconds, returns the last value seen
+hsa_signal_value_t hsa_signal_wait_scacquire(hsa_signal_t signal, hsa_signal_condition_t condition, hsa_signal_value_t compare_value,
+					     uint64_t timeout_hint, hsa_wait_state_t wait_state_hint){
+	signal_t *s = signal_of(signal);
+	hsa_signal_value_t current;
+	wait_until([&]{
+		current = __atomic_load_n(&s->value, __ATOMIC_ACQUIRE);
+		return condition_met(condition, current, compare_value);
+	}, &s->event, &s->waiters, timeout_hint, wait_state_hint);
+	return current;
+}
+
+uint32_t hsa_fpga_signal_wait_any(uint32_t count, const hsa_signal_t *signals, const hsa_signal_condition_t *conditions,
+				  const hsa_signal_value_t *compare_values, uint64_t timeout_hint, hsa_wait_state_t wait_state_hint,
+				  hsa_signal_value_t *satisfying_value){
+	uint32_t index = UINT32_MAX;
+	hsa_signal_value_t value = 0;
+	wait_until([&]{
+		for(uint32_t i=0; i<count; ++i){
+			value = __atomic_load_n(&signal_of(signals[i])->value, __ATOMIC_ACQUIRE);
+			if(condition_met(conditions[i], value, compare_values[i])){
+				index = i;
+				return true;
+			}
+		}
+		return false;
+	}, &any_event, &any_waiters, timeout_hint, wait_state_hint);
+	if(index != UINT32_MAX && satisfying_value != NULL){
+		*satisfying_value = value;
+	}
+	return index;
+}
+
+uint32_t hsa_fpga_signal_wait_all(uint32_t count, const hsa_signal_t *signals, const hsa_signal_condition_t *conditions,
+				  const hsa_signal_value_t *compare_values, uint64_t timeout_hint, hsa_wait_state_t wait_state_hint){
+	// signals before <first> met their conditions at an earlier look and are
+	// not read again, completions only move a signal towards its condition
+	uint32_t first = 0;
+	wait_until([&]{
+		while(first < count && condition_met(conditions[first], __atomic_load_n(&signal_of(signals[first])->value, __ATOMIC_ACQUIRE), compare_values[first])){
+			++first;
+		}
+		return first == count;
+	}, &any_event, &any_waiters, timeout_hint, wait_state_hint);
+	return first;
+}
@@ -0,0 +1,44 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SIGNAL_H_
+#define SIGNAL_H_
+
+#include <cstdint>
+
+#include "hsa.h"
+
+// The handle of a signal is the address of its value, the packet processor
+// decrements it in place. Behind the value follow the words the host
+// waiters block on. Every signal gets a cache line of its own, the packet
+// processor and the waiters poll them.
+typedef struct alignas(64) signal_s {
+	hsa_signal_value_t value;
+	uint32_t event;			// futex word, advanced on every notification
+	uint32_t waiters;		// threads blocked on event
+} signal_t;
+
+static inline signal_t *signal_of(hsa_signal_t signal){
+	return (signal_t*)signal.handle;
+}
+
+// wakes up the threads that wait for <signal> after its value changed
+void signal_notify(signal_t *signal);
+
+// spin budget of blocking waits in ns, from HSA_FPGA_WAIT_SPIN_NS at hsa_init()
+// or DEFAULT_SPIN_NS, on a single core the waiter yields while it polls
+void signal_wait_init();
+
+#endif
@@ -0,0 +1,232 @@
+#!/bin/bash
+
+# Cycles per pixel of the filter kernels, with a baseline that flags
+# regressions. This is a timing and completion suite, not a differential
+# test of the filter outputs: the accelerator cores of the testbench are
+# handshake stubs and the only pixel comparison is one of the host filters
+# with themselves.
+#
+# usage: cycles_suite.sh <aql2mem> <output dir> [native|vsim|ghdl] [<baseline>]
+#
+# Every case is one dispatch of a filter kernel on a generated image, for all
+# kernels, color models, border modes and the image sizes in SIZES.
+#
+# native  runs the packets with the host-native model of aql2mem -x and
+#         decodes the result with aql2mem -d -r. Both sides use
+#         tools/common/filters, so this checks the packet path of the model
+#         (kernel arguments, image addresses, signals, completion) and not
+#         the filters. It measures no time.
+# vsim    runs sim_packet_processor.do with the ModelSim command line and
+#         decodes its dram_out.mem. The time of the last READ_INDEX note of
+#         tb_packet_processor_top gives cycles/pixel. The output image is
+#         left as it is, so only completion and timing are checked.
+# ghdl    like vsim with sim_packet_processor.sh in benchmark mode, which ends
+#         the simulation once the packet completed. The cycles of its
+#         BENCHMARK line per pixel of the case give cycles/pixel.
+#
+# Cases where the firmware configures the accelerator differently from the
+# host filters (filter_deviation() of tools/common/filters) are reported as
+# DEVIATION and counted apart when the output is compared.
+#
+# environment:
+#   SIZES="16,8 33,17 64,48"   image sizes, width,height
+#   KERNELS, COLORMODELS, BORDERS   restrict the cases
+#   REFERENCE=1                compare the output images with the host filters,
+#                              only native by default, meaningless for vsim and ghdl
+#   TOLERANCE=5                cycles/pixel regression in percent
+#   UPDATE_BASELINE=1          write the measured cycles/pixel to <baseline>
+#   SIM_CYCLES=500000          cycle limit per case of the ghdl backend
+
+if [ -z "$2" ]; then
+	echo "wrong usage: cycles_suite.sh <aql2mem> <output dir> [native|vsim|ghdl] [<baseline>]"
+	exit 1
+fi
+
+aql2mem=$(readlink -f $1)
+output=$2
+backend=${3:-native}
+baseline=$4
+
+SIZES=${SIZES:-"16,8 33,17 64,48"}
+KERNELS=${KERNELS:-"SOBELX3x3 SOBELY3x3 SOBELXY3x3 SOBELX5x5 SOBELY5x5 SOBELXY5x5 GAUSS3x3 GAUSS5x5 MIN_FILTER3x3 MIN_FILTER5x5 MAX_FILTER3x3 MAX_FILTER5x5 MEDIAN_FILTER3x3 MEDIAN_FILTER5x5 CUSTOM_FILTER3x3 CUSTOM_FILTER5x5"}
+COLORMODELS=${COLORMODELS:-"gray16 rgb8 rgbx8"}
+BORDERS=${BORDERS:-"zero edge"}
+if [ "$backend" == "native" ]; then
+	REFERENCE=${REFERENCE:-1}
+else
+	REFERENCE=${REFERENCE:-0}
+fi
+TOLERANCE=${TOLERANCE:-5}
+
+script_dir=$(dirname $(readlink -f $0))
+simulations=$script_dir/../../../lib/packet_processor/hw/simulations
+core_software=$script_dir/../../../lib/packet_processor/sw/core/vsim
+
+if [ "$backend" != "native" ] && [ "$backend" != "vsim" ] && [ "$backend" != "ghdl" ]; then
+	echo "ERROR: unknown backend $backend, use native, vsim or ghdl"
+	exit 1
+fi
+simulator=$backend
+if [ "$backend" == "ghdl" ]; then
+	simulator=${GHDL:-ghdl}
+fi
+if [ "$backend" != "native" ] && ! command -v $simulator > /dev/null; then
+	echo "ERROR: $simulator is not in the PATH"
+	exit 1
+fi
+if [ "$backend" != "native" ] && [ ! -d $core_software ]; then
+	echo "ERROR: no firmware in $core_software, run make in lib/packet_processor/sw/core first"
+	exit 1
+fi
+
+mkdir -p $output
+
+# sharpening and an edge mask, the accelerator applies no normalization to custom filters
+mask3="mask=0,-1,0,-1,5,-1,0,-1,0"
+mask5="mask=$(printf -- '-1,%.0s' $(seq 12))24$(printf -- ',-1%.0s' $(seq 12))"
+
+# simulated time in ns of the last READ_INDEX update in a vsim transcript
+last_completion(){
+	awk '/\*\* Note: READ_INDEX/ { note = 1; next }
+	     note && /Time:/ { t = $3; u = $4; note = 0 }
+	     END {
+		if (t == "") { exit 1 }
+		f = (u == "ps") ? 0.001 : (u == "ns") ? 1 : (u == "us") ? 1000 : (u == "ms") ? 1000000 : 0
+		printf "%.0f\n", t * f
+	     }' $1
+}
+
+# clock cycles from the end of the reset to the last packet in the BENCHMARK
+# line of bench_statistics, which the testbench ends with
+benchmark_cycles(){
+	awk '/BENCHMARK .* packets in / {
+		for (i = 1; i < NF; i++) { if ($(i+1) == "cycles,") { c = $i } }
+	     }
+	     END {
+		if (c == "") { exit 1 }
+		print c
+	     }' $1
+}
+
+# cycles/pixel of <case> in the baseline
+baseline_value(){
+	if [ -n "$baseline" ] && [ -f "$baseline" ]; then
+		awk -v c=$1 '$1 == c { print $2 }' $baseline
+	fi
+}
+
+cases=0
+passed=0
+failed=0
+regressions=0
+deviations=0
+measured=""
+
+for kernel in $KERNELS; do
+	for colormodel in $COLORMODELS; do
+		for border in $BORDERS; do
+			for size in $SIZES; do
+				name=${kernel}_${colormodel}_${border}_${size/,/x}
+				workload=$output/$name.wl
+				options=""
+				case $kernel in
+					CUSTOM_FILTER3x3) options=$mask3 ;;
+					CUSTOM_FILTER5x5) options=$mask5 ;;
+				esac
+				echo "KERNEL_DISPATCH kernel=$kernel src=generated grid=$size colormodel=$colormodel border=$border $options signal=auto" > $workload
+				cases=$((cases+1))
+				status="ok"
+				cpp=""
+				cycles=""
+
+				if [ "$backend" == "native" ]; then
+					dump=$output/$name.mem
+					if ! $aql2mem $dump -f $workload -x > $output/$name.log 2>&1; then
+						status="FAILED (host-native model)"
+					fi
+					timing=""
+				else
+					dump=$simulations/dram_out.mem
+					rm -f $core_software/dram.stim $dump
+					if ! $aql2mem $output/$name.mem -f $workload > $output/$name.log 2>&1; then
+						status="FAILED (aql2mem)"
+					fi
+					cp $output/$name.mem $core_software/dram.mem
+					if [ -f $output/$name.mem.stim ]; then
+						mv $output/$name.mem.stim $core_software/dram.stim
+					fi
+					timing=""
+					if [ "$backend" == "vsim" ]; then
+						(cd $simulations && vsim -c -do "onerror {resume}; do sim_packet_processor.do; quit -f") > $output/$name.vsim.log 2>&1
+						end=$(last_completion $output/$name.vsim.log)
+						timing=${end:+-t $end}
+					else
+						$simulations/sim_packet_processor.sh -b 1 -c ${SIM_CYCLES:-500000} > $output/$name.ghdl.log 2>&1
+						end=$(grep -v INCOMPLETE $output/$name.ghdl.log | benchmark_cycles /dev/stdin)
+						cycles=$end
+					fi
+					if [ -z "$end" ]; then
+						status="FAILED (no packet completed)"
+					fi
+					cp $dump $output/$name.out.mem 2> /dev/null
+					dump=$output/$name.out.mem
+				fi
+
+				if [ "$status" == "ok" ]; then
+					flags=""
+					if [ "$REFERENCE" == "1" ]; then
+						flags="-r"
+					fi
+					$aql2mem $dump -d -f $workload $flags $timing >> $output/$name.log 2>&1
+					result=$?
+					mismatch=$(grep -m 1 "MISMATCH" $output/$name.log)
+					deviation=$(grep -m 1 "DEVIATION" $output/$name.log)
+					if [ -n "$deviation" ] && [ $result -eq 0 -o -n "$mismatch" ]; then
+						status="DEVIATION, ${deviation#*DEVIATION, }"
+						deviations=$((deviations+1))
+					elif [ -n "$mismatch" ]; then
+						status="FAILED ${mismatch#*: }"
+					elif [ $result -ne 0 ]; then
+						status="FAILED (decode, see $name.log)"
+					fi
+					if [ -n "$cycles" ]; then
+						cpp=$(awk -v c=$cycles -v s=$size 'BEGIN { split(s, d, ","); printf "%g\n", c/(d[1]*d[2]) }')
+					else
+						cpp=$(awk '/cycles\/pixel:/ { print $2 }' $output/$name.log | tail -n 1)
+					fi
+				fi
+
+				if [ -n "$cpp" ]; then
+					measured="$measured$name $cpp"$'\n'
+					base=$(baseline_value $name)
+					if [ -n "$base" ] && awk -v c=$cpp -v b=$base -v t=$TOLERANCE 'BEGIN { exit !(c > b*(1+t/100)) }'; then
+						status="$status, REGRESSION against $base"
+						regressions=$((regressions+1))
+					fi
+				fi
+
+				if [ "$status" == "ok" ]; then
+					passed=$((passed+1))
+				elif [ "${status:0:6}" == "FAILED" ]; then
+					failed=$((failed+1))
+				fi
+				printf "%-40s %s%s\n" $name "$status" "${cpp:+, $cpp cycles/pixel}"
+			done
+		done
+	done
+done
+
+if [ "$UPDATE_BASELINE" == "1" ] && [ -n "$baseline" ]; then
+	if [ -n "$measured" ]; then
+		echo "# cycles/pixel per case of cycles_suite.sh" > $baseline
+		printf "%s" "$measured" >> $baseline
+		echo "baseline $baseline updated"
+	else
+		echo "ERROR: no cycles/pixel measured, the baseline is kept"
+	fi
+fi
+
+echo "$cases cases, $passed passed, $failed failed, $deviations deviations, $regressions regressions"
+if [ $failed -ne 0 ] || [ $regressions -ne 0 ]; then
+	exit 1
+fi
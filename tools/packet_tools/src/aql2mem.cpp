@@ -17,8 +17,18 @@
 #include <cstdint>
 #include <string>
 #include <fstream>
+#include <vector>
+#include <map>
 
 #include "hsa_packets.h"
+#include "workload.h"
+#include "generator.h"
+#include "arena.h"
+#include "image.h"
+#include "stimulus.h"
+#include "decode.h"
+#include "native.h"
+#include "mti.h"
 
 #ifndef MAX_QUEUE_LENGTH
 #define MAX_QUEUE_LENGTH 128
@@ -52,63 +62,43 @@ int get_barrier_int_representation(std::string s){
 	}
 }
 
-void printfile(const char *filename, void *packet_begin, uint32_t *pasid, unsigned int length){
-	uint64_t *write = (uint64_t*)packet_begin;
-	unsigned int line = 0;
-	std::ofstream file(filename);
-		
-	// header for modelsim
-	file << "// instance=/tb_packet_processor_top/inst_dram/bram" << std::endl;
-	file << "// format=mti addressradix=d dataradix=h version=1.0 wordsperline=2" << std::endl;
-
-	// write AQL packets
-	for(unsigned int i=0; i<(length*(PACKETSIZE/8))/2; ++i){
-		file << std::dec;
-		file << line << ": ";
-		file.width(16);
-		file.fill('0');
-		file << std::hex;
-		file << *write << " ";	
-		file.width(16);
-		file.fill('0');
-		file << *(write+1) << std::endl;
-		write += 2;
-		line += 2;
+// builds the memory image of the queue and the arena
+void buildimage(mti_image_t &mti, void *packet_begin, uint32_t *pasid, unsigned int length, uint64_t write_index, const arena_t &arena){
+	mti_init(mti);
+	mti.instance = "/tb_packet_processor_top/inst_dram/bram";
+	mti_runs_t &image = mti.runs;
+
+	// AQL packets
+	const uint64_t *packets = (const uint64_t*)packet_begin;
+	image[0].assign(packets, packets + length*(PACKETSIZE/8));
+
+	// PASIDs, two per word, the last line of four is padded with zeros
+	std::vector<uint64_t> &pasid_words = image[MAX_QUEUE_LENGTH*(PACKETSIZE/8)];
+	for(unsigned int i=0; i<length; i+=4){
+		pasid_words.push_back(((uint64_t)pasid[i+1] << 32) | pasid[i]);
+		pasid_words.push_back(((uint64_t)pasid[i+3] << 32) | pasid[i+2]);
 	}
 
-	// write PASIDs
-	line = MAX_QUEUE_LENGTH*(PACKETSIZE/8);
-	unsigned int lines_to_write = (length+(4-(length&3))) >> 2;
-	for(unsigned int i=0; i<lines_to_write; i+=4){
-		file << std::dec;
-		file << line << ": ";
-		file.width(8);
-		file.fill('0');
-		file << std::hex;
-		file << pasid[i+1];
-		file.width(8);
-		file.fill('0');
-		file << pasid[i] << " ";	
-		file.width(8);
-		file.fill('0');
-		file << pasid[i+3];
-		file.width(8);
-		file.fill('0');
-		file << pasid[i+2] << std::endl;
-		line += 2;
+	// READ and WRITE INDEX
+	std::vector<uint64_t> &index_words = image[MAX_QUEUE_LENGTH*(PACKETSIZE/8) + (MAX_QUEUE_LENGTH*4)/8];
+	index_words.push_back(0);
+	index_words.push_back(write_index);
+
+	// kernargs, images and signals placed in the arena, padded to whole lines
+	std::vector<uint64_t> &arena_words = image[(arena.base - BASE_DEVICE_MEMORY)/8];
+	arena_words.assign(((arena.data.size() + 15)/16)*2, 0);
+	for(uint64_t i=0; i<arena.data.size(); ++i){
+		arena_words[i/8] |= (uint64_t)arena.data[i] << (8*(i%8));
 	}
 
-	// write READ and WRITE INDEX
-	line = MAX_QUEUE_LENGTH*(PACKETSIZE/8) + (MAX_QUEUE_LENGTH*4)/8;
-	file << std::dec;
-	file << line << ": ";
-	file.width(16);
-	file.fill('0');
-	file << std::hex;
-	file << 0x0 << " ";
-	file.width(16);
-	file.fill('0');
-	file << length << std::endl;
+	// runs without words are dropped, the arena may be empty
+	for(mti_runs_t::iterator it=image.begin(); it!=image.end(); ){
+		if(it->second.empty()){
+			image.erase(it++);
+		}else{
+			++it;
+		}
+	}
 }
 
 uint16_t header(hsa_packet_type_t type){
@@ -139,10 +129,245 @@ uint16_t setup(uint16_t dims) {
 	return (dims & ((1 << HSA_KERNEL_DISPATCH_PACKET_SETUP_WIDTH_DIMENSIONS)-1)) << HSA_KERNEL_DISPATCH_PACKET_SETUP_DIMENSIONS;
 }
 
+// source image already placed in the arena
+typedef struct placed_image_s {
+	uint64_t address;
+	uint32_t width;
+	uint32_t height;
+	uint8_t colormodel;
+} placed_image_t;
+
+static bool arena_full(const workload_packet_t &p, const arena_t &arena){
+	std::cerr << "ERROR: workload line " << p.line << ": arena of " << arena.size << " bytes at 0x" << std::hex << arena.base << std::dec << " is full" << std::endl;
+	return false;
+}
+
+// places source and destination image and the kernarg block of a dispatch in the arena
+// kernargs: src_address (64 bit) | dest_address (64 bit) | colormodel (8 bit) | borderhandling (8 bit) | threshold (16 bit)
+//           (| optional: normalization (16 bit + 16 bit padding) | filter mask (25x4 byte or 9x4 byte))
+static bool place_kernel_data(workload_packet_t &p, arena_t &arena, std::map<std::string,placed_image_t> &images){
+	uint64_t src = 0;
+	uint64_t dst = 0;
+	uint8_t colormodel = p.colormodel;
+	if(!p.image.empty()){
+		// identical sources are shared, every dispatch gets its own destination
+		std::string key = p.image;
+		if(p.image.compare("generated")==0){
+			key += ":" + std::to_string(p.grid_size[0]) + "x" + std::to_string(p.grid_size[1]) + ":" + std::to_string(p.colormodel);
+		}
+		std::map<std::string,placed_image_t>::iterator it = images.find(key);
+		if(it == images.end()){
+			image_t image;
+			if(p.image.compare("generated")==0){
+				generate_image(p.grid_size[0], p.grid_size[1], p.colormodel, image);
+			}else if(!load_image(p.image, p.grid_size[0], p.grid_size[1], p.colormodel, image)){
+				return false;
+			}
+			placed_image_t placed = {0, image.width, image.height, image.colormodel};
+			// the padding of padded color models stays 0
+			if(!arena_alloc(arena, image_storage(image.width, image.height, image.colormodel), 64, placed.address)){
+				return arena_full(p, arena);
+			}
+			arena_write(arena, placed.address, image.data.data(), image.data.size());
+			it = images.insert(std::make_pair(key, placed)).first;
+		}
+		src = it->second.address;
+		colormodel = it->second.colormodel;
+		p.grid_size[0] = it->second.width;
+		p.grid_size[1] = it->second.height;
+		p.grid_size[2] = 1;
+		if(p.dim < 2){
+			p.dim = 2;
+		}
+		if(!arena_alloc(arena, image_storage(p.grid_size[0], p.grid_size[1], colormodel), 64, dst)){
+			return arena_full(p, arena);
+		}
+	}
+
+	const uint64_t size = kernarg_size(p.kernel_object);
+	std::vector<uint8_t> kernargs(size, 0);
+	for(unsigned int b=0; b<8; ++b){
+		kernargs[b] = src >> (8*b);
+		kernargs[8+b] = dst >> (8*b);
+	}
+	kernargs[16] = colormodel;
+	kernargs[17] = p.borderhandling;
+	kernargs[18] = p.threshold & 0xFF;
+	kernargs[19] = p.threshold >> 8;
+	if(size > 20){
+		kernargs[20] = p.normalization & 0xFF;
+		kernargs[21] = p.normalization >> 8;
+		for(unsigned int m=0; m<p.mask.size(); ++m){
+			for(unsigned int b=0; b<4; ++b){
+				kernargs[24+4*m+b] = (uint32_t)p.mask[m] >> (8*b);
+			}
+		}
+	}
+	if(!arena_alloc(arena, size, 8, p.kernarg_address)){
+		return arena_full(p, arena);
+	}
+	arena_write(arena, p.kernarg_address, kernargs.data(), size);
+	return true;
+}
+
+// appends all packets of the workload to <slots> (PACKETSIZE/8 words per packet), <pasids>
+// and <arrival>, places their data in the arena and stores the resulting addresses in <workload>
+bool write_workload(std::vector<workload_packet_t> &workload, arena_t &arena, std::vector<uint64_t> &slots, std::vector<uint32_t> &pasids, std::vector<uint64_t> &arrival){
+	std::map<std::string,placed_image_t> images;
+	uint64_t time = 0;
+	slots.reserve(workload_length(workload)*(PACKETSIZE/8));
+	for(unsigned int i=0; i<workload.size(); ++i){
+		workload_packet_t &p = workload[i];
+		for(unsigned int d=0; d<p.num_dep_signals; ++d){
+			if(p.dep_packet[d] >= 0){
+				p.dep_signal[d] = workload[p.dep_packet[d]].completion_signal;
+			}
+		}
+		for(unsigned int r=0; r<p.repeat; ++r){
+			if(p.auto_signal){
+				uint64_t value = p.signal_value;
+				if(!arena_alloc(arena, 8, 8, p.completion_signal)){
+					return arena_full(p, arena);
+				}
+				arena_write(arena, p.completion_signal, &value, 8);
+			}
+			if(p.type == HSA_PACKET_TYPE_KERNEL_DISPATCH && p.auto_kernarg && !place_kernel_data(p, arena, images)){
+				return false;
+			}
+
+			uint64_t words[PACKETSIZE/8] = {};
+			void *slot = (void*)words;
+			if(p.type == HSA_PACKET_TYPE_KERNEL_DISPATCH){
+				hsa_kernel_dispatch_packet_t *packet = (hsa_kernel_dispatch_packet_t*)slot;
+				packet->header = header(p.type,p.barrier,p.acquire,p.release);
+				packet->setup = setup(p.dim);
+				packet->workgroup_size_x = p.workgroup_size[0];
+				packet->workgroup_size_y = p.workgroup_size[1];
+				packet->workgroup_size_z = p.workgroup_size[2];
+				packet->grid_size_x = p.grid_size[0];
+				packet->grid_size_y = p.grid_size[1];
+				packet->grid_size_z = p.grid_size[2];
+				packet->private_segment_size = p.private_segment_size;
+				packet->group_segment_size = p.group_segment_size;
+				packet->kernel_object = p.kernel_object;
+				packet->kernarg_address = (void*)p.kernarg_address;
+				packet->completion_signal.handle = p.completion_signal;
+			}else if(p.type == HSA_PACKET_TYPE_BARRIER_AND || p.type == HSA_PACKET_TYPE_BARRIER_OR){
+				// barrier-and and barrier-or packets share the same layout
+				hsa_barrier_and_packet_t *packet = (hsa_barrier_and_packet_t*)slot;
+				packet->header = header(p.type,p.barrier,p.acquire,p.release);
+				for(unsigned int d=0; d<5; ++d){
+					packet->dep_signal[d].handle = (d < p.num_dep_signals) ? p.dep_signal[d] : 0;
+				}
+				packet->completion_signal.handle = p.completion_signal;
+			}else{
+				*((uint16_t*)slot) = header(p.type,p.barrier,p.acquire,p.release);
+			}
+			slots.insert(slots.end(), words, words+PACKETSIZE/8);
+			pasids.push_back(p.pasid);
+			time += p.gap;
+			arrival.push_back(time);
+		}
+	}
+	return true;
+}
+
+// aql2mem <dump> -d [-f <workload file> | -g <generator config>] [-t [<start ns>,]<end ns>] [-r]
+int decode(int argc, char *argv[]){
+	std::vector<workload_packet_t> workload;
+	std::vector<uint64_t> slots;
+	std::vector<uint32_t> pasids;
+	std::vector<uint64_t> arrival;
+	arena_t arena;
+	arena_init(arena, DEFAULT_ARENA_BASE, DEFAULT_ARENA_SIZE);
+	double start_ns = 0;
+	double end_ns = 0;
+	bool reference = false;
+	for(int i=3; i<argc; i+=2){
+		std::string option(argv[i]);
+		if(option.compare("-r")==0){
+			// the only option without an argument
+			reference = true;
+			--i;
+			continue;
+		}
+		if(i+1 >= argc){
+			std::cerr << "ERROR: " << option << " needs an argument" << std::endl;
+			return EXIT_FAILURE;
+		}
+		if(option.compare("-f")==0 && workload.empty()){
+			if(!read_workload(argv[i+1], workload, arena)){
+				return EXIT_FAILURE;
+			}
+		}else if(option.compare("-g")==0 && workload.empty()){
+			generator_config_t config;
+			if(!read_generator_config(argv[i+1], MAX_QUEUE_LENGTH, config)){
+				return EXIT_FAILURE;
+			}
+			generate_workload(config, workload);
+			arena_init(arena, config.arena_base, config.arena_size);
+		}else if(option.compare("-t")==0){
+			std::vector<std::string> times;
+			tokenize(argv[i+1], times, ',');
+			try{
+				end_ns = std::stod(times.at(times.size()-1));
+				start_ns = (times.size() == 2) ? std::stod(times[0]) : 0;
+			}catch(const std::exception &e){
+				std::cerr << "ERROR: invalid simulation time " << argv[i+1] << std::endl;
+				return EXIT_FAILURE;
+			}
+		}else{
+			std::cerr << "ERROR: unknown decode option " << option << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	// rebuild the packets and the placement of their data
+	if(!workload.empty() && !write_workload(workload, arena, slots, pasids, arrival)){
+		return EXIT_FAILURE;
+	}
+
+	memory_dump_t dump;
+	if(!read_dump(argv[1], dump)){
+		return EXIT_FAILURE;
+	}
+	return decode_dump(dump, workload, slots, reference, start_ns, end_ns) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int main(int argc, char *argv[]){
+
+	// the output format and -x can be given anywhere after the output filename
+	mti_format_t format = MTI_FORMAT_MTI;
+	bool execute = false;
+	std::vector<char*> args;
+	for(int i=0; i<argc; ++i){
+		if(i > 1 && std::string(argv[i]).compare("-x")==0){
+			execute = true;
+		}else if(i > 1 && i+1 < argc && std::string(argv[i]).compare("-o")==0){
+			if(!mti_parse_format(argv[i+1], format)){
+				std::cerr << "ERROR: unknown output format " << argv[i+1] << ", expected mti, bin, sparse or readmemh" << std::endl;
+				return EXIT_FAILURE;
+			}
+			++i;
+		}else{
+			args.push_back(argv[i]);
+		}
+	}
+	argc = args.size();
+	argv = args.data();
 	
-	if(argc != 2 && argc != 3){
-		std::cout << "wrong usage: first argument must be output filename [optional: second argument string containing \"default\" for one or a number for more packets]" << std::endl;
+	std::string mode = (argc >= 3) ? std::string(argv[2]) : "";
+	if(mode.compare("-d") == 0){
+		return decode(argc, argv);
+	}
+	bool workload_mode = (argc == 4 || argc == 5) && mode.compare("-f") == 0;
+	bool generator_mode = (argc >= 4 && argc <= 6) && mode.compare("-g") == 0;
+	if(argc < 2 || (argc > 3 && !workload_mode && !generator_mode) || (execute && !workload_mode && !generator_mode)){
+		std::cout << "wrong usage: first argument must be output filename [optional: second argument string containing \"default\" for one or a number for more packets, "
+			  << "or \"-f <workload file> [<stimulus file>]\", or \"-g <generator config> [<trace file> [<stimulus file>]]\"]" << std::endl;
+		std::cout << "select the output format with \"-o mti|bin|sparse|readmemh\" (default mti)" << std::endl;
+		std::cout << "with \"-x\" the packets of a workload run on the host-native model and the output is the memory afterwards" << std::endl;
+		std::cout << "decode a DRAM dump: <dump> -d [-f <workload file> | -g <generator config>] [-t [<start ns>,]<end ns>] [-r]" << std::endl;
+		return EXIT_FAILURE;
 	}
 
 	char *alloc = new char[PACKETSIZE*MAX_QUEUE_LENGTH];
@@ -152,11 +377,71 @@ int main(int argc, char *argv[]){
 	}
 	void *packet_begin = (void*)alloc;
 	unsigned int packet_queue_end_idx = 0;
+	unsigned int ring_slots = 0;
+
+	uint32_t *pasid = new uint32_t[MAX_QUEUE_LENGTH]();
+
+	// device memory for kernargs, images and signals of the workload modes
+	arena_t arena;
+	arena_init(arena, DEFAULT_ARENA_BASE, DEFAULT_ARENA_SIZE);
 
-	uint32_t *pasid = new uint32_t[MAX_QUEUE_LENGTH];
+	// all packets of a workload, the ring holds the leading ones
+	std::vector<uint64_t> slots;
+	std::vector<uint32_t> pasids;
 
-	// printing default aql packet if desired
-	if(argc==3){
+	// build the ring from a workload description or a generated workload
+	if(workload_mode || generator_mode){
+		std::vector<workload_packet_t> workload;
+		generator_config_t config;
+		if(workload_mode && !read_workload(argv[3], workload, arena)){
+			return EXIT_FAILURE;
+		}
+		if(generator_mode){
+			if(!read_generator_config(argv[3], MAX_QUEUE_LENGTH, config)){
+				return EXIT_FAILURE;
+			}
+			generate_workload(config, workload);
+			arena_init(arena, config.arena_base, config.arena_size);
+		}
+		std::vector<uint64_t> arrival;
+		if(!write_workload(workload, arena, slots, pasids, arrival)){
+			return EXIT_FAILURE;
+		}
+		if(generator_mode){
+			std::string trace = (argc >= 5) ? std::string(argv[4]) : std::string(argv[1]) + ".trace";
+			if(!write_trace(trace.c_str(), config, workload)){
+				return EXIT_FAILURE;
+			}
+		}
+
+		// workloads longer than the ring or with a stimulus file are streamed by the
+		// testbench, the ring starts with the leading packets that arrive at cycle 0
+		const int stimulus_arg = workload_mode ? 4 : 5;
+		const uint64_t length = pasids.size();
+		const bool stream = argc > stimulus_arg || length > MAX_QUEUE_LENGTH;
+		while(packet_queue_end_idx < length && packet_queue_end_idx < MAX_QUEUE_LENGTH && (!stream || arrival[packet_queue_end_idx] == 0)){
+			for(unsigned int w=0; w<PACKETSIZE/8; ++w){
+				((uint64_t*)packet_begin)[packet_queue_end_idx*(PACKETSIZE/8) + w] = slots[packet_queue_end_idx*(PACKETSIZE/8) + w];
+			}
+			pasid[packet_queue_end_idx] = pasids[packet_queue_end_idx];
+			++packet_queue_end_idx;
+		}
+		if(stream){
+			// the producer makes the remaining slots valid by writing their header last
+			for(unsigned int i=packet_queue_end_idx; i<MAX_QUEUE_LENGTH; ++i){
+				*((uint16_t*)((char*)packet_begin+PACKETSIZE*i)) = header(HSA_PACKET_TYPE_INVALID);
+			}
+			ring_slots = MAX_QUEUE_LENGTH;
+		}
+		// the host-native model publishes the remaining packets itself
+		if(stream && !execute){
+			std::string stimulus = (argc > stimulus_arg) ? std::string(argv[stimulus_arg]) : std::string(argv[1]) + ".stim";
+			if(!write_stimulus(stimulus.c_str(), slots, pasids, arrival, packet_queue_end_idx)){
+				return EXIT_FAILURE;
+			}
+		}
+	}else if(argc==3){
+		// printing default aql packet if desired
 		unsigned int num_packets = 1;
 		std::string arg2(argv[2]);
 		if(arg2.compare("default")!=0){
@@ -393,7 +678,23 @@ int main(int argc, char *argv[]){
 	}
 	
 	const char *filename = argv[1];
-	printfile(filename,packet_begin,pasid,packet_queue_end_idx);
+	if(ring_slots < packet_queue_end_idx){
+		ring_slots = packet_queue_end_idx;
+	}
+	mti_image_t image;
+	buildimage(image,packet_begin,pasid,ring_slots,packet_queue_end_idx,arena);
+	bool completed = true;
+	if(execute){
+		native_result_t result;
+		native_run(image, slots, pasids, result);
+		std::cout << "host-native model: " << result.completed << " of " << pasids.size() << " packets completed, "
+			  << result.dispatches << " dispatches with " << result.pixels << " pixels filtered, "
+			  << result.skipped << " without output" << (result.stalled ? ", STALLED" : "") << std::endl;
+		completed = !result.stalled;
+	}
+	if(!mti_write(filename, format, image) || !completed){
+		return EXIT_FAILURE;
+	}
 
 	delete[] alloc;
 	delete[] pasid;
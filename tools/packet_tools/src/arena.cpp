@@ -0,0 +1,44 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstring>
+
+#include "arena.h"
+
+void arena_init(arena_t &arena, uint64_t base, uint64_t size){
+	arena.base = base;
+	arena.size = size;
+	arena.data.clear();
+}
+
+bool arena_valid(const arena_t &arena){
+	return (arena.base & 0xF) == 0
+		&& arena.base >= BASE_DEVICE_MEMORY + PP_DRAM_RESERVED
+		&& arena.size <= UINT64_MAX - arena.base;
+}
+
+bool arena_alloc(arena_t &arena, uint64_t length, uint64_t align, uint64_t &address){
+	uint64_t offset = (arena.data.size() + align - 1) & ~(align - 1);
+	if(offset > arena.size || length > arena.size - offset){
+		return false;
+	}
+	arena.data.resize(offset + length, 0);
+	address = arena.base + offset;
+	return true;
+}
+
+void arena_write(arena_t &arena, uint64_t address, const void *src, uint64_t length){
+	std::memcpy(&arena.data[address - arena.base], src, length);
+}
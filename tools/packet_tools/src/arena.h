@@ -0,0 +1,60 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "hsa_packets.h"
+
+#ifndef MAX_QUEUE_LENGTH
+#define MAX_QUEUE_LENGTH 128
+#endif
+
+// device memory layout, see address_conf.h of the packet processor
+#define BASE_DEVICE_MEMORY	UINT64_C(0x0001000000000000)
+#define PP_DRAM_RESERVED	(MAX_QUEUE_LENGTH*PACKETSIZE + MAX_QUEUE_LENGTH*4 + 2*8)
+
+// The firmware heap starts at PP_HEAP_OFFSET right behind the reserved
+// queue area and grows upwards. The simulated DRAM of tb_packet_processor_top
+// holds 4 MiB, by default the arena takes the upper half of it. Completion
+// signals placed here are decremented in that DRAM too, the testbench decodes
+// device memory addresses of the signal engine onto it.
+#define TB_DRAM_SIZE		(UINT64_C(4) << 20)
+#define DEFAULT_ARENA_BASE	(BASE_DEVICE_MEMORY + (UINT64_C(2) << 20))
+#define DEFAULT_ARENA_SIZE	(UINT64_C(2) << 20)
+
+// bump allocator over a device memory region, the contents end up in the memory image
+typedef struct arena_s {
+	uint64_t base;
+	uint64_t size;
+	std::vector<uint8_t> data;
+} arena_t;
+
+void arena_init(arena_t &arena, uint64_t base, uint64_t size);
+
+// checks that the arena is 16 byte aligned and lies in device memory behind the queue
+bool arena_valid(const arena_t &arena);
+
+// reserves <length> zeroed bytes aligned to <align> (a power of 2),
+// returns false if the arena is full
+bool arena_alloc(arena_t &arena, uint64_t length, uint64_t align, uint64_t &address);
+
+// copies <length> bytes to the already allocated device <address>
+void arena_write(arena_t &arena, uint64_t address, const void *src, uint64_t length);
+
+#endif
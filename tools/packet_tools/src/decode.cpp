@@ -0,0 +1,302 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <iomanip>
+
+#include "decode.h"
+#include "arena.h"
+#include "image.h"
+#include "stimulus.h"
+#include "filters.h"
+
+bool read_dump(const char *filename, memory_dump_t &dump){
+	return mti_read(filename, dump.image);
+}
+
+static uint64_t dump_word(const memory_dump_t &dump, uint64_t index){
+	return mti_word(dump.image, index);
+}
+
+// copies <length> bytes at device <address>, false if they are not part of the dump
+static bool dump_bytes(const memory_dump_t &dump, uint64_t address, uint64_t length, std::vector<uint8_t> &bytes){
+	const uint64_t size = mti_end(dump.image)*8;
+	if(address < BASE_DEVICE_MEMORY || address - BASE_DEVICE_MEMORY > size || length > size - (address - BASE_DEVICE_MEMORY)){
+		return false;
+	}
+	bytes.resize(length);
+	for(uint64_t i=0; i<length; ++i){
+		uint64_t offset = address - BASE_DEVICE_MEMORY + i;
+		bytes[i] = dump_word(dump, offset/8) >> (8*(offset%8));
+	}
+	return true;
+}
+
+static const char *type_name(unsigned int type){
+	switch(type){
+		case HSA_PACKET_TYPE_VENDOR_SPECIFIC: return "VENDOR_SPECIFIC";
+		case HSA_PACKET_TYPE_INVALID: return "INVALID";
+		case HSA_PACKET_TYPE_KERNEL_DISPATCH: return "KERNEL_DISPATCH";
+		case HSA_PACKET_TYPE_BARRIER_AND: return "BARRIER_AND";
+		case HSA_PACKET_TYPE_AGENT_DISPATCH: return "AGENT_DISPATCH";
+		case HSA_PACKET_TYPE_BARRIER_OR: return "BARRIER_OR";
+		default: return "UNKNOWN";
+	}
+}
+
+static unsigned int header_type(uint64_t word){
+	return (word >> HSA_PACKET_HEADER_TYPE) & ((1 << HSA_PACKET_HEADER_WIDTH_TYPE)-1);
+}
+
+static unsigned int header_barrier(uint64_t word){
+	return (word >> HSA_PACKET_HEADER_BARRIER) & ((1 << HSA_PACKET_HEADER_WIDTH_BARRIER)-1);
+}
+
+// 64 bit FNV-1a, a stable checksum of an output image
+static uint64_t checksum(const std::vector<uint8_t> &bytes){
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+	for(uint64_t i=0; i<bytes.size(); ++i){
+		hash = (hash ^ bytes[i]) * UINT64_C(0x100000001b3);
+	}
+	return hash;
+}
+
+// packet of the report, <source> is the workload entry it was built from or NULL
+typedef struct decoded_packet_s {
+	uint64_t index;
+	uint64_t words[PACKETSIZE/8];
+	const workload_packet_t *source;
+} decoded_packet_t;
+
+// diffs an output image against the expected one and prints the result, false on a mismatch
+static bool report_diff(const std::string &what, const std::vector<uint8_t> &output, const uint8_t *expected, uint32_t width, uint32_t height,
+			uint8_t colormodel){
+	image_diff_t diff;
+	if(image_diff(output.data(), expected, width, height, colormodel, diff)){
+		std::cout << "  " << what << ": match" << std::endl;
+		return true;
+	}
+	std::cout << "  " << what << ": MISMATCH, " << diff.pixels << " of " << (uint64_t)width*height << " pixels differ, first at ("
+		  << diff.x << "," << diff.y << ") channel " << diff.channel << ": 0x" << std::hex << diff.actual << ", expected 0x"
+		  << diff.expected << std::dec << std::endl;
+	return false;
+}
+
+// compares an output image to its golden image, prints the result and returns false on a mismatch
+static bool compare_golden(const std::string &golden, const std::vector<uint8_t> &output, uint32_t width, uint32_t height, uint8_t colormodel){
+	image_t expected;
+	if(!load_image(golden, width, height, colormodel, expected)){
+		std::cout << "  golden " << golden << ": not loadable" << std::endl;
+		return false;
+	}
+	if(expected.width != width || expected.height != height || expected.colormodel != colormodel){
+		std::cout << "  golden " << golden << ": MISMATCH, golden image is " << expected.width << "x" << expected.height
+			  << " " << colormodel_name(expected.colormodel) << std::endl;
+		return false;
+	}
+	return report_diff("golden " + golden, output, expected.data.data(), width, height, colormodel);
+}
+
+// compares an output image to the host filters applied to the source image in
+// the dump, prints the result and returns false on a mismatch
+static bool compare_reference(const memory_dump_t &dump, const hsa_kernel_dispatch_packet_t *kp, const std::vector<uint8_t> &kernargs,
+			      const std::vector<uint8_t> &output){
+	const uint32_t width = kp->grid_size_x;
+	const uint32_t height = kp->grid_size_y;
+	filter_params_t params;
+	if(!filter_params_from_kernargs(kp->kernel_object, kernargs.data(), params)){
+		std::cout << "  reference: none for this kernel" << std::endl;
+		return true;
+	}
+	uint64_t src = 0;
+	for(unsigned int b=0; b<8; ++b){
+		src |= (uint64_t)kernargs[b] << (8*b);
+	}
+	std::vector<uint8_t> input;
+	if(src == 0 || !dump_bytes(dump, src, output.size(), input)){
+		std::cout << "  reference: source 0x" << std::hex << src << std::dec << " not in the dump" << std::endl;
+		return false;
+	}
+	// the plain kernels on one thread, independent of what the device under test used
+	std::vector<uint8_t> expected(output.size());
+	if(!filter_run(params, width, height, input.data(), expected.data(), 1, FILTER_ISA_SCALAR)){
+		return false;
+	}
+	const char *deviation = filter_deviation(params);
+	if(deviation != NULL){
+		std::cout << "  reference: DEVIATION, " << deviation << std::endl;
+	}
+	return report_diff("reference", output, expected.data(), width, height, params.colormodel);
+}
+
+bool decode_dump(const memory_dump_t &dump, const std::vector<workload_packet_t> &workload, const std::vector<uint64_t> &slots,
+		 bool reference, double start_ns, double end_ns){
+	const uint64_t read_index = dump_word(dump, AQL_READ_INDEX_WORD);
+	const uint64_t write_index = dump_word(dump, AQL_WRITE_INDEX_WORD);
+	bool golden_ok = true;
+
+	std::cout << "queue: " << MAX_QUEUE_LENGTH << " slots, READ_INDEX " << read_index << ", WRITE_INDEX " << write_index;
+	if(write_index >= read_index){
+		std::cout << ", " << write_index - read_index << " published packets not completed" << std::endl;
+	}else{
+		std::cout << ", READ_INDEX is ahead of WRITE_INDEX" << std::endl;
+	}
+
+	// the slots hold the last published packet with the same index modulo the queue length,
+	// the packet processor marks completed packets INVALID
+	std::cout << std::endl << "slot   packet  type             barrier  pasid  state" << std::endl;
+	for(uint64_t s=0; s<MAX_QUEUE_LENGTH; ++s){
+		const uint64_t header = dump_word(dump, s*(PACKETSIZE/8));
+		const bool published = write_index > s;
+		if(!published && header == 0){
+			continue;
+		}
+		const uint64_t packet = published ? s + ((write_index-1-s)/MAX_QUEUE_LENGTH)*MAX_QUEUE_LENGTH : 0;
+		const uint32_t pasid = dump_word(dump, AQL_PASID_WORD + s/2) >> (32*(s&1));
+		const bool invalid = header_type(header) == HSA_PACKET_TYPE_INVALID;
+		const char *state = invalid ? (published ? "completed" : "free") : (published ? "pending" : "unpublished");
+		std::cout << std::left << std::dec << std::setw(7) << s;
+		if(published){
+			std::cout << std::setw(8) << packet;
+		}else{
+			std::cout << std::setw(8) << "-";
+		}
+		std::cout << std::setw(17) << type_name(header_type(header)) << std::setw(9) << (header_barrier(header) ? "y" : "n")
+			  << std::setw(7) << pasid << state << std::endl;
+	}
+
+	// all packets of the workload, or the published packets still in the ring
+	std::vector<decoded_packet_t> packets;
+	if(!slots.empty()){
+		uint64_t index = 0;
+		for(unsigned int i=0; i<workload.size(); ++i){
+			for(unsigned int r=0; r<workload[i].repeat; ++r, ++index){
+				decoded_packet_t p = {index, {}, &workload[i]};
+				for(unsigned int w=0; w<PACKETSIZE/8; ++w){
+					p.words[w] = slots[index*(PACKETSIZE/8) + w];
+				}
+				packets.push_back(p);
+			}
+		}
+	}else{
+		const uint64_t first = (write_index > MAX_QUEUE_LENGTH) ? write_index - MAX_QUEUE_LENGTH : 0;
+		for(uint64_t index=first; index<write_index; ++index){
+			decoded_packet_t p = {index, {}, NULL};
+			for(unsigned int w=0; w<PACKETSIZE/8; ++w){
+				p.words[w] = dump_word(dump, (index & (MAX_QUEUE_LENGTH-1))*(PACKETSIZE/8) + w);
+			}
+			packets.push_back(p);
+		}
+	}
+
+	std::cout << std::endl << "packets:" << std::endl;
+	uint64_t completed_pixels = 0;
+	for(unsigned int i=0; i<packets.size(); ++i){
+		const decoded_packet_t &p = packets[i];
+		const unsigned int type = header_type(p.words[0]);
+		// the ring shows the state as long as the slot was not refilled
+		const bool in_ring = p.index < write_index && p.index + MAX_QUEUE_LENGTH >= write_index;
+		const uint64_t ring_header = dump_word(dump, (p.index & (MAX_QUEUE_LENGTH-1))*(PACKETSIZE/8));
+		const char *state = "unpublished";
+		bool completed = false;
+		if(p.index < write_index){
+			completed = !in_ring || header_type(ring_header) == HSA_PACKET_TYPE_INVALID;
+			state = completed ? "completed" : "pending";
+		}
+
+		std::cout << std::dec << p.index << ": " << type_name(type) << ", " << state;
+		if(type == HSA_PACKET_TYPE_KERNEL_DISPATCH){
+			const hsa_kernel_dispatch_packet_t *kp = (const hsa_kernel_dispatch_packet_t*)p.words;
+			const char *name = kernel_name(kp->kernel_object);
+			std::cout << ", kernel ";
+			if(name != NULL){
+				std::cout << name;
+			}else{
+				std::cout << "0x" << std::hex << kp->kernel_object << std::dec;
+			}
+			std::cout << ", grid " << kp->grid_size_x << "x" << kp->grid_size_y << "x" << kp->grid_size_z;
+			if(completed){
+				completed_pixels += (uint64_t)kp->grid_size_x*kp->grid_size_y*kp->grid_size_z;
+			}
+		}else if(type == HSA_PACKET_TYPE_BARRIER_AND || type == HSA_PACKET_TYPE_BARRIER_OR){
+			const hsa_barrier_and_packet_t *bp = (const hsa_barrier_and_packet_t*)p.words;
+			std::cout << ", deps" << std::hex;
+			for(unsigned int d=0; d<5; ++d){
+				if(bp->dep_signal[d].handle != 0){
+					std::cout << " 0x" << bp->dep_signal[d].handle;
+				}
+			}
+			std::cout << std::dec;
+		}
+		std::cout << std::endl;
+
+		// completion signal, decremented by the packet processor when the packet completes
+		const uint64_t signal = p.words[PACKETSIZE/8-1];
+		std::vector<uint8_t> bytes;
+		if(type != HSA_PACKET_TYPE_VENDOR_SPECIFIC && type != HSA_PACKET_TYPE_INVALID && signal != 0){
+			std::cout << "  signal 0x" << std::hex << signal << std::dec;
+			if(dump_bytes(dump, signal, 8, bytes)){
+				int64_t value = 0;
+				for(unsigned int b=0; b<8; ++b){
+					value |= (int64_t)bytes[b] << (8*b);
+				}
+				std::cout << ": " << value;
+				if(p.source != NULL && p.source->auto_signal){
+					std::cout << " (initial " << p.source->signal_value << ")";
+				}
+			}else{
+				std::cout << ": not in the dump";
+			}
+			std::cout << std::endl;
+		}
+
+		// output image described by the kernargs
+		if(type == HSA_PACKET_TYPE_KERNEL_DISPATCH){
+			const hsa_kernel_dispatch_packet_t *kp = (const hsa_kernel_dispatch_packet_t*)p.words;
+			const uint64_t kernargs = (uint64_t)kp->kernarg_address;
+			if(kernargs == 0 || !dump_bytes(dump, kernargs, kernarg_size(kp->kernel_object), bytes)){
+				continue;
+			}
+			uint64_t dst = 0;
+			for(unsigned int b=0; b<8; ++b){
+				dst |= (uint64_t)bytes[8+b] << (8*b);
+			}
+			const uint8_t colormodel = bytes[16];
+			std::vector<uint8_t> output;
+			std::cout << "  output 0x" << std::hex << dst << std::dec;
+			if(dst == 0 || !dump_bytes(dump, dst, (uint64_t)kp->grid_size_x*kp->grid_size_y*pixel_storage(colormodel), output)){
+				std::cout << ": not in the dump" << std::endl;
+				continue;
+			}
+			std::cout << ", " << output.size() << " bytes, checksum 0x" << std::hex << checksum(output) << std::dec << std::endl;
+			if(p.source != NULL && !p.source->golden.empty()){
+				golden_ok = compare_golden(p.source->golden, output, kp->grid_size_x, kp->grid_size_y, colormodel) && golden_ok;
+			}
+			if(reference && completed){
+				golden_ok = compare_reference(dump, kp, bytes, output) && golden_ok;
+			}
+		}
+	}
+
+	if(end_ns > start_ns){
+		const double ns = end_ns - start_ns;
+		std::cout << std::endl << "throughput: " << read_index << " packets completed in " << ns << " ns, "
+			  << read_index / ns * 1e6 << " packets/ms, " << completed_pixels / ns * 1e3 << " Mpixel/s" << std::endl;
+		if(completed_pixels > 0){
+			std::cout << "cycles/pixel: " << ns / TB_CLOCK_NS / completed_pixels << std::endl;
+		}
+	}
+	return golden_ok;
+}
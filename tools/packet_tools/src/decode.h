@@ -0,0 +1,62 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef DECODE_H_
+#define DECODE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "workload.h"
+#include "mti.h"
+
+// Decoder for DRAM dumps of tb_packet_processor_top (aql2mem <dump> -d).
+//
+// The dump is either an MTI file, as written after a run by sim_packet_processor.do
+//   mem save -format mti -dataradix hex -wordsperline 2 -outfile dram_out.mem /tb_packet_processor_top/inst_dram/bram
+// the $readmemh output of aql2mem -o readmemh, or the output of mti2hex
+// with one or more 64 bit words per line, the most significant word first.
+//
+// The report lists READ_INDEX and WRITE_INDEX, the ring slots, and for every
+// packet its completion signal and for dispatches the output image. With
+// the workload that produced the memory image, all packets are reported,
+// including those streamed through the ring, signals are compared to their
+// initial value and output images to the golden= files of the workload.
+// With <reference>, every output image of a completed dispatch is also
+// compared pixel by pixel to the host filters (tools/common/filters) applied
+// to its source image in the dump. Mismatches report the number of differing
+// pixels and the first one with its channel values.
+//
+// The simulated time gives the throughput and the clock cycles per pixel of
+// the completed dispatches at the TB_CLOCK_NS clock of the testbench.
+
+#define TB_CLOCK_NS	20
+
+typedef struct memory_dump_s {
+	// 64 bit words from the DRAM base on, words missing in the dump are 0
+	mti_image_t image;
+} memory_dump_t;
+
+// parses an MTI or hex dump, reports errors on std::cerr and returns false on failure
+bool read_dump(const char *filename, memory_dump_t &dump);
+
+// Prints the report to std::cout. <workload> and <slots> (as built by
+// write_workload) may be empty. If <end_ns> is larger than <start_ns>, the
+// throughput of the completed packets over that simulated time is reported.
+// Returns false if an output image differs from its golden or reference image.
+bool decode_dump(const memory_dump_t &dump, const std::vector<workload_packet_t> &workload, const std::vector<uint64_t> &slots,
+		 bool reference, double start_ns, double end_ns);
+
+#endif
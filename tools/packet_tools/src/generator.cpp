@@ -0,0 +1,348 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <random>
+#include <cmath>
+
+#include "generator.h"
+#include "image.h"
+
+static void report(const char *filename, unsigned int line, std::string message){
+	std::cerr << "ERROR: " << filename << ":" << line << ": " << message << std::endl;
+}
+
+static bool parse_probability(std::string s, double &p){
+	try{
+		size_t pos = 0;
+		p = std::stod(s, &pos);
+		return pos == s.length() && p >= 0.0 && p <= 1.0;
+	}catch(const std::exception &e){
+		return false;
+	}
+}
+
+static bool parse_value(std::string s, bool kernel, uint64_t &value){
+	if(kernel){
+		return parse_kernel(s, value);
+	}
+	return parse_number(s, UINT64_MAX, value);
+}
+
+// parses the tokens following the key, returns an error message or an empty string
+static std::string parse_distribution(const std::vector<std::string> &tokens, bool kernel, distribution_t &d){
+	if(tokens.size() < 3){
+		return "distribution needs a kind and parameters";
+	}
+	std::string kind = tokens[1];
+	d.values.clear();
+	d.weights.clear();
+	if(kind.compare("const")==0 && tokens.size() == 3){
+		d.kind = DIST_CONST;
+		if(!parse_value(tokens[2], kernel, d.lo)) return "invalid value " + tokens[2];
+	}else if(kind.compare("uniform")==0 && tokens.size() == 4){
+		d.kind = DIST_UNIFORM;
+		if(!parse_value(tokens[2], kernel, d.lo)) return "invalid value " + tokens[2];
+		if(!parse_value(tokens[3], kernel, d.hi)) return "invalid value " + tokens[3];
+		if(d.hi < d.lo) return "uniform bounds are reversed";
+	}else if(kind.compare("choice")==0){
+		d.kind = DIST_CHOICE;
+		uint64_t total = 0;
+		for(unsigned int i=2; i<tokens.size(); ++i){
+			size_t colon = tokens[i].find(':');
+			uint64_t value = 0;
+			uint64_t weight = 1;
+			if(!parse_value(tokens[i].substr(0,colon), kernel, value)) return "invalid value " + tokens[i];
+			if(colon != std::string::npos && !parse_number(tokens[i].substr(colon+1), UINT32_MAX, weight)) return "invalid weight " + tokens[i];
+			d.values.push_back(value);
+			d.weights.push_back(weight);
+			total += weight;
+		}
+		if(total == 0) return "choice needs a nonzero weight";
+	}else if(kind.compare("exp")==0 && tokens.size() == 3){
+		d.kind = DIST_EXP;
+		try{
+			size_t pos = 0;
+			d.mean = std::stod(tokens[2], &pos);
+			if(pos != tokens[2].length() || !(d.mean >= 0.0)) return "invalid mean " + tokens[2];
+		}catch(const std::exception &e){
+			return "invalid mean " + tokens[2];
+		}
+	}else{
+		return "unknown distribution " + kind;
+	}
+	return "";
+}
+
+static distribution_t uniform_distribution(uint64_t lo, uint64_t hi){
+	distribution_t d;
+	d.kind = (lo == hi) ? DIST_CONST : DIST_UNIFORM;
+	d.lo = lo;
+	d.hi = hi;
+	d.mean = 0.0;
+	return d;
+}
+
+bool read_generator_config(const char *filename, unsigned int default_packets, generator_config_t &config){
+	config.seed = 1;
+	config.packets = default_packets;
+	config.pasids = 1;
+	config.gap = uniform_distribution(0, 0);
+	config.kernel = uniform_distribution(0x01, 0x01);
+	config.width = uniform_distribution(640, 640);
+	config.height = uniform_distribution(480, 480);
+	config.barrier_and = 0.0;
+	config.barrier_or = 0.0;
+	config.fan_in = uniform_distribution(1, 5);
+	config.dep_window = 16;
+	config.barrier_bit = 0.0;
+	config.signal_base = 0;
+	config.kernarg_base = 0;
+	config.images = false;
+	config.colormodel = UINT16_GRAY_SCALE;
+	config.arena_base = DEFAULT_ARENA_BASE;
+	config.arena_size = DEFAULT_ARENA_SIZE;
+
+	std::ifstream file(filename);
+	if(!file.is_open()){
+		std::cerr << "ERROR: could not open file " << filename << std::endl;
+		return false;
+	}
+
+	std::string line = "";
+	unsigned int line_number = 0;
+	while(std::getline(file,line)){
+		++line_number;
+		line = line.substr(0, line.find('#'));
+		std::vector<std::string> tokens;
+		tokenize(line, tokens, ' ');
+		if(tokens.size() == 0){
+			continue;
+		}
+
+		std::string key = tokens[0];
+		std::string error = "";
+		uint64_t n = 0;
+		if(key.compare("gap")==0){
+			error = parse_distribution(tokens, false, config.gap);
+		}else if(key.compare("kernel")==0){
+			error = parse_distribution(tokens, true, config.kernel);
+		}else if(key.compare("width")==0){
+			error = parse_distribution(tokens, false, config.width);
+		}else if(key.compare("height")==0){
+			error = parse_distribution(tokens, false, config.height);
+		}else if(key.compare("fan_in")==0){
+			error = parse_distribution(tokens, false, config.fan_in);
+		}else if(tokens.size() != 2){
+			error = key + " takes exactly one value";
+		}else if(key.compare("seed")==0){
+			if(!parse_number(tokens[1], UINT64_MAX, config.seed)) error = "invalid seed " + tokens[1];
+		}else if(key.compare("packets")==0){
+			if(!parse_number(tokens[1], UINT32_MAX, n) || n == 0) error = "invalid packet count " + tokens[1];
+			config.packets = n;
+		}else if(key.compare("pasids")==0){
+			if(!parse_number(tokens[1], UINT32_MAX, n) || n == 0) error = "invalid PASID count " + tokens[1];
+			config.pasids = n;
+		}else if(key.compare("dep_window")==0){
+			if(!parse_number(tokens[1], UINT32_MAX, n) || n == 0) error = "invalid dependency window " + tokens[1];
+			config.dep_window = n;
+		}else if(key.compare("barrier_and")==0){
+			if(!parse_probability(tokens[1], config.barrier_and)) error = "invalid probability " + tokens[1];
+		}else if(key.compare("barrier_or")==0){
+			if(!parse_probability(tokens[1], config.barrier_or)) error = "invalid probability " + tokens[1];
+		}else if(key.compare("barrier_bit")==0){
+			if(!parse_probability(tokens[1], config.barrier_bit)) error = "invalid probability " + tokens[1];
+		}else if(key.compare("signal_base")==0){
+			if(!parse_number(tokens[1], UINT64_MAX, config.signal_base)) error = "invalid address " + tokens[1];
+		}else if(key.compare("kernarg_base")==0){
+			if(!parse_number(tokens[1], UINT64_MAX, config.kernarg_base)) error = "invalid address " + tokens[1];
+		}else if(key.compare("images")==0){
+			config.images = tokens[1].compare("generated")==0;
+			if(!config.images && tokens[1].compare("none")!=0) error = "images must be none or generated";
+		}else if(key.compare("colormodel")==0){
+			if(tokens[1].compare("gray16")==0){
+				config.colormodel = UINT16_GRAY_SCALE;
+			}else if(tokens[1].compare("rgb8")==0){
+				config.colormodel = UINT8_RGB;
+			}else if(tokens[1].compare("rgbx8")==0){
+				config.colormodel = UINT8_RGBX;
+			}else{
+				error = "colormodel must be gray16, rgb8 or rgbx8";
+			}
+		}else if(key.compare("arena_base")==0){
+			if(!parse_number(tokens[1], UINT64_MAX, config.arena_base)) error = "invalid address " + tokens[1];
+		}else if(key.compare("arena_size")==0){
+			if(!parse_number(tokens[1], UINT64_MAX, config.arena_size)) error = "invalid size " + tokens[1];
+		}else{
+			error = "unknown key " + key;
+		}
+		if(!error.empty()){
+			report(filename, line_number, error);
+			return false;
+		}
+	}
+
+	arena_t arena;
+	arena_init(arena, config.arena_base, config.arena_size);
+	if(!arena_valid(arena)){
+		std::cerr << "ERROR: " << filename << ": arena must be 16 byte aligned and lie in device memory behind PP_DRAM_RESERVED" << std::endl;
+		return false;
+	}
+	// the ring, the doorbells and the queue bookkeeping sit at the start of device memory
+	if(config.signal_base != 0
+	   && ((config.signal_base & 0x7) != 0
+	       || config.signal_base < BASE_DEVICE_MEMORY + PP_DRAM_RESERVED
+	       || config.packets > (UINT64_MAX - config.signal_base) / 8)){
+		std::cerr << "ERROR: " << filename << ": signals must be 8 byte aligned and lie in device memory behind PP_DRAM_RESERVED" << std::endl;
+		return false;
+	}
+	if(config.barrier_and + config.barrier_or > 1.0){
+		std::cerr << "ERROR: " << filename << ": barrier_and and barrier_or add up to more than 1" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// [0,1) with the full 53 bit mantissa
+static double sample_real(std::mt19937_64 &rng){
+	return (rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// [lo,hi] without modulo bias
+static uint64_t sample_range(std::mt19937_64 &rng, uint64_t lo, uint64_t hi){
+	const uint64_t range = hi - lo + 1;
+	if(range == 0){
+		return rng();
+	}
+	const uint64_t limit = UINT64_MAX - (UINT64_MAX % range);
+	uint64_t r = rng();
+	while(r >= limit){
+		r = rng();
+	}
+	return lo + r % range;
+}
+
+static uint64_t sample(std::mt19937_64 &rng, const distribution_t &d){
+	switch(d.kind){
+		case DIST_UNIFORM:
+			return sample_range(rng, d.lo, d.hi);
+		case DIST_CHOICE: {
+			uint64_t total = 0;
+			for(unsigned int i=0; i<d.weights.size(); ++i){
+				total += d.weights[i];
+			}
+			uint64_t r = sample_range(rng, 0, total-1);
+			unsigned int i = 0;
+			while(r >= d.weights[i]){
+				r -= d.weights[i];
+				++i;
+			}
+			return d.values[i];}
+		case DIST_EXP:
+			return (uint64_t)std::floor(-d.mean * std::log(1.0 - sample_real(rng)));
+		default:
+			return d.lo;
+	}
+}
+
+static uint64_t clamp(uint64_t value, uint64_t lo, uint64_t hi){
+	return (value < lo) ? lo : ((value > hi) ? hi : value);
+}
+
+void generate_workload(const generator_config_t &config, std::vector<workload_packet_t> &packets){
+	std::mt19937_64 rng(config.seed);
+	// indices of the dispatches generated so far
+	std::vector<int> dispatches;
+
+	for(unsigned int i=0; i<config.packets; ++i){
+		workload_packet_t p = default_packet(HSA_PACKET_TYPE_KERNEL_DISPATCH, 0);
+		if(i != 0){
+			p.gap = sample(rng, config.gap);
+		}
+		p.completion_signal = config.signal_base + 8*(uint64_t)i;
+		p.auto_signal = config.images || config.signal_base == 0;
+
+		// a barrier packet needs at least one earlier dispatch to depend on
+		const double u = sample_real(rng);
+		if(!dispatches.empty() && u < config.barrier_and + config.barrier_or){
+			p.type = (u < config.barrier_and) ? HSA_PACKET_TYPE_BARRIER_AND : HSA_PACKET_TYPE_BARRIER_OR;
+			unsigned int window = (dispatches.size() < config.dep_window) ? dispatches.size() : config.dep_window;
+			std::vector<int> candidates(dispatches.end()-window, dispatches.end());
+			p.num_dep_signals = clamp(sample(rng, config.fan_in), 1, 5);
+			if(p.num_dep_signals > window){
+				p.num_dep_signals = window;
+			}
+			// partial Fisher-Yates shuffle, the dependencies are distinct
+			for(unsigned int d=0; d<p.num_dep_signals; ++d){
+				unsigned int j = sample_range(rng, d, window-1);
+				std::swap(candidates[d], candidates[j]);
+				p.dep_packet[d] = candidates[d];
+				p.dep_signal[d] = packets[candidates[d]].completion_signal;
+			}
+		}else{
+			p.kernel_object = sample(rng, config.kernel);
+			p.dim = 2;
+			p.grid_size[0] = clamp(sample(rng, config.width), 1, UINT32_MAX);
+			p.grid_size[1] = clamp(sample(rng, config.height), 1, UINT32_MAX);
+			p.kernarg_address = config.kernarg_base + 128*(uint64_t)i;
+			p.barrier = (sample_real(rng) < config.barrier_bit) ? 1 : 0;
+			if(config.images){
+				p.image = "generated";
+				p.auto_kernarg = true;
+				p.colormodel = config.colormodel;
+				// custom filters get an identity mask
+				if(p.kernel_object == CUSTOM_FILTER3x3 || p.kernel_object == CUSTOM_FILTER5x5){
+					unsigned int size = (p.kernel_object == CUSTOM_FILTER3x3) ? 9 : 25;
+					p.mask.assign(size, 0);
+					p.mask[size/2] = 1;
+				}
+			}
+			dispatches.push_back(i);
+		}
+		p.pasid = sample_range(rng, 1, config.pasids);
+
+		packets.push_back(p);
+	}
+}
+
+bool write_trace(const char *filename, const generator_config_t &config, const std::vector<workload_packet_t> &packets){
+	std::ofstream file(filename);
+	if(!file.is_open()){
+		std::cerr << "ERROR: could not open file " << filename << std::endl;
+		return false;
+	}
+
+	file << "# aql2mem trace seed=" << config.seed << " packets=" << packets.size() << std::endl;
+	file << "# slot arrival type pasid barrier kernel grid_x grid_y signal num_deps deps... (kernel, signal and deps in hex)" << std::endl;
+	uint64_t arrival = 0;
+	for(unsigned int i=0; i<packets.size(); ++i){
+		const workload_packet_t &p = packets[i];
+		const bool dispatch = p.type == HSA_PACKET_TYPE_KERNEL_DISPATCH;
+		arrival += p.gap;
+		file << std::dec << i << " " << arrival << " " << p.type << " " << p.pasid << " " << p.barrier;
+		file << std::hex << " " << (dispatch ? p.kernel_object : 0);
+		file << std::dec << " " << (dispatch ? p.grid_size[0] : 0) << " " << (dispatch ? p.grid_size[1] : 0);
+		file << std::hex << " " << p.completion_signal;
+		file << std::dec << " " << p.num_dep_signals;
+		file << std::hex;
+		for(unsigned int d=0; d<p.num_dep_signals; ++d){
+			file << " " << p.dep_signal[d];
+		}
+		file << std::endl;
+	}
+	return true;
+}
@@ -0,0 +1,109 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GENERATOR_H_
+#define GENERATOR_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "workload.h"
+
+// Seeded synthetic workload generator for aql2mem.
+//
+// The configuration file holds one "<key> <value ...>" per line, '#' starts
+// a comment. Keys and defaults:
+//
+//   seed <n>			seed of the random number generator (1)
+//   packets <n>			number of generated packets, more than MAX_QUEUE_LENGTH
+//				are streamed into the ring (MAX_QUEUE_LENGTH)
+//   pasids <n>			PASIDs 1..n are picked uniformly (1)
+//   gap <dist>			inter-arrival gap in cycles (const 0)
+//   kernel <dist>			kernel object, names allowed (const SOBELX3x3)
+//   width <dist>			image width (const 640)
+//   height <dist>			image height (const 480)
+//   barrier_and <p>		probability of a barrier-and packet (0)
+//   barrier_or <p>		probability of a barrier-or packet (0)
+//   fan_in <dist>			dependency signals per barrier packet, 1..5 (uniform 1 5)
+//   dep_window <n>		dependencies are drawn from the last n dispatches (16)
+//   barrier_bit <p>		probability of the barrier bit on a dispatch (0)
+//   signal_base <addr>		completion signal of packet i at signal_base + 8*i, must lie
+//				behind PP_DRAM_RESERVED, 0 allocates the signals in the arena (0)
+//   kernarg_base <addr>		kernargs of packet i at kernarg_base + 128*i (0)
+//   images none|generated		with generated, every dispatch gets a generated source
+//				image, kernargs and a signal in the arena and both base
+//				addresses above are ignored (none)
+//   colormodel gray16|rgb8|rgbx8	color model of generated images (gray16)
+//   arena_base <addr>		device memory for the generated data (DEFAULT_ARENA_BASE)
+//   arena_size <n>		(DEFAULT_ARENA_SIZE)
+//
+// Distributions <dist>:
+//   const <v>
+//   uniform <lo> <hi>		inclusive
+//   choice <v>:<w> ...		<v> with relative weight <w>
+//   exp <mean>			exponential, rounded down to an integer
+//
+// Only the raw output of std::mt19937_64 is used, the distributions are
+// sampled by hand, so a seed yields the same workload on every platform.
+
+typedef enum {
+	DIST_CONST,
+	DIST_UNIFORM,
+	DIST_CHOICE,
+	DIST_EXP
+} distribution_kind_t;
+
+typedef struct distribution_s {
+	distribution_kind_t kind;
+	uint64_t lo;
+	uint64_t hi;
+	double mean;
+	std::vector<uint64_t> values;
+	std::vector<uint64_t> weights;
+} distribution_t;
+
+typedef struct generator_config_s {
+	uint64_t seed;
+	unsigned int packets;
+	unsigned int pasids;
+	distribution_t gap;
+	distribution_t kernel;
+	distribution_t width;
+	distribution_t height;
+	double barrier_and;
+	double barrier_or;
+	distribution_t fan_in;
+	unsigned int dep_window;
+	double barrier_bit;
+	uint64_t signal_base;
+	uint64_t kernarg_base;
+	bool images;
+	uint8_t colormodel;
+	uint64_t arena_base;
+	uint64_t arena_size;
+} generator_config_t;
+
+// parses <filename> into <config>, reports errors on std::cerr and returns false on failure
+bool read_generator_config(const char *filename, unsigned int default_packets, generator_config_t &config);
+
+// generates the packets with their inter-arrival gaps, every packet has repeat count 1
+void generate_workload(const generator_config_t &config, std::vector<workload_packet_t> &packets);
+
+// writes one line per packet: slot arrival type pasid barrier kernel grid_x grid_y signal num_deps deps...
+// arrival is in cycles since the first packet, kernel, signal and deps are hexadecimal
+bool write_trace(const char *filename, const generator_config_t &config, const std::vector<workload_packet_t> &packets);
+
+#endif
@@ -0,0 +1,187 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <fstream>
+#include <cctype>
+
+#include "image.h"
+
+unsigned int pixel_storage(uint8_t colormodel){
+	switch(colormodel){
+		case UINT16_GRAY_SCALE: return 2;
+		case UINT8_RGB: return 3;
+		case UINT8_RGBX: return 4;
+		default: return 1;
+	}
+}
+
+uint64_t image_storage(uint32_t width, uint32_t height, uint8_t colormodel){
+	uint64_t storage = (uint64_t)width*height*pixel_storage(colormodel);
+	if(colormodel == UINT8_RGBX){
+		storage = (storage + 63) & ~(uint64_t)63;
+	}
+	return storage;
+}
+
+const char *colormodel_name(uint8_t colormodel){
+	switch(colormodel){
+		case UINT16_GRAY_SCALE: return "gray16";
+		case UINT8_RGB: return "rgb8";
+		case UINT8_RGBX: return "rgbx8";
+		default: return "unknown";
+	}
+}
+
+// reads one header number of a netpbm file, skipping whitespace and comments
+static bool read_header_number(std::ifstream &file, uint32_t &value){
+	int c = file.get();
+	while(c != EOF && (std::isspace(c) || c == '#')){
+		if(c == '#'){
+			while(c != EOF && c != '\n'){
+				c = file.get();
+			}
+		}
+		c = file.get();
+	}
+	if(c == EOF || !std::isdigit(c)){
+		return false;
+	}
+	value = 0;
+	while(c != EOF && std::isdigit(c)){
+		value = value*10 + (c - '0');
+		c = file.get();
+	}
+	// exactly one whitespace character separates the header from the pixels
+	return c != EOF && std::isspace(c);
+}
+
+// <padded> stores a PPM as RGBX
+static bool load_netpbm(std::ifstream &file, const std::string &filename, bool rgb, bool padded, image_t &image){
+	uint32_t maxval = 0;
+	if(!read_header_number(file, image.width) || !read_header_number(file, image.height) || !read_header_number(file, maxval)
+	   || image.width == 0 || image.height == 0 || maxval == 0 || maxval > 65535){
+		std::cerr << "ERROR: invalid header in " << filename << std::endl;
+		return false;
+	}
+	const unsigned int sample_bytes = (maxval < 256) ? 1 : 2;
+	const unsigned int samples = rgb ? 3 : 1;
+	std::vector<uint8_t> raw((uint64_t)image.width*image.height*samples*sample_bytes);
+	file.read((char*)raw.data(), raw.size());
+	if((uint64_t)file.gcount() != raw.size()){
+		std::cerr << "ERROR: " << filename << " is truncated" << std::endl;
+		return false;
+	}
+
+	image.colormodel = rgb ? (padded ? UINT8_RGBX : UINT8_RGB) : UINT16_GRAY_SCALE;
+	image.data.assign((uint64_t)image.width*image.height*pixel_storage(image.colormodel), 0);
+	const uint64_t count = (uint64_t)image.width*image.height*samples;
+	for(uint64_t i=0; i<count; ++i){
+		// netpbm samples are big endian
+		uint16_t sample = (sample_bytes == 1) ? raw[i] : (raw[2*i] << 8) | raw[2*i+1];
+		if(rgb){
+			image.data[padded ? i/3*4 + i%3 : i] = (sample_bytes == 1) ? sample : sample >> 8;
+		}else{
+			image.data[2*i] = sample & 0xFF;
+			image.data[2*i+1] = sample >> 8;
+		}
+	}
+	return true;
+}
+
+bool load_image(const std::string &filename, uint32_t width, uint32_t height, uint8_t colormodel, image_t &image){
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if(!file.is_open()){
+		std::cerr << "ERROR: could not open file " << filename << std::endl;
+		return false;
+	}
+
+	char magic[2] = {0, 0};
+	file.read(magic, 2);
+	if(magic[0] == 'P' && (magic[1] == '5' || magic[1] == '6')){
+		return load_netpbm(file, filename, magic[1] == '6', colormodel == UINT8_RGBX, image);
+	}
+
+	// raw pixels in the device format
+	image.width = width;
+	image.height = height;
+	image.colormodel = colormodel;
+	image.data.resize((uint64_t)width*height*pixel_storage(colormodel));
+	file.seekg(0, std::ios::end);
+	if((uint64_t)file.tellg() != image.data.size()){
+		std::cerr << "ERROR: " << filename << " has " << file.tellg() << " bytes, the grid needs " << image.data.size() << std::endl;
+		return false;
+	}
+	file.seekg(0, std::ios::beg);
+	file.read((char*)image.data.data(), image.data.size());
+	return true;
+}
+
+void generate_image(uint32_t width, uint32_t height, uint8_t colormodel, image_t &image){
+	const unsigned int storage = pixel_storage(colormodel);
+	image.width = width;
+	image.height = height;
+	image.colormodel = colormodel;
+	image.data.resize((uint64_t)width*height*storage);
+	for(uint32_t y=0; y<height; ++y){
+		for(uint32_t x=0; x<width; ++x){
+			// 16x16 checkerboard with a horizontal gradient on top
+			uint8_t value = ((((x >> 4) ^ (y >> 4)) & 1) ? 0xA0 : 0x20) + (x & 0x3F);
+			uint8_t *pixel = &image.data[((uint64_t)y*width + x)*storage];
+			if(colormodel == UINT8_RGB || colormodel == UINT8_RGBX){
+				pixel[0] = value;
+				pixel[1] = value ^ 0x55;
+				pixel[2] = 0xFF - value;
+				if(colormodel == UINT8_RGBX){
+					pixel[3] = 0;
+				}
+			}else{
+				pixel[0] = value;
+				pixel[1] = 0;
+			}
+		}
+	}
+}
+
+bool image_diff(const uint8_t *actual, const uint8_t *expected, uint32_t width, uint32_t height, uint8_t colormodel, image_diff_t &diff){
+	const unsigned int storage = pixel_storage(colormodel);
+	// gray scale has one little endian 16 bit channel, the others one byte per channel
+	const unsigned int channel_bytes = (colormodel == UINT16_GRAY_SCALE) ? 2 : 1;
+	diff = {0, 0, 0, 0, 0, 0};
+	for(uint64_t pixel=0; pixel<(uint64_t)width*height; ++pixel){
+		const uint8_t *a = actual + pixel*storage;
+		const uint8_t *e = expected + pixel*storage;
+		for(unsigned int c=0; c<storage/channel_bytes; ++c){
+			uint32_t va = a[c*channel_bytes];
+			uint32_t ve = e[c*channel_bytes];
+			if(channel_bytes == 2){
+				va |= (uint32_t)a[c*channel_bytes+1] << 8;
+				ve |= (uint32_t)e[c*channel_bytes+1] << 8;
+			}
+			if(va != ve){
+				if(diff.pixels == 0){
+					diff.x = pixel % width;
+					diff.y = pixel / width;
+					diff.channel = c;
+					diff.actual = va;
+					diff.expected = ve;
+				}
+				++diff.pixels;
+				break;
+			}
+		}
+	}
+	return diff.pixels == 0;
+}
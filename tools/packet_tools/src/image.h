@@ -0,0 +1,69 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef IMAGE_H_
+#define IMAGE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// color models and border handling modes, see hsa_fpga.h
+#define UINT16_GRAY_SCALE	0x0
+#define UINT8_RGB		0x1
+#define UINT8_RGBX		0x2
+#define CLAMP_TO_ZERO		0x0
+#define CLAMP_TO_EDGE		0x1
+
+// pixels in the device format: gray scale as little endian uint16, RGB as three bytes,
+// RGBX as four bytes with the fourth 0; <data> holds the pixels without padding
+typedef struct image_s {
+	uint32_t width;
+	uint32_t height;
+	uint8_t colormodel;
+	std::vector<uint8_t> data;
+} image_t;
+
+// bytes per pixel, same as get_pixel_storage() of the firmware
+unsigned int pixel_storage(uint8_t colormodel);
+
+// bytes of an image in device memory including the padding of padded color
+// models, same as get_image_storage() of the firmware
+uint64_t image_storage(uint32_t width, uint32_t height, uint8_t colormodel);
+
+// gray16, rgb8 or rgbx8 as in workload files
+const char *colormodel_name(uint8_t colormodel);
+
+// loads a PGM (P5) or PPM (P6) file, which sets size and color model, or a raw file
+// with the given size and color model; reports errors on std::cerr
+bool load_image(const std::string &filename, uint32_t width, uint32_t height, uint8_t colormodel, image_t &image);
+
+// fills <image> with a deterministic pattern of edges and gradients
+void generate_image(uint32_t width, uint32_t height, uint8_t colormodel, image_t &image);
+
+// differing pixels of two images and the first one in row-major order
+typedef struct image_diff_s {
+	uint64_t pixels;
+	uint32_t x;
+	uint32_t y;
+	unsigned int channel;		// first differing channel of that pixel, the fourth of RGBX is the padding byte
+	uint32_t actual;		// channel values there
+	uint32_t expected;
+} image_diff_t;
+
+// compares the pixels of two images in the device format, true if they are equal
+bool image_diff(const uint8_t *actual, const uint8_t *expected, uint32_t width, uint32_t height, uint8_t colormodel, image_diff_t &diff);
+
+#endif
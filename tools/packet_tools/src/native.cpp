@@ -0,0 +1,253 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <cstring>
+
+#include "native.h"
+#include "arena.h"
+#include "image.h"
+#include "stimulus.h"
+#include "workload.h"
+#include "filters.h"
+
+// problems reported per run, the rest are only counted
+#define MAX_REPORTS 10
+
+static unsigned int reports;
+
+// whether to print the next problem, a note once the limit is reached
+static bool report(){
+	++reports;
+	if(reports == MAX_REPORTS+1){
+		std::cerr << "ERROR: more problems of the host-native model are not reported" << std::endl;
+	}
+	return reports <= MAX_REPORTS;
+}
+
+// whether <length> bytes at device <address> lie in the DRAM of the testbench,
+// which is also where its signal engine decrements device memory signals
+static bool in_dram(uint64_t address, uint64_t length){
+	return address >= BASE_DEVICE_MEMORY && address - BASE_DEVICE_MEMORY <= TB_DRAM_SIZE
+	       && length <= TB_DRAM_SIZE - (address - BASE_DEVICE_MEMORY);
+}
+
+static void load(const mti_image_t &image, uint64_t address, uint64_t length, uint8_t *bytes){
+	const uint64_t offset = address - BASE_DEVICE_MEMORY;
+	uint64_t word = offset/8;
+	uint64_t value = mti_word(image, word);
+	for(uint64_t i=0; i<length; ++i){
+		if((offset+i)/8 != word){
+			word = (offset+i)/8;
+			value = mti_word(image, word);
+		}
+		bytes[i] = value >> (8*((offset+i)%8));
+	}
+}
+
+// whole words are replaced, the bytes around a partial word are kept
+static void store(mti_image_t &image, uint64_t address, const uint8_t *bytes, uint64_t length){
+	const uint64_t offset = address - BASE_DEVICE_MEMORY;
+	uint64_t i = 0;
+	while(i < length){
+		const uint64_t word = (offset+i)/8;
+		const unsigned int first = (offset+i)%8;
+		uint64_t value = (first == 0 && length-i >= 8) ? 0 : mti_word(image, word);
+		for(unsigned int b=first; b<8 && i<length; ++b, ++i){
+			value = (value & ~(UINT64_C(0xFF) << (8*b))) | ((uint64_t)bytes[i] << (8*b));
+		}
+		mti_set(image, word, value);
+	}
+}
+
+static void store_header(mti_image_t &image, uint64_t slot, uint16_t header){
+	const uint64_t word = slot*(PACKETSIZE/8);
+	mti_set(image, word, (mti_word(image, word) & ~UINT64_C(0xFFFF)) | header);
+}
+
+static unsigned int header_type(uint64_t word){
+	return (word >> HSA_PACKET_HEADER_TYPE) & ((1 << HSA_PACKET_HEADER_WIDTH_TYPE)-1);
+}
+
+// the producer of the testbench writes a streamed packet into its slot and publishes it
+static void publish(mti_image_t &image, const std::vector<uint64_t> &slots, const std::vector<uint32_t> &pasids, uint64_t index){
+	const uint64_t slot = index & (MAX_QUEUE_LENGTH-1);
+	for(unsigned int w=0; w<PACKETSIZE/8; ++w){
+		mti_set(image, slot*(PACKETSIZE/8) + w, slots[index*(PACKETSIZE/8) + w]);
+	}
+	const uint64_t pasid_word = AQL_PASID_WORD + slot/2;
+	const unsigned int shift = 32*(slot&1);
+	mti_set(image, pasid_word, (mti_word(image, pasid_word) & ~(UINT64_C(0xFFFFFFFF) << shift)) | ((uint64_t)pasids[index] << shift));
+	mti_set(image, AQL_WRITE_INDEX_WORD, index+1);
+}
+
+// value of a signal, false if it is not in device memory
+static bool signal_value(const mti_image_t &image, uint64_t handle, int64_t &value){
+	uint8_t bytes[8];
+	if(!in_dram(handle, 8)){
+		return false;
+	}
+	load(image, handle, 8, bytes);
+	std::memcpy(&value, bytes, 8);
+	return true;
+}
+
+// whether the dependencies of a barrier packet are met, with the loop conditions of the firmware
+static bool barrier_ready(const mti_image_t &image, const hsa_barrier_and_packet_t *packet, bool all, uint64_t index){
+	bool any_set = false;
+	for(unsigned int d=0; d<5; ++d){
+		const uint64_t handle = packet->dep_signal[d].handle;
+		if(handle == 0){
+			continue;
+		}
+		int64_t value = 0;
+		if(!signal_value(image, handle, value)){
+			if(report()){
+				std::cerr << "ERROR: packet " << index << ": dependency signal 0x" << std::hex << handle << std::dec
+					  << " is not in device memory" << std::endl;
+			}
+			return false;
+		}
+		if(value == 0){
+			any_set = true;
+		}else if(all){
+			return false;
+		}
+	}
+	// barrier-or without dependencies spins forever in the firmware
+	return all || any_set;
+}
+
+// runs a dispatch through the host filters, false if it completes without output
+static bool run_dispatch(mti_image_t &image, const hsa_kernel_dispatch_packet_t *kp, uint64_t index, native_result_t &result){
+	const uint64_t kernarg_address = (uint64_t)kp->kernarg_address;
+	const uint64_t size = kernarg_size(kp->kernel_object);
+	uint8_t kernargs[124] = {};
+	filter_params_t params;
+	if(filter_kernel_name(kp->kernel_object) == NULL){
+		return false;
+	}
+	if(kernarg_address == 0 || !in_dram(kernarg_address, size)){
+		if(report()){
+			std::cerr << "ERROR: packet " << index << ": kernargs at 0x" << std::hex << kernarg_address << std::dec
+				  << " are not in device memory" << std::endl;
+		}
+		return false;
+	}
+	load(image, kernarg_address, size, kernargs);
+	filter_params_from_kernargs(kp->kernel_object, kernargs, params);
+	uint64_t src_address = 0;
+	uint64_t dst_address = 0;
+	std::memcpy(&src_address, kernargs, 8);
+	std::memcpy(&dst_address, kernargs + 8, 8);
+	const uint32_t width = kp->grid_size_x;
+	const uint32_t height = kp->grid_size_y;
+	const uint64_t bytes = (uint64_t)width*height*filter_pixel_storage(params.colormodel);
+	if(bytes == 0){
+		if(report()){
+			std::cerr << "ERROR: packet " << index << ": empty grid or unknown color model " << (unsigned int)params.colormodel << std::endl;
+		}
+		return false;
+	}
+	if(!in_dram(src_address, image_storage(width, height, params.colormodel)) || !in_dram(dst_address, bytes)){
+		if(report()){
+			std::cerr << "ERROR: packet " << index << ": source 0x" << std::hex << src_address << " or destination 0x" << dst_address
+				  << std::dec << " of the " << width << "x" << height << " image is not in device memory" << std::endl;
+		}
+		return false;
+	}
+	std::vector<uint8_t> src(bytes), dst(bytes);
+	load(image, src_address, bytes, src.data());
+	if(!filter_run(params, width, height, src.data(), dst.data())){
+		return false;
+	}
+	store(image, dst_address, dst.data(), bytes);
+	++result.dispatches;
+	result.pixels += (uint64_t)width*height;
+	return true;
+}
+
+void native_run(mti_image_t &image, const std::vector<uint64_t> &slots, const std::vector<uint32_t> &pasids, native_result_t &result){
+	result = {0, 0, 0, 0, 0, false};
+	reports = 0;
+	const uint64_t length = slots.size()/(PACKETSIZE/8);
+	// current_packet_number of the firmware, READ_INDEX counts the completed packets
+	uint64_t index = mti_word(image, AQL_READ_INDEX_WORD);
+	uint64_t read_index = index;
+	uint64_t write_index = mti_word(image, AQL_WRITE_INDEX_WORD);
+	while(index < write_index || index < length){
+		if(index == write_index){
+			// the slot of the next streamed packet is free once the one before is done
+			publish(image, slots, pasids, index);
+			write_index = index+1;
+		}
+		const uint64_t slot = index & (MAX_QUEUE_LENGTH-1);
+		uint64_t words[PACKETSIZE/8];
+		for(unsigned int w=0; w<PACKETSIZE/8; ++w){
+			words[w] = mti_word(image, slot*(PACKETSIZE/8) + w);
+		}
+		const unsigned int type = header_type(words[0]);
+		const bool barrier = (words[0] >> HSA_PACKET_HEADER_BARRIER) & ((1 << HSA_PACKET_HEADER_WIDTH_BARRIER)-1);
+		if(type == HSA_PACKET_TYPE_INVALID){
+			std::cerr << "ERROR: packet " << index << " is published but INVALID, the packet processor waits for it forever" << std::endl;
+			result.stalled = true;
+			break;
+		}
+		if(barrier && index != read_index){
+			std::cerr << "ERROR: packet " << index << " has the barrier bit, but an earlier packet never completes" << std::endl;
+			result.stalled = true;
+			break;
+		}
+		++index;
+		if(type == HSA_PACKET_TYPE_KERNEL_DISPATCH){
+			if(!run_dispatch(image, (const hsa_kernel_dispatch_packet_t*)words, index-1, result)){
+				++result.skipped;
+			}
+		}else if(type == HSA_PACKET_TYPE_BARRIER_AND || type == HSA_PACKET_TYPE_BARRIER_OR){
+			if(!barrier_ready(image, (const hsa_barrier_and_packet_t*)words, type == HSA_PACKET_TYPE_BARRIER_AND, index-1)){
+				std::cerr << "ERROR: packet " << index-1 << ": the dependencies of the barrier are never met" << std::endl;
+				result.stalled = true;
+				--index;
+				break;
+			}
+		}else{
+			// vendor specific and agent dispatch packets are passed over without completing
+			continue;
+		}
+
+		const uint64_t signal = words[PACKETSIZE/8-1];
+		int64_t value = 0;
+		if(signal != 0 && signal_value(image, signal, value)){
+			--value;
+			store(image, signal, (const uint8_t*)&value, 8);
+		}else if(signal != 0){
+			if(report()){
+				std::cerr << "ERROR: packet " << index-1 << ": completion signal 0x" << std::hex << signal << std::dec
+					  << " is not in device memory" << std::endl;
+			}
+		}
+		store_header(image, slot, HSA_PACKET_TYPE_INVALID);
+		++read_index;
+		mti_set(image, AQL_READ_INDEX_WORD, read_index);
+	}
+
+	// the producer fills the ring while the packet processor hangs
+	while(result.stalled && write_index < length && write_index < index + MAX_QUEUE_LENGTH){
+		publish(image, slots, pasids, write_index);
+		++write_index;
+	}
+	result.completed = read_index;
+	result.published = write_index;
+}
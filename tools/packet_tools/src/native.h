@@ -0,0 +1,57 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NATIVE_H_
+#define NATIVE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "mti.h"
+
+// Host-native model of tb_packet_processor_top for aql2mem -x, a device
+// under test that needs no simulator.
+//
+// The packets run in ring order like process_aql_packets() of the packet
+// processor, each completes before the next one starts. Kernel dispatches
+// read their kernargs and source image from the memory image and the host
+// filters (widest instruction set, all cores) stand in for the accelerator
+// cores; other kernel objects complete without output. BARRIER_AND and
+// BARRIER_OR wait for their dependency signals like the firmware, a
+// dependency nothing will decrement stops the model where the simulation
+// would hang. Vendor specific and agent dispatch packets are passed over
+// without completing. Completed slots become INVALID, READ_INDEX advances and
+// completion signals are decremented. Packets of <slots> (see
+// write_workload() of aql2mem) behind WRITE_INDEX are published as soon as
+// their slot is free, gaps are ignored.
+//
+// The image afterwards has the layout of a DRAM dump of the testbench, so
+// aql2mem -d checks it like a simulation result. The reference check of
+// aql2mem -d -r uses the same host filters, so it covers the packet path of
+// the model and not the filter results.
+
+typedef struct native_result_s {
+	uint64_t completed;		// READ_INDEX at the end
+	uint64_t published;		// WRITE_INDEX at the end
+	uint64_t dispatches;		// dispatches run through the host filters
+	uint64_t pixels;		// and their pixels
+	uint64_t skipped;		// dispatches completed without output
+	bool stalled;			// the packet processor waits forever
+} native_result_t;
+
+// runs the packets of <image>, reports problems on std::cerr
+void native_run(mti_image_t &image, const std::vector<uint64_t> &slots, const std::vector<uint32_t> &pasids, native_result_t &result);
+
+#endif
@@ -0,0 +1,80 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <fstream>
+
+#include "stimulus.h"
+
+static void write_word(std::ofstream &file, uint64_t word, uint64_t value){
+	file << "M " << word << " " << value << std::endl;
+}
+
+// publishes all packets written so far
+static void publish(std::ofstream &file, uint64_t &write_index, uint64_t written){
+	if(written > write_index){
+		write_index = written;
+		write_word(file, AQL_WRITE_INDEX_WORD, write_index);
+		file << "I" << std::endl;
+	}
+}
+
+bool write_stimulus(const char *filename, const std::vector<uint64_t> &slots, const std::vector<uint32_t> &pasids,
+		    const std::vector<uint64_t> &arrival, unsigned int preloaded){
+	std::ofstream file(filename);
+	if(!file.is_open()){
+		std::cerr << "ERROR: could not open file " << filename << std::endl;
+		return false;
+	}
+
+	const uint64_t length = pasids.size();
+	file << "# aql2mem stimulus packets=" << length << " preloaded=" << preloaded << " queue=" << MAX_QUEUE_LENGTH << std::endl;
+	file << std::hex;
+
+	// PASIDs share a word in pairs, keep the ring contents to rewrite the neighbour
+	std::vector<uint32_t> ring_pasid(MAX_QUEUE_LENGTH, 0);
+	for(unsigned int i=0; i<preloaded; ++i){
+		ring_pasid[i] = pasids[i];
+	}
+
+	uint64_t write_index = preloaded;
+	uint64_t read_index = 0;
+	for(uint64_t i=preloaded; i<length; ++i){
+		const uint64_t gap = (i == 0) ? arrival[i] : arrival[i] - arrival[i-1];
+		if(gap != 0){
+			publish(file, write_index, i);
+			file << "D " << gap << std::endl;
+		}
+		// the slot is free once the packet MAX_QUEUE_LENGTH before this one completed
+		if(i >= read_index + MAX_QUEUE_LENGTH){
+			publish(file, write_index, i);
+			read_index = i - MAX_QUEUE_LENGTH + 1;
+			file << "R " << AQL_READ_INDEX_WORD << " " << read_index << std::endl;
+		}
+
+		const unsigned int slot = i & (MAX_QUEUE_LENGTH-1);
+		const uint64_t *packet = &slots[i*(PACKETSIZE/8)];
+		for(unsigned int w=1; w<PACKETSIZE/8; ++w){
+			write_word(file, slot*(PACKETSIZE/8) + w, packet[w]);
+		}
+		ring_pasid[slot] = pasids[i];
+		const unsigned int pair = slot & ~1u;
+		write_word(file, AQL_PASID_WORD + slot/2, ((uint64_t)ring_pasid[pair+1] << 32) | ring_pasid[pair]);
+		// the header makes the packet valid for the packet processor
+		write_word(file, slot*(PACKETSIZE/8), packet[0]);
+	}
+	publish(file, write_index, length);
+	return true;
+}
@@ -0,0 +1,56 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STIMULUS_H_
+#define STIMULUS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "hsa_packets.h"
+
+#ifndef MAX_QUEUE_LENGTH
+#define MAX_QUEUE_LENGTH 128
+#endif
+
+// Stimulus file for workloads that do not fit into the ring or arrive over time.
+//
+// tb_packet_processor_top replays it as the host side producer of the queue
+// (generic G_AQL_STIMULUS_FILE). One command per line, all numbers are
+// hexadecimal, '#' starts a comment:
+//
+//   D <cycles>			wait <cycles> clock cycles
+//   M <word> <value>		write the 64 bit <value> to DRAM word <word>
+//   R <word> <value>		wait until DRAM word <word> is at least <value>
+//   I				raise the AQL interrupt (doorbell)
+//
+// Words are 64 bit indices relative to the DRAM base, the same as the line
+// numbers of the MTI image.
+
+// queue layout in DRAM words, see printfile() of aql2mem
+#define AQL_PASID_WORD		(MAX_QUEUE_LENGTH*(PACKETSIZE/8))
+#define AQL_READ_INDEX_WORD	(AQL_PASID_WORD + (MAX_QUEUE_LENGTH*4)/8)
+#define AQL_WRITE_INDEX_WORD	(AQL_READ_INDEX_WORD + 1)
+
+// Writes the producer for packets <preloaded> and later of <slots> (PACKETSIZE/8
+// words per packet). The first <preloaded> packets are already in the ring and
+// published. Before each packet the producer waits for the difference of its
+// arrival cycle to the previous one, so back pressure delays all later packets.
+// A packet is written to its slot header word last, waiting packets are
+// published with a single WRITE_INDEX update and doorbell.
+bool write_stimulus(const char *filename, const std::vector<uint64_t> &slots, const std::vector<uint32_t> &pasids,
+		    const std::vector<uint64_t> &arrival, unsigned int preloaded);
+
+#endif
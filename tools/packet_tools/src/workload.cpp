@@ -0,0 +1,417 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <map>
+
+#include "workload.h"
+#include "image.h"
+
+// kernel objects of the FPGA operations, see fpga_operation_type_t in hsa_fpga.h
+typedef struct kernel_name_s {
+	const char *name;
+	uint64_t kernel_object;
+} kernel_name_t;
+
+static const kernel_name_t kernel_names[] = {
+	{"SOBELX3x3",        0x01},
+	{"SOBELY3x3",        0x02},
+	{"SOBELXY3x3",       0x03},
+	{"SOBELX5x5",        0x04},
+	{"SOBELY5x5",        0x05},
+	{"SOBELXY5x5",       0x06},
+	{"GAUSS3x3",         0x11},
+	{"GAUSS5x5",         0x12},
+	{"MIN_FILTER3x3",    0x21},
+	{"MIN_FILTER5x5",    0x22},
+	{"MAX_FILTER3x3",    0x23},
+	{"MAX_FILTER5x5",    0x24},
+	{"MEDIAN_FILTER3x3", 0x25},
+	{"MEDIAN_FILTER5x5", 0x26},
+	{"CUSTOM_FILTER3x3", 0x31},
+	{"CUSTOM_FILTER5x5", 0x32},
+};
+
+void tokenize(std::string line, std::vector<std::string> &vec, char separator){
+	unsigned int last = 0;
+	unsigned int length = 0;
+	for(unsigned int i=0; i<line.length(); ++i){
+		if(line[i]==separator || line[i]=='\t'){
+			if(length != 0){
+				vec.push_back(line.substr(last,length));
+			}
+			last = i+1;
+			length = 0;
+		}else{
+			++length;
+		}
+	}
+	if(length != 0){
+		vec.push_back(line.substr(last,length));
+	}
+}
+
+static void report(const char *filename, unsigned int line, std::string message){
+	std::cerr << "ERROR: " << filename << ":" << line << ": " << message << std::endl;
+}
+
+bool parse_number(std::string s, uint64_t max, uint64_t &value){
+	try{
+		size_t pos = 0;
+		value = std::stoull(s, &pos, 0);
+		return pos == s.length() && value <= max;
+	}catch(const std::exception &e){
+		return false;
+	}
+}
+
+static bool parse_signed(std::string s, int64_t min, int64_t max, int64_t &value){
+	try{
+		size_t pos = 0;
+		value = std::stoll(s, &pos, 0);
+		return pos == s.length() && value >= min && value <= max;
+	}catch(const std::exception &e){
+		return false;
+	}
+}
+
+static bool parse_list(std::string s, uint64_t max, uint64_t *values, unsigned int max_count, unsigned int &count){
+	std::vector<std::string> items;
+	tokenize(s, items, ',');
+	if(items.size() == 0 || items.size() > max_count){
+		return false;
+	}
+	for(unsigned int i=0; i<items.size(); ++i){
+		if(!parse_number(items[i], max, values[i])){
+			return false;
+		}
+	}
+	count = items.size();
+	return true;
+}
+
+static bool parse_type(std::string s, hsa_packet_type_t &type){
+	if(s.compare("KERNEL_DISPATCH")==0){
+		type = HSA_PACKET_TYPE_KERNEL_DISPATCH;
+	}else if(s.compare("BARRIER_AND")==0){
+		type = HSA_PACKET_TYPE_BARRIER_AND;
+	}else if(s.compare("BARRIER_OR")==0){
+		type = HSA_PACKET_TYPE_BARRIER_OR;
+	}else if(s.compare("VENDOR_SPECIFIC")==0){
+		type = HSA_PACKET_TYPE_VENDOR_SPECIFIC;
+	}else if(s.compare("INVALID")==0){
+		type = HSA_PACKET_TYPE_INVALID;
+	}else{
+		return false;
+	}
+	return true;
+}
+
+static bool parse_scope(std::string s, hsa_fence_scope_t &scope){
+	if(s.compare("none")==0){
+		scope = HSA_FENCE_SCOPE_NONE;
+	}else if(s.compare("agent")==0){
+		scope = HSA_FENCE_SCOPE_AGENT;
+	}else if(s.compare("system")==0){
+		scope = HSA_FENCE_SCOPE_SYSTEM;
+	}else{
+		return false;
+	}
+	return true;
+}
+
+bool parse_kernel(std::string s, uint64_t &kernel_object){
+	for(unsigned int i=0; i<sizeof(kernel_names)/sizeof(kernel_names[0]); ++i){
+		if(s.compare(kernel_names[i].name)==0){
+			kernel_object = kernel_names[i].kernel_object;
+			return true;
+		}
+	}
+	return parse_number(s, UINT64_MAX, kernel_object);
+}
+
+const char *kernel_name(uint64_t kernel_object){
+	for(unsigned int i=0; i<sizeof(kernel_names)/sizeof(kernel_names[0]); ++i){
+		if(kernel_names[i].kernel_object == kernel_object){
+			return kernel_names[i].name;
+		}
+	}
+	return NULL;
+}
+
+// kernargs: src_address (64 bit) | dest_address (64 bit) | colormodel (8 bit) | borderhandling (8 bit) | threshold (16 bit)
+//           (| optional: normalization (16 bit + 16 bit padding) | filter mask (25x4 byte or 9x4 byte))
+uint64_t kernarg_size(uint64_t kernel_object){
+	if(kernel_object == CUSTOM_FILTER3x3){
+		return 60;
+	}else if(kernel_object == CUSTOM_FILTER5x5){
+		return 124;
+	}
+	return 20;
+}
+
+// same values as the "default" packet of aql2mem
+workload_packet_t default_packet(hsa_packet_type_t type, unsigned int line){
+	workload_packet_t p = {};
+	p.type = type;
+	p.barrier = 0;
+	p.acquire = HSA_FENCE_SCOPE_NONE;
+	p.release = HSA_FENCE_SCOPE_NONE;
+	p.pasid = 15;
+	p.completion_signal = 0;
+	p.repeat = 1;
+	p.gap = 0;
+	p.kernel_object = UINT64_C(0x000100000000FFFF);
+	p.dim = 1;
+	p.grid_size[0] = 1024;
+	p.grid_size[1] = 1;
+	p.grid_size[2] = 1;
+	p.workgroup_size[0] = 64;
+	p.workgroup_size[1] = 1;
+	p.workgroup_size[2] = 1;
+	p.num_dep_signals = 0;
+	p.auto_signal = false;
+	p.signal_value = 1;
+	p.auto_kernarg = false;
+	p.colormodel = UINT16_GRAY_SCALE;
+	p.borderhandling = CLAMP_TO_ZERO;
+	p.line = line;
+	return p;
+}
+
+// parses the dependency list, @<label> refers to the last earlier packet named <label>
+static std::string parse_deps(std::string value, const std::map<std::string,int> &names, workload_packet_t &p){
+	std::vector<std::string> items;
+	tokenize(value, items, ',');
+	if(items.size() == 0 || items.size() > 5){
+		return "dep takes one to five signal handles";
+	}
+	for(unsigned int i=0; i<items.size(); ++i){
+		p.dep_signal[i] = 0;
+		p.dep_packet[i] = -1;
+		if(items[i][0] == '@'){
+			std::map<std::string,int>::const_iterator it = names.find(items[i].substr(1));
+			if(it == names.end()){
+				return "no earlier packet is named " + items[i].substr(1);
+			}
+			p.dep_packet[i] = it->second;
+		}else if(!parse_number(items[i], UINT64_MAX, p.dep_signal[i])){
+			return "invalid dependency signal " + items[i];
+		}
+	}
+	p.num_dep_signals = items.size();
+	return "";
+}
+
+// applies one key=value pair to <p>, returns an error message or an empty string
+static std::string parse_option(std::string key, std::string value, const std::map<std::string,int> &names, workload_packet_t &p){
+	const bool dispatch = p.type == HSA_PACKET_TYPE_KERNEL_DISPATCH;
+	const bool barrier = p.type == HSA_PACKET_TYPE_BARRIER_AND || p.type == HSA_PACKET_TYPE_BARRIER_OR;
+	uint64_t n = 0;
+	int64_t sn = 0;
+	uint64_t list[5];
+	unsigned int count = 0;
+
+	if(key.compare("barrier")==0){
+		if(value.compare("y")==0){
+			p.barrier = 1;
+		}else if(value.compare("n")==0){
+			p.barrier = 0;
+		}else{
+			return "barrier must be y or n";
+		}
+	}else if(key.compare("acquire")==0){
+		if(!parse_scope(value, p.acquire)) return "fence scope must be none, agent or system";
+	}else if(key.compare("release")==0){
+		if(!parse_scope(value, p.release)) return "fence scope must be none, agent or system";
+	}else if(key.compare("pasid")==0){
+		if(!parse_number(value, UINT32_MAX, n)) return "invalid pasid " + value;
+		p.pasid = n;
+	}else if(key.compare("signal")==0){
+		p.auto_signal = value.compare("auto")==0;
+		if(!p.auto_signal && !parse_number(value, UINT64_MAX, p.completion_signal)) return "invalid signal " + value;
+	}else if(key.compare("signal_value")==0){
+		if(!parse_signed(value, INT64_MIN, INT64_MAX, p.signal_value)) return "invalid signal value " + value;
+	}else if(key.compare("name")==0){
+		if(value.empty()) return "empty name";
+		p.name = value;
+	}else if(key.compare("repeat")==0){
+		if(!parse_number(value, UINT32_MAX, n) || n == 0) return "invalid repeat count " + value;
+		p.repeat = n;
+	}else if(key.compare("gap")==0){
+		if(!parse_number(value, UINT64_MAX, p.gap)) return "invalid gap " + value;
+	}else if(dispatch && key.compare("kernel")==0){
+		if(!parse_kernel(value, p.kernel_object)) return "unknown kernel " + value;
+	}else if(dispatch && key.compare("dim")==0){
+		if(!parse_number(value, 3, n) || n == 0) return "dim must be 1, 2 or 3";
+		p.dim = n;
+	}else if(dispatch && key.compare("grid")==0){
+		if(!parse_list(value, UINT32_MAX, list, 3, count)) return "invalid grid size " + value;
+		for(unsigned int i=0; i<3; ++i){
+			p.grid_size[i] = (i < count) ? list[i] : 1;
+		}
+	}else if(dispatch && key.compare("wg")==0){
+		if(!parse_list(value, UINT16_MAX, list, 3, count)) return "invalid workgroup size " + value;
+		for(unsigned int i=0; i<3; ++i){
+			p.workgroup_size[i] = (i < count) ? list[i] : 1;
+		}
+	}else if(dispatch && key.compare("kernarg")==0){
+		p.auto_kernarg = value.compare("auto")==0;
+		if(!p.auto_kernarg && !parse_number(value, UINT64_MAX, p.kernarg_address)) return "invalid kernarg address " + value;
+	}else if(dispatch && key.compare("src")==0){
+		if(value.empty()) return "empty source image";
+		p.image = value;
+		p.auto_kernarg = true;
+	}else if(dispatch && key.compare("golden")==0){
+		if(value.empty()) return "empty golden image";
+		p.golden = value;
+	}else if(dispatch && key.compare("colormodel")==0){
+		if(value.compare("gray16")==0){
+			p.colormodel = UINT16_GRAY_SCALE;
+		}else if(value.compare("rgb8")==0){
+			p.colormodel = UINT8_RGB;
+		}else if(value.compare("rgbx8")==0){
+			p.colormodel = UINT8_RGBX;
+		}else{
+			return "colormodel must be gray16, rgb8 or rgbx8";
+		}
+	}else if(dispatch && key.compare("border")==0){
+		if(value.compare("zero")==0){
+			p.borderhandling = CLAMP_TO_ZERO;
+		}else if(value.compare("edge")==0){
+			p.borderhandling = CLAMP_TO_EDGE;
+		}else{
+			return "border must be zero or edge";
+		}
+	}else if(dispatch && key.compare("threshold")==0){
+		if(!parse_number(value, UINT16_MAX, n)) return "invalid threshold " + value;
+		p.threshold = n;
+	}else if(dispatch && key.compare("normalization")==0){
+		if(!parse_number(value, UINT16_MAX, n)) return "invalid normalization " + value;
+		p.normalization = n;
+	}else if(dispatch && key.compare("mask")==0){
+		std::vector<std::string> items;
+		tokenize(value, items, ',');
+		if(items.size() != 9 && items.size() != 25) return "mask takes 9 or 25 values";
+		p.mask.clear();
+		for(unsigned int i=0; i<items.size(); ++i){
+			if(!parse_signed(items[i], INT32_MIN, INT32_MAX, sn)) return "invalid mask value " + items[i];
+			p.mask.push_back(sn);
+		}
+	}else if(dispatch && key.compare("private")==0){
+		if(!parse_number(value, UINT32_MAX, n)) return "invalid private segment size " + value;
+		p.private_segment_size = n;
+	}else if(dispatch && key.compare("group")==0){
+		if(!parse_number(value, UINT32_MAX, n)) return "invalid group segment size " + value;
+		p.group_segment_size = n;
+	}else if(barrier && key.compare("dep")==0){
+		return parse_deps(value, names, p);
+	}else{
+		return "unknown option " + key;
+	}
+	return "";
+}
+
+// ARENA base=<addr> size=<n>
+static std::string parse_arena(const std::vector<std::string> &tokens, arena_t &arena){
+	uint64_t base = arena.base;
+	uint64_t size = arena.size;
+	for(unsigned int i=1; i<tokens.size(); ++i){
+		size_t eq = tokens[i].find('=');
+		std::string key = tokens[i].substr(0,eq);
+		std::string value = (eq == std::string::npos) ? "" : tokens[i].substr(eq+1);
+		if(key.compare("base")==0){
+			if(!parse_number(value, UINT64_MAX, base)) return "invalid arena base " + value;
+		}else if(key.compare("size")==0){
+			if(!parse_number(value, UINT64_MAX, size)) return "invalid arena size " + value;
+		}else{
+			return "unknown arena option " + tokens[i];
+		}
+	}
+	arena_init(arena, base, size);
+	if(!arena_valid(arena)){
+		return "arena must be 16 byte aligned and lie in device memory behind PP_DRAM_RESERVED";
+	}
+	return "";
+}
+
+bool read_workload(const char *filename, std::vector<workload_packet_t> &packets, arena_t &arena){
+	std::ifstream file(filename);
+	if(!file.is_open()){
+		std::cerr << "ERROR: could not open file " << filename << std::endl;
+		return false;
+	}
+
+	std::map<std::string,int> names;
+	std::string line = "";
+	unsigned int line_number = 0;
+	while(std::getline(file,line)){
+		++line_number;
+		line = line.substr(0, line.find('#'));
+		std::vector<std::string> tokens;
+		tokenize(line, tokens, ' ');
+		if(tokens.size() == 0){
+			continue;
+		}
+
+		if(tokens[0].compare("ARENA")==0){
+			std::string error = parse_arena(tokens, arena);
+			if(!error.empty()){
+				report(filename, line_number, error);
+				return false;
+			}
+			continue;
+		}
+
+		hsa_packet_type_t type;
+		if(!parse_type(tokens[0], type)){
+			report(filename, line_number, "unknown packet type " + tokens[0]);
+			return false;
+		}
+		workload_packet_t p = default_packet(type, line_number);
+		for(unsigned int i=1; i<tokens.size(); ++i){
+			size_t eq = tokens[i].find('=');
+			if(eq == std::string::npos){
+				report(filename, line_number, "expected key=value, got " + tokens[i]);
+				return false;
+			}
+			std::string error = parse_option(tokens[i].substr(0,eq), tokens[i].substr(eq+1), names, p);
+			if(!error.empty()){
+				report(filename, line_number, error);
+				return false;
+			}
+		}
+		if((p.kernel_object == CUSTOM_FILTER3x3 || p.kernel_object == CUSTOM_FILTER5x5) && p.auto_kernarg
+		   && p.mask.size() != ((p.kernel_object == CUSTOM_FILTER3x3) ? 9 : 25)){
+			report(filename, line_number, "custom filters need a mask of matching size");
+			return false;
+		}
+		if(!p.name.empty()){
+			names[p.name] = packets.size();
+		}
+		packets.push_back(p);
+	}
+	return true;
+}
+
+uint64_t workload_length(const std::vector<workload_packet_t> &packets){
+	uint64_t length = 0;
+	for(unsigned int i=0; i<packets.size(); ++i){
+		length += packets[i].repeat;
+	}
+	return length;
+}
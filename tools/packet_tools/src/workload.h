@@ -0,0 +1,142 @@
+// Copyright (C) 2017 Philipp Holzinger
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WORKLOAD_H_
+#define WORKLOAD_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hsa_packets.h"
+#include "arena.h"
+
+// Declarative workload description for aql2mem.
+//
+// Every line describes one AQL packet, '#' starts a comment:
+//
+//   <packet type> [key=value ...]
+//
+// packet types: KERNEL_DISPATCH, BARRIER_AND, BARRIER_OR, VENDOR_SPECIFIC, INVALID
+//
+// keys of all packet types:
+//   barrier=y|n				barrier bit (default n)
+//   acquire=none|agent|system		acquire fence scope (default none)
+//   release=none|agent|system		release fence scope (default none)
+//   pasid=<n>				process ID (default 15)
+//   signal=<addr>|auto			completion signal handle (default 0, no signal),
+//					auto places a signal word in the arena
+//   signal_value=<n>			initial value of an auto signal (default 1)
+//   name=<label>				name for dep=@<label> of later packets
+//   repeat=<n>				number of identical packets (default 1)
+//   gap=<n>				cycles the producer waits before each of the packets,
+//					only used when the workload is streamed (default 0)
+//
+// keys of KERNEL_DISPATCH:
+//   kernel=<name>|<n>			fpga_operation_type_t name (e.g. SOBELX3x3) or kernel object
+//   dim=1..3				number of dimensions (default 1)
+//   grid=<x>[,<y>[,<z>]]			grid size (default 1024,1,1)
+//   wg=<x>[,<y>[,<z>]]			workgroup size (default 64,1,1)
+//   kernarg=<addr>|auto			kernarg address (default 0), auto places a kernarg block in the arena
+//   private=<n>				private segment size (default 0)
+//   group=<n>				group segment size (default 0)
+//   src=<file>|generated			source image, implies kernarg=auto; PGM (P5) and PPM (P6)
+//					files set the grid, other files are raw pixels of the grid size
+//   colormodel=gray16|rgb8|rgbx8	color model of raw and generated images (default gray16),
+//					a PPM is stored as RGBX with rgbx8
+//   border=zero|edge			border handling (default zero)
+//   threshold=<n>				threshold kernarg (default 0), SOBELXY and custom filters only
+//   normalization=<n>			normalization kernarg of custom filters (default 0), the
+//					firmware does not apply it
+//   mask=<v>,<v>,...			9 or 25 mask values of custom filters
+//   golden=<file>				expected output image for aql2mem -d, PGM, PPM or raw
+//					pixels like src
+//
+// keys of BARRIER_AND and BARRIER_OR:
+//   dep=<addr>|@<label>[,...]		up to five dependency signal handles, @<label> is the
+//					completion signal of the last earlier packet with that name
+//
+// Other lines:
+//   ARENA base=<addr> size=<n>		device memory used for auto kernargs, images and signals
+//
+// Numbers are decimal or hexadecimal with a 0x prefix.
+
+// kernel objects that take their filter mask from the kernargs
+#define CUSTOM_FILTER3x3	0x31
+#define CUSTOM_FILTER5x5	0x32
+
+typedef struct workload_packet_s {
+	hsa_packet_type_t type;
+	uint16_t barrier;
+	hsa_fence_scope_t acquire;
+	hsa_fence_scope_t release;
+	uint32_t pasid;
+	uint64_t completion_signal;
+	unsigned int repeat;
+	uint64_t gap;
+	// kernel dispatch
+	uint64_t kernel_object;
+	uint16_t dim;
+	uint32_t grid_size[3];
+	uint16_t workgroup_size[3];
+	uint64_t kernarg_address;
+	uint32_t private_segment_size;
+	uint32_t group_segment_size;
+	// barrier and / or, dep_packet is the index of a named dependency or -1
+	uint64_t dep_signal[5];
+	int dep_packet[5];
+	unsigned int num_dep_signals;
+	// data placed in the arena by aql2mem
+	std::string name;
+	bool auto_signal;
+	int64_t signal_value;
+	bool auto_kernarg;
+	std::string image;
+	uint8_t colormodel;
+	uint8_t borderhandling;
+	uint16_t threshold;
+	uint16_t normalization;
+	std::vector<int32_t> mask;
+	std::string golden;
+	// position in the workload file for error messages
+	unsigned int line;
+} workload_packet_t;
+
+// splits <line> at <separator> and tabs, empty items are dropped
+void tokenize(std::string line, std::vector<std::string> &vec, char separator);
+
+// parses a decimal or 0x prefixed hexadecimal number not larger than <max>
+bool parse_number(std::string s, uint64_t max, uint64_t &value);
+
+// parses an fpga_operation_type_t name or a plain kernel object
+bool parse_kernel(std::string s, uint64_t &kernel_object);
+
+// fpga_operation_type_t name of a kernel object or NULL
+const char *kernel_name(uint64_t kernel_object);
+
+// bytes of the kernarg block of a dispatch, the size of the kernarg DMA of the packet processor
+uint64_t kernarg_size(uint64_t kernel_object);
+
+// initial values of a packet of the given type
+workload_packet_t default_packet(hsa_packet_type_t type, unsigned int line);
+
+// parses <filename> into <packets> and the ARENA line into <arena>,
+// reports errors on std::cerr and returns false on failure
+bool read_workload(const char *filename, std::vector<workload_packet_t> &packets, arena_t &arena);
+
+// total number of ring slots the workload occupies
+uint64_t workload_length(const std::vector<workload_packet_t> &packets);
+
+#endif
@@ -0,0 +1,12 @@
+# Example workload for aql2mem -f, see src/workload.h for the format.
+#
+# Addresses are plain device addresses and are written to the packets as
+# they are, the memory they point to is not part of the image.
+
+# two independent streams of sobel filters on a VGA gray scale image
+KERNEL_DISPATCH kernel=SOBELX3x3 dim=2 grid=640,480 wg=64,1 kernarg=0x0001000010000000 signal=0x100 pasid=1 repeat=8
+KERNEL_DISPATCH kernel=SOBELY3x3 dim=2 grid=640,480 wg=64,1 kernarg=0x0001000010000100 signal=0x108 pasid=2 repeat=8
+
+# wait for both streams before the gauss pass
+BARRIER_AND dep=0x100,0x108 signal=0x110 pasid=1 acquire=system release=system
+KERNEL_DISPATCH kernel=GAUSS5x5 dim=2 grid=640,480 wg=64,1 kernarg=0x0001000010000200 signal=0x118 pasid=1 barrier=y repeat=4
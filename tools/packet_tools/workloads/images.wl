@@ -0,0 +1,16 @@
+# Example workload with real data for aql2mem -f, see src/workload.h for the format.
+#
+# Kernargs, images and signals are placed in the arena and written to the
+# memory image together with the queue.
+
+ARENA base=0x0001000000200000 size=0x200000
+
+# two filters on the same generated QVGA source, each with its own output
+KERNEL_DISPATCH kernel=SOBELX3x3 src=generated grid=320,240 border=edge signal=auto name=sobel pasid=1
+KERNEL_DISPATCH kernel=GAUSS5x5 src=generated grid=320,240 signal=auto name=gauss pasid=1
+
+# custom sharpening filter on a small RGB image
+KERNEL_DISPATCH kernel=CUSTOM_FILTER3x3 src=generated grid=64,48 colormodel=rgb8 normalization=0 mask=0,-1,0,-1,5,-1,0,-1,0 signal=auto name=sharpen pasid=2
+
+# completes once all three filters are done
+BARRIER_AND dep=@sobel,@gauss,@sharpen signal=auto pasid=1
@@ -19,25 +19,75 @@
 #include <fstream>
 #include <vector>
 
-void tokenize(std::string line, std::vector<std::string> &vec, char separator){
-	unsigned int last = 0;
-	unsigned int length = 0;
-	for(unsigned int i=0; i<line.length(); ++i){
-		if(line[i]==separator){
-			std::string item = line.substr(last,length);
-			vec.push_back(item);
-			last = i+1;
-			length = 0;
-		}else{
-			++length;
-		}
+#include "mti.h"
+#include "elf_file.h"
+
+// 64 bit word <index> of a segment, 32 bit memories hold the lower half at the even address
+static uint64_t segment_word(const mti_image_t &image, uint64_t index){
+	if(image.word_digits == 8){
+		return (mti_word(image, 2*index+1) << 32) | (mti_word(image, 2*index) & 0xFFFFFFFF);
 	}
-	if(line.length() >= 1){
-		if(line[line.length()-1]!=separator){
-			std::string item = line.substr(last,length);
-			vec.push_back(item);
+	return mti_word(image, index);
+}
+
+// zero runs shorter than this are kept inside an extent, an extent
+// costs three words of offset, length and pointer
+#define MIN_ZERO_RUN 4
+
+// words [offset, offset+length) of a segment
+typedef struct segment_extent_s {
+	uint64_t offset;
+	uint64_t length;
+} segment_extent_t;
+
+// The extents of the non-zero words among the first <length> 64 bit words
+// of a segment. Only the loaded runs of the image are scanned, unloaded
+// words are zero anyway.
+static void find_extents(const mti_image_t &image, uint64_t length, std::vector<segment_extent_t> &extents){
+	extents.clear();
+	const uint64_t ratio = (image.word_digits == 8) ? 2 : 1;
+	uint64_t start = 0;		// first word of the open extent
+	uint64_t last = 0;		// last non-zero word of the open extent
+	bool open = false;
+	for(mti_runs_t::const_iterator run=image.runs.begin(); run!=image.runs.end(); ++run){
+		const uint64_t first = run->first / ratio;
+		const uint64_t end = (run->first + run->second.size() + ratio-1) / ratio;
+		for(uint64_t index=first; index<end && index<length; ++index){
+			if(segment_word(image, index) == 0){
+				continue;
+			}
+			if(open && index - last > MIN_ZERO_RUN){
+				extents.push_back({start, last-start+1});
+				open = false;
+			}
+			if(!open){
+				start = index;
+				open = true;
+			}
+			last = index;
 		}
 	}
+	if(open){
+		extents.push_back({start, last-start+1});
+	}
+}
+
+// text (<memory> 0) or data (<memory> 1) memory of a firmware ELF file,
+// words as in the instr.mem and data.mem files of scripts/elf2mem.sh
+static bool read_elf_memory(const char *filename, unsigned int memory, mti_image_t &image){
+	elf_file_t elf;
+	if(!elf_read(filename, elf)){
+		return false;
+	}
+	const uint64_t text_origin = elf.is_64 ? ELF64_TEXT_ORIGIN : ELF32_TEXT_ORIGIN;
+	const uint64_t data_origin = elf.is_64 ? ELF64_DATA_ORIGIN : ELF32_DATA_ORIGIN;
+	mti_init(image);
+	if(memory == 0){
+		elf_region(elf, text_origin, data_origin, 4, image);
+	}else{
+		elf_region(elf, data_origin, UINT64_MAX, elf.is_64 ? 8 : 4, image);
+	}
+	return true;
 }
 
 int main(int argc, char *argv[]){
@@ -52,79 +102,84 @@ int main(int argc, char *argv[]){
 		std::cerr << "ERROR: could not open file " << argv[1] << std::endl;
 		return EXIT_FAILURE;
 	}
-	std::ofstream outfile("code_segments.h");
 
 	// read header
-	std::string config_line = "";
-	std::getline(config_file,config_line);
+	std::string header_line = "";
+	std::getline(config_file,header_line);
 	if(config_file.eof()){
 		std::cerr << "ERROR: wrong file format - empty input file!!" << std::endl;
 		return EXIT_FAILURE;
 	}
-	std::vector<std::string> header_strings;
-	tokenize(config_line, header_strings,' ');
+	std::vector<std::string_view> header_strings;
+	mti_split(header_line, ' ', header_strings);
 	
 	// read code paths and data sizes	
-	std::vector<std::vector<std::string>> system_strings;
-	std::getline(config_file,config_line);
-	while(!config_file.eof()){
-		std::vector<std::string> processor_strings;
-		tokenize(config_line, processor_strings,' ');
-		system_strings.push_back(processor_strings);
+	std::vector<std::string> config_lines;
+	std::vector<std::vector<std::string_view>> system_strings;
+	std::string config_line = "";
+	while(std::getline(config_file,config_line)){
+		config_lines.push_back(config_line);
+	}
+	for(unsigned int i=0; i<config_lines.size(); ++i){
+		std::vector<std::string_view> processor_strings;
+		mti_split(config_lines[i], ' ', processor_strings);
+		if(processor_strings.empty()){
+			continue;
+		}
 		if(processor_strings.size() != 3){
-			std::cerr << "ERROR: wrong line format: " << config_line << std::endl;
+			std::cerr << "ERROR: wrong line format: " << config_lines[i] << std::endl;
 			return EXIT_FAILURE;
 		}
-		std::getline(config_file,config_line);
+		system_strings.push_back(processor_strings);
+	}
+
+	mti_writer_t outfile;
+	if(!mti_writer_open(outfile, "code_segments.h", false)){
+		return EXIT_FAILURE;
 	}
 
 	// write output file header
-	outfile << "// this file is machine generated by vsim2cmd, do not edit below!!!" << std::endl;
-	outfile << "#ifndef CODE_SEGMENTS_H_" << std::endl;
-	outfile << "#define CODE_SEGMENTS_H_" << std::endl << std::endl;
+	mti_writer_text(outfile, "// this file is machine generated by vsim2cmd, do not edit below!!!\n");
+	mti_writer_text(outfile, "#ifndef CODE_SEGMENTS_H_\n");
+	mti_writer_text(outfile, "#define CODE_SEGMENTS_H_\n\n");
 	
-	outfile << "#include <stdint.h>"      << std::endl << std::endl;
+	mti_writer_text(outfile, "#include <stddef.h>\n");
+	mti_writer_text(outfile, "#include <stdint.h>\n\n");
 
-	// write segment struct definition
-	outfile << "typedef struct code_segment_s{" << std::endl;
-	outfile << "    uint64_t *instructions;"    << std::endl;
-	outfile << "    uint64_t *data;"            << std::endl;
-	outfile << "    uint64_t imem_length;"      << std::endl;
-	outfile << "    uint64_t dmem_length;"      << std::endl;
-	outfile << "} code_segment_t;"              << std::endl << std::endl;
+	// write segment struct definitions, a segment is a list of extents
+	// holding its non-zero words, the words between them are zero
+	mti_writer_text(outfile, "typedef struct code_extent_s{\n");
+	mti_writer_text(outfile, "    uint64_t offset;\n");
+	mti_writer_text(outfile, "    uint64_t length;\n");
+	mti_writer_text(outfile, "    uint64_t *words;\n");
+	mti_writer_text(outfile, "} code_extent_t;\n\n");
+	mti_writer_text(outfile, "typedef struct code_segment_s{\n");
+	mti_writer_text(outfile, "    code_extent_t *instructions;\n");
+	mti_writer_text(outfile, "    code_extent_t *data;\n");
+	mti_writer_text(outfile, "    uint64_t imem_extents;\n");
+	mti_writer_text(outfile, "    uint64_t dmem_extents;\n");
+	mti_writer_text(outfile, "    uint64_t imem_length;\n");
+	mti_writer_text(outfile, "    uint64_t dmem_length;\n");
+	mti_writer_text(outfile, "} code_segment_t;\n\n");
 
 	// generate code dump as C arrays
 	std::vector<std::string> generated_variables;
-	std::vector<int> imem_sizes;
-	std::vector<int> dmem_sizes;
+	std::vector<uint64_t> extent_counts;
+	std::vector<uint64_t> imem_sizes;
+	std::vector<uint64_t> dmem_sizes;
 	for(unsigned int i=0; i<system_strings.size(); ++i){
-		std::string instr_path(system_strings[i][0]);
-		std::string data_path(system_strings[i][0]);
-		std::string cpu_code[2] = {instr_path.append("instr.mem"),data_path.append("data.mem")};
+		// the path is either a firmware ELF file or the vsim directory of its instr.mem and data.mem
+		const std::string path(system_strings[i][0]);
+		const bool elf = elf_is_elf(path.c_str());
+		std::string cpu_code[2] = {elf ? path : path + "instr.mem", elf ? path : path + "data.mem"};
 		for(unsigned int j=0; j<2; ++j){
-			std::ifstream mti_file(cpu_code[j]);
-			if(!mti_file.is_open()){
-				std::cerr << "ERROR: could not open file " << cpu_code[j] << std::endl;
+			mti_image_t image;
+			if(!(elf ? read_elf_memory(cpu_code[j].c_str(), j, image) : mti_read(cpu_code[j].c_str(), image))){
 				return EXIT_FAILURE;
 			}
-			std::string mti_line = "";
-			// read mti file header
-			std::getline(mti_file,mti_line);
-			std::getline(mti_file,mti_line);
-			std::vector<std::string> mti_header;
-			tokenize(mti_line,mti_header,' ');
-			
-			unsigned int words_per_line = 0;
-			for(unsigned int entry=0; entry<mti_header.size(); ++entry){
-				std::vector<std::string> kv;
-				tokenize(mti_header[entry],kv,'=');
-				if(kv[0].compare("wordsperline")==0){
-					words_per_line = std::stoi(kv[1]);
-					if(words_per_line != 2 && words_per_line !=4){
-						std::cerr << "ERROR: " << words_per_line << " not supported!" << std::endl;
-						return EXIT_FAILURE;
-					}
-				}
+			if(image.word_digits != 16 && image.word_digits != 8 && !image.runs.empty()){
+				std::cerr << "ERROR: unsupported word width in " << cpu_code[j] << ". Only standard MIPS mti files supported. This means 64 bit or 32 bit words!!" << std::endl;
+				return EXIT_FAILURE;
 			}
 
 			// declare variable name
@@ -133,126 +188,120 @@ int main(int argc, char *argv[]){
 				var_name = "data_segment";
 			}
 			var_name.append(std::to_string((long long unsigned int)i));
-			generated_variables.push_back(var_name);
 
-			int blocksize = std::stoi(system_strings[i][j+1]) * 4096 / 8;
-			outfile << "uint64_t " << var_name << "[" << blocksize << "] = {" << std::endl << "    ";
-			
+			uint64_t blocks = 0;
+			if(!mti_parse_dec(system_strings[i][j+1], blocks)){
+				std::cerr << "ERROR: wrong number of blocks: " << system_strings[i][j+1] << std::endl;
+				return EXIT_FAILURE;
+			}
+			const uint64_t blocksize = blocks * 4096 / 8;
 			if(j==0){
 				imem_sizes.push_back(blocksize);
 			}else{
 				dmem_sizes.push_back(blocksize);
 			}
-			
-			// read data and dump it in new format
-			unsigned int max_index = (unsigned int)blocksize;
-			if(words_per_line == 2){
-				unsigned int index = 0;
-				while(index<max_index){
-					std::vector<std::string> mti_strings;
-					int mti_index = blocksize;
-					std::getline(mti_file,mti_line);
-					if(!mti_file.eof()){
-						tokenize(mti_line,mti_strings,' ');
-						mti_index = std::stoi(mti_strings[0].substr(0,mti_strings[0].length()-1));
-					}
-
-					// fill with zeros if some values are not in the file
-					while(index < mti_index){
-						outfile << "0x0000000000000000";
-						if(index != max_index-1){
-							outfile << ", ";
-						}
-						if((index&1) == 1){
-							outfile << std::endl << "    ";
-						}
-						++index;
-					}
 
-					// write data if present
-					for(unsigned int entry=1; entry<mti_strings.size() && index<max_index; ++entry){
-						outfile << "0x" << mti_strings[entry];
-						if(index != max_index-1){
-							outfile << ", ";
-						}
-						if((index&1) == 1){
-							outfile << std::endl << "    ";
-						}
-						++index;
-					}
-				}
-			}else if(words_per_line == 4){
-				max_index *= 2;
-				unsigned int index = 0;
-				std::string last_value = "";
-				while(index<max_index){
-					std::vector<std::string> mti_strings;
-					int mti_index = blocksize;
-					std::getline(mti_file,mti_line);
-					if(!mti_file.eof()){
-						tokenize(mti_line,mti_strings,' ');
-						mti_index = std::stoi(mti_strings[0].substr(0,mti_strings[0].length()-1));
-					}
+			// the extents of the segment, split at runs of zeros that
+			// take more space than a new extent
+			std::vector<segment_extent_t> extents;
+			find_extents(image, blocksize, extents);
+			extent_counts.push_back(extents.size());
+			if(extents.empty()){
+				generated_variables.push_back("NULL");
+				continue;
+			}
+			uint64_t words = 0;
+			for(unsigned int e=0; e<extents.size(); ++e){
+				words += extents[e].length;
+			}
 
-					// fill with zeros if some values are not in the file
-					while(index < mti_index){
-						std::string current_value = "";
-						current_value = "00000000";
-						if((index&1) == 1){
-							outfile << "0x" << current_value << last_value;
-							if(index != max_index-1){
-								outfile << ", ";
-							}
-						}
-						if((index&3) == 3){
-							outfile << std::endl << "    ";
-						}
-						++index;
-						last_value = current_value;
+			// dump the non-zero words of all extents into one array
+			mti_writer_text(outfile, "uint64_t ");
+			mti_writer_text(outfile, var_name);
+			mti_writer_text(outfile, "[");
+			mti_writer_dec(outfile, words);
+			mti_writer_text(outfile, "] = {\n    ");
+			uint64_t written = 0;
+			for(unsigned int e=0; e<extents.size(); ++e){
+				for(uint64_t index=extents[e].offset; index<extents[e].offset+extents[e].length; ++index){
+					mti_writer_text(outfile, "0x");
+					mti_writer_hex(outfile, segment_word(image, index), 16);
+					if(written != words-1){
+						mti_writer_text(outfile, ", ");
 					}
-
-					// write data if present
-					for(unsigned int entry=1; entry<mti_strings.size() && index<max_index; ++entry){
-						std::string current_value = "";
-						current_value = mti_strings[entry];
-						if((index&1) == 1){
-							outfile << "0x" << current_value << last_value;
-							if(index != max_index-1){
-								outfile << ", ";
-							}
-						}
-						if((index&3) == 3){
-							outfile << std::endl << "    ";
-						}
-						++index;
-						last_value = current_value;
+					if((written&1) == 1){
+						mti_writer_text(outfile, "\n    ");
 					}
+					++written;
 				}
-			}else{
-				std::cerr << "ERROR: unsupported number of words per line. Only standard MIPS mti files supported. This means 2 64 bit or 4 32 bit words per line!!" << std::endl;
-				return EXIT_FAILURE;
 			}
-			outfile << "};" << std::endl << std::endl;
+			mti_writer_text(outfile, "};\n\n");
+
+			// the extents point into the array
+			const std::string extent_name = var_name + "_extents";
+			generated_variables.push_back(extent_name);
+			mti_writer_text(outfile, "code_extent_t ");
+			mti_writer_text(outfile, extent_name);
+			mti_writer_text(outfile, "[");
+			mti_writer_dec(outfile, extents.size());
+			mti_writer_text(outfile, "] = {\n");
+			written = 0;
+			for(unsigned int e=0; e<extents.size(); ++e){
+				mti_writer_text(outfile, "    {");
+				mti_writer_dec(outfile, extents[e].offset);
+				mti_writer_text(outfile, ",");
+				mti_writer_dec(outfile, extents[e].length);
+				mti_writer_text(outfile, ",");
+				mti_writer_text(outfile, var_name);
+				mti_writer_text(outfile, "+");
+				mti_writer_dec(outfile, written);
+				mti_writer_text(outfile, (e != extents.size()-1) ? "},\n" : "}\n");
+				written += extents[e].length;
+			}
+			mti_writer_text(outfile, "};\n\n");
 		}
 	}
 
 	// generate segment struct array
-	outfile << "code_segment_t code_vector[" << header_strings.size() << "] = {" << std::endl;
+	mti_writer_text(outfile, "#define CODE_VECTOR_LENGTH ");
+	mti_writer_dec(outfile, header_strings.size());
+	mti_writer_text(outfile, "\n\n");
+	mti_writer_text(outfile, "code_segment_t code_vector[CODE_VECTOR_LENGTH] = {\n");
 	
 	for(unsigned int i=0; i<header_strings.size(); ++i){
 		if(header_strings[i].compare("-")==0){
-			outfile << "    {NULL,NULL,0,0}";
+			mti_writer_text(outfile, "    {NULL,NULL,0,0,0,0}");
 		}else{
-			int program_index = std::stoi(header_strings[i]);
-			outfile << "    {" << generated_variables[program_index*2] << ","<< generated_variables[program_index*2 + 1] << "," << imem_sizes[program_index] << "," << dmem_sizes[program_index] << "}";
+			uint64_t program_index = 0;
+			if(!mti_parse_dec(header_strings[i], program_index) || program_index >= imem_sizes.size()){
+				std::cerr << "ERROR: unknown program " << header_strings[i] << std::endl;
+				return EXIT_FAILURE;
+			}
+			mti_writer_text(outfile, "    {");
+			mti_writer_text(outfile, generated_variables[program_index*2]);
+			mti_writer_text(outfile, ",");
+			mti_writer_text(outfile, generated_variables[program_index*2 + 1]);
+			mti_writer_text(outfile, ",");
+			mti_writer_dec(outfile, extent_counts[program_index*2]);
+			mti_writer_text(outfile, ",");
+			mti_writer_dec(outfile, extent_counts[program_index*2 + 1]);
+			mti_writer_text(outfile, ",");
+			mti_writer_dec(outfile, imem_sizes[program_index]);
+			mti_writer_text(outfile, ",");
+			mti_writer_dec(outfile, dmem_sizes[program_index]);
+			mti_writer_text(outfile, "}");
 		}
 		if(i != header_strings.size()-1){
-			outfile << ",";
+			mti_writer_text(outfile, ",");
 		}
-		outfile << std::endl;
+		mti_writer_text(outfile, "\n");
 	}
 
-	outfile << "};" << std::endl << std::endl;
+	mti_writer_text(outfile, "};\n\n");
 	
-	outfile << "#endif" << std::endl;
+	mti_writer_text(outfile, "#endif\n");
+	if(!mti_writer_close(outfile)){
+		std::cerr << "ERROR: could not write file code_segments.h" << std::endl;
+		return EXIT_FAILURE;
+	}
 }